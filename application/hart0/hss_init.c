@@ -43,6 +43,7 @@
 #include "mpfs_reg_map.h"
 
 #include "hss_memcpy_via_pdma.h"
+#include "hss_zerofill.h"
 #include "mpfs_hal_version.h"
 #include "miv_ihc_version.h"
 #include "mss_sys_services.h"
@@ -105,11 +106,11 @@ extern const uint64_t hss_init_ddr_end;
 bool HSS_ZeroDDR(void)
 {
 #if IS_ENABLED(CONFIG_INITIALIZE_MEMORIES)
-    uint64_t volatile *pDWord = (uint64_t volatile *)DDR_START;
+    uintptr_t const ddrStart = (uintptr_t)DDR_START;
+    uintptr_t const ddrEnd = (uintptr_t)DDR_END;
 
-    while (pDWord < (uint64_t volatile const * const)DDR_END) {
-        *pDWord = 0llu;
-        pDWord++;
+    if (ddrEnd > ddrStart) {
+        HSS_ZeroFill((void *)ddrStart, ddrEnd - ddrStart);
     }
 #endif
 
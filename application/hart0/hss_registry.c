@@ -37,6 +37,14 @@
 # include "spi_service.h"
 #endif
 
+#if IS_ENABLED(CONFIG_MEMTEST_PARALLEL)
+# include "hss_memtest.h"
+#endif
+
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_ZERO_INIT_ON_TARGET)
+# include "hss_zerofill.h"
+#endif
+
 #if IS_ENABLED(CONFIG_SERVICE_SCRUB)
 # include "scrub_service.h"
 #endif
@@ -172,6 +180,16 @@ const struct IPI_Handler ipiRegistry[] = {
 #else
     { IPI_MSG_OPENSBI_INIT, 	  	HSS_Null_IPIHandler },
 #endif
+#if IS_ENABLED(CONFIG_MEMTEST_PARALLEL)
+    { IPI_MSG_MEMTEST, 	  		HSS_MemTest_IPIHandler },
+#else
+    { IPI_MSG_MEMTEST, 	  		HSS_Null_IPIHandler },
+#endif
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_ZERO_INIT_ON_TARGET)
+    { IPI_MSG_ZEROFILL, 	  		HSS_ZeroFill_IPIHandler },
+#else
+    { IPI_MSG_ZEROFILL, 	  		HSS_Null_IPIHandler },
+#endif
 };
 const size_t spanOfIpiRegistry = ARRAY_SIZE(ipiRegistry);
 
@@ -272,11 +290,14 @@ const struct InitFunction /*@null@*/ globalInitFunctions[] = {
     { "HSS_MemTestDDRFast",            HSS_MemTestDDRFast,            false, false },
 #endif
     { "HSS_BoardLateInit",             HSS_BoardLateInit,             false, false },
-#if IS_ENABLED(CONFIG_SERVICE_MMC)
+#if !IS_ENABLED(CONFIG_SERVICE_BOOT_CONCURRENT_PROBE)
+    // otherwise, the boot sources are initialized as they are probed, in HSS_BootInit()
+#  if IS_ENABLED(CONFIG_SERVICE_MMC)
     { "HSS_MMCInit",                   HSS_MMCInit,                   false, false },
-#endif
-#if IS_ENABLED(CONFIG_SERVICE_QSPI)
+#  endif
+#  if IS_ENABLED(CONFIG_SERVICE_QSPI)
     { "HSS_QSPIInit",                  HSS_QSPIInit,                  false, false },
+#  endif
 #endif
 #if IS_ENABLED(CONFIG_SERVICE_TINYCLI)
     { "HSS_TinyCLI_Parser",            HSS_TinyCLI_Parser,            false, false },
@@ -26,8 +26,12 @@
 
 #include "csr_helper.h"
 #include "profiling.h"
+#include "uart_helper.h"
+#include "mpfs_reg_map.h"
 
 #include "hss_registry.h"
+#include "hss_trace.h"
+#include "hss_boot_timeline.h"
 
 /**
  * \brief Ensure that state is valid for given state machine
@@ -74,6 +78,9 @@ void RunStateMachine(struct StateMachine *const pCurrentMachine)
         pCurrentMachine->lastExecutionTime = lastEntry;
 
         if (prevState != currentState) {
+            mHSS_TRACE(HSS_TRACE_EVT_SM_TRANSITION, (uint32_t)(uintptr_t)pCurrentMachine,
+                (uint32_t)prevState, (uint32_t)currentState);
+
             if (IsValidState(pCurrentMachine, prevState)) {
                 struct StateDesc const * const pLastStateDesc =
                     &(pCurrentMachine->pStateDescs[prevState]);
@@ -93,6 +100,8 @@ void RunStateMachine(struct StateMachine *const pCurrentMachine)
             pCurrentMachine->prevState = pCurrentMachine->state;
         }
 
+        pCurrentMachine->wakeEvents = 0u; // handler must re-declare quiescence each time
+
         if (likely(pCurrentStateDesc->state_handler != NULL)) {
             pCurrentStateDesc->state_handler(pCurrentMachine);
         }
@@ -136,11 +145,131 @@ void RunStateMachine(struct StateMachine *const pCurrentMachine)
     }
 }
 
+/**
+ * \brief Declare a state machine quiescent until one of the given events occurs
+ */
+void SleepStateMachine(struct StateMachine * const pMyMachine, uint32_t wakeEvents, HSSTicks_t wakeTime)
+{
+    assert(pMyMachine != NULL);
+
+    pMyMachine->wakeEvents = wakeEvents | SM_WAKE_ON_STATE_CHANGE;
+    pMyMachine->wakeTime = wakeTime;
+}
+
+/**
+ * \brief Make a quiescent state machine runnable again
+ */
+void WakeStateMachine(struct StateMachine * const pMyMachine)
+{
+    assert(pMyMachine != NULL);
+
+    pMyMachine->wakeEvents = 0u;
+}
+
+static uint32_t getPendingEvents_(uint32_t wantedEvents)
+{
+    uint32_t result = 0u;
+
+    if (wantedEvents & SM_WAKE_ON_IPI) {
+        enum HSSHartId const myHartId = current_hartid();
+
+        for (size_t i = 0u; i < MAX_NUM_HARTS; ++i) {
+            if (unlikely(i == myHartId)) { continue; }
+
+            if (IPI_GetQueuePendingCount(IPI_CalculateQueueIndex(i, myHartId))) {
+                result |= SM_WAKE_ON_IPI;
+                break;
+            }
+        }
+    }
+
+    // only touch the UART if someone is waiting on it, as it may have been surrendered
+    if ((wantedEvents & SM_WAKE_ON_UART_RX) && uart_rx_ready()) {
+        result |= SM_WAKE_ON_UART_RX;
+    }
+
+    return result;
+}
+
+static uint32_t getWantedEvents_(const size_t spanOfPStateMachines, struct StateMachine *const pStateMachines[])
+{
+    uint32_t result = 0u;
+
+    for (size_t i = 0u; i < spanOfPStateMachines; ++i) {
+        result |= pStateMachines[i]->wakeEvents;
+    }
+
+    return result;
+}
+
+static inline bool isQuiescent_(struct StateMachine const * const pCurrentMachine)
+{
+    return (pCurrentMachine->wakeEvents) && (pCurrentMachine->state == pCurrentMachine->prevState);
+}
+
+static bool shouldRun_(struct StateMachine * const pCurrentMachine, uint32_t pendingEvents, HSSTicks_t now)
+{
+    bool result = true;
+
+    if (isQuiescent_(pCurrentMachine)) {
+        uint32_t const wakeEvents = pCurrentMachine->wakeEvents;
+
+        result = ((wakeEvents & pendingEvents)
+            || ((wakeEvents & SM_WAKE_ON_TIMER) && (now >= pCurrentMachine->wakeTime)));
+    }
+
+    return result;
+}
+
+#if IS_ENABLED(CONFIG_SUPERLOOP_IDLE_WFI)
+#  define SUPERLOOP_MAX_IDLE_TIME \
+    ((CONFIG_SUPERLOOP_IDLE_WFI_MAX_USEC * TICKS_PER_MILLISEC) / 1000llu)
+
+#  ifndef mHSS_WFI
+#    define mHSS_WFI() __asm__ __volatile__ ("wfi")
+#  endif
+
+/**
+ * \brief Wait for the next event when every state machine is quiescent
+ *
+ * The E51 CLINT timer compare is programmed for the earliest timer deadline (bounded by
+ * SUPERLOOP_MAX_IDLE_TIME), and MSIP/MTIP are enabled in mie purely as WFI wake sources.
+ * The E51 superloop runs with mstatus.MIE clear, so no trap is taken.
+ */
+static void idle_(const size_t spanOfPStateMachines, struct StateMachine *const pStateMachines[])
+{
+    HSSTicks_t deadline = HSS_GetTime() + SUPERLOOP_MAX_IDLE_TIME;
+
+    for (size_t i = 0u; i < spanOfPStateMachines; ++i) {
+        if ((pStateMachines[i]->wakeEvents & SM_WAKE_ON_TIMER)
+            && (pStateMachines[i]->wakeTime < deadline)) {
+            deadline = pStateMachines[i]->wakeTime;
+        }
+    }
+
+    // clear any stale MSIP before the final check, so that an IPI sent after the check
+    // still wakes us from the WFI below
+    CLINT_Clear_MSIP(HSS_HART_E51);
+
+    if (!getPendingEvents_(getWantedEvents_(spanOfPStateMachines, pStateMachines))) {
+        unsigned long const mie = mHSS_CSR_READ(mie);
+
+        mHSS_WriteRegEx(uint64_t, CLINT, MTIMECMP_E51_0, deadline);
+        mHSS_CSR_WRITE(mie, mie | MIP_MSIP | MIP_MTIP);
+        mHSS_WFI();
+        mHSS_CSR_WRITE(mie, mie);
+        mHSS_WriteRegEx(uint64_t, CLINT, MTIMECMP_E51_0, UINT64_MAX);
+    }
+}
+#endif
+
 static HSSTicks_t maxLoopTime = 0u;
 static uint64_t loopCount = 0u;
+static HSSTicks_t lastLoopTime = 0u;
 void RunStateMachines(const size_t spanOfPStateMachines, struct StateMachine *const pStateMachines[])
 {
     HSSTicks_t const startTicks = HSS_GetTickCount();
+    HSSTicks_t const startTime = HSS_GetTime();
     HSSTicks_t endTicks;
 
     if (!IS_ENABLED(CONFIG_SERVICE_IPI_POLL)) {
@@ -164,17 +293,37 @@ void RunStateMachines(const size_t spanOfPStateMachines, struct StateMachine *co
         }
     }
 
+    bool allQuiescent = true;
     {
+        uint32_t const pendingEvents =
+            getPendingEvents_(getWantedEvents_(spanOfPStateMachines, pStateMachines));
         size_t i = 0u;
 
         for (i = 0; i < spanOfPStateMachines; ++i) {
             struct StateMachine * const pCurrentMachine = pStateMachines[i];
 
-            RunStateMachine(pCurrentMachine);
+            if (shouldRun_(pCurrentMachine, pendingEvents, startTime)) {
+                RunStateMachine(pCurrentMachine);
+            }
+        }
+
+        // re-check after the pass, as handlers may have changed each other's states
+        for (i = 0; (i < spanOfPStateMachines) && allQuiescent; ++i) {
+            allQuiescent = isQuiescent_(pStateMachines[i]);
         }
     }
 
     ++loopCount;
+    lastLoopTime = HSS_GetTime() - startTime;
+
+#if IS_ENABLED(CONFIG_SUPERLOOP_IDLE_WFI)
+    if (allQuiescent) {
+        idle_(spanOfPStateMachines, pStateMachines);
+    }
+#else
+    (void)allQuiescent;
+#endif
+
     endTicks = HSS_GetTickCount();
     if (IS_ENABLED(CONFIG_DEBUG_LOOP_TIMES) || IS_ENABLED(CONFIG_DEBUG_IPI_STATS)) {
         HSSTicks_t const delta = endTicks - startTicks;
@@ -234,6 +383,14 @@ uint64_t GetStateMachinesExecutionCount(void)
     return loopCount;
 }
 
+/**
+ * \brief Get duration of the last State Machines loop
+ */
+HSSTicks_t GetStateMachinesLastLoopTime(void)
+{
+    return lastLoopTime;
+}
+
 
 /**
  * \brief Run through array of InitFunctions
@@ -247,7 +404,9 @@ void RunInitFunctions(const size_t spanOfInitFunctions, const struct InitFunctio
         //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Running %d of %d: %s()" CRLF, i, spanOfInitFunctions,
         //    initFunctions[i].pName);
 
+        HSSBootPhaseHandle_t const phase = mHSS_BOOT_PHASE_BEGIN(initFunctions[i].pName);
         bool result = (initFunctions[i].handler)();
+        mHSS_BOOT_PHASE_END(phase);
 
         if (!result) {
             mHSS_DEBUG_PRINTF(LOG_ERROR, "%s() returned %d" CRLF, initFunctions[i].pName, result);
@@ -283,5 +442,9 @@ void DumpStateMachineStats(void)
             pGlobalStateMachines[i]->maxState,
             pGlobalStateMachines[i]->lastDeltaExecutionTime,
             pGlobalStateMachines[i]->state);
+
+        if (pGlobalStateMachines[i]->dumpStats) {
+            pGlobalStateMachines[i]->dumpStats(pGlobalStateMachines[i]);
+        }
     }
 }
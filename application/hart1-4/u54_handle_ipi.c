@@ -62,6 +62,12 @@ static const struct IntentsArray
 #if IS_ENABLED(CONFIG_SERVICE_OPENSBI)
     { IPI_MSG_OPENSBI_INIT },
 #endif
+#if IS_ENABLED(CONFIG_MEMTEST_PARALLEL)
+    { IPI_MSG_MEMTEST },
+#endif
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_ZERO_INIT_ON_TARGET)
+    { IPI_MSG_ZEROFILL },
+#endif
 };
 #endif
 
@@ -20,6 +20,15 @@
 
 #include "uart_helper.h"
 
+#if IS_ENABLED(CONFIG_UART_TX_RING)
+#  include "uart_tx_ring.h"
+#endif
+
+#if IS_ENABLED(CONFIG_UART_RX_RING)
+#  include "uart_rx_ring.h"
+#  include "csr_helper.h"
+#endif
+
 static inline mss_uart_instance_t *get_uart_instance(int hartid)
 {
     mss_uart_instance_t *pUart;
@@ -52,10 +61,14 @@ int uart_putstring(int hartid, char *p)
 {
     const uint32_t len = (uint32_t)strlen(p);
 
+#if IS_ENABLED(CONFIG_UART_TX_RING)
+    if (uart_tx_ring_put(hartid, (const uint8_t *)p, len)) {
+        return len;
+    }
+#endif
+
     mss_uart_instance_t *pUart = get_uart_instance(hartid);
     MSS_UART_polled_tx_string(pUart, (const uint8_t *)p);
-    // TODO: if hartId is zero (i.e., E51), replace this with non-blocking
-    // queue implementation, with HSS_UART state machine consuming from queues...
     return len;
 }
 
@@ -65,10 +78,73 @@ void uart_putc(int hartid, const char ch)
     string[0] = (uint8_t)ch;
     string[1] = 0u;
 
+#if IS_ENABLED(CONFIG_UART_TX_RING)
+    if (uart_tx_ring_put(hartid, string, 1u)) {
+        return;
+    }
+#endif
+
     mss_uart_instance_t *pUart = get_uart_instance(hartid);
     MSS_UART_polled_tx_string(pUart, (const uint8_t *)string);
 }
 
+#if IS_ENABLED(CONFIG_UART_TX_RING)
+static size_t uart_fill_tx_fifo_(int hartid, uint8_t const *pBuf, size_t len)
+{
+    return MSS_UART_fill_tx_fifo(get_uart_instance(hartid), pBuf, len);
+}
+#endif
+
+// Non-blocking: moves at most one TX FIFO's worth of buffered output into the UART.
+// Returns true once nothing is left buffered for this hart
+bool uart_tx_drain(int hartid)
+{
+    bool result = true;
+
+#if IS_ENABLED(CONFIG_UART_TX_RING)
+    (void)uart_tx_ring_drain(hartid, uart_fill_tx_fifo_);
+    result = uart_tx_ring_is_empty(hartid);
+#else
+    (void)hartid;
+#endif
+
+    return result;
+}
+
+// Blocking: sends all buffered output. Anything that writes to the UART directly
+// must call this first, so that its output is not reordered ahead of buffered output
+void uart_tx_flush(void)
+{
+#if IS_ENABLED(CONFIG_UART_TX_RING)
+    for (int hartid = HSS_HART_E51; hartid < HSS_HART_NUM_PEERS; hartid++) {
+        while (!uart_tx_drain(hartid)) {
+            ;
+        }
+    }
+#endif
+}
+
+#if IS_ENABLED(CONFIG_UART_RX_RING)
+static size_t uart_read_rx_fifo_(uint8_t *pBuf, size_t len)
+{
+    return MSS_UART_get_rx(&g_mss_uart0_lo, pBuf, len);
+}
+#endif
+
+// Non-blocking: returns up to len bytes of console input that have already arrived.
+// On the E51, the RX FIFO is first emptied into the input ring buffer
+static size_t uart_rx_(uint8_t *pBuf, size_t len)
+{
+#if IS_ENABLED(CONFIG_UART_RX_RING)
+    if (current_hartid() == HSS_HART_E51) {
+        (void)uart_rx_ring_fill(uart_read_rx_fifo_);
+        return uart_rx_ring_get(pBuf, len);
+    }
+#endif
+
+    return MSS_UART_get_rx(&g_mss_uart0_lo, pBuf, len);
+}
+
 ssize_t uart_getline(char **pBuffer, size_t *pBufLen)
 {
     ssize_t result = 0;
@@ -77,10 +153,11 @@ ssize_t uart_getline(char **pBuffer, size_t *pBufLen)
     const size_t bufferLen = ARRAY_SIZE(myBuffer);
 
     memset(myBuffer, 0, bufferLen);
+    uart_tx_flush();
 
     uint8_t cBuf[1];
     while (!finished) {
-        while (0 == MSS_UART_get_rx(&g_mss_uart0_lo, cBuf, 1));
+        while (0 == uart_rx_(cBuf, 1u));
 
         switch (cBuf[0]) {
         case '\r':
@@ -169,7 +246,7 @@ bool uart_getchar(uint8_t *pbuf, int32_t timeout_sec, bool do_sec_tick)
     //(void)MSS_UART_get_rx_status(&g_mss_uart0_lo); // clear sticky status
 
     while (!done) {
-        size_t received = MSS_UART_get_rx(&g_mss_uart0_lo, rx_buff, 1u);
+        size_t received = uart_rx_(rx_buff, 1u);
         if (0u != received) {
             done = true;
             if (MSS_UART_NO_ERROR == MSS_UART_get_rx_status(&g_mss_uart0_lo)) {
@@ -183,6 +260,7 @@ bool uart_getchar(uint8_t *pbuf, int32_t timeout_sec, bool do_sec_tick)
 
         if (do_sec_tick && HSS_Timer_IsElapsed(last_sec_time, TICKS_PER_SEC)) {
             const uint8_t dot='.';
+            uart_tx_flush();
             MSS_UART_polled_tx(&g_mss_uart0_lo, &dot, 1);
             last_sec_time = HSS_GetTime();
         }
@@ -200,3 +278,30 @@ bool uart_getchar(uint8_t *pbuf, int32_t timeout_sec, bool do_sec_tick)
 
     return result;
 }
+
+// Block read: waits for len bytes, giving up once nothing has arrived for timeout_sec
+// (negative waits forever, zero returns only what has already arrived). Returns the
+// number of bytes read. Line errors are not reported, so callers must validate the data
+size_t uart_getbuf(uint8_t *pBuf, size_t len, int32_t timeout_sec)
+{
+    size_t result = 0u;
+    HSSTicks_t last_rx_time = HSS_GetTime();
+    const HSSTicks_t timeout_ticks = timeout_sec * TICKS_PER_SEC;
+
+    while (result < len) {
+        size_t const received = uart_rx_(pBuf + result, len - result);
+
+        if (received) {
+            result += received;
+            last_rx_time = HSS_GetTime();
+        } else if (timeout_sec == 0) {
+            break;
+        } else if ((timeout_sec > 0) && HSS_Timer_IsElapsed(last_rx_time, timeout_ticks)) {
+            break;
+        }
+    }
+
+    (void)MSS_UART_get_rx_status(&g_mss_uart0_lo); // clear sticky status
+
+    return result;
+}
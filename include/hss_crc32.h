@@ -39,6 +39,14 @@ uint32_t CRC32_calculate(const uint8_t *pInput, size_t numBytes);
 
 uint32_t CRC32_calculate_ex(uint32_t seed, uint8_t const *pInput, size_t numBytes);
 
+/**
+ * \brief Combine two CRC32s
+ *
+ * Given crc1 over a block A and crc2 over a following block B of len2 bytes, returns
+ * the CRC32 of A followed by B, without needing to re-read either block.
+ */
+uint32_t CRC32_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,6 +40,69 @@ extern "C" {
 
 void *memcpy_via_pdma(void *dest, void const *src, size_t num_bytes);
 
+/**
+ * \brief Asynchronous PDMA transfer handle
+ *
+ * Bitmask of the PDMA channels still carrying a submitted transfer. Zero means complete.
+ */
+typedef uint8_t HSS_PDMA_Txn_t;
+
+//
+// PDMA channel allocation. SGDMA owns the first CONFIG_SERVICE_SGDMA_PDMA_CHANNELS
+// channels and RAM scrubbing owns the last one. Owners use their channels through
+// memcpy_via_pdma_submit_channel(), and memcpy_via_pdma_submit() never touches them, so
+// boot and zero-fill copies are spread across whatever is left
+//
+#define HSS_PDMA_NUM_CHANNELS           4u
+
+#if defined(CONFIG_SERVICE_SGDMA_PDMA_CHANNELS)
+#  define HSS_PDMA_SGDMA_NUM_CHANNELS   (CONFIG_SERVICE_SGDMA_PDMA_CHANNELS)
+#else
+#  define HSS_PDMA_SGDMA_NUM_CHANNELS   0
+#endif
+#define HSS_PDMA_SGDMA_FIRST_CHANNEL    0u
+#define HSS_PDMA_SGDMA_CHANNELS_MASK    ((HSS_PDMA_Txn_t)((1u << HSS_PDMA_SGDMA_NUM_CHANNELS) - 1u))
+
+#define HSS_PDMA_SCRUB_CHANNEL          (HSS_PDMA_NUM_CHANNELS - 1u)
+#if defined(CONFIG_SERVICE_SCRUB_USE_PDMA)
+#  define HSS_PDMA_SCRUB_CHANNELS_MASK  ((HSS_PDMA_Txn_t)(1u << HSS_PDMA_SCRUB_CHANNEL))
+#else
+#  define HSS_PDMA_SCRUB_CHANNELS_MASK  ((HSS_PDMA_Txn_t)0u)
+#endif
+
+#define HSS_PDMA_RESERVED_CHANNELS_MASK (HSS_PDMA_SGDMA_CHANNELS_MASK | HSS_PDMA_SCRUB_CHANNELS_MASK)
+
+/**
+ * \brief Submit an asynchronous copy
+ *
+ * The copy is spread across the free PDMA channels that are not reserved for an owner
+ * (see HSS_PDMA_RESERVED_CHANNELS_MASK). Unaligned heads and tails, and small copies, are
+ * done by the CPU before returning. Returns false, without copying anything, if no such
+ * channel is currently free.
+ */
+bool memcpy_via_pdma_submit(void * restrict dest, void const * restrict src, size_t num_bytes,
+    HSS_PDMA_Txn_t *pTxn);
+
+/**
+ * \brief Submit an asynchronous copy on one specific PDMA channel
+ *
+ * As memcpy_via_pdma_submit(), but the whole copy is carried by the given channel (taken
+ * modulo the number of channels). This is for the owners of reserved channels.
+ * Returns false, without copying anything, if that channel is currently busy.
+ */
+bool memcpy_via_pdma_submit_channel(unsigned int channel, void * restrict dest,
+    void const * restrict src, size_t num_bytes, HSS_PDMA_Txn_t *pTxn);
+
+/**
+ * \brief Poll an asynchronous copy, returning true once it has completed
+ */
+bool memcpy_via_pdma_poll(HSS_PDMA_Txn_t *pTxn);
+
+/**
+ * \brief Wait for an asynchronous copy to complete
+ */
+void memcpy_via_pdma_complete(HSS_PDMA_Txn_t *pTxn);
+
 #ifdef __cplusplus
 }
 #endif
@@ -41,6 +41,11 @@ bool HSS_MemTestDDRFast(void);
 bool HSS_MemTestDDRFull(void);
 bool HSS_MemTestDDR_Ex(volatile uint64_t *baseAddr, size_t numBytes);
 
+#if IS_ENABLED(CONFIG_MEMTEST_PARALLEL)
+#  include "ssmb_ipi.h"
+enum IPIStatusCode HSS_MemTest_IPIHandler(TxId_t transaction_id, enum HSSHartId source, uint32_t immediate_arg, void *p_extended_buffer_in_ddr, void *p_ancilliary_buffer_in_ddr);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -82,10 +82,28 @@ struct StateMachine {
     bool debugFlag;
     uint8_t priority;
     void *pInstanceData;
+    void (*dumpStats)(struct StateMachine * const pMyMachine);
+    uint32_t wakeEvents;
+    HSSTicks_t wakeTime;
 };
 
 #define SM_INVALID_STATE ((stateType_t)-1)
 
+/**
+ * \brief State Machine wake events
+ *
+ * A state machine with nothing to do can declare itself quiescent from its handler by
+ * calling SleepStateMachine(). The superloop then skips it until one of the requested
+ * events occurs. A change of state, or a call to WakeStateMachine(), always wakes it.
+ */
+#define SM_WAKE_ON_STATE_CHANGE (1u << 0)
+#define SM_WAKE_ON_IPI          (1u << 1)
+#define SM_WAKE_ON_TIMER        (1u << 2)
+#define SM_WAKE_ON_UART_RX      (1u << 3)
+
+void SleepStateMachine(struct StateMachine * const pMyMachine, uint32_t wakeEvents, HSSTicks_t wakeTime);
+void WakeStateMachine(struct StateMachine * const pMyMachine);
+
 void RunStateMachine(struct StateMachine * const pCurrentMachine);
 void RunStateMachines(const size_t spanOfPStateMachines, struct StateMachine * const pStateMachines[]);
 
@@ -106,6 +124,11 @@ struct InitFunction {
  */
 uint64_t GetStateMachinesExecutionCount(void);
 
+/**
+ * \brief Get duration of the last State Machines loop, in HSS_GetTime() ticks
+ */
+HSSTicks_t GetStateMachinesLastLoopTime(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -62,6 +62,9 @@ extern "C" {
 
 #ifndef CONFIG_OPENSBI
 #  define MIN(A,B)		((A) < (B) ? A : B)
+#  ifndef MAX
+#    define MAX(A,B)		((A) > (B) ? A : B)
+#  endif
 #  define likely(x)		__builtin_expect((x), 1)
 #  define unlikely(x)		__builtin_expect((x), 0)
 #  ifndef __ssize_t_defined
@@ -221,12 +224,22 @@ struct HSS_CompressedImage {
 #endif
 };
 
+enum HSS_StorageInitStatus {
+    HSS_STORAGE_INIT_PENDING,
+    HSS_STORAGE_INIT_DONE,
+    HSS_STORAGE_INIT_FAILED,
+};
+
 struct HSS_Storage;
 typedef bool (* HSS_GetBootImageFnPtr_t)(struct HSS_Storage *pStorage, struct HSS_BootImage **ppBootImage);
 struct HSS_Storage {
     char const * const name;
     HSS_GetBootImageFnPtr_t const getBootImage;
     bool (* const init)(void);
+    // optional non-blocking init, called repeatedly until it is no longer pending
+    enum HSS_StorageInitStatus (* const initPoll)(void);
+    // optional read and check of the boot image header only, without copying the image
+    bool (* const probeBootImage)(struct HSS_Storage *pStorage, struct HSS_BootImage *pHeader);
     bool (* const readBlock)(void *pDest, size_t srcOffset, size_t byteCount);
     bool (* const writeBlock)(size_t dstOffset, void *pSrc, size_t byteCount);
     void (* const getInfo)(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount);
@@ -0,0 +1,93 @@
+#ifndef HSS_ZEROFILL_H
+#define HSS_ZEROFILL_H
+
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ *
+ * Hart Software Services - Zero Fill Engine
+ *
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \file Zero Fill Engine
+ * \brief Zero Fill Engine
+ */
+
+#include "hss_types.h"
+#include "hss_clock.h"
+#include "hss_memcpy_via_pdma.h"
+
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_ZERO_INIT_ON_TARGET)
+#  include "ssmb_ipi.h"
+#endif
+
+/**
+ * \brief Zero fill of one region, tracked until completion
+ *
+ * A job is either handed to a U54 (which zeroes the region from its IPI handler), or driven
+ * by the E51 through the PDMA, by zeroing a small seed with the CPU and then repeatedly
+ * doubling it with PDMA copies. The job memory must stay valid until the job is done.
+ */
+struct HSS_ZeroFill_Job {
+    char *pDest;
+    size_t numBytes;
+    size_t bytesDone;
+    uint32_t generation;
+    uint32_t state;
+    HSS_PDMA_Txn_t pdmaTxn;
+    HSSTicks_t submitTime;
+};
+
+/**
+ * \brief Zero a region on the calling hart, using wide stores and (if enabled) the PDMA
+ */
+void HSS_ZeroFill(void *pDest, size_t numBytes);
+
+/**
+ * \brief Start zeroing a region
+ *
+ * If worker is a U54 and CONFIG_SERVICE_BOOT_ZERO_INIT_ON_TARGET is enabled, the region is
+ * offered to that hart. If it has not picked it up in time, the E51 takes it back.
+ */
+void HSS_ZeroFill_Submit(struct HSS_ZeroFill_Job *pJob, enum HSSHartId worker, void *pDest,
+    size_t numBytes);
+
+/**
+ * \brief Advance a zero fill job, returning true once the region is zeroed
+ */
+bool HSS_ZeroFill_Poll(struct HSS_ZeroFill_Job *pJob);
+
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_ZERO_INIT_ON_TARGET)
+enum IPIStatusCode HSS_ZeroFill_IPIHandler(TxId_t transaction_id, enum HSSHartId source, uint32_t immediate_arg, void *p_extended_buffer_in_ddr, void *p_ancilliary_buffer_in_ddr);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
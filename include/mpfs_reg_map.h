@@ -46,12 +46,15 @@ extern "C" {
 
 #define U54_4_ITIM_BASE_ADDR	 		(0x01820000u)
 
-#define CLINT_BASE_ADDR		  		(0x02000000u)
+#ifndef CLINT_BASE_ADDR
+#	define CLINT_BASE_ADDR			(0x02000000u)
+#endif
 #define CLINT_MSIP_E51_0_OFFSET			(0x0000u)
 #define CLINT_MSIP_U54_1_OFFSET			(0x0004u)
 #define CLINT_MSIP_U54_2_OFFSET			(0x0008u)
 #define CLINT_MSIP_U54_3_OFFSET			(0x000Cu)
 #define CLINT_MSIP_U54_4_OFFSET			(0x0010u)
+#define CLINT_MTIMECMP_E51_0_OFFSET		(0x4000u)
 #define CLINT_MTIME_OFFSET		        (0xBFF8u)
 
 #define L2_CACHE_CTRL_BASE_ADDR	  		(0x02010000u)
@@ -75,8 +78,13 @@ extern "C" {
 #	define PLIC_BASE_ADDR			(0x0C000000u)
 #endif
 
-#define SYSREGSCB_BASE_ADDR			(0x20003000u)
+#ifndef SYSREGSCB_BASE_ADDR
+#	define SYSREGSCB_BASE_ADDR		(0x20003000u)
+#endif
 #define SYSREGSCB_MSS_STATUS_OFFSET		(0x0104u)
+#define SYSREGSCB_DEVICE_CONFIG_CR_OFFSET	(0x01A0u)
+
+#define SYSREGSCB_DEVICE_CONFIG_CR_CRYPTO_DISABLE_MASK	(1u << 2)
 
 #define MPU_BASE_ADDR				(0x2000E000u)
 #define MPU_FIC0_OFFSET				(0x0000u)
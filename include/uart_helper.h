@@ -37,7 +37,11 @@ extern "C" {
 int uart_putstring(int hartid, char *p);
 ssize_t uart_getline(char **pBuffer, size_t *pBufLen);
 bool uart_getchar(uint8_t *pbuf, int32_t timeout_sec, bool do_sec_tick);
+size_t uart_getbuf(uint8_t *pBuf, size_t len, int32_t timeout_sec);
+bool uart_rx_ready(void);
 void uart_putc(int hartid, const char ch);
+bool uart_tx_drain(int hartid);
+void uart_tx_flush(void);
 
 #ifdef __cplusplus
 }
@@ -49,6 +49,7 @@
 #include "hss_debug.h"
 #include "hss_crc32.h"
 #include "hss_perfctr.h"
+#include "hss_boot_timeline.h"
 
 #include <string.h>
 #include <assert.h>
@@ -72,7 +73,7 @@ static inline bool verifyMagic_(struct HSS_BootImage const * const pBootImage);
 #if !IS_ENABLED(CONFIG_SERVICE_BOOT_USE_PAYLOAD)
 typedef bool (*HSS_BootImageCopyFnPtr_t)(void *pDest, size_t srcOffset, size_t byteCount);
 static bool copyBootImageToDDR_(struct HSS_BootImage *pBootImage, char *pDest,
-    size_t srcOffset, HSS_BootImageCopyFnPtr_t pCopyFunction);
+    size_t srcOffset, HSS_BootImageCopyFnPtr_t pCopyFunction, size_t signingChunkSize);
 #endif
 
 static bool getBootImageFromQSPI_(struct HSS_Storage *pStorage, struct HSS_BootImage **ppBootImage);
@@ -80,10 +81,32 @@ static bool getBootImageFromMMC_(struct HSS_Storage *pStorage, struct HSS_BootIm
 static bool getBootImageFromSpiFlash_(struct HSS_Storage *pStorage, struct HSS_BootImage **ppBootImage);
 static bool getBootImageFromPayload_(struct HSS_Storage *pStorage, struct HSS_BootImage **ppBootImage);
 
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_CONCURRENT_PROBE)
+static bool probeBootImageFromQSPI_(struct HSS_Storage *pStorage, struct HSS_BootImage *pHeader);
+static bool probeBootImageFromMMC_(struct HSS_Storage *pStorage, struct HSS_BootImage *pHeader);
+static bool probeBootImageFromSpiFlash_(struct HSS_Storage *pStorage, struct HSS_BootImage *pHeader);
+static bool probeBootImageFromPayload_(struct HSS_Storage *pStorage, struct HSS_BootImage *pHeader);
+#  define mPROBE_FN(x) (x)
+#else
+#  define mPROBE_FN(x) NULL
+#endif
+
 static void printBootImageDetails_(struct HSS_BootImage const * const pBootImage);
 static bool validateCrc_(struct HSS_BootImage *pImage);
 static bool tryBootFunction_(struct HSS_Storage *pStorage, HSS_GetBootImageFnPtr_t getBootImageFunction);
 
+#if IS_ENABLED(CONFIG_CRYPTO_SIGNING_STREAMING)
+// how much of the image is copied before it is hashed, when streaming code signing checks.
+// MMC gets its own (larger) size, so as not to break up its multi-block SDMA reads
+#  define BOOT_SIGNING_CHUNK_SIZE ((size_t)CONFIG_CRYPTO_SIGNING_STREAMING_CHUNK_KIB * 1024u)
+#  if IS_ENABLED(CONFIG_SERVICE_MMC)
+#    define BOOT_SIGNING_MMC_CHUNK_SIZE ((size_t)CONFIG_CRYPTO_SIGNING_STREAMING_MMC_CHUNK_KIB * 1024u)
+#  endif
+#else
+#  define BOOT_SIGNING_CHUNK_SIZE 0u
+#  define BOOT_SIGNING_MMC_CHUNK_SIZE 0u
+#endif
+
 //
 //
 
@@ -92,6 +115,8 @@ static struct HSS_Storage qspiStorage_ = {
     .name = "QSPI",
     .getBootImage = getBootImageFromQSPI_,
     .init = HSS_CachedQSPIInit,
+    .initPoll = NULL,
+    .probeBootImage = mPROBE_FN(probeBootImageFromQSPI_),
     .readBlock = HSS_CachedQSPI_ReadBlock,
     .writeBlock = HSS_CachedQSPI_WriteBlock,
     .getInfo = HSS_CachedQSPI_GetInfo,
@@ -103,10 +128,12 @@ static struct HSS_Storage mmcStorage_ = {
     .name = "MMC",
     .getBootImage = getBootImageFromMMC_,
     .init = HSS_MMCInit,
+    .initPoll = HSS_MMCInitPoll,
+    .probeBootImage = mPROBE_FN(probeBootImageFromMMC_),
     .readBlock = HSS_MMC_ReadBlock,
     .writeBlock = HSS_MMC_WriteBlockSDMA,
     .getInfo = HSS_MMC_GetInfo,
-    .flushWriteBuffer = NULL
+    .flushWriteBuffer = HSS_MMC_FlushWriteBuffer
 };
 #endif
 #if IS_ENABLED(CONFIG_SERVICE_SPI)
@@ -114,6 +141,8 @@ static struct HSS_Storage spiStorage_ = {
     .name = "SPI",
     .getBootImage = getBootImageFromSpiFlash_,
     .init = NULL,
+    .initPoll = NULL,
+    .probeBootImage = mPROBE_FN(probeBootImageFromSpiFlash_),
     .readBlock = NULL,
     .writeBlock = NULL,
     .getInfo = NULL,
@@ -125,6 +154,8 @@ static struct HSS_Storage payloadStorage_ = {
     .name = "Payload",
     .getBootImage = getBootImageFromPayload_,
     .init = NULL,
+    .initPoll = NULL,
+    .probeBootImage = mPROBE_FN(probeBootImageFromPayload_),
     .readBlock = NULL,
     .writeBlock = NULL,
     .getInfo = NULL,
@@ -171,6 +202,133 @@ struct HSS_Storage *HSS_BootGetActiveStorage(void)
 
 }
 
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_CONCURRENT_PROBE)
+//
+// Concurrent boot source probing
+//
+// Rather than fully initializing each boot source in turn, every source is stepped in
+// round-robin until its init has completed and its boot image header has been read and
+// checked. Sources with a non-blocking init (initPoll) spend their retry delays without
+// holding up the others.
+//
+// By default, the source chosen is the highest priority one (i.e. earliest in pStorages[])
+// with a valid header, once every higher priority source has failed. With
+// CONFIG_SERVICE_BOOT_PROBE_FIRST_VALID, the first source found valid is chosen instead.
+// If booting from the chosen source fails, the choice is made again without it.
+//
+enum BootProbeState {
+    BOOT_PROBE_INIT,
+    BOOT_PROBE_HEADER,
+    BOOT_PROBE_VALID,
+    BOOT_PROBE_FAILED,
+};
+
+static struct HSS_BootImage probeHeaders_[ARRAY_SIZE(pStorages)] __attribute__((aligned(8)));
+static HSSBootPhaseHandle_t probePhases_[ARRAY_SIZE(pStorages)];
+
+static enum BootProbeState bootProbeStep_(struct HSS_Storage *pStorage, enum BootProbeState state,
+    struct HSS_BootImage *pHeader)
+{
+    enum HSS_StorageInitStatus status = HSS_STORAGE_INIT_DONE;
+
+    switch (state) {
+    case BOOT_PROBE_INIT:
+        if (pStorage->initPoll) {
+            status = pStorage->initPoll();
+        } else if (pStorage->init) {
+            status = pStorage->init() ? HSS_STORAGE_INIT_DONE : HSS_STORAGE_INIT_FAILED;
+        }
+
+        if (status == HSS_STORAGE_INIT_DONE) {
+            state = BOOT_PROBE_HEADER;
+        } else if (status == HSS_STORAGE_INIT_FAILED) {
+            mHSS_DEBUG_PRINTF(LOG_WARN, "%s: initialization failed" CRLF, pStorage->name);
+            state = BOOT_PROBE_FAILED;
+        }
+        break;
+
+    case BOOT_PROBE_HEADER:
+        if (pStorage->probeBootImage && pStorage->probeBootImage(pStorage, pHeader)) {
+            mHSS_DEBUG_PRINTF(LOG_NORMAL, "%s: valid boot image header found" CRLF, pStorage->name);
+            state = BOOT_PROBE_VALID;
+        } else {
+            state = BOOT_PROBE_FAILED;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return state;
+}
+
+static int bootProbeSelect_(enum BootProbeState const states[])
+{
+    int result = -1;
+
+    for (int i = 0; i < ARRAY_SIZE(pStorages); i++) {
+        if (states[i] == BOOT_PROBE_VALID) {
+            result = i;
+            break;
+        } else if ((states[i] != BOOT_PROBE_FAILED)
+                && !IS_ENABLED(CONFIG_SERVICE_BOOT_PROBE_FIRST_VALID)) {
+            break; // a higher priority source has not yet finished probing
+        }
+    }
+
+    return result;
+}
+
+static bool bootInitConcurrent_(void)
+{
+    bool result = false;
+    enum BootProbeState states[ARRAY_SIZE(pStorages)];
+
+    mHSS_DEBUG_PRINTF(LOG_NORMAL, "Probing %d boot sources ..." CRLF, (int)ARRAY_SIZE(pStorages));
+
+    for (int i = 0; i < ARRAY_SIZE(pStorages); i++) {
+        states[i] = BOOT_PROBE_INIT;
+        probePhases_[i] = mHSS_BOOT_PHASE_BEGIN_ASYNC(pStorages[i]->name);
+    }
+
+    while (!result) {
+        bool pending = true;
+        int selected = bootProbeSelect_(states);
+
+        while ((selected < 0) && pending) {
+            pending = false;
+
+            for (int i = 0; i < ARRAY_SIZE(pStorages); i++) {
+                if ((states[i] == BOOT_PROBE_INIT) || (states[i] == BOOT_PROBE_HEADER)) {
+                    states[i] = bootProbeStep_(pStorages[i], states[i], &probeHeaders_[i]);
+                    pending = true;
+
+                    if ((states[i] == BOOT_PROBE_VALID) || (states[i] == BOOT_PROBE_FAILED)) {
+                        mHSS_BOOT_PHASE_END(probePhases_[i]);
+                    }
+                }
+            }
+
+            selected = bootProbeSelect_(states);
+        }
+
+        if (selected < 0) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "No boot source has a valid boot image" CRLF);
+            break;
+        }
+
+        mHSS_DEBUG_PRINTF(LOG_NORMAL, "Trying to boot via %s ..." CRLF, pStorages[selected]->name);
+        result = tryBootFunction_(pStorages[selected], pStorages[selected]->getBootImage);
+        if (!result) {
+            states[selected] = BOOT_PROBE_FAILED;
+        }
+    }
+
+    return result;
+}
+#endif
+
 bool HSS_BootInit(void)
 {
     bool result = false;
@@ -186,20 +344,37 @@ bool HSS_BootInit(void)
             result = tryBootFunction_(pDefaultStorage, pDefaultStorage->getBootImage);
         }
     } else {
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_CONCURRENT_PROBE)
+        result = bootInitConcurrent_();
+#else
         for (int i = 0; i < ARRAY_SIZE(pStorages); i++) {
             mHSS_DEBUG_PRINTF(LOG_NORMAL, "Trying to boot via %s ..." CRLF, pStorages[i]->name);
+            HSSBootPhaseHandle_t const phase = mHSS_BOOT_PHASE_BEGIN(pStorages[i]->name);
             result = pStorages[i]->init();
+            mHSS_BOOT_PHASE_END(phase);
             if (result) {
                 result = tryBootFunction_(pStorages[i], pStorages[i]->getBootImage);
                 if (result) { break; }
             }
         }
+#endif
     }
 
     HSS_PerfCtr_Lap(perf_ctr_index);
     return result;
 }
 
+#if IS_ENABLED(CONFIG_CRYPTO_SIGNING)
+static bool bootCheckCodeSigning_(struct HSS_BootImage *pBootImage)
+{
+    HSSBootPhaseHandle_t const phase = mHSS_BOOT_PHASE_BEGIN("code signing");
+    bool const result = HSS_Boot_Secure_CheckCodeSigning(pBootImage);
+    mHSS_BOOT_PHASE_END(phase);
+
+    return result;
+}
+#endif
+
 bool tryBootFunction_(struct HSS_Storage *pStorage, HSS_GetBootImageFnPtr_t const bootImageFunction)
 {
     bool result = false;
@@ -214,7 +389,9 @@ bool tryBootFunction_(struct HSS_Storage *pStorage, HSS_GetBootImageFnPtr_t cons
     // check if this image is compressed...
     // if so, decompress it to DDR
     //
-    // for now, compression only works with a source already in DDR 
+    // with streaming decompression, images from storage have already been
+    // inflated by the time we get here, so this only handles a compressed
+    // source already in memory (e.g. a directly contained payload)
 #  if IS_ENABLED(CONFIG_COMPRESSION)
     if (result && pBootImage->magic == mHSS_COMPRESSED_MAGIC) {
         decompressedFlag = true;
@@ -228,7 +405,9 @@ bool tryBootFunction_(struct HSS_Storage *pStorage, HSS_GetBootImageFnPtr_t cons
             void* const pInput = (void*)pBootImage;
             void * const pOutputInDDR = (void *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR);
 
+            HSSBootPhaseHandle_t const phase = mHSS_BOOT_PHASE_BEGIN("decompress");
             int outputSize = HSS_Decompress(pInput, pOutputInDDR);
+            mHSS_BOOT_PHASE_END(phase);
             mHSS_DEBUG_PRINTF(LOG_NORMAL, "decompressed %d bytes ..." CRLF, outputSize);
 
             if (outputSize) {
@@ -251,7 +430,7 @@ bool tryBootFunction_(struct HSS_Storage *pStorage, HSS_GetBootImageFnPtr_t cons
             mHSS_DEBUG_PRINTF(LOG_ERROR, "Boot Image magic invalid, ignoring" CRLF);
             result = false;
 #  if IS_ENABLED(CONFIG_CRYPTO_SIGNING)
-        } else if (!HSS_Boot_Secure_CheckCodeSigning(pBootImage)) {
+        } else if (!bootCheckCodeSigning_(pBootImage)) {
             mHSS_DEBUG_PRINTF(LOG_ERROR, "Boot Image failed code signing" CRLF);
             result = false;
 #  endif
@@ -331,15 +510,56 @@ static void printBootImageDetails_(struct HSS_BootImage const * const pBootImage
 
 #if !IS_ENABLED(CONFIG_SERVICE_BOOT_USE_PAYLOAD)
 static bool copyBootImageToDDR_(struct HSS_BootImage *pBootImage, char *pDest,
-    size_t srcOffset, HSS_BootImageCopyFnPtr_t pCopyFunction)
+    size_t srcOffset, HSS_BootImageCopyFnPtr_t pCopyFunction, size_t signingChunkSize)
 {
     bool result = true;
 
     printBootImageDetails_(pBootImage);
 
+#if IS_ENABLED(CONFIG_CRYPTO_SIGNING_STREAMING)
+    // whatever the path below, nothing hashed by an earlier copy stands for this image
+    HSS_Boot_Secure_StreamReset();
+#endif
+
+#if IS_ENABLED(CONFIG_COMPRESSION_STREAMING)
+    //
+    // compressed images are inflated straight from storage into DDR, so the
+    // compressed copy never needs its own staging area
+    if (pBootImage->magic == mHSS_COMPRESSED_MAGIC) {
+        HSSBootPhaseHandle_t const phase = mHSS_BOOT_PHASE_BEGIN("decompress");
+        size_t outputSize = HSS_DecompressFromStorage(pCopyFunction, srcOffset, pDest);
+        mHSS_BOOT_PHASE_END(phase);
+        mHSS_DEBUG_PRINTF(LOG_NORMAL, "decompressed %lu bytes ..." CRLF, outputSize);
+
+        return (outputSize != 0u);
+    }
+#endif
+
     mHSS_DEBUG_PRINTF(LOG_NORMAL, "Copying %lu bytes to 0x%lx" CRLF,
         pBootImage->bootImageLength, pDest);
+
+    HSSBootPhaseHandle_t const phase = mHSS_BOOT_PHASE_BEGIN("image copy");
+#if IS_ENABLED(CONFIG_CRYPTO_SIGNING_STREAMING)
+    //
+    // copy a chunk at a time, hashing each chunk for code signing as soon as it lands,
+    // rather than reading the whole image back again afterwards
+    HSS_Boot_Secure_StreamBegin(pBootImage, (struct HSS_BootImage *)pDest);
+
+    size_t offset = 0u;
+    while (result && (offset < pBootImage->bootImageLength)) {
+        size_t const chunkSize = MIN(pBootImage->bootImageLength - offset, signingChunkSize);
+
+        result = pCopyFunction(pDest + offset, srcOffset + offset, chunkSize);
+        if (result) {
+            HSS_Boot_Secure_StreamUpdate(chunkSize);
+        }
+        offset += chunkSize;
+    }
+#else
+    (void)signingChunkSize;
     result = pCopyFunction(pDest, srcOffset, pBootImage->bootImageLength);
+#endif
+    mHSS_BOOT_PHASE_END(phase);
 
     return result;
 }
@@ -359,17 +579,13 @@ static inline bool verifyMagic_(struct HSS_BootImage const * const pBootImage)
     return result;
 }
 
-static bool getBootImageFromMMC_(struct HSS_Storage *pStorage, struct HSS_BootImage **ppBootImage)
+#if IS_ENABLED(CONFIG_SERVICE_MMC)
+//
+// returns the byte offset of the boot image on MMC, from the GPT if enabled
+//
+static size_t getMMCBootImageOffset_(struct HSS_Storage *pStorage)
 {
     bool result = false;
-
-#if IS_ENABLED(CONFIG_SERVICE_MMC)
-    assert(ppBootImage);
-
-    // if we are using MMC, then we need to do an initial copy of the
-    // boot header into our structure, for subsequent use
-    mHSS_DEBUG_PRINTF(LOG_NORMAL, "Preparing to copy from MMC to DDR ..." CRLF);
-
     size_t srcLBAOffset = 0u;
     assert(pStorage);
 
@@ -411,16 +627,33 @@ static bool getBootImageFromMMC_(struct HSS_Storage *pStorage, struct HSS_BootIm
     } else {
         //mHSS_DEBUG_PRINTF(LOG_WARN, "GPT_PartitionIdToLBAOffset() returned %lu" CRLF, srcLBAOffset);
     }
+# else
+    (void)result;
+# endif
+
+    return srcLBAOffset * blockSize;
+}
 #endif
 
+static bool getBootImageFromMMC_(struct HSS_Storage *pStorage, struct HSS_BootImage **ppBootImage)
+{
+    bool result = false;
+
+#if IS_ENABLED(CONFIG_SERVICE_MMC)
+    assert(ppBootImage);
+
+    // if we are using MMC, then we need to do an initial copy of the
+    // boot header into our structure, for subsequent use
+    mHSS_DEBUG_PRINTF(LOG_NORMAL, "Preparing to copy from MMC to DDR ..." CRLF);
+
     //
     // Even if we have GPT enabled and it fails to find a GPT parttion, we'll still
     // try to boot
+    size_t const srcOffset = getMMCBootImageOffset_(pStorage);
     {
         mHSS_DEBUG_PRINTF(LOG_NORMAL, "Attempting to read image header (%d bytes) ..." CRLF,
             sizeof(struct HSS_BootImage));
-        result = HSS_MMC_ReadBlock(&bootImage, srcLBAOffset * blockSize,
-            sizeof(struct HSS_BootImage));
+        result = HSS_MMC_ReadBlock(&bootImage, srcOffset, sizeof(struct HSS_BootImage));
 
         if (!result) {
             mHSS_DEBUG_PRINTF(LOG_ERROR, "HSS_MMC_ReadBlock() failed" CRLF);
@@ -434,8 +667,8 @@ static bool getBootImageFromMMC_(struct HSS_Storage *pStorage, struct HSS_BootIm
                 HSS_PerfCtr_Allocate(&perf_ctr_index, "Boot Image MMC Copy");
 
                 result = copyBootImageToDDR_(&bootImage,
-                    (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR), srcLBAOffset * blockSize,
-                    HSS_MMC_ReadBlock);
+                    (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR), srcOffset,
+                    HSS_MMC_ReadBlock, BOOT_SIGNING_MMC_CHUNK_SIZE);
                 *ppBootImage = (struct HSS_BootImage *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR);
 
                 HSS_PerfCtr_Lap(perf_ctr_index);
@@ -495,7 +728,7 @@ static bool getBootImageFromQSPI_(struct HSS_Storage *pStorage, struct HSS_BootI
 
             result = copyBootImageToDDR_(&bootImage,
                 (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR), srcLBAOffset * blockSize,
-                HSS_QSPI_ReadBlock);
+                HSS_QSPI_ReadBlock, BOOT_SIGNING_CHUNK_SIZE);
             *ppBootImage = (struct HSS_BootImage *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR);
 
             HSS_PerfCtr_Lap(perf_ctr_index);
@@ -587,7 +820,7 @@ static bool getBootImageFromSpiFlash_(struct HSS_Storage *pStorage, struct HSS_B
     }
 
     result = copyBootImageToDDR_(&bootImage, (char *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR),
-        srcOffset, spiFlashReadBlock_);
+        srcOffset, spiFlashReadBlock_, BOOT_SIGNING_CHUNK_SIZE);
     *ppBootImage = (struct HSS_BootImage *)(CONFIG_SERVICE_BOOT_DDR_TARGET_ADDR);
 #endif
 
@@ -604,6 +837,86 @@ void HSS_BootSelectSPI(void)
 #endif
 }
 
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_CONCURRENT_PROBE)
+//
+// a header is valid if its magic is, and (for an uncompressed image) its header CRC
+//
+static bool probeHeaderIsValid_(struct HSS_BootImage *pHeader)
+{
+    bool result = verifyMagic_(pHeader);
+
+    if (result && (pHeader->magic == mHSS_BOOT_MAGIC)) {
+        result = validateCrc_(pHeader);
+    }
+
+    return result;
+}
+
+static bool probeBootImageFromQSPI_(struct HSS_Storage *pStorage, struct HSS_BootImage *pHeader)
+{
+    bool result = false;
+    (void)pStorage;
+
+# if IS_ENABLED(CONFIG_SERVICE_QSPI)
+    result = HSS_QSPI_ReadBlock(pHeader, 0u, sizeof(struct HSS_BootImage))
+        && probeHeaderIsValid_(pHeader);
+# else
+    (void)pHeader;
+# endif
+
+    return result;
+}
+
+static bool probeBootImageFromMMC_(struct HSS_Storage *pStorage, struct HSS_BootImage *pHeader)
+{
+    bool result = false;
+
+# if IS_ENABLED(CONFIG_SERVICE_MMC)
+    result = HSS_MMC_ReadBlock(pHeader, getMMCBootImageOffset_(pStorage), sizeof(struct HSS_BootImage))
+        && probeHeaderIsValid_(pHeader);
+# else
+    (void)pStorage;
+    (void)pHeader;
+# endif
+
+    return result;
+}
+
+static bool probeBootImageFromSpiFlash_(struct HSS_Storage *pStorage, struct HSS_BootImage *pHeader)
+{
+    bool result = false;
+    (void)pStorage;
+
+# if IS_ENABLED(CONFIG_SERVICE_SPI)
+    MSS_SYS_select_service_mode(MSS_SYS_SERVICE_POLLING_MODE, NULL);
+
+    result = spiFlashReadBlock_(pHeader, CONFIG_SERVICE_BOOT_SPI_FLASH_OFFSET, sizeof(struct HSS_BootImage))
+        && probeHeaderIsValid_(pHeader);
+# else
+    (void)pHeader;
+# endif
+
+    return result;
+}
+
+static bool probeBootImageFromPayload_(struct HSS_Storage *pStorage, struct HSS_BootImage *pHeader)
+{
+    bool result = false;
+    (void)pStorage;
+
+# if IS_ENABLED(CONFIG_SERVICE_BOOT_USE_PAYLOAD)
+    extern struct HSS_BootImage _payload_start;
+
+    *pHeader = _payload_start;
+    result = probeHeaderIsValid_(pHeader);
+# else
+    (void)pHeader;
+# endif
+
+    return result;
+}
+#endif
+
 bool HSS_Storage_Init(void);
 bool HSS_Storage_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount);
 bool HSS_Storage_WriteBlock(size_t dstOffset, void *pSrc, size_t byteCount);
@@ -40,11 +40,11 @@
 #include "hss_progress.h"
 
 #include <assert.h>
+#include <string.h>
 
-int HSS_Decompress(const void* pInputBuffer, void* pOutputBuffer)
+static bool validateHeader_(struct HSS_CompressedImage compressedImageHdr)
 {
-    int result = 0;
-    struct HSS_CompressedImage compressedImageHdr = *(struct HSS_CompressedImage *)pInputBuffer;
+    bool result = false;
 
     if (compressedImageHdr.magic != mHSS_COMPRESSED_MAGIC) {
         mHSS_DEBUG_PRINTF(LOG_NORMAL, "Compressed Image is missing magic value (%08x vs %08x)" CRLF,
@@ -62,20 +62,142 @@ int HSS_Decompress(const void* pInputBuffer, void* pOutputBuffer)
         if (originalCrc != compressedCrc) {
             mHSS_DEBUG_PRINTF(LOG_NORMAL, "Compressed Image failed CRC check" CRLF);
         } else {
-            const uint8_t *pByteOffset = pInputBuffer;
-            pByteOffset += sizeof(struct HSS_CompressedImage);
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+int HSS_Decompress(const void* pInputBuffer, void* pOutputBuffer)
+{
+    int result = 0;
+    struct HSS_CompressedImage compressedImageHdr = *(struct HSS_CompressedImage *)pInputBuffer;
+
+    if (validateHeader_(compressedImageHdr)) {
+        const uint8_t *pByteOffset = pInputBuffer;
+        pByteOffset += sizeof(struct HSS_CompressedImage);
+
+        mHSS_DEBUG_PRINTF(LOG_NORMAL, "Decompressing from %p to %p" CRLF, pByteOffset, pOutputBuffer);
+
+        size_t decompressedOutputSize = (size_t)compressedImageHdr.originalImageLen;
+        result = mz_uncompress(
+            (void *)pOutputBuffer, &decompressedOutputSize,
+            (const void *)pByteOffset, (int)compressedImageHdr.compressedImageLen);
+    }
+
+    return result;
+}
 
-            mHSS_DEBUG_PRINTF(LOG_NORMAL, "Decompressing from %p to %p" CRLF, pByteOffset, pOutputBuffer);
+#if IS_ENABLED(CONFIG_COMPRESSION_STREAMING)
+//
+// Streaming decompression reads the compressed image from storage one window at a time,
+// and feeds each window to the tinfl incremental inflator. As the output buffer is large
+// enough to hold the entire decompressed image, no separate dictionary buffer is needed.
+//
+// The window size is a multiple of the MMC sector size, so every read after the first
+// remains sector aligned provided the initial source offset is.
+//
+#if (CONFIG_COMPRESSION_STREAM_WINDOW_SIZE % 512) != 0
+#  error CONFIG_COMPRESSION_STREAM_WINDOW_SIZE must be a multiple of 512
+#endif
+
+static tinfl_decompressor inflator_;
+static uint8_t streamWindow_[CONFIG_COMPRESSION_STREAM_WINDOW_SIZE] __attribute__((aligned(8)));
+
+size_t HSS_DecompressFromStorage(HSS_DecompressReadFnPtr_t pReadFunction, size_t srcOffset,
+    void* pOutputBuffer)
+{
+    size_t result = 0u;
+    struct HSS_CompressedImage compressedImageHdr;
+
+    assert(pReadFunction);
+    assert(pOutputBuffer);
+
+    size_t const headerLen = sizeof(struct HSS_CompressedImage);
+
+    if (!pReadFunction(streamWindow_, srcOffset, headerLen)) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Failed to read compressed image header" CRLF);
+        return 0u;
+    }
+
+    memcpy(&compressedImageHdr, streamWindow_, headerLen);
+    if (!validateHeader_(compressedImageHdr)) {
+        return 0u;
+    }
+
+    // nothing past the end of the image is read, as the image may end the storage; the
+    // first window re-reads the header, so that every window starts sector aligned
+    size_t const totalLen = headerLen + compressedImageHdr.compressedImageLen;
+    size_t windowLen = MIN(sizeof(streamWindow_), totalLen);
+
+    if (!pReadFunction(streamWindow_, srcOffset, windowLen)) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Failed to read compressed image at offset 0x%lx" CRLF,
+            srcOffset);
+        return 0u;
+    }
 
-            size_t decompressedOutputSize = (size_t)compressedImageHdr.originalImageLen;
-            result = mz_uncompress(
-                (void *)pOutputBuffer, &decompressedOutputSize,
-                (const void *)pByteOffset, (int)compressedImageHdr.compressedImageLen);
+    size_t windowOffset = headerLen;
+    size_t srcCursor = srcOffset + windowLen;
+    size_t inputRemaining = totalLen - windowLen;
+
+    uint8_t * const pOutStart = (uint8_t *)pOutputBuffer;
+    uint8_t *pOut = pOutStart;
+    size_t outputRemaining = compressedImageHdr.originalImageLen;
+
+    mHSS_DEBUG_PRINTF(LOG_NORMAL, "Streaming decompression from offset 0x%lx to %p" CRLF,
+        srcOffset, pOutputBuffer);
+
+    tinfl_status status;
+    tinfl_init(&inflator_);
+
+    do {
+        size_t inBytes = windowLen - windowOffset;
+        size_t outBytes = outputRemaining;
+        mz_uint32 flags = TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF;
+
+        if (inputRemaining) {
+            flags |= TINFL_FLAG_HAS_MORE_INPUT;
         }
+
+        status = tinfl_decompress(&inflator_, &streamWindow_[windowOffset], &inBytes,
+            pOutStart, pOut, &outBytes, flags);
+
+        windowOffset += inBytes;
+        pOut += outBytes;
+        outputRemaining -= outBytes;
+
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT) {
+            windowLen = MIN(sizeof(streamWindow_), inputRemaining);
+
+            if (!windowLen || !pReadFunction(streamWindow_, srcCursor, windowLen)) {
+                mHSS_DEBUG_PRINTF(LOG_ERROR, "Failed to read compressed image at offset 0x%lx" CRLF,
+                    srcCursor);
+                status = TINFL_STATUS_FAILED;
+            } else {
+                srcCursor += windowLen;
+                inputRemaining -= windowLen;
+                windowOffset = 0u;
+                HSS_ShowProgress(totalLen, inputRemaining);
+            }
+        } else if (status == TINFL_STATUS_HAS_MORE_OUTPUT) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "Decompressed image exceeds %lu bytes" CRLF,
+                compressedImageHdr.originalImageLen);
+            status = TINFL_STATUS_FAILED;
+        }
+    } while (status > TINFL_STATUS_DONE);
+
+    HSS_ShowProgress(totalLen, 0u);
+
+    if (status == TINFL_STATUS_DONE) {
+        result = (size_t)(pOut - pOutStart);
+    } else {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Streaming decompression failed (status %d)" CRLF, status);
     }
 
     return result;
 }
+#endif
 
 #include <stdlib.h>
 
@@ -35,6 +35,12 @@ extern "C" {
 
 int HSS_Decompress(const void* pInputBuffer, void* pOutputBuffer);
 
+#if IS_ENABLED(CONFIG_COMPRESSION_STREAMING)
+typedef bool (*HSS_DecompressReadFnPtr_t)(void *pDest, size_t srcOffset, size_t byteCount);
+size_t HSS_DecompressFromStorage(HSS_DecompressReadFnPtr_t pReadFunction, size_t srcOffset,
+    void* pOutputBuffer);
+#endif
+
 #if defined (__cplusplus)
 }
 #endif
@@ -0,0 +1,122 @@
+/******************************************************************************************
+ *
+ * MPFS HSS Embedded Software
+ *
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*\!
+ *\file Image Signing Crypto
+ *\brief Image Signing Crypto
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_debug.h"
+
+#include "hss_crypto.h"
+
+#include <assert.h>
+
+// in order of preference
+static struct HSS_Crypto_Backend const * const backends_[] = {
+#if IS_ENABLED(CONFIG_CRYPTO_USER_CRYPTO)
+    &HSS_Crypto_CAL_Backend,
+#endif
+#if IS_ENABLED(CONFIG_CRYPTO_LIBECC)
+    &HSS_Crypto_Libecc_Backend,
+#endif
+};
+
+static struct HSS_Crypto_Backend const *crypto_get_backend_(void)
+{
+    static struct HSS_Crypto_Backend const *pBackend = NULL;
+
+    if (!pBackend) {
+        for (size_t i = 0u; i < ARRAY_SIZE(backends_); i++) {
+            if (backends_[i]->probe()) {
+                pBackend = backends_[i];
+                mHSS_DEBUG_PRINTF(LOG_STATUS, "Using %s for code signing" CRLF, pBackend->name);
+                break;
+            }
+        }
+
+        if (!pBackend) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "No crypto backend available" CRLF);
+        }
+    }
+
+    return pBackend;
+}
+
+bool HSS_Crypto_Verify_ECDSA_P384_Init(const size_t siglen, uint8_t sigBuffer[siglen], const size_t dataSize)
+{
+    bool result = false;
+    struct HSS_Crypto_Backend const * const pBackend = crypto_get_backend_();
+
+    if (pBackend) {
+        result = pBackend->verifyInit(siglen, sigBuffer, dataSize);
+    }
+
+    return result;
+}
+
+bool HSS_Crypto_Verify_ECDSA_P384_Update(const size_t dataBufSize, uint8_t dataBuf[dataBufSize])
+{
+    bool result = false;
+    struct HSS_Crypto_Backend const * const pBackend = crypto_get_backend_();
+
+    if (pBackend) {
+        result = pBackend->verifyUpdate(dataBufSize, dataBuf);
+    }
+
+    return result;
+}
+
+bool HSS_Crypto_Verify_ECDSA_P384_Finalize(void)
+{
+    bool result = false;
+    struct HSS_Crypto_Backend const * const pBackend = crypto_get_backend_();
+
+    if (pBackend) {
+        result = pBackend->verifyFinalize();
+    }
+
+    return result;
+}
+
+bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen],
+    const size_t dataBufSize, uint8_t dataBuf[dataBufSize])
+{
+    bool result = HSS_Crypto_Verify_ECDSA_P384_Init(siglen, sigBuffer, dataBufSize);
+
+    if (result) {
+        result = HSS_Crypto_Verify_ECDSA_P384_Update(dataBufSize, dataBuf);
+    }
+
+    if (result) {
+        result = HSS_Crypto_Verify_ECDSA_P384_Finalize();
+    }
+
+    return result;
+}
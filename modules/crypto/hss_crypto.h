@@ -29,12 +29,43 @@
  *
  */
 
+#include "config.h"
+#include "hss_types.h"
+
 #if defined (__cplusplus)
 extern "C" {
 #endif
 
 bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen], const size_t dataBufSize, uint8_t dataBuf[dataBufSize]);
 
+//
+// Streaming verification, for when the signed data arrives in pieces: the signature and
+// total data size are passed to init, the data (in order) to update, and finalize returns
+// true if the signature matches. Only one verification can be in progress at a time.
+//
+bool HSS_Crypto_Verify_ECDSA_P384_Init(const size_t siglen, uint8_t sigBuffer[siglen], const size_t dataSize);
+bool HSS_Crypto_Verify_ECDSA_P384_Update(const size_t dataBufSize, uint8_t dataBuf[dataBufSize]);
+bool HSS_Crypto_Verify_ECDSA_P384_Finalize(void);
+
+//
+// Each crypto library is wrapped as a backend. Where more than one is built in, the first
+// whose probe succeeds is used, so hardware is preferred to software when it is present.
+//
+struct HSS_Crypto_Backend {
+    char const * const name;
+    bool (* const probe)(void);
+    bool (* const verifyInit)(const size_t siglen, uint8_t sigBuffer[siglen], const size_t dataSize);
+    bool (* const verifyUpdate)(const size_t dataBufSize, uint8_t dataBuf[dataBufSize]);
+    bool (* const verifyFinalize)(void);
+};
+
+#if IS_ENABLED(CONFIG_CRYPTO_USER_CRYPTO)
+extern const struct HSS_Crypto_Backend HSS_Crypto_CAL_Backend;
+#endif
+#if IS_ENABLED(CONFIG_CRYPTO_LIBECC)
+extern const struct HSS_Crypto_Backend HSS_Crypto_Libecc_Backend;
+#endif
+
 #if defined (__cplusplus)
 }
 #endif
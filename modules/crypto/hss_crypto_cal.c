@@ -42,17 +42,8 @@
 #include "calini.h"
 #include "calenum.h"
 #include "hash.h"
-
-static void crypto_init_(void)
-{
-    static bool initialized = false;
-
-    if (!initialized) {
-        SATR retval = CALIni();
-        assert(retval == SATR_SUCCESS);
-        initialized = true;
-    }
-}
+#include "mss_peripherals.h"
+#include "mpfs_reg_map.h"
 
 // Required constants
 const SATUINT32_t P384_Gx[] = {
@@ -77,6 +68,14 @@ const SATUINT32_t P384_b[] = {
 };
 
 
+const SATUINT32_t P384_p[] = {
+
+    0xffffffff, 0x00000000, 0x00000000, 0xffffffff,
+    0xfffffffe, 0xffffffff, 0xffffffff, 0xffffffff,
+    0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff
+};
+
+
 const SATUINT32_t P384_n[] = {
 
     0xccc52973, 0xecec196a, 0x48b0a77a, 0x581a0db2,
@@ -93,12 +92,12 @@ const SATUINT32_t P384_npc[] = {
     0x00000001
 };
 
-bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen], const size_t dataBufSize, uint8_t dataBuf[dataBufSize])
+#define ECDSA_P384_SIG_LEN  96
+#define SHA384_DIGEST_SIZE  48
+
+static bool cal_get_public_key_(uint32_t pubKey[ECDSA_P384_SIG_LEN / sizeof(uint32_t)])
 {
     bool result = false;
-    SATR retval;
-
-    crypto_init_();
 
     //
     // X5.09 ASN.1 DER keys are of the format
@@ -127,6 +126,7 @@ bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen]
     //           :     xx xx xx xx xx xx xx xx xx xx xx xx xx xx xx xx
     //           :   }
     //
+#    define X509_ASN1_DER_KEY_OFFSET (24)
 #    include "x509-ec-secp384r1-public.h"
 
     const char x509_asn1_ec_der_p384_root[] = {
@@ -138,29 +138,117 @@ bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen]
         mHSS_DEBUG_PRINTF(LOG_ERROR, "invalid signing certificate type" CRLF);
         result = false;
     } else {
-#define SHA384_DIGEST_SIZE  48
-#define P384_MOD 0 //TODO REMOVE
-        uint8_t hashBuffer[SHA384_DIGEST_SIZE];
-        retval = CALHash(SATHASHTYPE_SHA384, dataBuf, dataBufSize, hashBuffer);
+        memcpy(pubKey, &SECP384R1_ECDSA_public_key[X509_ASN1_DER_KEY_OFFSET], ECDSA_P384_SIG_LEN);
+        result = true;
+    }
 
-        if (retval == SATR_SUCCESS) {
-            retval = CALPKTrfRes(SAT_TRUE);
+    return result;
+}
+
+//
+// Devices without the User Crypto core have it disabled in the device configuration
+// loaded by the system controller, and accessing the core there may hang rather than
+// fail, so that is checked before it is brought out of reset and the CAL initialized
+//
+static bool cal_probe_(void)
+{
+    bool result = false;
+
+    if (mHSS_ReadRegU32(SYSREGSCB, DEVICE_CONFIG_CR) & SYSREGSCB_DEVICE_CONFIG_CR_CRYPTO_DISABLE_MASK) {
+        mHSS_DEBUG_PRINTF(LOG_NORMAL, "User Crypto core not present" CRLF);
+    } else {
+        (void)mss_config_clk_rst(MSS_PERIPH_ATHENA, (uint8_t)0u, PERIPHERAL_ON);
+        result = (CALIni() == SATR_SUCCESS);
+    }
+
+    return result;
+}
+
+//
+// The hash engine is fed each piece of the signed data as it arrives, through the CAL's
+// multiple call hash functions, so only the ECDSA verification is left for finalize.
+//
+// The result of each CALHashWrite() is not collected until the next piece arrives (or
+// finalize), so the engine hashes one piece while the caller copies in the next. Pieces
+// are the boot image in place in DDR, so they are not touched while being hashed.
+//
+static struct {
+    uint32_t sig[ECDSA_P384_SIG_LEN / sizeof(uint32_t)];
+    bool active;
+    bool writePending;
+} verify_;
+
+static bool cal_hash_write_complete_(void)
+{
+    bool result = true;
+
+    if (verify_.writePending) {
+        verify_.writePending = false;
+        result = (CALPKTrfRes(SAT_TRUE) == SATR_SUCCESS);
+    }
+
+    return result;
+}
+
+static bool cal_verify_init_(const size_t siglen, uint8_t sigBuffer[siglen], const size_t dataSize)
+{
+    bool result = false;
+
+    assert(siglen == ECDSA_P384_SIG_LEN);
 
-            uint32_t u32SigBuffer[96/sizeof(uint32_t)];
-            memcpy(u32SigBuffer, sigBuffer, 96);
+    // an abandoned verification may have left a write outstanding
+    (void)cal_hash_write_complete_();
+    verify_.active = false;
 
-            uint32_t u32PubKeyBuffer[96/sizeof(uint32_t)];
-            memcpy(u32PubKeyBuffer, &(x509_asn1_ec_der_p384_root[24]), 96);
+    if (dataSize > UINT32_MAX) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "signed data too large for hash engine" CRLF);
+    } else {
+        memcpy(verify_.sig, sigBuffer, ECDSA_P384_SIG_LEN);
+        result = (CALHashIni(SATHASHTYPE_SHA384, (SATUINT32_t)dataSize) == SATR_SUCCESS);
+        verify_.active = result;
+    }
+
+    return result;
+}
+
+static bool cal_verify_update_(const size_t dataBufSize, uint8_t dataBuf[dataBufSize])
+{
+    bool result = false;
+
+    if (verify_.active) {
+        result = cal_hash_write_complete_()
+            && (CALHashWrite(dataBuf, (SATUINT32_t)dataBufSize) == SATR_SUCCESS);
+        verify_.writePending = result;
+        verify_.active = result;
+    }
+
+    return result;
+}
+
+static bool cal_verify_finalize_(void)
+{
+    bool result = false;
+    SATR retval;
+
+    if (verify_.active) {
+        verify_.active = false;
+
+        uint32_t hashBuffer[SHA384_DIGEST_SIZE / sizeof(uint32_t)];
+        uint32_t pubKey[ECDSA_P384_SIG_LEN / sizeof(uint32_t)];
+
+        if (cal_hash_write_complete_() && cal_get_public_key_(pubKey)
+                && (CALHashRead(hashBuffer) == SATR_SUCCESS)) {
+            retval = CALPKTrfRes(SAT_TRUE);
 
             if (retval == SATR_SUCCESS) {
                 // signature is composed of (r, s)
-                uint32_t *sigR = &(u32SigBuffer[0]), *sigS = &(u32SigBuffer[96/(sizeof(uint32_t)*2)]);
+                uint32_t *sigR = &(verify_.sig[0]), *sigS = &(verify_.sig[ECDSA_P384_SIG_LEN/(sizeof(uint32_t)*2)]);
 
                 // public key, after 24-byte header, is composed of (x, y)
-                uint32_t *pubKeyX = &(u32PubKeyBuffer[0]), *pubKeyY = &(u32PubKeyBuffer[96/(sizeof(uint32_t)*2)]);
+                uint32_t *pubKeyX = &(pubKey[0]), *pubKeyY = &(pubKey[ECDSA_P384_SIG_LEN/(sizeof(uint32_t)*2)]);
 
-                retval = CALECDSAVerify((const uint32_t *)hashBuffer, P384_Gx, P384_Gy, pubKeyX, pubKeyY,
-                    sigR, sigS, P384_b, P384_MOD, SAT_NULL, P384_n, P384_npc, SHA384_DIGEST_SIZE, SAT_FALSE);
+                retval = CALECDSAVerify(hashBuffer, P384_Gx, P384_Gy, pubKeyX, pubKeyY,
+                    sigR, sigS, P384_b, P384_p, SAT_NULL, P384_n, P384_npc, SHA384_DIGEST_SIZE, SAT_FALSE);
 
                 if (retval == SATR_SUCCESS) {
                     retval = CALPKTrfRes(SAT_TRUE);
@@ -174,3 +262,11 @@ bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen]
 
     return result;
 }
+
+const struct HSS_Crypto_Backend HSS_Crypto_CAL_Backend = {
+    .name = "User Crypto",
+    .probe = cal_probe_,
+    .verifyInit = cal_verify_init_,
+    .verifyUpdate = cal_verify_update_,
+    .verifyFinalize = cal_verify_finalize_,
+};
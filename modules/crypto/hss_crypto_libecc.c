@@ -47,13 +47,29 @@
 #pragma GCC diagnostic pop
 
 #define ECDSA_P384_SIG_LEN ((384u/8)*2)
-bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen],
-    const size_t dataBufSize, uint8_t dataBuf[dataBufSize])
+
+// a single verification can be in progress at a time. The context refers to the public
+// key, so both must outlive it
+static struct ec_verify_context verifyCtx_;
+static ec_pub_key pubKey_;
+static bool verifyActive_ = false;
+
+// software only, so always available
+static bool libecc_probe_(void)
+{
+    return true;
+}
+
+static bool libecc_verify_init_(const size_t siglen, uint8_t sigBuffer[siglen], const size_t dataSize)
 {
     bool result = false;
 
+    (void)dataSize;
+
     assert(siglen == ECDSA_P384_SIG_LEN);
 
+    verifyActive_ = false;
+
     //
     // X5.09 ASN.1 DER keys are of the format
     //
@@ -99,8 +115,7 @@ bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen]
         uint8_t const curve_name[] = "SECP384R1";
         const ec_str_params *p_str_params = ec_get_curve_params_by_name(&curve_name[0], ARRAY_SIZE(curve_name));
 
-        ec_pub_key pub_key;
-        ec_params params;
+        static ec_params params;
         uint8_t u8siglen;
 
         import_params(&params, p_str_params);
@@ -119,7 +134,7 @@ bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen]
                 mHSS_DEBUG_PRINTF(LOG_ERROR, "ec_check_curve_type_and_name returned %d" CRLF, retval);
                 result = false;
             } else {
-                retval = ec_pub_key_import_from_aff_buf(&pub_key, &params,
+                retval = ec_pub_key_import_from_aff_buf(&pubKey_, &params,
                     (const uint8_t *)&SECP384R1_ECDSA_public_key[X509_ASN1_DER_KEY_OFFSET],
                     ARRAY_SIZE(SECP384R1_ECDSA_public_key) - X509_ASN1_DER_KEY_OFFSET, ECDSA);
 
@@ -127,10 +142,17 @@ bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen]
                     mHSS_DEBUG_PRINTF(LOG_ERROR, "ec_pub_key_import_from_aff_buf returned %d" CRLF, retval);
                     result = false;
                 } else {
-                    int libecc_result = ec_verify(sigBuffer, u8siglen, &pub_key, dataBuf, dataBufSize,
+                    // the signature is parsed here, but only checked by finalize
+                    retval = ec_verify_init(&verifyCtx_, &pubKey_, sigBuffer, u8siglen,
                         ECDSA, SHA384, aDataBuf, aDataBufSize);
 
-                    result = (libecc_result == 0) ? true : false;
+                    if (retval) {
+                        mHSS_DEBUG_PRINTF(LOG_ERROR, "ec_verify_init returned %d" CRLF, retval);
+                        result = false;
+                    } else {
+                        verifyActive_ = true;
+                        result = true;
+                    }
                 }
             }
         }
@@ -138,3 +160,46 @@ bool HSS_Crypto_Verify_ECDSA_P384(const size_t siglen, uint8_t sigBuffer[siglen]
 
     return result;
 }
+
+static bool libecc_verify_update_(const size_t dataBufSize, uint8_t dataBuf[dataBufSize])
+{
+    bool result = false;
+
+    if (verifyActive_) {
+        // libecc takes 32-bit lengths, so feed very large regions in pieces
+        size_t offset = 0u;
+
+        result = true;
+        while (result && (offset < dataBufSize)) {
+            uint32_t const chunkSize = (uint32_t)MIN(dataBufSize - offset, (size_t)UINT32_MAX);
+
+            result = (ec_verify_update(&verifyCtx_, &dataBuf[offset], chunkSize) == 0);
+            offset += chunkSize;
+        }
+
+        // on error, libecc has already cleared the context
+        verifyActive_ = result;
+    }
+
+    return result;
+}
+
+static bool libecc_verify_finalize_(void)
+{
+    bool result = false;
+
+    if (verifyActive_) {
+        result = (ec_verify_finalize(&verifyCtx_) == 0);
+        verifyActive_ = false;
+    }
+
+    return result;
+}
+
+const struct HSS_Crypto_Backend HSS_Crypto_Libecc_Backend = {
+    .name = "libecc",
+    .probe = libecc_probe_,
+    .verifyInit = libecc_verify_init_,
+    .verifyUpdate = libecc_verify_update_,
+    .verifyFinalize = libecc_verify_finalize_,
+};
@@ -0,0 +1,207 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/**
+ * \file Boot Timeline
+ * \brief Boot Timeline
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_debug.h"
+#include "hss_clock.h"
+#include "hss_boot_timeline.h"
+#include "csr_helper.h"
+
+#include <assert.h>
+#include <string.h>
+
+#define BOOT_TIMELINE_NUM_PHASES    ((uint32_t)CONFIG_DEBUG_BOOT_TIMELINE_NUM_PHASES)
+#define BOOT_TIMELINE_MAX_DEPTH     (8u)
+
+static struct {
+    struct HSSBootTimeline header;
+    struct HSSBootPhase phases[BOOT_TIMELINE_NUM_PHASES];
+} timeline_ = {
+    .header = {
+        .magic = HSS_BOOT_TIMELINE_MAGIC,
+        .version = HSS_BOOT_TIMELINE_VERSION,
+        .phaseSize = (uint16_t)sizeof(struct HSSBootPhase),
+        .ticksPerSec = TICKS_PER_SEC,
+        .numPhases = 0u,
+        .numDropped = 0u,
+    },
+};
+
+// slots are claimed with a single atomic add, so any hart can record phases
+static uint32_t nextPhase_ = 0u;
+
+// per-hart stack of open (non-async) phases, giving the nesting depth
+static HSSBootPhaseHandle_t phaseStack_[MAX_NUM_HARTS][BOOT_TIMELINE_MAX_DEPTH];
+static uint8_t phaseDepth_[MAX_NUM_HARTS];
+
+static HSSBootPhaseHandle_t boot_timeline_record_(char const *pName, uint16_t flags)
+{
+    HSSBootPhaseHandle_t result = 0u;
+    uint32_t const index = __atomic_fetch_add(&nextPhase_, 1u, __ATOMIC_RELAXED);
+
+    if (index < BOOT_TIMELINE_NUM_PHASES) {
+        int const hartId = current_hartid();
+        struct HSSBootPhase * const pPhase = &timeline_.phases[index];
+
+        pPhase->startTick = HSS_GetTime();
+        pPhase->endTick = pPhase->startTick;
+        strncpy(pPhase->name, pName, HSS_BOOT_TIMELINE_NAME_LEN - 1u);
+        pPhase->name[HSS_BOOT_TIMELINE_NAME_LEN - 1u] = '\0';
+        pPhase->hartId = (uint8_t)hartId;
+        pPhase->depth = phaseDepth_[hartId];
+        pPhase->flags = flags;
+
+        result = index + 1u;
+    }
+
+    return result;
+}
+
+HSSBootPhaseHandle_t HSS_BootTimeline_Begin(char const *pName)
+{
+    HSSBootPhaseHandle_t const result = boot_timeline_record_(pName, HSS_BOOT_PHASE_FLAG_OPEN);
+    int const hartId = current_hartid();
+
+    // phases nested deeper than the stack are still recorded, but cannot be parents
+    if (result && (phaseDepth_[hartId] < BOOT_TIMELINE_MAX_DEPTH)) {
+        phaseStack_[hartId][phaseDepth_[hartId]] = result;
+        phaseDepth_[hartId]++;
+    }
+
+    return result;
+}
+
+HSSBootPhaseHandle_t HSS_BootTimeline_BeginAsync(char const *pName)
+{
+    return boot_timeline_record_(pName, HSS_BOOT_PHASE_FLAG_OPEN | HSS_BOOT_PHASE_FLAG_ASYNC);
+}
+
+void HSS_BootTimeline_End(HSSBootPhaseHandle_t phase)
+{
+    if (phase && (phase <= BOOT_TIMELINE_NUM_PHASES)) {
+        struct HSSBootPhase * const pPhase = &timeline_.phases[phase - 1u];
+        int const hartId = current_hartid();
+
+        // the table is wiped if RW data and BSS are (re)initialized while a phase is open
+        if (!(pPhase->flags & HSS_BOOT_PHASE_FLAG_OPEN)) {
+            return;
+        }
+
+        pPhase->endTick = HSS_GetTime();
+        pPhase->flags &= (uint16_t)~HSS_BOOT_PHASE_FLAG_OPEN;
+
+        if (!(pPhase->flags & HSS_BOOT_PHASE_FLAG_ASYNC) && phaseDepth_[hartId]) {
+            // nested phases must end innermost first
+            assert(phaseStack_[hartId][phaseDepth_[hartId] - 1u] == phase);
+            phaseDepth_[hartId]--;
+        }
+    }
+}
+
+void HSS_BootTimeline_Mark(char const *pName)
+{
+    (void)boot_timeline_record_(pName, HSS_BOOT_PHASE_FLAG_MARK);
+}
+
+void HSS_BootTimeline_MarkHartEntry(enum HSSHartId hartId)
+{
+    static char const * const entryNames[] = {
+        [ HSS_HART_E51 ]   = "E51 entry",
+        [ HSS_HART_U54_1 ] = "U54_1 entry",
+        [ HSS_HART_U54_2 ] = "U54_2 entry",
+        [ HSS_HART_U54_3 ] = "U54_3 entry",
+        [ HSS_HART_U54_4 ] = "U54_4 entry",
+    };
+
+    if ((unsigned int)hartId < ARRAY_SIZE(entryNames)) {
+        HSS_BootTimeline_Mark(entryNames[hartId]);
+        HSS_BootTimeline_Publish();
+    }
+}
+
+//
+// Publishing is done by the E51 as each hart finishes booting, and by each U54 as it
+// leaves the HSS, so a lock keeps concurrent copies from interleaving
+//
+void HSS_BootTimeline_Publish(void)
+{
+    static int publishLock_ = 0;
+    static bool budgetExceeded_ = false;
+    uint32_t const next = __atomic_load_n(&nextPhase_, __ATOMIC_RELAXED);
+
+    while (__sync_lock_test_and_set(&publishLock_, 1)) {
+        ;
+    }
+
+    timeline_.header.numPhases = MIN(next, BOOT_TIMELINE_NUM_PHASES);
+    timeline_.header.numDropped = next - timeline_.header.numPhases;
+
+#if (CONFIG_DEBUG_BOOT_TIMELINE_PUBLISH_ADDR != 0)
+    memcpy((void *)(uintptr_t)CONFIG_DEBUG_BOOT_TIMELINE_PUBLISH_ADDR, &timeline_,
+        sizeof(timeline_.header) + (timeline_.header.numPhases * sizeof(struct HSSBootPhase)));
+    __sync_synchronize();
+#endif
+
+#if (CONFIG_DEBUG_BOOT_TIMELINE_BUDGET_MSEC != 0)
+    HSSTicks_t lastTick = 0u;
+
+    for (uint32_t i = 0u; i < timeline_.header.numPhases; i++) {
+        if (timeline_.phases[i].endTick > lastTick) {
+            lastTick = timeline_.phases[i].endTick;
+        }
+    }
+
+    if (!budgetExceeded_ && (lastTick > (CONFIG_DEBUG_BOOT_TIMELINE_BUDGET_MSEC * ONE_MILLISEC))) {
+        budgetExceeded_ = true;
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Boot time budget of %lu ms exceeded (%lu ms)" CRLF,
+            (unsigned long)CONFIG_DEBUG_BOOT_TIMELINE_BUDGET_MSEC,
+            (unsigned long)(lastTick / ONE_MILLISEC));
+    }
+#else
+    (void)budgetExceeded_;
+#endif
+
+    __sync_lock_release(&publishLock_);
+}
+
+//
+// The dump is one line per phase, in the order phases were begun, with the phase names
+// indented by nesting depth. Times are in microseconds since reset.
+//
+void HSS_BootTimeline_Dump(void)
+{
+    uint32_t const next = __atomic_load_n(&nextPhase_, __ATOMIC_RELAXED);
+    uint32_t const numPhases = MIN(next, BOOT_TIMELINE_NUM_PHASES);
+    HSSTicks_t const now = HSS_GetTime();
+    static char const indent[2u * BOOT_TIMELINE_MAX_DEPTH + 1u] = "                ";
+
+    mHSS_PRINTF("Boot timeline: %u phases (%u dropped), times in us since reset" CRLF,
+        numPhases, next - numPhases);
+    mHSS_PRINTF("     Start        End   Duration Hart Phase" CRLF);
+
+    for (uint32_t i = 0u; i < numPhases; i++) {
+        struct HSSBootPhase const * const pPhase = &timeline_.phases[i];
+        bool const isOpen = (pPhase->flags & HSS_BOOT_PHASE_FLAG_OPEN);
+        HSSTicks_t const endTick = isOpen ? now : pPhase->endTick;
+        size_t const depth = MIN((size_t)pPhase->depth, (size_t)BOOT_TIMELINE_MAX_DEPTH);
+
+        mHSS_PRINTF("%10lu %10lu %10lu %4u %s%s%s" CRLF,
+            (unsigned long)((pPhase->startTick * 1000u) / TICKS_PER_MILLISEC),
+            (unsigned long)((endTick * 1000u) / TICKS_PER_MILLISEC),
+            (unsigned long)(((endTick - pPhase->startTick) * 1000u) / TICKS_PER_MILLISEC),
+            pPhase->hartId, &indent[2u * (BOOT_TIMELINE_MAX_DEPTH - depth)], pPhase->name,
+            isOpen ? " (open)" : ((pPhase->flags & HSS_BOOT_PHASE_FLAG_MARK) ? " (mark)" : ""));
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef HSS_BOOT_TIMELINE_H
+#define HSS_BOOT_TIMELINE_H
+
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/**
+ * \file Boot Timeline
+ * \brief Boot Timeline
+ *
+ * A table of named boot phases, each with start and end ticks (counted from reset), the
+ * hart that recorded it, and its nesting depth. Phases begun with HSS_BootTimeline_Begin()
+ * nest on the calling hart, and must be ended in reverse order. Phases begun with
+ * HSS_BootTimeline_BeginAsync() (e.g. a per-hart boot state machine) sit under the current
+ * phase, but may overlap others and end in any order. HSS_BootTimeline_Mark() records an
+ * instant, such as a hart's first instruction.
+ *
+ * HSS_BootTimeline_Publish() copies the table to CONFIG_DEBUG_BOOT_TIMELINE_PUBLISH_ADDR
+ * (if non-zero) for a later boot stage to read, and checks it against the boot-time budget.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_clock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HSS_BOOT_TIMELINE_MAGIC         (0x54425348u) // "HSBT"
+#define HSS_BOOT_TIMELINE_VERSION       (1u)
+#define HSS_BOOT_TIMELINE_NAME_LEN      (24u)
+
+#define HSS_BOOT_PHASE_FLAG_OPEN        (1u << 0)
+#define HSS_BOOT_PHASE_FLAG_ASYNC       (1u << 1)
+#define HSS_BOOT_PHASE_FLAG_MARK        (1u << 2)
+
+// keep these layouts stable, as they are read by later boot stages. The published table is
+// a struct HSSBootTimeline, immediately followed by numPhases struct HSSBootPhase entries
+struct HSSBootPhase {
+    uint64_t startTick;
+    uint64_t endTick;
+    char name[HSS_BOOT_TIMELINE_NAME_LEN];
+    uint8_t hartId;
+    uint8_t depth;
+    uint16_t flags;
+    uint32_t reserved;
+};
+
+struct HSSBootTimeline {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t phaseSize;
+    uint64_t ticksPerSec;
+    uint32_t numPhases;
+    uint32_t numDropped;
+};
+
+// phase handles are 1-based, so that zero means "no phase"
+typedef uint32_t HSSBootPhaseHandle_t;
+
+#if IS_ENABLED(CONFIG_DEBUG_BOOT_TIMELINE)
+HSSBootPhaseHandle_t HSS_BootTimeline_Begin(char const *pName);
+HSSBootPhaseHandle_t HSS_BootTimeline_BeginAsync(char const *pName);
+void HSS_BootTimeline_End(HSSBootPhaseHandle_t phase);
+void HSS_BootTimeline_Mark(char const *pName);
+void HSS_BootTimeline_MarkHartEntry(enum HSSHartId hartId);
+void HSS_BootTimeline_Publish(void);
+void HSS_BootTimeline_Dump(void);
+#  define mHSS_BOOT_PHASE_BEGIN(pName)          HSS_BootTimeline_Begin(pName)
+#  define mHSS_BOOT_PHASE_BEGIN_ASYNC(pName)    HSS_BootTimeline_BeginAsync(pName)
+#  define mHSS_BOOT_PHASE_END(phase)            HSS_BootTimeline_End(phase)
+#  define mHSS_BOOT_PHASE_HART_ENTRY(hartId)    HSS_BootTimeline_MarkHartEntry(hartId)
+#  define mHSS_BOOT_PHASE_PUBLISH()             HSS_BootTimeline_Publish()
+#else
+#  define mHSS_BOOT_PHASE_BEGIN(pName)          ((void)(pName), (HSSBootPhaseHandle_t)0u)
+#  define mHSS_BOOT_PHASE_BEGIN_ASYNC(pName)    ((void)(pName), (HSSBootPhaseHandle_t)0u)
+#  define mHSS_BOOT_PHASE_END(phase)            (void)(phase)
+#  define mHSS_BOOT_PHASE_HART_ENTRY(hartId)    (void)(hartId)
+#  define mHSS_BOOT_PHASE_PUBLISH()             (void)0
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -20,18 +20,66 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 #if IS_ENABLED(CONFIG_DEBUG_PERF_CTRS)
-struct {
-    int index;
+//
+// Each Lap records one sample (time since the last Start, or since Allocate).
+// Alongside the running min/max/total, samples are binned into a log2 histogram
+// (bucket n holds samples of [2^n, 2^(n+1)) ticks), from which approximate
+// percentiles are derived.
+//
+#define PERF_CTR_NUM_BUCKETS 32u
+#define PERF_CTR_MAX_DEPTH   8u
+
+static struct {
     char const * pName;
     bool isAllocated;
+    int parent;
     HSSTicks_t startTime;
     HSSTicks_t lapTime;
+    uint32_t count;
+    HSSTicks_t minTime;
+    HSSTicks_t maxTime;
+    HSSTicks_t totalTime;
+    uint32_t histogram[PERF_CTR_NUM_BUCKETS];
 } perfCtrs[CONFIG_DEBUG_PERF_CTRS_NUM];
+
+static void reset_stats_(int index)
+{
+    perfCtrs[index].count = 0u;
+    perfCtrs[index].minTime = (HSSTicks_t)-1;
+    perfCtrs[index].maxTime = 0u;
+    perfCtrs[index].totalTime = 0u;
+    memset(perfCtrs[index].histogram, 0, sizeof(perfCtrs[index].histogram));
+}
+
+static HSSTicks_t get_percentile_(int index, uint32_t percent)
+{
+    HSSTicks_t result = 0u;
+    uint64_t const threshold = ((uint64_t)perfCtrs[index].count * percent + 99u) / 100u;
+    uint64_t cumulative = 0u;
+
+    for (uint32_t bucket = 0u; bucket < PERF_CTR_NUM_BUCKETS; bucket++) {
+        cumulative += perfCtrs[index].histogram[bucket];
+
+        if (cumulative >= threshold) {
+            // report the upper bound of the bucket, but never more than the observed max
+            result = MIN((HSSTicks_t)((2llu << bucket) - 1u), perfCtrs[index].maxTime);
+            break;
+        }
+    }
+
+    return result;
+}
 #endif
 
 bool HSS_PerfCtr_Allocate(int *pIdx, char const * pName)
+{
+    return HSS_PerfCtr_AllocateChild(pIdx, pName, PERF_CTR_UNINITIALIZED);
+}
+
+bool HSS_PerfCtr_AllocateChild(int *pIdx, char const * pName, int parentIdx)
 {
     bool result = false;
 
@@ -44,14 +92,30 @@ bool HSS_PerfCtr_Allocate(int *pIdx, char const * pName)
     } else {
         assert(pIdx);
 
-        *pIdx = PERF_CTR_UNINITIALIZED;
+        *pIdx = PERF_CTR_UNAVAILABLE;
 
         for (int index = 0; index < ARRAY_SIZE(perfCtrs); index++) {
             if (!perfCtrs[index].isAllocated) {
                 perfCtrs[index].isAllocated = true;
                 perfCtrs[index].pName = pName;
+
+                // a parent must be a different, live counter, or the report would walk a
+                // stale or cyclic tree - otherwise this becomes a top-level counter
+                if ((parentIdx >= 0) && (parentIdx < ARRAY_SIZE(perfCtrs))
+                        && (parentIdx != index) && perfCtrs[parentIdx].isAllocated) {
+                    perfCtrs[index].parent = parentIdx;
+                } else {
+                    if (parentIdx >= 0) {
+                        mHSS_DEBUG_PRINTF(LOG_WARN, "invalid parent perf ctr %d for >>%s<<" CRLF,
+                            parentIdx, pName);
+                    }
+                    perfCtrs[index].parent = PERF_CTR_UNINITIALIZED;
+                }
+
+                reset_stats_(index);
                 result = true;
                 perfCtrs[index].startTime = HSS_GetTime();
+                perfCtrs[index].lapTime = perfCtrs[index].startTime;
                 *pIdx = index;
                 break;
             }
@@ -61,6 +125,9 @@ bool HSS_PerfCtr_Allocate(int *pIdx, char const * pName)
             mHSS_DEBUG_PRINTF(LOG_ERROR, "failed to allocate perf ctr for >>%s<<" CRLF, pName);
         }
     }
+#else
+    (void)pName;
+    (void)parentIdx;
 #endif
 
     return result;
@@ -70,11 +137,18 @@ void HSS_PerfCtr_Deallocate(int index)
 {
     if (index != PERF_CTR_UNINITIALIZED) {
 #if IS_ENABLED(CONFIG_DEBUG_PERF_CTRS)
-        assert(index < ARRAY_SIZE(perfCtrs));
+        assert(index < (int)ARRAY_SIZE(perfCtrs));
 
         if ((index >= 0) && (perfCtrs[index].isAllocated)) {
             perfCtrs[index].isAllocated = false;
             perfCtrs[index].pName = NULL;
+
+            // orphaned children become top-level counters
+            for (int i = 0; i < ARRAY_SIZE(perfCtrs); i++) {
+                if (perfCtrs[i].parent == index) {
+                    perfCtrs[i].parent = PERF_CTR_UNINITIALIZED;
+                }
+            }
         }
 #endif
     }
@@ -84,7 +158,7 @@ void HSS_PerfCtr_Start(int index)
 {
     if (index != PERF_CTR_UNINITIALIZED) {
 #if IS_ENABLED(CONFIG_DEBUG_PERF_CTRS)
-        assert(index < ARRAY_SIZE(perfCtrs));
+        assert(index < (int)ARRAY_SIZE(perfCtrs));
         if (index >= 0) {
             perfCtrs[index].startTime = HSS_GetTime();
         }
@@ -96,21 +170,63 @@ void HSS_PerfCtr_Lap(int index)
 {
     if (index != PERF_CTR_UNINITIALIZED) {
 #if IS_ENABLED(CONFIG_DEBUG_PERF_CTRS)
-        assert(index < ARRAY_SIZE(perfCtrs));
+        assert(index < (int)ARRAY_SIZE(perfCtrs));
         if (index >= 0) {
             perfCtrs[index].lapTime = HSS_GetTime();
+            HSS_PerfCtr_Record(index, perfCtrs[index].lapTime - perfCtrs[index].startTime);
+        }
+#endif
+    }
+}
+
+void HSS_PerfCtr_Record(int index, HSSTicks_t ticks)
+{
+    if (index != PERF_CTR_UNINITIALIZED) {
+#if IS_ENABLED(CONFIG_DEBUG_PERF_CTRS)
+        assert(index < (int)ARRAY_SIZE(perfCtrs));
+        if (index >= 0) {
+            uint32_t const bucket = ticks ? MIN(63u - (uint32_t)__builtin_clzll(ticks), PERF_CTR_NUM_BUCKETS - 1u) : 0u;
+
+            perfCtrs[index].count++;
+            perfCtrs[index].totalTime += ticks;
+            perfCtrs[index].minTime = MIN(perfCtrs[index].minTime, ticks);
+            perfCtrs[index].maxTime = MAX(perfCtrs[index].maxTime, ticks);
+            perfCtrs[index].histogram[bucket]++;
         }
+#else
+        (void)ticks;
 #endif
     }
 }
 
+void HSS_PerfCtr_Reset(int index)
+{
+    if (index != PERF_CTR_UNINITIALIZED) {
+#if IS_ENABLED(CONFIG_DEBUG_PERF_CTRS)
+        assert(index < (int)ARRAY_SIZE(perfCtrs));
+        if ((index >= 0) && (perfCtrs[index].isAllocated)) {
+            reset_stats_(index);
+        }
+#endif
+    }
+}
+
+void HSS_PerfCtr_ResetAll(void)
+{
+#if IS_ENABLED(CONFIG_DEBUG_PERF_CTRS)
+    for (int i = 0; i < ARRAY_SIZE(perfCtrs); i++) {
+        HSS_PerfCtr_Reset(i);
+    }
+#endif
+}
+
 HSSTicks_t HSS_PerfCtr_GetTime(int index)
 {
     HSSTicks_t result = 0u;
 
     if (index != PERF_CTR_UNINITIALIZED) {
 #if IS_ENABLED(CONFIG_DEBUG_PERF_CTRS)
-        assert(index < ARRAY_SIZE(perfCtrs));
+        assert(index < (int)ARRAY_SIZE(perfCtrs));
 
         if (index >= 0) {
             result = perfCtrs[index].lapTime - perfCtrs[index].startTime;
@@ -121,17 +237,38 @@ HSSTicks_t HSS_PerfCtr_GetTime(int index)
     return result;
 }
 
-void HSS_PerfCtr_DumpAll(void)
-{
 #if IS_ENABLED(CONFIG_DEBUG_PERF_CTRS)
+static void dump_tree_(int parent, uint32_t depth)
+{
+    static char const indent[] = "                "; // 2 spaces per level, up to PERF_CTR_MAX_DEPTH
+    char const * const pIndent = &indent[sizeof(indent) - 1u - 2u * MIN(depth, PERF_CTR_MAX_DEPTH)];
+
     for (int i = 0; i < ARRAY_SIZE(perfCtrs); i++) {
-        if (perfCtrs[i].isAllocated) {
+        if (perfCtrs[i].isAllocated && (perfCtrs[i].parent == parent)) {
             size_t ticks = HSS_PerfCtr_GetTime(i);
             size_t millisecs = (ticks + (TICKS_PER_MILLISEC/2)) / TICKS_PER_MILLISEC;
 
-            mHSS_DEBUG_PRINTF(LOG_NORMAL, "% 8lu ms (% 8lu ticks) - %s" CRLF,
-                millisecs, ticks, perfCtrs[i].pName ? perfCtrs[i].pName : "(null)");
+            mHSS_DEBUG_PRINTF(LOG_NORMAL, "% 8lu ms (% 8lu ticks) - %s%s" CRLF,
+                millisecs, ticks, pIndent, perfCtrs[i].pName ? perfCtrs[i].pName : "(null)");
+
+            if (perfCtrs[i].count > 1u) {
+                mHSS_DEBUG_PRINTF_EX("%s    n=%u min/mean/max=%lu/%lu/%lu p50/p90/p99<=%lu/%lu/%lu ticks" CRLF,
+                    pIndent, perfCtrs[i].count, perfCtrs[i].minTime,
+                    perfCtrs[i].totalTime / perfCtrs[i].count, perfCtrs[i].maxTime,
+                    get_percentile_(i, 50u), get_percentile_(i, 90u), get_percentile_(i, 99u));
+            }
+
+            if (depth < ARRAY_SIZE(perfCtrs)) {
+                dump_tree_(i, depth + 1u);
+            }
         }
     }
+}
+#endif
+
+void HSS_PerfCtr_DumpAll(void)
+{
+#if IS_ENABLED(CONFIG_DEBUG_PERF_CTRS)
+    dump_tree_(PERF_CTR_UNINITIALIZED, 0u);
 #endif
 }
@@ -23,12 +23,17 @@
 #include <assert.h>
 
 bool HSS_PerfCtr_Allocate(int *pIdx, char const * name) __attribute__((nonnull(1)));
+bool HSS_PerfCtr_AllocateChild(int *pIdx, char const * name, int parentIdx) __attribute__((nonnull(1)));
 void HSS_PerfCtr_Deallocate(int index);
 void HSS_PerfCtr_Start(int index);
 void HSS_PerfCtr_Lap(int index);
+void HSS_PerfCtr_Record(int index, HSSTicks_t ticks);
+void HSS_PerfCtr_Reset(int index);
+void HSS_PerfCtr_ResetAll(void);
 HSSTicks_t HSS_PerfCtr_GetTime(int index);
 void HSS_PerfCtr_DumpAll(void);
 
 #define PERF_CTR_UNINITIALIZED -1
+#define PERF_CTR_UNAVAILABLE   -2 // allocation failed
 
 #endif
@@ -0,0 +1,93 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/**
+ * \file Binary Trace Log
+ * \brief Binary Trace Log
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_debug.h"
+#include "hss_clock.h"
+#include "hss_trace.h"
+#include "hss_state_machine.h"
+#include "ssmb_ipi.h"
+#include "hss_registry.h"
+#include "csr_helper.h"
+
+#include <assert.h>
+
+#if (CONFIG_DEBUG_TRACE_NUM_ENTRIES & (CONFIG_DEBUG_TRACE_NUM_ENTRIES - 1))
+#  error CONFIG_DEBUG_TRACE_NUM_ENTRIES must be a power of 2
+#endif
+
+#define HSS_TRACE_VERSION 1u
+#define HSS_TRACE_INDEX_MASK (CONFIG_DEBUG_TRACE_NUM_ENTRIES - 1u)
+
+static struct HSSTraceEntry traceRing_[CONFIG_DEBUG_TRACE_NUM_ENTRIES];
+static uint32_t traceHead_ = 0u;
+
+//
+// Producers on any hart claim a slot with a single atomic add, so there is no
+// locking. The ring silently overwrites its oldest entries once full.
+//
+void HSS_Trace(enum HSSTraceEvent eventId, uint32_t arg0, uint32_t arg1, uint32_t arg2)
+{
+    uint32_t const index = __atomic_fetch_add(&traceHead_, 1u, __ATOMIC_RELAXED) & HSS_TRACE_INDEX_MASK;
+    struct HSSTraceEntry * const pEntry = &traceRing_[index];
+
+    pEntry->tick = HSS_GetTime();
+    pEntry->eventId = (uint16_t)eventId;
+    pEntry->hartId = (uint8_t)current_hartid();
+    pEntry->args[0] = arg0;
+    pEntry->args[1] = arg1;
+    pEntry->args[2] = arg2;
+}
+
+void HSS_Trace_Clear(void)
+{
+    __atomic_store_n(&traceHead_, 0u, __ATOMIC_RELAXED);
+}
+
+//
+// The dump is line-oriented text so that it can be captured from the console.
+// It starts with a header, then a legend mapping state machine addresses and
+// state indices to names, then the entries from oldest to newest.
+//
+void HSS_Trace_Dump(void)
+{
+    uint32_t const head = __atomic_load_n(&traceHead_, __ATOMIC_RELAXED);
+    uint32_t const numEntries = MIN(head, (uint32_t)CONFIG_DEBUG_TRACE_NUM_ENTRIES);
+
+    mHSS_PRINTF("HSSTRACE %u %llu %u %u" CRLF, HSS_TRACE_VERSION,
+        TICKS_PER_SEC, numEntries, head - numEntries);
+
+    for (size_t i = 0u; i < spanOfPGlobalStateMachines; i++) {
+        struct StateMachine const * const pMachine = pGlobalStateMachines[i];
+
+        if (pMachine && pMachine->pMachineName) {
+            mHSS_PRINTF("M %x %s" CRLF, (uint32_t)(uintptr_t)pMachine, pMachine->pMachineName);
+
+            for (uint32_t state = 0u; state < pMachine->numStates; state++) {
+                mHSS_PRINTF("S %x %u %s" CRLF, (uint32_t)(uintptr_t)pMachine, state,
+                    pMachine->pStateDescs[state].pStateName);
+            }
+        }
+    }
+
+    for (uint32_t i = head - numEntries; i != head; i++) {
+        struct HSSTraceEntry const * const pEntry = &traceRing_[i & HSS_TRACE_INDEX_MASK];
+
+        mHSS_PRINTF("E %llx %x %x %x %x %x" CRLF, pEntry->tick, pEntry->eventId, pEntry->hartId,
+            pEntry->args[0], pEntry->args[1], pEntry->args[2]);
+    }
+
+    mHSS_PRINTF("HSSTRACE END" CRLF);
+}
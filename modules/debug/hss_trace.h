@@ -0,0 +1,63 @@
+#ifndef HSS_TRACE_H
+#define HSS_TRACE_H
+
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/**
+ * \file Binary Trace Log
+ * \brief Binary Trace Log
+ *
+ * A fixed size ring of binary trace entries (event ID, timestamp, hart and three
+ * arguments), cheap enough to leave enabled around timing sensitive code where
+ * mHSS_DEBUG_PRINTF() would perturb what is being debugged. The ring is dumped
+ * as text with HSS_Trace_Dump() (TinyCLI "DEBUG TRACE"), and the dump can be
+ * turned into a timeline with tools/trace-decoder/hss-trace-decode.py.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_clock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// keep in sync with tools/trace-decoder/hss-trace-decode.py
+enum HSSTraceEvent {
+    HSS_TRACE_EVT_NONE,
+    HSS_TRACE_EVT_SM_TRANSITION,        // machine, prevState, newState
+    HSS_TRACE_EVT_IPI_SEND,             // target, msgType, transactionId
+    HSS_TRACE_EVT_IPI_CONSUME,          // source, msgType, transactionId
+    HSS_TRACE_EVT_USER,                 // free for ad-hoc debugging
+    HSS_TRACE_EVT_NUM_EVENTS,
+};
+
+struct HSSTraceEntry {
+    HSSTicks_t tick;
+    uint16_t eventId;
+    uint8_t hartId;
+    uint8_t reserved;
+    uint32_t args[3];
+};
+
+#if IS_ENABLED(CONFIG_DEBUG_TRACE)
+void HSS_Trace(enum HSSTraceEvent eventId, uint32_t arg0, uint32_t arg1, uint32_t arg2);
+void HSS_Trace_Dump(void);
+void HSS_Trace_Clear(void);
+#  define mHSS_TRACE(eventId, arg0, arg1, arg2) HSS_Trace(eventId, arg0, arg1, arg2)
+#else
+#  define mHSS_TRACE(eventId, arg0, arg1, arg2) (void)0
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
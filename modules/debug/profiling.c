@@ -10,96 +10,165 @@
 /**
  * \file Code Profiling
  * \brief Code Profiling
+ *
+ * Each hart records a calling context tree: one node per distinct (parent node,
+ * function) pair, i.e. per caller->callee edge in a given calling context, with
+ * call count and inclusive and exclusive cycle counts. Nodes live in a per-hart
+ * open-addressed hash table, and a per-hart shadow call stack tracks the node,
+ * entry time and time spent in callees of each active frame. Nothing is shared
+ * between harts, so no locking is needed.
+ *
+ * dump_profile() emits one line per node, which tools/profiling/hss-profile-fold.py
+ * turns into folded stacks for flame graphs.
  */
 
 #include "config.h"
 #include "hss_types.h"
+#include "hss_debug.h"
 #include "csr_helper.h"
+#include "profiling.h"
 
 #include <assert.h>
 
+#if (CONFIG_DEBUG_PROFILING_MAX_NUM_FUNCTIONS & (CONFIG_DEBUG_PROFILING_MAX_NUM_FUNCTIONS - 1))
+#  error CONFIG_DEBUG_PROFILING_MAX_NUM_FUNCTIONS must be a power of 2
+#endif
+
+#define PROFILE_HASH_MASK (CONFIG_DEBUG_PROFILING_MAX_NUM_FUNCTIONS - 1u)
+#define PROFILE_NO_NODE   (UINT32_MAX)      // table full, or parent not tracked
+#define PROFILE_ROOT_NODE (UINT32_MAX - 1u) // parent of outermost frames
+
 struct Node {
     void *pFunc;
+    uint32_t parent;
+    uint32_t callCount;
+    uint64_t inclusiveTime;
+    uint64_t exclusiveTime;
+};
+
+struct Frame {
+    uint32_t node;
     uint64_t entryTime;
-    uint64_t timeCount;
-} functionNode[CONFIG_DEBUG_PROFILING_MAX_NUM_FUNCTIONS] = { 0 };
-size_t allocationCount = 0u;
+    uint64_t childTime;
+};
+
+static struct {
+    struct Node node[CONFIG_DEBUG_PROFILING_MAX_NUM_FUNCTIONS];
+    struct Frame stack[CONFIG_DEBUG_PROFILING_MAX_CALL_DEPTH];
+    uint32_t depth;         // may exceed the shadow stack, deeper frames are not tracked
+    uint32_t numNodes;
+    uint32_t numDropped;    // calls not tracked because the table was full
+    bool paused;
+} profile[MAX_NUM_HARTS];
+
+static inline uint32_t __attribute__((no_instrument_function)) find_node_(size_t hartid, void *pFunc,
+    uint32_t parent)
+{
+    uint32_t result = PROFILE_NO_NODE;
+    uint32_t index = (uint32_t)(((uintptr_t)pFunc >> 1) ^ (parent * 0x9E3779B1u)) & PROFILE_HASH_MASK;
 
-extern void g5soc_init_mutex(volatile uint32_t * p_mutex);
-extern void g5soc_take_mutex(volatile uint32_t * p_mutex);
-extern void g5soc_release_mutex(volatile uint32_t * p_mutex);
+    for (size_t probe = 0u; probe < ARRAY_SIZE(profile[0].node); probe++) {
+        struct Node * const pNode = &(profile[hartid].node[index]);
 
-volatile uint32_t profiling_mutex = 0u;
+        if (!pNode->pFunc) {
+            pNode->pFunc = pFunc;
+            pNode->parent = parent;
+            profile[hartid].numNodes++;
+            result = index;
+            break;
+        } else if ((pNode->pFunc == pFunc) && (pNode->parent == parent)) {
+            result = index;
+            break;
+        }
 
-#define mATOMIC_ENTER g5soc_take_mutex(&profiling_mutex);
-#define mATOMIC_EXIT g5soc_release_mutex(&profiling_mutex);
+        index = (index + 1u) & PROFILE_HASH_MASK;
+    }
+
+    return result;
+}
 
 void __attribute__((no_instrument_function)) __cyg_profile_func_enter (void *pFunc, void *pCaller)
 {
-    enum HSSHartId const myHartId = current_hartid();
+    size_t const hartid = current_hartid();
     (void) pCaller;
 
-    if (myHartId != 0) { return; }
+    if ((hartid >= MAX_NUM_HARTS) || profile[hartid].paused) { return; }
 
-    assert(pFunc != NULL);
-    struct Node *pNode = NULL;
-
-    size_t i;
-    for (i = 0u; i < allocationCount; i++) {
-        if (functionNode[i].pFunc == pFunc) {
-            pNode = &(functionNode[i]);
-            break;
-        }
-    }
+    uint32_t const depth = profile[hartid].depth;
 
-    if (!pNode) {
-        assert(allocationCount < ARRAY_SIZE(functionNode));
-        pNode = &(functionNode[allocationCount]);
-        allocationCount++;
-        mATOMIC_ENTER;
-        pNode->pFunc = pFunc;
-        pNode->timeCount = 0lu;
-        mATOMIC_EXIT;
-    }
+    if (depth < ARRAY_SIZE(profile[0].stack)) {
+        uint32_t const parent = depth ? profile[hartid].stack[depth - 1u].node : PROFILE_ROOT_NODE;
+        struct Frame * const pFrame = &(profile[hartid].stack[depth]);
 
-    if (pNode) {
-        mATOMIC_ENTER;
-        pNode->entryTime = CSR_GetTickCount();
-        mATOMIC_EXIT;
+        pFrame->node = (parent == PROFILE_NO_NODE) ? PROFILE_NO_NODE : find_node_(hartid, pFunc, parent);
+        if (pFrame->node == PROFILE_NO_NODE) {
+            profile[hartid].numDropped++;
+        }
+        pFrame->childTime = 0u;
+        pFrame->entryTime = CSR_GetTickCount();
     }
 
-    return;
+    profile[hartid].depth = depth + 1u;
 }
 
 void __attribute__((no_instrument_function)) __cyg_profile_func_exit (void *pFunc, void *pCaller)
 {
-    enum HSSHartId const myHartId = current_hartid();
+    uint64_t const now = CSR_GetTickCount();
+    size_t const hartid = current_hartid();
+    (void) pFunc;
     (void) pCaller;
 
-    assert(pFunc != NULL);
+    if ((hartid >= MAX_NUM_HARTS) || profile[hartid].paused || !profile[hartid].depth) { return; }
 
-    if (myHartId != 0) { return; }
+    uint32_t const depth = --profile[hartid].depth;
 
-    size_t i;
-    for (i = 0u; i < allocationCount; i++) {
-        if (functionNode[i].pFunc == pFunc) {
-            mATOMIC_ENTER;
-            functionNode[i].timeCount += (CSR_GetTickCount() - functionNode[i].entryTime);
-            mATOMIC_EXIT;
-            break;
-        }
-    }
+    if (depth < ARRAY_SIZE(profile[0].stack)) {
+        struct Frame const * const pFrame = &(profile[hartid].stack[depth]);
+        uint64_t const elapsed = now - pFrame->entryTime;
 
-    return;
-}
+        if (pFrame->node != PROFILE_NO_NODE) {
+            struct Node * const pNode = &(profile[hartid].node[pFrame->node]);
 
+            pNode->callCount++;
+            pNode->inclusiveTime += elapsed;
+            pNode->exclusiveTime += elapsed - pFrame->childTime;
+        }
 
-void __attribute__((no_instrument_function)) dump_profile(void);
+        if (depth) {
+            profile[hartid].stack[depth - 1u].childTime += elapsed;
+        }
+    }
+}
 
 void __attribute__((no_instrument_function)) dump_profile(void)
 {
-    size_t i;
-    for (i = 0u; i < allocationCount; i++) {
-        mHSS_DEBUG_PRINTF_EX("PROFILE: %p, %lu" CRLF, functionNode[i].pFunc, functionNode[i].timeCount);
+    size_t const myHartId = current_hartid();
+
+    // calls made while dumping are not recorded, so don't add nodes mid-iteration.
+    // Other harts keep running, so their tables are read on the fly
+    if (myHartId < MAX_NUM_HARTS) {
+        profile[myHartId].paused = true;
+    }
+
+    for (size_t hartid = 0u; hartid < MAX_NUM_HARTS; hartid++) {
+        if (!profile[hartid].numNodes) { continue; }
+
+        mHSS_DEBUG_PRINTF_EX("PROFILE: hart %lu, %u nodes, %u untracked calls" CRLF, hartid,
+            profile[hartid].numNodes, profile[hartid].numDropped);
+
+        for (size_t i = 0u; i < ARRAY_SIZE(profile[0].node); i++) {
+            struct Node const * const pNode = &(profile[hartid].node[i]);
+
+            if (pNode->pFunc) {
+                // hart node parent function calls inclusive exclusive
+                mHSS_DEBUG_PRINTF_EX("PROFILE: %lu %lu %ld %p %u %lu %lu" CRLF, hartid, i,
+                    (pNode->parent == PROFILE_ROOT_NODE) ? -1l : (long)pNode->parent, pNode->pFunc,
+                    pNode->callCount, pNode->inclusiveTime, pNode->exclusiveTime);
+            }
+        }
+    }
+
+    if (myHartId < MAX_NUM_HARTS) {
+        profile[myHartId].paused = false;
     }
 }
@@ -15,6 +15,7 @@
 #include "config.h"
 #include "hss_types.h"
 #include "hss_debug.h"
+#include "uart_helper.h"
 
 #include <stdlib.h>
 
@@ -30,6 +31,7 @@ __attribute__ ((__noreturn__)) void __assert_func(const char *__file, unsigned i
 {
     mHSS_DEBUG_PRINTF(LOG_ERROR, "%s:%d: %s() Assertion failed:" CRLF "\t%s" CRLF,
         __file, __line, __function, __assertion);
+    uart_tx_flush(); // nothing will drain buffered output once we stop here
 
 #ifndef __riscv
     exit(1);
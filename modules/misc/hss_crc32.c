@@ -77,6 +77,74 @@ static inline uint32_t CRC32_updateByte(uint32_t crc32, const uint8_t byte)
     return crc32 & CRC32_MASK;
 }
 
+#if IS_ENABLED(CONFIG_CRC32_SLICING_BY_8) && !defined(HSS_CRC32_FORCE_BYTEWISE)
+#  define CRC32_USE_SLICING_BY_8 1
+#endif
+
+#ifdef CRC32_USE_SLICING_BY_8
+//
+// Slicing-by-8 processes 8 input bytes per iteration using 8 lookup tables. Table 0 is
+// the byte-wise table above; the remaining 7 tables are derived from it on first use,
+// so they cost RAM rather than eNVM.
+//
+static uint32_t slicingTable_[7][256];
+static bool slicingTableReady_ = false;
+
+static void CRC32_initSlicingTables_(void)
+{
+    for (size_t i = 0u; i < 256u; i++) {
+        uint32_t crc32 = precalcTable_[i];
+
+        for (size_t slice = 0u; slice < ARRAY_SIZE(slicingTable_); slice++) {
+            crc32 = (crc32 >> 8) ^ precalcTable_[crc32 & 0xFFu];
+            slicingTable_[slice][i] = crc32;
+        }
+    }
+
+    slicingTableReady_ = true;
+}
+
+static uint32_t CRC32_updateSlicingBy8_(uint32_t crc32, uint8_t const *pInput, size_t numBytes)
+{
+    if (!slicingTableReady_) {
+        CRC32_initSlicingTables_();
+    }
+
+    // byte-wise until aligned...
+    while (numBytes && ((uintptr_t)pInput & (sizeof(uint32_t) - 1u))) {
+        crc32 = CRC32_updateByte(crc32, *pInput);
+        ++pInput;
+        --numBytes;
+    }
+
+    // then 8 bytes at a time (little endian)...
+    while (numBytes >= 8u) {
+        uint32_t const one = *(uint32_t const *)pInput ^ crc32;
+        uint32_t const two = *(uint32_t const *)(pInput + 4);
+
+        crc32 = slicingTable_[6][one & 0xFFu]
+            ^ slicingTable_[5][(one >> 8) & 0xFFu]
+            ^ slicingTable_[4][(one >> 16) & 0xFFu]
+            ^ slicingTable_[3][one >> 24]
+            ^ slicingTable_[2][two & 0xFFu]
+            ^ slicingTable_[1][(two >> 8) & 0xFFu]
+            ^ slicingTable_[0][(two >> 16) & 0xFFu]
+            ^ precalcTable_[two >> 24];
+
+        pInput += 8;
+        numBytes -= 8u;
+    }
+
+    // and finally any remaining tail bytes
+    while (numBytes--) {
+        crc32 = CRC32_updateByte(crc32, *pInput);
+        ++pInput;
+    }
+
+    return crc32;
+}
+#endif
+
 uint32_t CRC32_calculate(uint8_t const *pInput, size_t numBytes)
 {
     uint32_t crc32 = 0u;
@@ -89,11 +157,88 @@ uint32_t CRC32_calculate_ex(uint32_t seed, uint8_t const *pInput, size_t numByte
     uint32_t crc32 = ~seed;
 
     if (pInput != NULL) {
+#ifdef CRC32_USE_SLICING_BY_8
+        crc32 = CRC32_updateSlicingBy8_(crc32, pInput, numBytes);
+#else
         while (numBytes--) {
             crc32 = CRC32_updateByte(crc32, *pInput);
             ++pInput;
         }
+#endif
     }
 
     return ~crc32;
 }
+
+//
+// CRC32_combine uses the GF(2) matrix method (as per zlib) to advance crc1 over len2
+// zero bytes, which can then be XOR'd with crc2. This costs O(log(len2)) rather than
+// needing to re-read the data.
+//
+#define CRC32_POLY_REVERSED (0xEDB88320u)
+#define GF2_DIM (32u)
+
+static uint32_t gf2_matrix_times_(uint32_t const *pMatrix, uint32_t vec)
+{
+    uint32_t sum = 0u;
+
+    while (vec) {
+        if (vec & 1u) {
+            sum ^= *pMatrix;
+        }
+        vec >>= 1;
+        pMatrix++;
+    }
+
+    return sum;
+}
+
+static void gf2_matrix_square_(uint32_t *pSquare, uint32_t const *pMatrix)
+{
+    for (size_t n = 0u; n < GF2_DIM; n++) {
+        pSquare[n] = gf2_matrix_times_(pMatrix, pMatrix[n]);
+    }
+}
+
+uint32_t CRC32_combine(uint32_t crc1, uint32_t crc2, size_t len2)
+{
+    uint32_t even[GF2_DIM]; // even-power-of-two zeros operator
+    uint32_t odd[GF2_DIM];  // odd-power-of-two zeros operator
+
+    if (len2 == 0u) {
+        return crc1;
+    }
+
+    // put operator for one zero bit in odd
+    odd[0] = CRC32_POLY_REVERSED;
+    uint32_t row = 1u;
+    for (size_t n = 1u; n < GF2_DIM; n++) {
+        odd[n] = row;
+        row <<= 1;
+    }
+
+    gf2_matrix_square_(even, odd); // put operator for two zero bits in even
+    gf2_matrix_square_(odd, even); // put operator for four zero bits in odd
+
+    // apply len2 zeros to crc1 (first square will put the operator for one
+    // zero byte, eight zero bits, in even)
+    do {
+        gf2_matrix_square_(even, odd);
+        if (len2 & 1u) {
+            crc1 = gf2_matrix_times_(even, crc1);
+        }
+        len2 >>= 1;
+
+        if (len2 == 0u) {
+            break;
+        }
+
+        gf2_matrix_square_(odd, even);
+        if (len2 & 1u) {
+            crc1 = gf2_matrix_times_(odd, crc1);
+        }
+        len2 >>= 1;
+    } while (len2 != 0u);
+
+    return crc1 ^ crc2;
+}
@@ -35,52 +35,231 @@ static char const * const pdmaErrorTable[] = {
 };
 #endif
 
-static void *do_memcpy_via_pdma_(void * restrict dest, void const * restrict src, size_t num_bytes);
-static void *do_memcpy_via_pdma_(void * restrict dest, void const * restrict src, size_t num_bytes)
+#if IS_ENABLED(CONFIG_USE_PDMA)
+#  define PDMA_NUM_CHANNELS     ((unsigned int)MSS_PDMA_lAST_CHANNEL)
+_Static_assert(HSS_PDMA_NUM_CHANNELS == PDMA_NUM_CHANNELS, "HSS_PDMA_NUM_CHANNELS must match the MSS PDMA");
+_Static_assert(HSS_PDMA_SGDMA_NUM_CHANNELS < (PDMA_NUM_CHANNELS - 1),
+    "at least one PDMA channel must be left for memcpy_via_pdma_submit()");
+#  define PDMA_ALIGNMENT        16u
+#  define PDMA_ALIGNMENT_MASK   (PDMA_ALIGNMENT - 1u)
+
+// transfers smaller than this are not worth the cost of claiming a channel
+#  define PDMA_MIN_TRANSFER_SIZE    64u
+
+// transfers are only spread across channels if each channel gets at least this much
+#  define PDMA_MIN_SPLIT_SIZE       4096u
+
+//
+// Each channel remembers what it was asked to copy, so that on a PDMA error the
+// piece can be recopied by the CPU, keeping the same fallback behavior as before
+//
+static struct {
+    void *dest;
+    void const *src;
+    size_t num_bytes;
+} pdmaChannel_[PDMA_NUM_CHANNELS];
+static HSS_PDMA_Txn_t pdmaChannelsBusy_ = 0u;
+
+static void pdma_report_error_(uint8_t pdma_error_code)
+{
+    if (pdma_error_code < ARRAY_SIZE(pdmaErrorTable)) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "PDMA Error: %s" CRLF, pdmaErrorTable[pdma_error_code]);
+    }
+}
+
+static bool pdma_start_channel_(unsigned int channel, void *dest, void const *src, size_t num_bytes)
+{
+    bool result = false;
+
+    mss_pdma_channel_config_t pdma_config = {
+        .src_addr = (size_t)src,
+        .dest_addr = (size_t)dest,
+        .num_bytes = num_bytes,
+        .enable_done_int = 0,
+        .enable_err_int = 0,
+        .force_order = 0,
+        .repeat = 0u };
+
+    uint8_t pdma_error_code = MSS_PDMA_setup_transfer((mss_pdma_channel_id_t)channel, &pdma_config);
+    if (pdma_error_code == 0) {
+        pdma_error_code = MSS_PDMA_start_transfer((mss_pdma_channel_id_t)channel);
+    }
+
+    if (pdma_error_code != 0) {
+        pdma_report_error_(pdma_error_code);
+    } else {
+        pdmaChannel_[channel].dest = dest;
+        pdmaChannel_[channel].src = src;
+        pdmaChannel_[channel].num_bytes = num_bytes;
+        pdmaChannelsBusy_ |= (HSS_PDMA_Txn_t)(1u << channel);
+        result = true;
+    }
+
+    return result;
+}
+
+static bool pdma_poll_channel_(unsigned int channel)
+{
+    bool result = false;
+
+    if (MSS_PDMA_get_transfer_error_status((mss_pdma_channel_id_t)channel)) {
+        MSS_PDMA_clear_transfer_error_status((mss_pdma_channel_id_t)channel);
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "PDMA Error: channel %u transfer failed" CRLF, channel);
+
+        // fall back to traditional memcpy() for this piece
+        memcpy(pdmaChannel_[channel].dest, pdmaChannel_[channel].src, pdmaChannel_[channel].num_bytes);
+        result = true;
+    } else if (MSS_PDMA_get_transfer_complete_status((mss_pdma_channel_id_t)channel)) {
+        MSS_PDMA_clear_transfer_complete_status((mss_pdma_channel_id_t)channel);
+        result = true;
+    }
+
+    if (result) {
+        pdmaChannelsBusy_ &= (HSS_PDMA_Txn_t)~(1u << channel);
+    }
+
+    return result;
+}
+#endif
+
+bool memcpy_via_pdma_submit(void * restrict dest, void const * restrict src, size_t num_bytes,
+    HSS_PDMA_Txn_t *pTxn)
 {
-    void *result = NULL;
+    assert(pTxn != NULL);
+    *pTxn = 0u;
 
 #if IS_ENABLED(CONFIG_USE_PDMA)
-    // num_bytes must be multiple of 16 or more
-    if (!(num_bytes & 0xFu)) {
-        uint8_t pdma_error_code = 0u;
-
-        mss_pdma_channel_config_t pdma_config_ch0 = {
-            .src_addr = (size_t)src,
-            .dest_addr = (size_t)dest,
-            .num_bytes = num_bytes,
-            .enable_done_int = 0,
-            .enable_err_int = 0,
-            .force_order = 0,
-            .repeat = 0u };
-
-        pdma_error_code = MSS_PDMA_setup_transfer(MSS_PDMA_CHANNEL_0, &pdma_config_ch0);
-        if (pdma_error_code == 0) {
-            pdma_error_code = MSS_PDMA_start_transfer(MSS_PDMA_CHANNEL_0);
-            if (pdma_error_code == 0) {
-                while (!MSS_PDMA_get_transfer_complete_status(MSS_PDMA_CHANNEL_0)) {
-                    ;
-                }
-                MSS_PDMA_clear_transfer_complete_status(MSS_PDMA_CHANNEL_0);
-            }
+    if (num_bytes >= PDMA_MIN_TRANSFER_SIZE) {
+        HSS_PDMA_Txn_t const freeChannels = (HSS_PDMA_Txn_t)(~pdmaChannelsBusy_
+            & ~HSS_PDMA_RESERVED_CHANNELS_MASK & ((1u << PDMA_NUM_CHANNELS) - 1u));
+
+        if (!freeChannels) {
+            return false; // nothing copied, caller should retry later
+        }
+
+        char *cDest = (char *)dest;
+        char const *cSrc = (char const *)src;
+
+        // unaligned head is copied by the CPU, so that the PDMA sees an aligned destination
+        size_t const headBytes = (PDMA_ALIGNMENT - ((uintptr_t)cDest & PDMA_ALIGNMENT_MASK)) & PDMA_ALIGNMENT_MASK;
+        size_t const bodyBytes = (num_bytes - headBytes) & ~(size_t)PDMA_ALIGNMENT_MASK;
+        size_t const tailBytes = num_bytes - headBytes - bodyBytes;
+
+        if (headBytes) {
+            memcpy(cDest, cSrc, headBytes);
+        }
+        if (tailBytes) {
+            memcpy(cDest + headBytes + bodyBytes, cSrc + headBytes + bodyBytes, tailBytes);
+        }
+
+        cDest += headBytes;
+        cSrc += headBytes;
+
+        // spread the body across the free channels, in whole multiples of PDMA_ALIGNMENT
+        unsigned int numPieces = (unsigned int)__builtin_popcount(freeChannels);
+        while ((numPieces > 1u) && ((bodyBytes / numPieces) < PDMA_MIN_SPLIT_SIZE)) {
+            numPieces--;
         }
 
-        if (pdma_error_code != 0) {
-            if (pdma_error_code < ARRAY_SIZE(pdmaErrorTable)) {
-                mHSS_DEBUG_PRINTF(LOG_ERROR, "PDMA Error: %s" CRLF, pdmaErrorTable[pdma_error_code]);
+        size_t const pieceBytes = (bodyBytes / numPieces) & ~(size_t)PDMA_ALIGNMENT_MASK;
+        size_t remaining = bodyBytes;
+
+        for (unsigned int channel = 0u; (channel < PDMA_NUM_CHANNELS) && remaining; channel++) {
+            if (!(freeChannels & (1u << channel))) { continue; }
+
+            numPieces--;
+            size_t const thisBytes = numPieces ? pieceBytes : remaining;
+
+            if (pdma_start_channel_(channel, cDest, cSrc, thisBytes)) {
+                *pTxn |= (HSS_PDMA_Txn_t)(1u << channel);
+            } else {
+                // fall back to traditional memcpy() for this piece
+                memcpy(cDest, cSrc, thisBytes);
             }
+
+            cDest += thisBytes;
+            cSrc += thisBytes;
+            remaining -= thisBytes;
+        }
+
+        return true;
+    }
+#endif
+
+    // fall back to traditional memcpy()
+    memcpy(dest, src, num_bytes);
+
+    return true;
+}
+
+bool memcpy_via_pdma_submit_channel(unsigned int channel, void * restrict dest,
+    void const * restrict src, size_t num_bytes, HSS_PDMA_Txn_t *pTxn)
+{
+    assert(pTxn != NULL);
+    *pTxn = 0u;
+
+#if IS_ENABLED(CONFIG_USE_PDMA)
+    channel = channel % PDMA_NUM_CHANNELS;
+
+    if (num_bytes >= PDMA_MIN_TRANSFER_SIZE) {
+        if (pdmaChannelsBusy_ & (1u << channel)) {
+            return false; // nothing copied, caller should retry later
+        }
+
+        char *cDest = (char *)dest;
+        char const *cSrc = (char const *)src;
+
+        // unaligned head and tail are copied by the CPU, as in memcpy_via_pdma_submit()
+        size_t const headBytes = (PDMA_ALIGNMENT - ((uintptr_t)cDest & PDMA_ALIGNMENT_MASK)) & PDMA_ALIGNMENT_MASK;
+        size_t const bodyBytes = (num_bytes - headBytes) & ~(size_t)PDMA_ALIGNMENT_MASK;
+        size_t const tailBytes = num_bytes - headBytes - bodyBytes;
+
+        if (headBytes) {
+            memcpy(cDest, cSrc, headBytes);
+        }
+        if (tailBytes) {
+            memcpy(cDest + headBytes + bodyBytes, cSrc + headBytes + bodyBytes, tailBytes);
+        }
+
+        if (pdma_start_channel_(channel, cDest + headBytes, cSrc + headBytes, bodyBytes)) {
+            *pTxn = (HSS_PDMA_Txn_t)(1u << channel);
         } else {
-            result = dest;
+            // fall back to traditional memcpy()
+            memcpy(cDest + headBytes, cSrc + headBytes, bodyBytes);
         }
+
+        return true;
     }
+#else
+    (void)channel;
 #endif
 
-    if (!result) {
-        // fall back to traditional memcpy()
-        result = memcpy(dest, src, num_bytes);
+    // fall back to traditional memcpy()
+    memcpy(dest, src, num_bytes);
+
+    return true;
+}
+
+bool memcpy_via_pdma_poll(HSS_PDMA_Txn_t *pTxn)
+{
+    assert(pTxn != NULL);
+
+#if IS_ENABLED(CONFIG_USE_PDMA)
+    for (unsigned int channel = 0u; channel < PDMA_NUM_CHANNELS; channel++) {
+        if ((*pTxn & (1u << channel)) && pdma_poll_channel_(channel)) {
+            *pTxn &= (HSS_PDMA_Txn_t)~(1u << channel);
+        }
     }
+#endif
 
-    return result;
+    return (*pTxn == 0u);
+}
+
+void memcpy_via_pdma_complete(HSS_PDMA_Txn_t *pTxn)
+{
+    while (!memcpy_via_pdma_poll(pTxn)) {
+        ;
+    }
 }
 
 void *memcpy_via_pdma(void *dest, void const *src, size_t num_bytes)
@@ -98,5 +277,11 @@ void *memcpy_via_pdma(void *dest, void const *src, size_t num_bytes)
     }
 
     //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Copy from %p to %p (%x bytes)" CRLF, src, dest, num_bytes);
-    return do_memcpy_via_pdma_(dest, src, num_bytes);
+    HSS_PDMA_Txn_t txn;
+    while (!memcpy_via_pdma_submit(dest, src, num_bytes, &txn)) {
+        ;
+    }
+    memcpy_via_pdma_complete(&txn);
+
+    return dest;
 }
@@ -31,6 +31,35 @@
 
 #include "hss_perfctr.h"
 
+#if IS_ENABLED(CONFIG_MEMTEST_PARALLEL)
+#  include "ssmb_ipi.h"
+#  include "hss_clock.h"
+#  include "hss_atomic.h"
+#endif
+
+// Progress and keypress polling are far more expensive than a single word
+// access, so only do them every MEMTEST_POLL_WORDS words
+#define MEMTEST_POLL_WORDS (64u * 1024u)
+
+#if !IS_ENABLED(CONFIG_MEMTEST_PARALLEL)
+
+static bool memtest_poll_serial_(size_t numWords, size_t offset)
+{
+    bool result = true;
+    uint8_t rx_char;
+
+    if ((offset % MEMTEST_POLL_WORDS) == 0u) {
+        HSS_ShowProgress(numWords, numWords - offset);
+
+        if (uart_getchar(&rx_char, 0, false) && ((rx_char == '\003') || (rx_char == '\033'))) {
+            result = false;
+        }
+    }
+
+    return result;
+}
+#endif
+
 // Walking Ones test of the Data Bus wiring
 static uint64_t HSS_MemTestDataBus(volatile uint64_t *address)
 {
@@ -130,6 +159,7 @@ do_return:
     return result;
 }
 
+#if !IS_ENABLED(CONFIG_MEMTEST_PARALLEL)
 static uint64_t *HSS_MemTestDevice(volatile uint64_t *baseAddr, size_t numBytes)
 {
     size_t offset;
@@ -138,16 +168,13 @@ static uint64_t *HSS_MemTestDevice(volatile uint64_t *baseAddr, size_t numBytes)
 
     uint64_t pattern;
     uint64_t antiPattern;
-    uint8_t rx_char;
 
     // write pattern to every cell
     mHSS_FANCY_PRINTF(LOG_NORMAL, "Write Seed Pattern to all cells" CRLF);
 
     for (pattern = 1u, offset = 0u; offset < numWords; pattern++, offset++) {
         baseAddr[offset] = pattern;
-        HSS_ShowProgress(numWords, numWords - offset);
-
-        if (uart_getchar(&rx_char, 0, false) && ((rx_char == '\003') || (rx_char == '\033'))) {
+        if (!memtest_poll_serial_(numWords, offset)) {
             goto do_return;
         }
     }
@@ -172,9 +199,7 @@ static uint64_t *HSS_MemTestDevice(volatile uint64_t *baseAddr, size_t numBytes)
             baseAddr[offset] = antiPattern;
         }
 
-        HSS_ShowProgress(numWords, numWords - offset);
-
-        if (uart_getchar(&rx_char, 0, false) && ((rx_char == '\003') || (rx_char == '\033'))) {
+        if (!memtest_poll_serial_(numWords, offset)) {
             goto do_return;
         }
     }
@@ -192,9 +217,7 @@ static uint64_t *HSS_MemTestDevice(volatile uint64_t *baseAddr, size_t numBytes)
                 break;
             }
 
-            HSS_ShowProgress(numWords, numWords - offset);
-
-            if (uart_getchar(&rx_char, 0, false) && ((rx_char == '\003') || (rx_char == '\033'))) {
+            if (!memtest_poll_serial_(numWords, offset)) {
                 goto do_return;
             }
         }
@@ -204,6 +227,263 @@ do_return:
     HSS_ShowProgress(numWords, 0u); // clear progress indicator
     return result;
 }
+#else
+//
+// Parallel March C- device test
+//
+// March C-: { (w0); up(r0,w1); up(r1,w0); down(r0,w1); down(r1,w0); (r0) }
+// where "0" is MEMTEST_BACKGROUND and "1" is its inverse.
+//
+// The range is split into cache-line aligned slices, one per hart. Each U54 is
+// sent its slice via IPI_MSG_MEMTEST and runs it from its IPI handler, while
+// the E51 runs its own slice and handles progress and keypresses. Any slice not
+// claimed by a U54 (e.g. because it is running a payload) is run by the E51, as
+// are all of them if the IPI queues have not been initialized yet (e.g. when run
+// from the TinyCLI before boot).
+// Note that address order is only maintained within a slice, so coupling
+// faults between cells in different slices are not guaranteed to be detected.
+//
+#define MEMTEST_BACKGROUND      (0x5555555555555555llu)
+#define MEMTEST_SLICE_ALIGN     (64u)
+#define MEMTEST_POLL_PERIOD     (100llu * ONE_MILLISEC)
+
+enum MemTestJobState {
+    MEMTEST_JOB_IDLE,
+    MEMTEST_JOB_QUEUED,
+    MEMTEST_JOB_RUNNING,
+    MEMTEST_JOB_DONE,
+};
+
+struct MemTestJob {
+    volatile uint64_t *baseAddr;
+    size_t numWords;
+    uint32_t generation;
+    uint32_t state;
+    volatile size_t wordsDone;
+    uint64_t *failAddr;
+    uint64_t failValue;
+    uint64_t failExpected;
+};
+
+struct MarchElement {
+    bool ascending;
+    bool doRead;
+    bool readInverse;
+    bool doWrite;
+    bool writeInverse;
+};
+
+static const struct MarchElement marchCMinus_[] = {
+    { true,  false, false, true,  false }, // (w0)
+    { true,  true,  false, true,  true  }, // up(r0,w1)
+    { true,  true,  true,  true,  false }, // up(r1,w0)
+    { false, true,  false, true,  true  }, // down(r0,w1)
+    { false, true,  true,  true,  false }, // down(r1,w0)
+    { true,  true,  false, false, false }, // (r0)
+};
+
+static struct MemTestJob memTestJobs_[HSS_HART_NUM_PEERS];
+static uint32_t memTestMsgIndex_[HSS_HART_NUM_PEERS];
+static bool memTestMsgSent_[HSS_HART_NUM_PEERS];
+static volatile bool memTestAbort_ = false;
+static uint32_t memTestGeneration_ = 0u;
+static size_t memTestTotalWork_ = 0u;
+static HSSTicks_t memTestLastPoll_ = 0u;
+
+static bool memtest_poll_parallel_(void)
+{
+    bool result = true;
+    uint8_t rx_char;
+
+    if (HSS_Timer_IsElapsed(memTestLastPoll_, MEMTEST_POLL_PERIOD)) {
+        size_t wordsDone = 0u;
+
+        memTestLastPoll_ = HSS_GetTime();
+
+        for (int peer = HSS_HART_E51; peer < HSS_HART_NUM_PEERS; peer++) {
+            wordsDone += memTestJobs_[peer].wordsDone;
+        }
+        HSS_ShowProgress(memTestTotalWork_, memTestTotalWork_ - wordsDone);
+
+        if (uart_getchar(&rx_char, 0, false) && ((rx_char == '\003') || (rx_char == '\033'))) {
+            memTestAbort_ = true;
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+static bool memtest_march_element_(struct MemTestJob *pJob, struct MarchElement const * const pElement,
+    bool (*pollFn)(void))
+{
+    bool result = true;
+    uint64_t const readVal = pElement->readInverse ? ~MEMTEST_BACKGROUND : MEMTEST_BACKGROUND;
+    uint64_t const writeVal = pElement->writeInverse ? ~MEMTEST_BACKGROUND : MEMTEST_BACKGROUND;
+    ptrdiff_t const stride = pElement->ascending ? 1 : -1;
+    volatile uint64_t *pWord = pElement->ascending ? pJob->baseAddr : (pJob->baseAddr + pJob->numWords - 1u);
+    size_t remaining = pJob->numWords;
+
+    while (result && remaining) {
+        size_t const batch = MIN(remaining, (size_t)MEMTEST_POLL_WORDS);
+
+        // keep the read/write decision out of the inner loops
+        if (pElement->doRead) {
+            for (size_t i = 0u; i < batch; i++, pWord += stride) {
+                uint64_t const value = *pWord;
+
+                if (value != readVal) {
+                    pJob->failAddr = (uint64_t *)pWord;
+                    pJob->failValue = value;
+                    pJob->failExpected = readVal;
+                    result = false;
+                    break;
+                }
+
+                if (pElement->doWrite) {
+                    *pWord = writeVal;
+                }
+            }
+        } else {
+            for (size_t i = 0u; i < batch; i++, pWord += stride) {
+                *pWord = writeVal;
+            }
+        }
+
+        remaining -= batch;
+        pJob->wordsDone += batch;
+
+        if (memTestAbort_ || (pollFn && !pollFn())) {
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+static void memtest_run_job_(struct MemTestJob *pJob, bool (*pollFn)(void))
+{
+    bool result = true;
+
+    for (size_t i = 0u; result && (i < ARRAY_SIZE(marchCMinus_)); i++) {
+        result = memtest_march_element_(pJob, &marchCMinus_[i], pollFn);
+    }
+
+    mb();
+    pJob->state = MEMTEST_JOB_DONE;
+}
+
+enum IPIStatusCode HSS_MemTest_IPIHandler(TxId_t transaction_id, enum HSSHartId source, uint32_t immediate_arg,
+    void *p_extended_buffer_in_ddr, void *p_ancilliary_buffer_in_ddr)
+{
+    (void)transaction_id;
+    (void)source;
+    (void)p_ancilliary_buffer_in_ddr;
+
+    enum IPIStatusCode result = IPI_FAIL;
+    struct MemTestJob *pJob = (struct MemTestJob *)p_extended_buffer_in_ddr;
+
+    // ignore stale requests from an earlier run, and slices already claimed by the E51
+    if (pJob && (pJob->generation == immediate_arg)
+            && __sync_bool_compare_and_swap(&pJob->state, MEMTEST_JOB_QUEUED, MEMTEST_JOB_RUNNING)) {
+        memtest_run_job_(pJob, NULL);
+        result = IPI_SUCCESS;
+    }
+
+    return result;
+}
+
+static uint64_t *HSS_MemTestDeviceParallel(volatile uint64_t *baseAddr, size_t numBytes)
+{
+    size_t const numWords = numBytes / sizeof(uint64_t);
+    size_t const wordsPerSlice = ((numWords / HSS_HART_NUM_PEERS)
+        / (MEMTEST_SLICE_ALIGN / sizeof(uint64_t))) * (MEMTEST_SLICE_ALIGN / sizeof(uint64_t));
+    size_t offset = 0u;
+    uint64_t *result = NULL;
+
+    mHSS_FANCY_PRINTF(LOG_NORMAL, "March C- test across %d harts" CRLF, HSS_HART_NUM_PEERS);
+
+    memTestGeneration_++;
+    memTestAbort_ = false;
+    memTestTotalWork_ = numWords * ARRAY_SIZE(marchCMinus_);
+    memTestLastPoll_ = HSS_GetTime();
+
+    for (int peer = HSS_HART_E51; peer < HSS_HART_NUM_PEERS; peer++) {
+        struct MemTestJob *pJob = &memTestJobs_[peer];
+
+        pJob->baseAddr = baseAddr + offset;
+        pJob->numWords = (peer == (HSS_HART_NUM_PEERS - 1)) ? (numWords - offset) : wordsPerSlice;
+        pJob->generation = memTestGeneration_;
+        pJob->wordsDone = 0u;
+        pJob->failAddr = NULL;
+        pJob->state = MEMTEST_JOB_QUEUED;
+        offset += pJob->numWords;
+    }
+    mb();
+
+    bool const useIPIs = IPI_QueuesInitialized();
+    if (!useIPIs) {
+        mHSS_FANCY_PRINTF(LOG_WARN, "IPI queues not initialized, testing on E51 only" CRLF);
+    }
+
+    for (int peer = HSS_HART_U54_1; peer < HSS_HART_NUM_PEERS; peer++) {
+        memTestMsgSent_[peer] = false;
+
+        if (useIPIs && memTestJobs_[peer].numWords && IPI_MessageAlloc(&memTestMsgIndex_[peer])) {
+            memTestMsgSent_[peer] = IPI_MessageDeliver(memTestMsgIndex_[peer], peer, IPI_MSG_MEMTEST,
+                memTestGeneration_, &memTestJobs_[peer], NULL);
+
+            if (!memTestMsgSent_[peer]) {
+                IPI_MessageFree(memTestMsgIndex_[peer]);
+            }
+        }
+    }
+
+    // the E51 slice comes first, so by the time it is done any idle U54 will
+    // have claimed its own slice...
+    bool claimedByE51[HSS_HART_NUM_PEERS] = { false };
+    for (int peer = HSS_HART_E51; peer < HSS_HART_NUM_PEERS; peer++) {
+        if (__sync_bool_compare_and_swap(&memTestJobs_[peer].state, MEMTEST_JOB_QUEUED, MEMTEST_JOB_RUNNING)) {
+            claimedByE51[peer] = true;
+            memtest_run_job_(&memTestJobs_[peer], memtest_poll_parallel_);
+        }
+    }
+
+    // ... and the rest just need to be waited for, until both the slice is done and
+    // the U54 has acknowledged the message, as nothing else consumes ACKs while the
+    // E51 is busy here. A message for a slice the E51 ran is left to go stale - its
+    // transaction ID no longer matches once the completion slot is freed
+    for (int peer = HSS_HART_U54_1; peer < HSS_HART_NUM_PEERS; peer++) {
+        if (!claimedByE51[peer]) {
+            while ((__atomic_load_n(&memTestJobs_[peer].state, __ATOMIC_ACQUIRE) != MEMTEST_JOB_DONE)
+                    || (memTestMsgSent_[peer] && !IPI_MessageCheckIfComplete(memTestMsgIndex_[peer]))) {
+                (void)IPI_ConsumeIntent(peer, IPI_MSG_ACK_COMPLETE);
+                (void)memtest_poll_parallel_();
+            }
+        }
+
+        if (memTestMsgSent_[peer]) {
+            IPI_MessageFree(memTestMsgIndex_[peer]);
+        }
+    }
+    HSS_ShowProgress(memTestTotalWork_, 0u); // clear progress indicator
+
+    for (int peer = HSS_HART_E51; peer < HSS_HART_NUM_PEERS; peer++) {
+        struct MemTestJob *pJob = &memTestJobs_[peer];
+
+        pJob->state = MEMTEST_JOB_IDLE;
+
+        if (!result && pJob->failAddr) {
+            mHSS_FANCY_PRINTF(LOG_ERROR, "6: 0x%016p==0x%016llx vs expected 0x%016llx" CRLF,
+                pJob->failAddr, pJob->failValue, pJob->failExpected);
+            result = pJob->failAddr;
+        }
+    }
+
+    return result;
+}
+#endif
+
 
 
 //
@@ -213,6 +493,12 @@ do_return:
 
 #include "ddr_service.h"
 
+#if IS_ENABLED(CONFIG_MEMTEST_PARALLEL)
+#  define memtest_device_ HSS_MemTestDeviceParallel
+#else
+#  define memtest_device_ HSS_MemTestDevice
+#endif
+
 bool HSS_MemTestDDRFast(void)
 {
     bool result = true;
@@ -247,7 +533,7 @@ bool HSS_MemTestDDRFull(void)
     bool result = HSS_MemTestDDRFast();
 
     if (result) {
-        if (HSS_MemTestDevice((uint64_t *)HSS_DDR_GetStart(), HSS_DDR_GetSize()) != NULL) {
+        if (memtest_device_((uint64_t *)HSS_DDR_GetStart(), HSS_DDR_GetSize()) != NULL) {
             mHSS_FANCY_PRINTF(LOG_ERROR, "FAILED!" CRLF);
             result = false;
         }
@@ -262,7 +548,7 @@ bool HSS_MemTestDDR_Ex(volatile uint64_t *baseAddr, size_t numBytes)
 
     if ((HSS_MemTestDataBus(baseAddr) != 0u)
             || (HSS_MemTestAddressBus(baseAddr, numBytes) != NULL)
-            || (HSS_MemTestDevice(baseAddr, numBytes) != NULL)) {
+            || (memtest_device_(baseAddr, numBytes) != NULL)) {
             mHSS_FANCY_PRINTF(LOG_ERROR, "FAILED!" CRLF);
         result = false;
     }
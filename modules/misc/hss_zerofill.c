@@ -0,0 +1,209 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/**
+ * \file Zero Fill Engine
+ * \brief Zero Fill Engine
+ *
+ * The E51 has no data cache, so a CPU zero fill from it is a long stream of single
+ * 64-bit writes. Large regions are therefore either handed to the U54 that will use them
+ * (which has a data cache and is otherwise idle while it waits to be booted), or zeroed
+ * by the PDMA: the CPU zeroes a small seed, and each PDMA step then copies everything
+ * zeroed so far to just after itself, doubling the zeroed span until the region is done.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_debug.h"
+#include "hss_clock.h"
+#include "hss_atomic.h"
+#include "hss_zerofill.h"
+
+#include <assert.h>
+
+// CPU-zeroed seed for the PDMA doubling, and the size below which the CPU does it all
+#define ZEROFILL_SEED_SIZE          4096u
+
+// how long a U54 has to claim a region before the E51 takes it back
+#define ZEROFILL_CLAIM_TIMEOUT      (10llu * ONE_MILLISEC)
+
+#define ZEROFILL_CACHE_LINE_WORDS   (64u / sizeof(uint64_t))
+
+enum ZeroFillJobState {
+    ZEROFILL_IDLE,
+    ZEROFILL_QUEUED,
+    ZEROFILL_RUNNING,
+    ZEROFILL_PDMA,
+    ZEROFILL_DONE,
+};
+
+static void zerofill_cpu_(char *pDest, size_t numBytes)
+{
+    // byte stores up to the first 64-bit boundary...
+    while (numBytes && ((uintptr_t)pDest & (sizeof(uint64_t) - 1u))) {
+        *pDest = 0;
+        pDest++;
+        numBytes--;
+    }
+
+    // ... then whole cache lines of back-to-back 64-bit stores. The pointer is volatile
+    // so that the compiler doesn't turn this back into a call to memset()
+    uint64_t volatile *pDWord = (uint64_t volatile *)pDest;
+    while (numBytes >= (ZEROFILL_CACHE_LINE_WORDS * sizeof(uint64_t))) {
+        pDWord[0] = 0llu;
+        pDWord[1] = 0llu;
+        pDWord[2] = 0llu;
+        pDWord[3] = 0llu;
+        pDWord[4] = 0llu;
+        pDWord[5] = 0llu;
+        pDWord[6] = 0llu;
+        pDWord[7] = 0llu;
+        pDWord += ZEROFILL_CACHE_LINE_WORDS;
+        numBytes -= ZEROFILL_CACHE_LINE_WORDS * sizeof(uint64_t);
+    }
+
+    while (numBytes >= sizeof(uint64_t)) {
+        *pDWord = 0llu;
+        pDWord++;
+        numBytes -= sizeof(uint64_t);
+    }
+
+    // ... and bytes for whatever is left
+    pDest = (char *)pDWord;
+    while (numBytes) {
+        *pDest = 0;
+        pDest++;
+        numBytes--;
+    }
+}
+
+static void zerofill_pdma_step_(struct HSS_ZeroFill_Job *pJob)
+{
+#if IS_ENABLED(CONFIG_USE_PDMA)
+    // each step reads what the previous one wrote, so it must have landed first
+    if (pJob->pdmaTxn && !memcpy_via_pdma_poll(&pJob->pdmaTxn)) {
+        return;
+    }
+
+    if (!pJob->bytesDone) {
+        size_t const seedBytes = MIN(pJob->numBytes, (size_t)ZEROFILL_SEED_SIZE);
+
+        zerofill_cpu_(pJob->pDest, seedBytes);
+        pJob->bytesDone = seedBytes;
+    } else if (pJob->bytesDone < pJob->numBytes) {
+        size_t const copyBytes = MIN(pJob->bytesDone, pJob->numBytes - pJob->bytesDone);
+
+        // if every channel is busy, nothing is copied and this is retried on the next poll
+        if (memcpy_via_pdma_submit(pJob->pDest + pJob->bytesDone, pJob->pDest, copyBytes,
+                &pJob->pdmaTxn)) {
+            pJob->bytesDone += copyBytes;
+        }
+    }
+#else
+    zerofill_cpu_(pJob->pDest, pJob->numBytes);
+    pJob->bytesDone = pJob->numBytes;
+#endif
+
+    if ((pJob->bytesDone == pJob->numBytes) && !pJob->pdmaTxn) {
+        pJob->state = ZEROFILL_DONE;
+    }
+}
+
+void HSS_ZeroFill_Submit(struct HSS_ZeroFill_Job *pJob, enum HSSHartId worker, void *pDest,
+    size_t numBytes)
+{
+    assert(pJob != NULL);
+
+    pJob->pDest = (char *)pDest;
+    pJob->numBytes = numBytes;
+    pJob->bytesDone = 0u;
+    pJob->pdmaTxn = 0u;
+    pJob->generation++;
+    pJob->submitTime = HSS_GetTime();
+
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_ZERO_INIT_ON_TARGET)
+    if ((worker != HSS_HART_E51) && (numBytes > ZEROFILL_SEED_SIZE)) {
+        pJob->state = ZEROFILL_QUEUED;
+        mb();
+
+        if (IPI_Send(worker, IPI_MSG_ZEROFILL, 0u, pJob->generation, pJob, NULL)) {
+            return;
+        }
+    }
+#else
+    (void)worker;
+#endif
+
+    pJob->state = ZEROFILL_PDMA;
+}
+
+bool HSS_ZeroFill_Poll(struct HSS_ZeroFill_Job *pJob)
+{
+    assert(pJob != NULL);
+
+    switch (__atomic_load_n(&pJob->state, __ATOMIC_ACQUIRE)) {
+    case ZEROFILL_QUEUED:
+        // the worker may be busy (or gone), in which case the E51 does it instead
+        if (HSS_Timer_IsElapsed(pJob->submitTime, ZEROFILL_CLAIM_TIMEOUT)
+                && __sync_bool_compare_and_swap(&pJob->state, ZEROFILL_QUEUED, ZEROFILL_PDMA)) {
+            mHSS_DEBUG_PRINTF(LOG_WARN, "Zero fill of %p not claimed, using PDMA" CRLF, pJob->pDest);
+        }
+        break;
+
+    case ZEROFILL_PDMA:
+        zerofill_pdma_step_(pJob);
+        break;
+
+    default: // idle, done, or running on the worker
+        break;
+    }
+
+    uint32_t const state = __atomic_load_n(&pJob->state, __ATOMIC_ACQUIRE);
+    return (state == ZEROFILL_DONE) || (state == ZEROFILL_IDLE);
+}
+
+void HSS_ZeroFill(void *pDest, size_t numBytes)
+{
+    if (numBytes <= ZEROFILL_SEED_SIZE) {
+        zerofill_cpu_((char *)pDest, numBytes);
+    } else {
+        struct HSS_ZeroFill_Job job = { 0 };
+
+        HSS_ZeroFill_Submit(&job, HSS_HART_E51, pDest, numBytes);
+        while (!HSS_ZeroFill_Poll(&job)) {
+            ;
+        }
+    }
+}
+
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_ZERO_INIT_ON_TARGET)
+enum IPIStatusCode HSS_ZeroFill_IPIHandler(TxId_t transaction_id, enum HSSHartId source, uint32_t immediate_arg,
+    void *p_extended_buffer_in_ddr, void *p_ancilliary_buffer_in_ddr)
+{
+    (void)transaction_id;
+    (void)source;
+    (void)p_ancilliary_buffer_in_ddr;
+
+    enum IPIStatusCode result = IPI_FAIL;
+    struct HSS_ZeroFill_Job *pJob = (struct HSS_ZeroFill_Job *)p_extended_buffer_in_ddr;
+
+    // ignore stale requests, and regions already taken back by the E51
+    if (pJob && (pJob->generation == immediate_arg)
+            && __sync_bool_compare_and_swap(&pJob->state, ZEROFILL_QUEUED, ZEROFILL_RUNNING)) {
+        zerofill_cpu_(pJob->pDest, pJob->numBytes);
+        pJob->bytesDone = pJob->numBytes;
+
+        mb();
+        pJob->state = ZEROFILL_DONE;
+        result = IPI_SUCCESS;
+    }
+
+    return result;
+}
+#endif
@@ -16,6 +16,7 @@
 #include "hss_types.h"
 
 #include "hss_debug.h"
+#include "uart_helper.h"
 
 const unsigned long __stack_chk_guard = 0xDEAD0BAD;
 
@@ -34,6 +35,7 @@ __attribute__((weak)) void __stack_chk_fail(void)
     // to help debug this, it might help to disable the print statement
     // once stack corruption is detected...
     mHSS_DEBUG_PUTS("__stack_chk_fail(): stack corruption detected!!" CRLF);
+    uart_tx_flush(); // the trap handler spins, so nothing would drain buffered output
     asm("ebreak");
 }
 
@@ -47,6 +49,7 @@ __attribute__((weak)) void* __memset_chk(void *dst, int c, size_t len, size_t ds
 
     if (dstlen < len) {
         mHSS_DEBUG_PUTS("__memset_chk(): dstlen < len!!" CRLF);
+        uart_tx_flush();
         asm("ebreak");
     } else {
         result = memset(dst, c, len);
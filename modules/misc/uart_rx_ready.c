@@ -0,0 +1,49 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software
+ *
+ */
+
+/**
+ * \file Console Input Poll
+ * \brief Non-blocking check for pending console input
+ *
+ * Used by the superloop to decide whether state machines waiting on SM_WAKE_ON_UART_RX
+ * should run. This is common to all boards, as the console is always MMUART0.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include "drivers/mss/mss_mmuart/mss_uart.h"
+
+#include "uart_helper.h"
+
+#if IS_ENABLED(CONFIG_UART_RX_RING)
+#  include "uart_rx_ring.h"
+#  include "csr_helper.h"
+
+static size_t uart_read_rx_fifo_(uint8_t *pBuf, size_t len)
+{
+    return MSS_UART_get_rx(&g_mss_uart0_lo, pBuf, len);
+}
+#endif
+
+bool uart_rx_ready(void)
+{
+#if IS_ENABLED(CONFIG_UART_RX_RING)
+    if (current_hartid() == HSS_HART_E51) {
+        (void)uart_rx_ring_fill(uart_read_rx_fifo_);
+        return (uart_rx_ring_count() != 0u);
+    }
+#endif
+
+    // LSR error bits are clear-on-read, so accumulate them for MSS_UART_get_rx_status()
+    uint8_t const status = g_mss_uart0_lo.hw_reg->LSR;
+    g_mss_uart0_lo.status |= status;
+
+    return (status & 0x01u); // DR (data ready)
+}
@@ -32,6 +32,7 @@
 #include "hss_state_machine.h"
 #include "hss_registry.h"
 #include "hss_atomic.h"
+#include "hss_trace.h"
 
 #if IS_ENABLED(CONFIG_HSS_USE_IHC)
 #  include "miv_ihc.h"
@@ -47,8 +48,15 @@
 #define SIZE_OF_IPI_QUEUES    (sizeof(struct IPI_Outbox_Queue) * IPI_OUTBOX_NUM_QUEUES)
 #define SIZE_OF_IPI_COMPLETES (sizeof(struct IPI_Complete) * IPI_MAX_NUM_OUTSTANDING_COMPLETES)
 
+// free completion slots are tracked in a bitmap, so allocation is a find-first-set per word
+#define IPI_COMPLETES_BITMAP_WORDS ((IPI_MAX_NUM_OUTSTANDING_COMPLETES + 63u) / 64u)
+
+#if ((CONFIG_IPI_MAX_NUM_QUEUE_MESSAGES * 4) > (1 << 16))
+#  error Too many IPI completion slots to encode in a transaction ID
+#endif
 
-#define IPI_VERSION (0x0101u)
+
+#define IPI_VERSION (0x0105u)
 
 /////////////////////////////////////////////////////////////////////////////
 
@@ -56,10 +64,8 @@ struct IPI_Data {
     uint32_t ipi_version;
     struct IPI_Outbox_Queue ipi_queues[IPI_OUTBOX_NUM_QUEUES];
     struct IPI_Complete ipi_completes[IPI_MAX_NUM_OUTSTANDING_COMPLETES];
-    struct {
-        TxId_t last[IPI_OUTBOX_NUM_QUEUES];
-        TxId_t shadow[IPI_OUTBOX_NUM_QUEUES];
-    } txId_per_queue;
+    uint64_t ipi_completes_free[IPI_COMPLETES_BITMAP_WORDS];
+    uint32_t shadow_head[IPI_OUTBOX_NUM_QUEUES];
     TxId_t my_transaction_id[MAX_NUM_HARTS];
     struct
     {
@@ -83,6 +89,10 @@ struct IPI_Data {
 #  define IPI_DATA (*ipi_data)
 #endif
 
+// the queues may be at a fixed address that survives a reset, so their contents
+// alone do not say whether they have been initialized by this boot
+static bool ipiQueuesInitialized_ = false;
+
 #if IS_ENABLED(CONFIG_DEBUG_MSCGEN_IPI)
 __extension__ static const char * const hartName[] = { // MAX_NUM_HARTS
     [ HSS_HART_E51 ]   = "E51",
@@ -110,7 +120,9 @@ __extension__ static const char * const ipiName[] = { // IPI_MSG_NUM_MSG_TYPES
     [ IPI_MSG_HALT ]              = "IPI_MSG_HALT",
     [ IPI_MSG_CONTINUE ]          = "IPI_MSG_CONTINUE",
     [ IPI_MSG_GOTO ]              = "IPI_MSG_GOTO",
-    [ IPI_MSG_OPENSBI_INIT ]      = "IPI_MSG_OPENSBI_INIT"
+    [ IPI_MSG_OPENSBI_INIT ]      = "IPI_MSG_OPENSBI_INIT",
+    [ IPI_MSG_MEMTEST ]           = "IPI_MSG_MEMTEST",
+    [ IPI_MSG_ZEROFILL ]          = "IPI_MSG_ZEROFILL"
 };
 #endif
 
@@ -174,9 +186,51 @@ inline uint32_t IPI_CalculateQueueIndex(enum HSSHartId source, enum HSSHartId ta
 //
 uint32_t IPI_GetQueuePendingCount(uint32_t queueIndex)
 {
-    //mHSS_DEBUG_PRINTF(LOG_NORMAL, "called - queueIndex is %u, count is %u" CRLF, queueIndex,
-    //    IPI_DATA.ipi_queues[queueIndex].count);
-    return (IPI_DATA.ipi_queues[queueIndex].count);
+    struct IPI_Outbox_Queue * const pQueue = &(IPI_DATA.ipi_queues[queueIndex]);
+
+    mb();
+    return (pQueue->head - pQueue->tail);
+}
+
+//
+// @brief Retire consumed messages from a queue
+//
+// Messages may be consumed out of order (by type), so consumed slots can be left behind
+// a message that is still pending. To stop one long-pending message from blocking the
+// queue, the pending messages are slid towards the head (keeping their order), so that
+// all of the consumed slots collect at the tail and can be handed back to the producer.
+// Only the target hart calls this, and the producer never touches slots between tail and
+// head, so no locking is needed.
+//
+// @param pQueue [in] queue to retire messages from
+//
+static void IPI_RetireConsumed_(struct IPI_Outbox_Queue * const pQueue)
+{
+    uint32_t tail = pQueue->tail;
+    uint32_t const head = pQueue->head;
+
+    // common case: consumed in order, so just skip the consumed run at the tail
+    while ((tail != head) && (pQueue->msgQ[tail & IPI_QUEUE_INDEX_MASK].msg_type == IPI_MSG_NO_MESSAGE)) {
+        tail++;
+    }
+
+    uint32_t dst = head;
+    for (uint32_t src = head; src != tail; ) {
+        src--;
+
+        struct IPI_Outbox_Msg * const pSrcMsg = &(pQueue->msgQ[src & IPI_QUEUE_INDEX_MASK]);
+        if (pSrcMsg->msg_type != IPI_MSG_NO_MESSAGE) {
+            dst--;
+
+            if (dst != src) {
+                pQueue->msgQ[dst & IPI_QUEUE_INDEX_MASK] = *pSrcMsg;
+                pSrcMsg->msg_type = IPI_MSG_NO_MESSAGE;
+            }
+        }
+    }
+
+    mb(); // ensure slot accesses complete before handing the slots back to the producer
+    pQueue->tail = dst;
 }
 
 // @brief Send an IPI to a particular target hart
@@ -251,8 +305,6 @@ inline struct IPI_Outbox_Msg *IPI_DirectionToFirstMsgInQueue(enum HSSHartId sour
     assert(target != source);
 
     //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Resolved (%d, %d) to index %u" CRLF, source, target, index);
-    //mHSS_DEBUG_PRINTF(WARN, "WARNING: queue %u is %u" CRLF, index,
-    //    IPI_DATA.ipi_queues[index].count);
 
     uint32_t index = IPI_CalculateQueueIndex(source, target);
     struct IPI_Outbox_Msg *pMsgResult = &(IPI_DATA.ipi_queues[index].msgQ[0]);
@@ -275,35 +327,29 @@ bool IPI_Send(enum HSSHartId target, enum IPIMessagesEnum message, TxId_t transa
         uint32_t immediate_arg, void const *p_extended_buffer_in_ddr,
         void const *p_ancilliary_buffer_in_ddr) {
     bool result = false;
-    uint32_t i = 0u;
 
     //mHSS_DEBUG_PRINTF(LOG_NORMAL, "called with message type of %u to %d" CRLF, message, target);
 
     // find where to put the message
     uint32_t index = IPI_CalculateQueueIndex(current_hartid(), target);
-    struct IPI_Outbox_Msg *pMsg = &(IPI_DATA.ipi_queues[index].msgQ[0]);
-    bool space_available = false;
+    struct IPI_Outbox_Queue * const pQueue = &(IPI_DATA.ipi_queues[index]);
 
-    assert(pMsg != NULL);
-
-    for (i = 0u; i < IPI_MAX_NUM_QUEUE_MESSAGES; i++) {
-        if (pMsg->msg_type == IPI_MSG_NO_MESSAGE) {
-            space_available = true;
-            break;
-        } else {
-            //mHSS_DEBUG_PRINTF(LOG_NORMAL, "pMsg: %p, index: %u, msg_type: %u" CRLF, pMsg, i, pMsg->msg_type);
-        }
-        pMsg++;
-    }
+    uint32_t const head = pQueue->head;
+    mb(); // ensure we see the latest tail from the consumer
+    bool space_available = ((head - pQueue->tail) < IPI_MAX_NUM_QUEUE_MESSAGES);
 
     if (space_available) {
+        struct IPI_Outbox_Msg *pMsg = &(pQueue->msgQ[head & IPI_QUEUE_INDEX_MASK]);
+
         pMsg->msg_type = message;
         pMsg->transaction_id = transaction_id;
         pMsg->p_extended_buffer_in_ddr = (void *)p_extended_buffer_in_ddr;
         pMsg->p_ancilliary_buffer_in_ddr = (void *)p_ancilliary_buffer_in_ddr;
         pMsg->immediate_arg = immediate_arg;
 
-        IPI_DATA.txId_per_queue.last[index] = transaction_id;
+        mb(); // publish the message contents before the new head
+        pQueue->head = head + 1u;
+        mHSS_TRACE(HSS_TRACE_EVT_IPI_SEND, (uint32_t)target, (uint32_t)message, (uint32_t)transaction_id);
 
 #if IS_ENABLED(CONFIG_HSS_USE_IHC)
         const uint32_t hss_message[] = { (uint32_t)message, (uint32_t)transaction_id, 0x0, 0x0 };
@@ -358,27 +404,15 @@ bool IPI_PollReceive(union HSSHartBitmask hartMask)
 
         // myHartId => target, i => source
         uint32_t const index = IPI_CalculateQueueIndex(i, myHartId);
-        if (IPI_DATA.txId_per_queue.shadow[index] == IPI_DATA.txId_per_queue.last[index]) {
+        mb();
+        uint32_t const head = IPI_DATA.ipi_queues[index].head;
+
+        if (IPI_DATA.shadow_head[index] == head) {
             // nothing new since last time, so continue
             continue;
         } else {
-            IPI_DATA.txId_per_queue.shadow[index] = IPI_DATA.txId_per_queue.last[index];
-
-            uint32_t countPerQueue = 0u;
-            uint32_t j;
-
-            for (j = 0u; j < IPI_MAX_NUM_QUEUE_MESSAGES; j++) {
-                if (IPI_DATA.ipi_queues[index].msgQ[j].msg_type != IPI_MSG_NO_MESSAGE) {
-                    result = true; // incoming message to handle
-                    countPerQueue++;
-
-                    //if (result) { mHSS_DEBUG_PRINTF(NLOG_ORMAL, "q(%u)/msg(%u): received IPI (type %d)"
-                    //     CRLF, index, j, IPI_DATA.ipi_queues[index].msgQ[j].msg_type); }
-                }
-            }
-
-            IPI_DATA.ipi_queues[index].count = countPerQueue;
-            result = true;
+            IPI_DATA.shadow_head[index] = head;
+            result = true; // incoming message(s) to handle
         }
     }
 
@@ -396,13 +430,16 @@ bool IPI_ConsumeIntent(enum HSSHartId source, enum IPIMessagesEnum msg_type)
     {
         // find appropriate starting point
         uint32_t const index = IPI_CalculateQueueIndex(source, myHartId);
-        struct IPI_Outbox_Msg *pMsg = &(IPI_DATA.ipi_queues[index].msgQ[0]);
+        struct IPI_Outbox_Queue * const pQueue = &(IPI_DATA.ipi_queues[index]);
+        struct IPI_Outbox_Msg *pMsg = NULL;
         IPI_handlerFunction pHandler = NULL;
 
-        assert(pMsg != NULL);
+        mb();
+        uint32_t const head = pQueue->head;
+        mb(); // ensure head is read before the message contents it publishes
 
         // search for handler function...
-        uint32_t j=0u;
+        uint32_t j;
 
         // direct look-up for speed into the table
         // to make this safer, we'll ensure its within range, and we'll also
@@ -416,8 +453,11 @@ bool IPI_ConsumeIntent(enum HSSHartId source, enum IPIMessagesEnum msg_type)
             }
         }
 
-        // check the queue for a message of the required type
-        for (j = 0u; j < IPI_MAX_NUM_QUEUE_MESSAGES; j++) {
+        // check the pending messages for one of the required type - in the common case,
+        // this is the message at the tail, so the search terminates immediately
+        for (j = pQueue->tail; j != head; j++) {
+            pMsg = &(pQueue->msgQ[j & IPI_QUEUE_INDEX_MASK]);
+
             if (pMsg->msg_type == msg_type) {
 #if IS_ENABLED(CONFIG_DEBUG_MSCGEN_IPI)
                 mHSS_DEBUG_PRINTF(LOG_NORMAL, "::mscgen: %s->%s %s %u %u %p %p" CRLF,
@@ -434,7 +474,6 @@ bool IPI_ConsumeIntent(enum HSSHartId source, enum IPIMessagesEnum msg_type)
                     break;
                 }
             }
-            pMsg++;
         }
 
         // if we found the intent we were looking for, and also have a valid handler for it
@@ -443,12 +482,20 @@ bool IPI_ConsumeIntent(enum HSSHartId source, enum IPIMessagesEnum msg_type)
         if (pHandler && intentFound) {
             enum IPIStatusCode result;
 
+            // the slot is freed before the handler runs, as retiring (including from any
+            // nested consume by the handler) may move the messages still in the queue
+            struct IPI_Outbox_Msg const msg = *pMsg;
+            pMsg->msg_type = IPI_MSG_NO_MESSAGE;
+            pMsg = NULL;
+
             assert(pHandler != NULL);
             IPI_DATA.mpfs_ipi_privateData[current_hartid()].consume_intents++;
-            result = (*pHandler)(pMsg->transaction_id, source,
-                pMsg->immediate_arg, pMsg->p_extended_buffer_in_ddr, pMsg->p_ancilliary_buffer_in_ddr);
+            mHSS_TRACE(HSS_TRACE_EVT_IPI_CONSUME, (uint32_t)source, (uint32_t)msg_type,
+                (uint32_t)msg.transaction_id);
+            result = (*pHandler)(msg.transaction_id, source,
+                msg.immediate_arg, msg.p_extended_buffer_in_ddr, msg.p_ancilliary_buffer_in_ddr);
 
-            switch (pMsg->msg_type) {
+            switch (msg.msg_type) {
             case IPI_MSG_ACK_COMPLETE:
                 break;
             case IPI_MSG_ACK_PENDING:
@@ -457,17 +504,17 @@ bool IPI_ConsumeIntent(enum HSSHartId source, enum IPIMessagesEnum msg_type)
                 switch (result) {
                 case IPI_SUCCESS:
                     //mHSS_DEBUG_PRINTF(LOG_NORMAL, "sending ACK_COMPLETE on txId %u" CRLF,
-                    //    pMsg->transaction_id);
-                    IPI_Send(source, IPI_MSG_ACK_COMPLETE, pMsg->transaction_id, IPI_SUCCESS, NULL, NULL);
+                    //    msg.transaction_id);
+                    IPI_Send(source, IPI_MSG_ACK_COMPLETE, msg.transaction_id, IPI_SUCCESS, NULL, NULL);
                     break;
 
                 case IPI_PENDING:
-                    IPI_Send(source, IPI_MSG_ACK_PENDING, pMsg->transaction_id, IPI_PENDING, NULL, NULL);
+                    IPI_Send(source, IPI_MSG_ACK_PENDING, msg.transaction_id, IPI_PENDING, NULL, NULL);
                     break;
 
                 default:
                 case IPI_FAIL:
-                    IPI_Send(source, IPI_MSG_ACK_COMPLETE, pMsg->transaction_id, IPI_FAIL, NULL, NULL);
+                    IPI_Send(source, IPI_MSG_ACK_COMPLETE, msg.transaction_id, IPI_FAIL, NULL, NULL);
                     break;
 
                 case IPI_IDLE:
@@ -476,9 +523,9 @@ bool IPI_ConsumeIntent(enum HSSHartId source, enum IPIMessagesEnum msg_type)
                     break;
                 }
             }
-
-            pMsg->msg_type = IPI_MSG_NO_MESSAGE;
         }
+
+        IPI_RetireConsumed_(pQueue);
     }
 
     if (!intentFound) {
@@ -519,35 +566,63 @@ bool IPI_QueuesInit(void)
         IPI_DATA.my_transaction_id[i] = 1u;
     }
 
+    for (unsigned int i = 0u; i < IPI_MAX_NUM_OUTSTANDING_COMPLETES; i++) {
+        IPI_DATA.ipi_completes_free[i / 64u] |= (1llu << (i % 64u));
+    }
+
     IPI_DATA.ipi_version = IPI_VERSION;
+    ipiQueuesInitialized_ = true;
 
     return true;
 }
 
+bool IPI_QueuesInitialized(void)
+{
+    return ipiQueuesInitialized_;
+}
+
 bool IPI_MessageAlloc(uint32_t *indexOut)
 {
-    uint32_t index;
+    uint32_t index = 0u;
     bool result = false;
 
     assert(indexOut != NULL);
 
-    for (index = 0u; index < IPI_MAX_NUM_OUTSTANDING_COMPLETES; index++) {
-        if (!IPI_DATA.ipi_completes[index].used) {
-            IPI_DATA.ipi_completes[index].used = true;
-            IPI_DATA.ipi_completes[index].transaction_id =
-                IPI_DATA.my_transaction_id[current_hartid()];;
+    // completion slots are shared by all harts, so claim a free slot atomically
+    for (uint32_t word = 0u; word < IPI_COMPLETES_BITMAP_WORDS; word++) {
+        uint64_t freeBits = __atomic_load_n(&IPI_DATA.ipi_completes_free[word], __ATOMIC_ACQUIRE);
 
-            IPI_DATA.ipi_completes[index].status = IPI_PENDING;
-            IPI_DATA.my_transaction_id[current_hartid()]++;
+        while (freeBits) {
+            uint64_t const bit = freeBits & -freeBits;
+            uint64_t const prevBits = __atomic_fetch_and(&IPI_DATA.ipi_completes_free[word], ~bit,
+                __ATOMIC_ACQ_REL);
 
-            result = true;
-            *indexOut = index;
-            break;
+            if (prevBits & bit) {
+                index = (word * 64u) + (uint32_t)__builtin_ctzll(bit);
+                result = true;
+                break;
+            }
+
+            freeBits = prevBits & ~bit; // lost a race for this slot, try the next
         }
+
+        if (result) { break; }
     }
 
     if (result) {
+        struct IPI_Complete * const pComplete = &(IPI_DATA.ipi_completes[index]);
+
+        uint32_t generation = (IPI_TXID_TO_GEN(pComplete->transaction_id) + 1u) & IPI_TXID_SLOT_MASK;
+        if (!generation) { generation = 1u; } // never hand out generation 0
+
+        pComplete->transaction_id = IPI_MAKE_TXID(generation, index);
+        pComplete->status = IPI_PENDING;
+        pComplete->used = true;
+
+        IPI_DATA.my_transaction_id[current_hartid()] = pComplete->transaction_id;
         IPI_DATA.mpfs_ipi_privateData[current_hartid()].message_allocs++;
+
+        *indexOut = index;
     }
 
     return result;
@@ -605,17 +680,18 @@ bool IPI_MessageCheckIfComplete(uint32_t index)
 bool IPI_MessageUpdateStatus(TxId_t transaction_id, enum IPIStatusCode status)
 {
     bool result = false;
-    uint32_t index;
+    uint32_t const index = IPI_TXID_TO_SLOT(transaction_id);
 
-    for (index = 0u; index < IPI_MAX_NUM_OUTSTANDING_COMPLETES; index++) {
-        if (IPI_DATA.ipi_completes[index].transaction_id == transaction_id) {
-            //mHSS_DEBUG_PRINTF(LOG_NORMAL, "index is %u, TxId is %u, status is %d" CRLF,
-            //    index, transaction_id, status);
-            IPI_DATA.ipi_completes[index].status = status;
+    // the slot is encoded in the transaction ID, and a stale ID will not match the
+    // generation currently held in that slot
+    if ((index < IPI_MAX_NUM_OUTSTANDING_COMPLETES)
+            && (IPI_DATA.ipi_completes[index].used)
+            && (IPI_DATA.ipi_completes[index].transaction_id == transaction_id)) {
+        //mHSS_DEBUG_PRINTF(LOG_NORMAL, "index is %u, TxId is %u, status is %d" CRLF,
+        //    index, transaction_id, status);
+        IPI_DATA.ipi_completes[index].status = status;
 
-            result = true;
-            break;
-        }
+        result = true;
     }
 
     return result;
@@ -623,9 +699,13 @@ bool IPI_MessageUpdateStatus(TxId_t transaction_id, enum IPIStatusCode status)
 
 void IPI_MessageFree(uint32_t index)
 {
+    assert(index < IPI_MAX_NUM_OUTSTANDING_COMPLETES);
     assert(IPI_DATA.ipi_completes[index].used);
     IPI_DATA.ipi_completes[index].used = false;
 
+    __atomic_fetch_or(&IPI_DATA.ipi_completes_free[index / 64u], (1llu << (index % 64u)),
+        __ATOMIC_RELEASE);
+
     IPI_DATA.mpfs_ipi_privateData[current_hartid()].message_frees++;
 
     //mHSS_DEBUG_PRINTF(LOG_NORMAL, "index is %u, TxId is %u" CRLF, index,
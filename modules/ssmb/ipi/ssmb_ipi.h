@@ -42,8 +42,24 @@ extern "C" {
 #include "hss_types.h"
 
 #define IPI_MAX_NUM_QUEUE_MESSAGES ((unsigned long)CONFIG_IPI_MAX_NUM_QUEUE_MESSAGES)
+#define IPI_QUEUE_INDEX_MASK (IPI_MAX_NUM_QUEUE_MESSAGES - 1u)
+
+#if (CONFIG_IPI_MAX_NUM_QUEUE_MESSAGES & (CONFIG_IPI_MAX_NUM_QUEUE_MESSAGES - 1))
+#  error CONFIG_IPI_MAX_NUM_QUEUE_MESSAGES must be a power of 2
+#endif
 #define IPI_MAX_NUM_OUTSTANDING_COMPLETES (IPI_MAX_NUM_QUEUE_MESSAGES * (HSS_HART_NUM_PEERS-1u))
 
+/*
+ * Transaction IDs encode the index of their completion slot in the low bits, and a
+ * per-slot generation count in the high bits, so that completions can be looked up
+ * directly and stale IDs detected.
+ */
+#define IPI_TXID_SLOT_BITS      (16u)
+#define IPI_TXID_SLOT_MASK      ((1u << IPI_TXID_SLOT_BITS) - 1u)
+#define IPI_TXID_TO_SLOT(txId)  ((uint32_t)(txId) & IPI_TXID_SLOT_MASK)
+#define IPI_TXID_TO_GEN(txId)   ((uint32_t)(txId) >> IPI_TXID_SLOT_BITS)
+#define IPI_MAKE_TXID(gen, slot) ((TxId_t)(((uint32_t)(gen) << IPI_TXID_SLOT_BITS) | (uint32_t)(slot)))
+
 /**
  * \brief IPI Outbox Enumeration
  */
@@ -100,6 +116,8 @@ enum IPIMessagesEnum {
     IPI_MSG_CONTINUE,
     IPI_MSG_GOTO,
     IPI_MSG_OPENSBI_INIT,
+    IPI_MSG_MEMTEST,
+    IPI_MSG_ZEROFILL,
     IPI_MSG_NUM_MSG_TYPES,
 };
 
@@ -134,10 +152,17 @@ struct IPI_Outbox_Msg {
 
 /**
  * \brief IPI Outbox Queue Structure
+ *
+ * Each outbox is a single-producer/single-consumer ring. head is only ever written by
+ * the source hart, and tail is only ever written by the target hart. Both are free-running
+ * and are masked with IPI_QUEUE_INDEX_MASK to give a slot index. Messages are consumed by
+ * type, so may be consumed out of order; the target hart compacts the pending messages
+ * towards head as it retires slots, so head - tail is always the number still pending.
  */
 struct IPI_Outbox_Queue {
     struct IPI_Outbox_Msg msgQ[IPI_MAX_NUM_QUEUE_MESSAGES];
-    uint32_t count;
+    uint32_t head;
+    uint32_t tail;
 };
 
 struct IPI_Complete {
@@ -165,6 +190,7 @@ bool IPI_Send(enum HSSHartId target, enum IPIMessagesEnum message, TxId_t transa
         void const *p_extended_buffer_in_ddr, void const *p_ancilliary_buffer_in_ddr);
 bool IPI_PollReceive(union HSSHartBitmask hartMask);
 bool IPI_QueuesInit(void);
+bool IPI_QueuesInitialized(void);
 bool IPI_ConsumeIntent(enum HSSHartId source, enum IPIMessagesEnum msg_type);
 uint32_t IPI_GetQueuePendingCount(uint32_t queueIndex);
 
@@ -22,6 +22,7 @@
 #include "hss_boot_secure.h"
 
 #include <assert.h>
+#include <stddef.h>
 #include <string.h>
 
 static void __attribute__((__noreturn__)) boot_secure_failure_(void)
@@ -40,20 +41,78 @@ static void __attribute__((__noreturn__)) boot_secure_failure_(void)
 
 static int perf_ctr_index = PERF_CTR_UNINITIALIZED;
 
+// image being hashed as it is copied in
+static struct {
+    struct HSS_BootImage *pBootImage;
+    struct HSS_Signature signature __attribute__((aligned));
+    size_t bytesHashed;
+    bool active;
+} stream_;
+
+void HSS_Boot_Secure_StreamReset(void)
+{
+    if (stream_.active) {
+        // close the abandoned verification, whatever it would have returned
+        (void)HSS_Crypto_Verify_ECDSA_P384_Finalize();
+    }
+
+    memset(&stream_, 0, sizeof(stream_));
+}
+
+void HSS_Boot_Secure_StreamBegin(struct HSS_BootImage const *pHeader, struct HSS_BootImage *pBootImage)
+{
+    stream_.pBootImage = pBootImage;
+    stream_.signature = pHeader->signature;
+    stream_.bytesHashed = 0u;
+    stream_.active = HSS_Crypto_Verify_ECDSA_P384_Init(ARRAY_SIZE(stream_.signature.ecdsaSig),
+        &(stream_.signature.ecdsaSig[0]), pHeader->bootImageLength);
+}
+
+void HSS_Boot_Secure_StreamUpdate(size_t numBytes)
+{
+    if (stream_.active) {
+        uint8_t * const pImage = (uint8_t *)stream_.pBootImage;
+        size_t const sigStart = offsetof(struct HSS_BootImage, signature);
+        size_t const sigEnd = sigStart + sizeof(struct HSS_Signature);
+        size_t const chunkStart = stream_.bytesHashed;
+        size_t const chunkEnd = chunkStart + numBytes;
+
+        // images are signed with the signature itself zeroed
+        if ((chunkStart < sigEnd) && (chunkEnd > sigStart)) {
+            size_t const zeroStart = (chunkStart > sigStart) ? chunkStart : sigStart;
+            size_t const zeroEnd = MIN(chunkEnd, sigEnd);
+
+            memset(pImage + zeroStart, 0, zeroEnd - zeroStart);
+        }
+
+        stream_.active = HSS_Crypto_Verify_ECDSA_P384_Update(numBytes, pImage + chunkStart);
+        stream_.bytesHashed = chunkEnd;
+    }
+}
+
 bool HSS_Boot_Secure_CheckCodeSigning(struct HSS_BootImage *pBootImage)
 {
     bool result = false;
 
     assert(pBootImage != NULL);
 
-    struct HSS_Signature originalSig __attribute__((aligned)) = pBootImage->signature;
-    memset((void *)&(pBootImage->signature), 0, sizeof(struct HSS_Signature));
-
     HSS_PerfCtr_Allocate(&perf_ctr_index, "SecureBoot");
     HSS_PerfCtr_Start(perf_ctr_index);
 
-    result = HSS_Crypto_Verify_ECDSA_P384(ARRAY_SIZE(originalSig.ecdsaSig), &(originalSig.ecdsaSig[0]),
-        pBootImage->bootImageLength, (uint8_t *)pBootImage);
+    if (stream_.active && (stream_.pBootImage == pBootImage)
+            && (stream_.bytesHashed == pBootImage->bootImageLength)) {
+        // already hashed as it was copied in, so only the signature check remains
+        stream_.active = false;
+        result = HSS_Crypto_Verify_ECDSA_P384_Finalize();
+    } else {
+        stream_.active = false;
+
+        struct HSS_Signature originalSig __attribute__((aligned)) = pBootImage->signature;
+        memset((void *)&(pBootImage->signature), 0, sizeof(struct HSS_Signature));
+
+        result = HSS_Crypto_Verify_ECDSA_P384(ARRAY_SIZE(originalSig.ecdsaSig), &(originalSig.ecdsaSig[0]),
+            pBootImage->bootImageLength, (uint8_t *)pBootImage);
+    }
 
     if (!result) {
         boot_secure_failure_();
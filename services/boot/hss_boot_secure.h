@@ -18,4 +18,15 @@
 
 bool HSS_Boot_Secure_CheckCodeSigning(struct HSS_BootImage *pBootImage) __attribute__((nonnull));
 
+//
+// Hashing can be overlapped with copying the image into memory: begin with the header read
+// from storage and the image's destination, then update as each piece of the image lands,
+// in order. HSS_Boot_Secure_CheckCodeSigning() then only needs to check the signature.
+// Each copy must reset the stream first, so that an earlier copy to the same destination
+// is never taken to have hashed the current image.
+//
+void HSS_Boot_Secure_StreamReset(void);
+void HSS_Boot_Secure_StreamBegin(struct HSS_BootImage const *pHeader, struct HSS_BootImage *pBootImage) __attribute__((nonnull));
+void HSS_Boot_Secure_StreamUpdate(size_t numBytes);
+
 #endif
@@ -23,6 +23,7 @@
 #include "hss_clock.h"
 #include "hss_debug.h"
 #include "hss_perfctr.h"
+#include "hss_crc32.h"
 
 #include <assert.h>
 #include <string.h>
@@ -51,6 +52,8 @@
 #endif
 
 #include "hss_memcpy_via_pdma.h"
+#include "hss_zerofill.h"
+#include "hss_boot_timeline.h"
 #include "system_startup.h"
 #include "fpga_design_config/fpga_design_config.h"
 
@@ -61,6 +64,18 @@
 
 #define BOOT_SUB_CHUNK_SIZE 256u
 
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_ADAPTIVE_SUB_CHUNK)
+#  define BOOT_SUB_CHUNK_MAX_SIZE       ((size_t)CONFIG_SERVICE_BOOT_SUB_CHUNK_MAX_SIZE)
+#  define BOOT_SUB_CHUNK_TIME_SLICE     \
+    ((CONFIG_SERVICE_BOOT_SUB_CHUNK_TIME_SLICE_USEC * TICKS_PER_MILLISEC) / 1000llu)
+#  if (CONFIG_SERVICE_BOOT_SUB_CHUNK_MAX_SIZE & (CONFIG_SERVICE_BOOT_SUB_CHUNK_MAX_SIZE - 1))
+#    error CONFIG_SERVICE_BOOT_SUB_CHUNK_MAX_SIZE must be a power of 2
+#  endif
+#  if (CONFIG_SERVICE_BOOT_SUB_CHUNK_MAX_SIZE < 256)
+#    error CONFIG_SERVICE_BOOT_SUB_CHUNK_MAX_SIZE must be at least BOOT_SUB_CHUNK_SIZE
+#  endif
+#endif
+
 /*
  * Module Prototypes (states)
  */
@@ -83,9 +98,10 @@ static void boot_error_handler(struct StateMachine * const pMyMachine);
 static void boot_idle_onEntry(struct StateMachine * const pMyMachine);
 static void boot_idle_handler(struct StateMachine * const pMyMachine);
 
-static void boot_do_download_chunk(struct HSS_BootChunkDesc const *pChunk,
-    ptrdiff_t subChunkOffset, size_t subChunkSize);
+static bool boot_do_download_chunk(struct HSS_BootChunkDesc const *pChunk,
+    ptrdiff_t subChunkOffset, size_t subChunkSize, HSS_PDMA_Txn_t *pTxn);
 static void boot_do_zero_init_chunk(struct HSS_BootZIChunkDesc const *pZiChunk);
+static void boot_dump_stats(struct StateMachine * const pMyMachine);
 
 /*!
  * \brief Boot Driver States
@@ -136,14 +152,34 @@ struct HSS_Boot_LocalData {
     unsigned int iterator;
     uintptr_t ancilliaryData;
     uint32_t msgIndexAux[MAX_NUM_HARTS-1];
+    uint32_t chunkCrc;
+    size_t subChunkSize;
+    size_t maxSubChunkSize;
+    uint64_t bytesDownloaded;
+    HSSTicks_t downloadStartTime;
+    HSSTicks_t downloadTime;
+    HSS_PDMA_Txn_t pdmaTxn;
+    int subChunkPerfCtr;
+    HSSTicks_t subChunkStartTime;
+    size_t subChunkBytes;
+    struct HSS_BootChunkDesc const *pSubChunk;
+    size_t subChunkChunkIndex;
+    uintptr_t subChunkDest;
+    bool subChunkIsLast;
+    struct HSS_ZeroFill_Job ziJob;
+    HSSBootPhaseHandle_t timelinePhase;
 };
 
 
 static struct HSS_Boot_LocalData localData[MAX_NUM_HARTS-1] = {
-    { HSS_HART_U54_1, NULL, NULL, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u } },
-    { HSS_HART_U54_2, NULL, NULL, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u } },
-    { HSS_HART_U54_3, NULL, NULL, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u } },
-    { HSS_HART_U54_4, NULL, NULL, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u } },
+    { HSS_HART_U54_1, NULL, NULL, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u }, 0u,
+        BOOT_SUB_CHUNK_SIZE, BOOT_SUB_CHUNK_SIZE, 0u, 0u, 0u, 0u, PERF_CTR_UNINITIALIZED },
+    { HSS_HART_U54_2, NULL, NULL, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u }, 0u,
+        BOOT_SUB_CHUNK_SIZE, BOOT_SUB_CHUNK_SIZE, 0u, 0u, 0u, 0u, PERF_CTR_UNINITIALIZED },
+    { HSS_HART_U54_3, NULL, NULL, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u }, 0u,
+        BOOT_SUB_CHUNK_SIZE, BOOT_SUB_CHUNK_SIZE, 0u, 0u, 0u, 0u, PERF_CTR_UNINITIALIZED },
+    { HSS_HART_U54_4, NULL, NULL, 0u, 0u, 0u, IPI_MAX_NUM_OUTSTANDING_COMPLETES, 0u, PERF_CTR_UNINITIALIZED, 0u, 0u, { 0u, 0u, 0u, 0u }, 0u,
+        BOOT_SUB_CHUNK_SIZE, BOOT_SUB_CHUNK_SIZE, 0u, 0u, 0u, 0u, PERF_CTR_UNINITIALIZED },
 };
 
 struct HSS_BootImage *pBootImage = NULL;
@@ -163,6 +199,7 @@ struct StateMachine boot_service1 = {
     .pStateDescs       = boot_state_descs,
     .debugFlag         = true,
     .priority          = 0u,
+    .dumpStats         = boot_dump_stats,
     .pInstanceData     = (void *)&localData[0]
 };
 
@@ -177,6 +214,7 @@ struct StateMachine boot_service2 = {
     .pStateDescs       = boot_state_descs,
     .debugFlag         = true,
     .priority          = 0u,
+    .dumpStats         = boot_dump_stats,
     .pInstanceData     = (void *)&localData[1]
 };
 
@@ -191,6 +229,7 @@ struct StateMachine boot_service3 = {
     .pStateDescs       = boot_state_descs,
     .debugFlag         = true,
     .priority          = 0u,
+    .dumpStats         = boot_dump_stats,
     .pInstanceData     = (void *)&localData[2]
 };
 
@@ -205,6 +244,7 @@ struct StateMachine boot_service4 = {
     .pStateDescs       = boot_state_descs,
     .debugFlag         = true,
     .priority          = 0u,
+    .dumpStats         = boot_dump_stats,
     .pInstanceData     = (void *)&localData[3]
 };
 
@@ -240,15 +280,116 @@ const struct {
  * This checks are done outside this function.
  *
  */
-static void boot_do_download_chunk(struct HSS_BootChunkDesc const *pChunk, ptrdiff_t subChunkOffset,
-    size_t subChunkSize)
+/*!
+ * \brief Download a sub-chunk
+ *
+ * If pTxn is NULL, the copy completes before returning. Otherwise, it is submitted
+ * asynchronously and false is returned if no PDMA channel was available.
+ */
+static bool boot_do_download_chunk(struct HSS_BootChunkDesc const *pChunk, ptrdiff_t subChunkOffset,
+    size_t subChunkSize, HSS_PDMA_Txn_t *pTxn)
 {
+    bool result = true;
+
     assert(pChunk);
     assert(pChunk->size);
 
     const uintptr_t execAddr = (uintptr_t)pChunk->execAddr + subChunkOffset;
     const uintptr_t loadAddr = (uintptr_t)pBootImage + (uintptr_t)pChunk->loadAddr + subChunkOffset;
-    memcpy_via_pdma((void *)execAddr, (void*)loadAddr, subChunkSize);
+    if (pTxn) {
+        result = memcpy_via_pdma_submit((void *)execAddr, (void*)loadAddr, subChunkSize, pTxn);
+    } else {
+        memcpy_via_pdma((void *)execAddr, (void*)loadAddr, subChunkSize);
+    }
+
+    return result;
+}
+
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_VERIFY_CHUNK_CRC)
+/*!
+ * \brief Update running CRC of a chunk
+ *
+ * Called for each sub-chunk once its copy has completed, so that the chunk CRC covers
+ * what was written to the destination, and so catches a bad copy as well as a bad image.
+ * On the last sub-chunk of a chunk, the CRC is checked and restarted.
+ */
+static bool boot_update_chunk_crc(struct StateMachine * const pMyMachine)
+{
+    struct HSS_Boot_LocalData * const pInstanceData = pMyMachine->pInstanceData;
+    bool result = true;
+
+    pInstanceData->chunkCrc = CRC32_calculate_ex(pInstanceData->chunkCrc,
+        (uint8_t const *)pInstanceData->subChunkDest, pInstanceData->subChunkBytes);
+
+    if (pInstanceData->subChunkIsLast) {
+        uint32_t const expectedCrc = pInstanceData->pSubChunk->crc32;
+
+        if (pInstanceData->chunkCrc != expectedCrc) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "%s::%d:chunk CRC mismatch (calculated %08x vs expected %08x)" CRLF,
+                pMyMachine->pMachineName, pInstanceData->subChunkChunkIndex,
+                pInstanceData->chunkCrc, expectedCrc);
+            result = false;
+        }
+        pInstanceData->chunkCrc = 0u;
+    }
+
+    return result;
+}
+#endif
+
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_ADAPTIVE_SUB_CHUNK)
+/*!
+ * \brief Adapt sub-chunk size to the superloop load
+ *
+ * The sub-chunk size is halved whenever the last superloop iteration (or this copy) took
+ * longer than the target time slice, so that the UART, watchdog and IPI state machines keep
+ * getting serviced. It is doubled whenever the superloop ran in under half the time slice.
+ */
+static void boot_adapt_sub_chunk_size(struct HSS_Boot_LocalData * const pInstanceData,
+    size_t bytesCopied, HSSTicks_t copyTime)
+{
+    HSSTicks_t const loopTime = GetStateMachinesLastLoopTime();
+
+    if ((loopTime > BOOT_SUB_CHUNK_TIME_SLICE) || (copyTime > BOOT_SUB_CHUNK_TIME_SLICE)) {
+        if (pInstanceData->subChunkSize > BOOT_SUB_CHUNK_SIZE) {
+            pInstanceData->subChunkSize >>= 1;
+        }
+    } else if ((loopTime < (BOOT_SUB_CHUNK_TIME_SLICE / 2u))
+        && (bytesCopied == pInstanceData->subChunkSize)) {
+        // only grow on full sub-chunks, as a chunk tail says nothing about the budget
+        if (pInstanceData->subChunkSize < BOOT_SUB_CHUNK_MAX_SIZE) {
+            pInstanceData->subChunkSize <<= 1;
+        }
+    }
+
+    if (pInstanceData->subChunkSize > pInstanceData->maxSubChunkSize) {
+        pInstanceData->maxSubChunkSize = pInstanceData->subChunkSize;
+    }
+}
+#endif
+
+/*!
+ * \brief Account for a completed sub-chunk copy
+ *
+ * The copy time runs from submission to PDMA completion, as seen by the state machine, so
+ * for asynchronous transfers it is only known once the poll has seen the channels go idle.
+ * Returns false if the chunk CRC check failed.
+ */
+static bool boot_sub_chunk_done(struct StateMachine * const pMyMachine)
+{
+    struct HSS_Boot_LocalData * const pInstanceData = pMyMachine->pInstanceData;
+    HSSTicks_t const copyTime = HSS_GetTime() - pInstanceData->subChunkStartTime;
+    bool result = true;
+
+    HSS_PerfCtr_Record(pInstanceData->subChunkPerfCtr, copyTime);
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_ADAPTIVE_SUB_CHUNK)
+    boot_adapt_sub_chunk_size(pInstanceData, pInstanceData->subChunkBytes, copyTime);
+#endif
+#if IS_ENABLED(CONFIG_SERVICE_BOOT_VERIFY_CHUNK_CRC)
+    result = boot_update_chunk_crc(pMyMachine);
+#endif
+
+    return result;
 }
 
 static void boot_do_zero_init_chunk(struct HSS_BootZIChunkDesc const *pZiChunk)
@@ -258,7 +399,7 @@ static void boot_do_zero_init_chunk(struct HSS_BootZIChunkDesc const *pZiChunk)
     const uintptr_t execAddr = (uintptr_t)pZiChunk->execAddr;
     const size_t ziChunkSize = pZiChunk->size;
 
-    memset((void *)execAddr, 0, ziChunkSize);
+    HSS_ZeroFill((void *)execAddr, ziChunkSize);
 }
 
 static void free_msg_index(struct HSS_Boot_LocalData * const pInstanceData)
@@ -322,6 +463,8 @@ static void boot_init_handler(struct StateMachine * const pMyMachine)
         }
 
         HSS_PerfCtr_Allocate(&pInstanceData->perfCtr, pMyMachine->pMachineName);
+        HSS_PerfCtr_AllocateChild(&pInstanceData->subChunkPerfCtr, "sub-chunk copy", pInstanceData->perfCtr);
+        pInstanceData->timelinePhase = mHSS_BOOT_PHASE_BEGIN_ASYNC(pMyMachine->pMachineName);
 
         pMyMachine->state = BOOT_SETUP_PMP;
     } else {
@@ -448,6 +591,11 @@ static void boot_zero_init_chunks_handler(struct StateMachine * const pMyMachine
     assert(pBootImage != NULL);
     struct HSS_BootZIChunkDesc const *pZiChunk = pInstanceData->pZiChunk;
 
+    // let the previous region be zeroed, servicing other state machines meanwhile
+    if (!HSS_ZeroFill_Poll(&pInstanceData->ziJob)) {
+        return;
+    }
+
     if (pZiChunk->size != 0u) {
         if (target == pZiChunk->owner) {
 #if IS_ENABLED(CONFIG_DEBUG_CHUNK_DOWNLOADS)
@@ -455,7 +603,8 @@ static void boot_zero_init_chunks_handler(struct StateMachine * const pMyMachine
                 pMyMachine->pMachineName, pInstanceData->ziChunkCount,
                 (uintptr_t)pZiChunk->execAddr, pZiChunk->size);
 #endif
-            boot_do_zero_init_chunk(pZiChunk);
+            // the owning hart is waiting to be booted, so it can zero its own region
+            HSS_ZeroFill_Submit(&pInstanceData->ziJob, target, pZiChunk->execAddr, pZiChunk->size);
         }
         pInstanceData->pZiChunk++;
     } else {
@@ -489,6 +638,10 @@ static void boot_download_chunks_onEntry(struct StateMachine * const pMyMachine)
 
         pInstanceData->chunkCount = 0u;
         pInstanceData->subChunkOffset = 0u;
+        pInstanceData->chunkCrc = 0u;
+        pInstanceData->bytesDownloaded = 0u;
+        pInstanceData->downloadTime = 0u;
+        pInstanceData->downloadStartTime = HSS_GetTime();
         pInstanceData->pChunk += pBootImage->hart[target-1].firstChunk;
     } else {
         // nothing to do for this machine, numChunks is zero...
@@ -502,6 +655,17 @@ static void boot_download_chunks_handler(struct StateMachine * const pMyMachine)
 
     assert(pBootImage != NULL);
 
+    // let the previous sub-chunk transfer complete, servicing other state machines meanwhile
+    if (pInstanceData->pdmaTxn) {
+        if (!memcpy_via_pdma_poll(&pInstanceData->pdmaTxn)) {
+            return;
+        }
+        if (!boot_sub_chunk_done(pMyMachine)) {
+            pMyMachine->state = BOOT_ERROR;
+            return;
+        }
+    }
+
     if (pBootImage->hart[target-1].numChunks) {
         //
         // end of image is denoted by sentinel chunk with zero size...
@@ -520,14 +684,34 @@ static void boot_download_chunks_handler(struct StateMachine * const pMyMachine)
                         (uintptr_t)pChunk->execAddr, pChunk->size);
                 }
 #endif
-                // check each hart to see if it wants to transmit
-                boot_do_download_chunk(pChunk,
 #ifdef BOOT_SUB_CHUNK_SIZE
-                    pInstanceData->subChunkOffset, BOOT_SUB_CHUNK_SIZE
+                size_t const subChunkSize =
+                    MIN(pInstanceData->subChunkSize, pChunk->size - pInstanceData->subChunkOffset);
 #else
-                    0u, pChunk->size
+                size_t const subChunkSize = pChunk->size;
 #endif
-                );
+
+                pInstanceData->subChunkStartTime = HSS_GetTime();
+                pInstanceData->subChunkBytes = subChunkSize;
+                pInstanceData->pSubChunk = pChunk;
+                pInstanceData->subChunkChunkIndex = pInstanceData->chunkCount;
+                pInstanceData->subChunkDest = (uintptr_t)pChunk->execAddr + pInstanceData->subChunkOffset;
+                pInstanceData->subChunkIsLast =
+                    ((pInstanceData->subChunkOffset + subChunkSize) >= pChunk->size);
+
+                // check each hart to see if it wants to transmit
+                if (!boot_do_download_chunk(pChunk, pInstanceData->subChunkOffset, subChunkSize,
+                        &pInstanceData->pdmaTxn)) {
+                    return; // all PDMA channels busy, so try again next time
+                }
+                pInstanceData->bytesDownloaded += subChunkSize;
+
+                if (!pInstanceData->pdmaTxn) {
+                    // copied synchronously (short sub-chunk or no PDMA), so already complete
+                    if (!boot_sub_chunk_done(pMyMachine)) {
+                        pMyMachine->state = BOOT_ERROR;
+                    }
+                }
 
                 if ((pChunk->owner & BOOT_FLAG_ANCILLIARY_DATA)
                     && (!pInstanceData->ancilliaryData)) {
@@ -536,21 +720,16 @@ static void boot_download_chunks_handler(struct StateMachine * const pMyMachine)
                     pInstanceData->ancilliaryData = pChunk->execAddr;
                 }
 
-#ifdef BOOT_SUB_CHUNK_SIZE
-                pInstanceData->subChunkOffset += BOOT_SUB_CHUNK_SIZE;
-                if (pInstanceData->subChunkOffset > pChunk->size) {
-#  if IS_ENABLED(CONFIG_DEBUG_CHUNK_DOWNLOADS)
+                pInstanceData->subChunkOffset += subChunkSize;
+                if (pInstanceData->subChunkOffset >= pChunk->size) {
+#if IS_ENABLED(CONFIG_DEBUG_CHUNK_DOWNLOADS)
                     mHSS_DEBUG_PRINTF(LOG_NORMAL, "%s::%d:sub-chunk finished at 0x%x" CRLF,
                         pMyMachine->pMachineName, pInstanceData->chunkCount, pInstanceData->subChunkOffset);
-#  endif
+#endif
                     pInstanceData->subChunkOffset = 0u;
                     pInstanceData->chunkCount++;
                     pInstanceData->pChunk++;
                 }
-#else
-                pInstanceData->chunkCount++;
-                pInstanceData->pChunk++;
-#endif
             } else {
                 if (pChunk->owner == target) {
                     mHSS_DEBUG_PRINTF(LOG_ERROR,
@@ -578,6 +757,37 @@ static void boot_download_chunks_handler(struct StateMachine * const pMyMachine)
 
 static void boot_download_chunks_onExit(struct StateMachine * const pMyMachine)
 {
+    struct HSS_Boot_LocalData * const pInstanceData = pMyMachine->pInstanceData;
+
+    if (pInstanceData->pdmaTxn) {
+        // leaving early, so the CRC of an unfinished chunk no longer matters
+        memcpy_via_pdma_complete(&pInstanceData->pdmaTxn);
+        (void)boot_sub_chunk_done(pMyMachine);
+    }
+    pInstanceData->downloadTime = HSS_GetTime() - pInstanceData->downloadStartTime;
+}
+
+static void boot_dump_stats(struct StateMachine * const pMyMachine)
+{
+    struct HSS_Boot_LocalData * const pInstanceData = pMyMachine->pInstanceData;
+    HSSTicks_t downloadTime = pInstanceData->downloadTime;
+
+    if (!pInstanceData->bytesDownloaded) {
+        return;
+    }
+
+    if (pMyMachine->state == BOOT_DOWNLOAD_CHUNKS) {
+        downloadTime = HSS_GetTime() - pInstanceData->downloadStartTime;
+    }
+
+    // throughput in units of 10KB/s, so that it can be shown as MB/s with two decimal places
+    uint64_t const rate = downloadTime ?
+        ((pInstanceData->bytesDownloaded * TICKS_PER_MILLISEC) / downloadTime) / 10u : 0u;
+
+    mHSS_DEBUG_PRINTF(LOG_STATUS, "%19s  sub-chunk %" PRIu64 " (max %" PRIu64 ") bytes,"
+        " %" PRIu64 " bytes in %" PRIu64 " ticks, %" PRIu64 ".%02" PRIu64 " MB/s" CRLF, "",
+        (uint64_t)pInstanceData->subChunkSize, (uint64_t)pInstanceData->maxSubChunkSize,
+        pInstanceData->bytesDownloaded, downloadTime, rate / 100u, rate % 100u);
 }
 
 /////////////////
@@ -760,8 +970,14 @@ static void boot_error_handler(struct StateMachine * const pMyMachine)
 
 static void boot_idle_onEntry(struct StateMachine * const pMyMachine)
 {
-    struct HSS_Boot_LocalData const * const pInstanceData = pMyMachine->pInstanceData;
+    struct HSS_Boot_LocalData * const pInstanceData = pMyMachine->pInstanceData;
     HSS_PerfCtr_Lap(pInstanceData->perfCtr);
+
+    if (pInstanceData->timelinePhase) {
+        mHSS_BOOT_PHASE_END(pInstanceData->timelinePhase);
+        pInstanceData->timelinePhase = 0u;
+        mHSS_BOOT_PHASE_PUBLISH();
+    }
     //mHSS_DEBUG_PRINTF(LOG_ERROR, "%s:: now at state %d\n", pMyMachine->pMachineName, pMyMachine->state);
 }
 
@@ -769,6 +985,7 @@ static void boot_idle_handler(struct StateMachine * const pMyMachine)
 {
     struct HSS_Boot_LocalData const * const pInstanceData = pMyMachine->pInstanceData;
     IPI_ConsumeIntent(pInstanceData->target, IPI_MSG_BOOT_REQUEST); // check for boot requests
+    SleepStateMachine(pMyMachine, SM_WAKE_ON_IPI, 0u);
 }
 
 
@@ -930,7 +1147,7 @@ bool HSS_Boot_Custom(void)
 #endif
             // check each hart to see if it wants to transmit
 #ifdef BOOT_SUB_CHUNK_SIZE
-            boot_do_download_chunk(pChunk, subChunkOffset, BOOT_SUB_CHUNK_SIZE);
+            boot_do_download_chunk(pChunk, subChunkOffset, BOOT_SUB_CHUNK_SIZE, NULL);
 
             subChunkOffset += BOOT_SUB_CHUNK_SIZE;
             if (subChunkOffset > pChunk->size) {
@@ -939,7 +1156,7 @@ bool HSS_Boot_Custom(void)
                 pChunk++;
             }
 #else
-            boot_do_download_chunk(pChunk, 0u, pChunk->size);
+            boot_do_download_chunk(pChunk, 0u, pChunk->size, NULL);
             chunkNum++;
             pChunk++;
             (void)subChunkOffset;
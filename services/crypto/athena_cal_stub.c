@@ -3,6 +3,14 @@
 #include <stdbool.h>
 #include "athena_cal.h"
 
+//
+// Every CAL call here succeeds, so any signature verifies. This is for host tests of
+// the code signing path only, and must never be linked into an HSS that checks signatures
+//
+#if !defined(HSS_CAL_STUB_HOST_TEST)
+#  error "athena_cal_stub.c accepts any signature - link the User Crypto CAL library instead"
+#endif
+
 
 // General Functions
 SATR CALIni(void) {
@@ -83,6 +83,9 @@ static void ddr_idle_handler(struct StateMachine * const pMyMachine)
 
     if (HSS_Timer_IsElapsed(pMyMachine->startTime, (HSSTicks_t)DDR_IDLE_PERIODIC_TIMEOUT)) {
         pMyMachine->state = DDR_RETRAIN;
+    } else {
+        SleepStateMachine(pMyMachine, SM_WAKE_ON_TIMER,
+            pMyMachine->startTime + (HSSTicks_t)DDR_IDLE_PERIODIC_TIMEOUT + 1u);
     }
 }
 
@@ -25,6 +25,7 @@
 #include "csr_helper.h"
 
 #include "ipi_poll_service.h"
+#include "hss_perfctr.h"
 
 
 static void ipiPoll_init_handler(struct StateMachine * const pMyMachine);
@@ -86,7 +87,14 @@ static void ipiPoll_monitoring_handler(struct StateMachine * const pMyMachine)
     (void) pMyMachine;
 
     // poll IPIs each iteration for new messages
+    static int perfCtr = PERF_CTR_UNINITIALIZED;
+    if (IS_ENABLED(CONFIG_DEBUG_PERF_CTRS) && (perfCtr == PERF_CTR_UNINITIALIZED)) {
+        HSS_PerfCtr_Allocate(&perfCtr, "IPI_PollReceive");
+    }
+
+    HSS_PerfCtr_Start(perfCtr);
     bool const status = IPI_PollReceive(hartBitmask);
+    HSS_PerfCtr_Lap(perfCtr);
 
     enum HSSHartId const myHartId = current_hartid();
     if (status) {
@@ -102,6 +110,8 @@ static void ipiPoll_monitoring_handler(struct StateMachine * const pMyMachine)
             }
         }
     }
+
+    SleepStateMachine(pMyMachine, SM_WAKE_ON_IPI, 0u);
 }
 
 
@@ -107,30 +107,11 @@ static void mmc_reset_block(void)
         ~(uint32_t)(SOFT_RESET_CR_MMC_MASK);
 }
 
-static bool mmc_init_common(mss_mmc_cfg_t *p_mmcConfig)
-{
-    bool result = false;
-    mss_mmc_status_t retval = MSS_MMC_init(p_mmcConfig);
-
-    if (retval != MSS_MMC_INIT_SUCCESS) {
-        mmc_reset_block();
-
-        //HSS_SpinDelay_Secs(1u); // delay for 1 second
-        HSS_SpinDelay_MilliSecs(50u); // delay for 50 second
-        retval = MSS_MMC_init(p_mmcConfig);
-    }
-
-    if (retval != MSS_MMC_INIT_SUCCESS) {
-        //mHSS_DEBUG_PRINTF(LOG_ERROR, "MSS_MMC_init() returned unexpected %d" CRLF, retval);
-    } else {
-        result = true;
-    }
-
-    return result;
-}
+// a failed MSS_MMC_init() is retried once, after resetting the block and waiting this long
+#define MMC_INIT_RETRY_DELAY    (50llu * ONE_MILLISEC)
 
 #if defined(CONFIG_SERVICE_MMC_MODE_EMMC)
-static bool mmc_init_emmc(void)
+static mss_mmc_cfg_t *mmc_select_emmc(void)
 {
     SYSREG->IOMUX1_CR = LIBERO_SETTING_IOMUX1_CR_eMMC;
     SYSREG->IOMUX2_CR = LIBERO_SETTING_IOMUX2_CR_eMMC;
@@ -171,12 +152,12 @@ static bool mmc_init_emmc(void)
 #endif
     };
 
-    return mmc_init_common(&emmcConfig);
+    return &emmcConfig;
 }
 #endif
 
 #if defined(CONFIG_SERVICE_MMC_MODE_SDCARD)
-static bool mmc_init_sdcard(void)
+static mss_mmc_cfg_t *mmc_select_sdcard(void)
 {
     SYSREG->IOMUX1_CR = LIBERO_SETTING_IOMUX1_CR_SD;
     SYSREG->IOMUX2_CR = LIBERO_SETTING_IOMUX2_CR_SD;
@@ -205,18 +186,86 @@ static bool mmc_init_sdcard(void)
         .clk_rate = MSS_MMC_CLOCK_50MHZ,
     };
 
-    return mmc_init_common(&sdcardConfig);
+    return &sdcardConfig;
 }
 #endif
 
-static bool mmc_initialized = false;
-bool HSS_MMCInit(void)
+//
+// MMC initialization is a small state machine, so that the retry delay after a failed
+// MSS_MMC_init() can be spent probing other boot sources (see HSS_MMCInitPoll()). SDCard
+// is tried before eMMC, as before.
+//
+static const struct {
+    char const * const name;
+    mss_mmc_cfg_t *(* const select)(void);
+} mmcInitModes_[] = {
+#if defined(CONFIG_SERVICE_MMC_MODE_SDCARD)
+    { "SDCARD", mmc_select_sdcard },
+#endif
+#if defined(CONFIG_SERVICE_MMC_MODE_EMMC)
+    { "eMMC",   mmc_select_emmc },
+#endif
+};
+
+enum MMCInitState {
+    MMC_INIT_START,
+    MMC_INIT_RETRY_WAIT,
+    MMC_INIT_DONE,
+    MMC_INIT_FAILED,
+};
+
+static struct {
+    enum MMCInitState state;
+    size_t modeIndex;
+    mss_mmc_cfg_t *pConfig;
+    HSSTicks_t retryTime;
+    int perfCtr;
+} mmcInit_ = { MMC_INIT_START, 0u, NULL, 0u, PERF_CTR_UNINITIALIZED };
+
+static void mmc_init_try_mode_(void);
+
+static void mmc_init_attempt_done_(bool passed)
 {
-    bool result = false;
+    mHSS_DEBUG_PRINTF(LOG_STATUS, "Attempting to select %s ... %s" CRLF,
+        mmcInitModes_[mmcInit_.modeIndex].name, passed ? "Passed" : "Failed");
 
-    if (!mmc_initialized) {
-        int perf_ctr_index = PERF_CTR_UNINITIALIZED;
-        HSS_PerfCtr_Allocate(&perf_ctr_index, "MMC Init");
+    if (passed) {
+        mmcInit_.state = MMC_INIT_DONE;
+        HSS_PerfCtr_Lap(mmcInit_.perfCtr);
+    } else {
+        mmcInit_.modeIndex++;
+        mmc_init_try_mode_();
+    }
+}
+
+static void mmc_init_try_mode_(void)
+{
+    if (mmcInit_.modeIndex >= ARRAY_SIZE(mmcInitModes_)) {
+        mmcInit_.state = MMC_INIT_FAILED;
+        HSS_PerfCtr_Lap(mmcInit_.perfCtr);
+    } else {
+        mmcInit_.pConfig = mmcInitModes_[mmcInit_.modeIndex].select();
+
+        if (MSS_MMC_init(mmcInit_.pConfig) == MSS_MMC_INIT_SUCCESS) {
+            mmc_init_attempt_done_(true);
+        } else {
+            mmc_reset_block();
+            mmcInit_.retryTime = HSS_GetTime();
+            mmcInit_.state = MMC_INIT_RETRY_WAIT;
+        }
+    }
+}
+
+enum HSS_StorageInitStatus HSS_MMCInitPoll(void)
+{
+    enum HSS_StorageInitStatus result = HSS_STORAGE_INIT_PENDING;
+
+    switch (mmcInit_.state) {
+    case MMC_INIT_START:
+        // a failed initialization may be retried, so only allocate the counter once
+        if (mmcInit_.perfCtr == PERF_CTR_UNINITIALIZED) {
+            HSS_PerfCtr_Allocate(&mmcInit_.perfCtr, "MMC Init");
+        }
 
 #ifdef CONFIG_MODULE_M100PFS
         MSS_GPIO_init(GPIO0_LO);
@@ -226,29 +275,51 @@ bool HSS_MMCInit(void)
 
         mmc_reset_block();
 
-#if defined(CONFIG_SERVICE_MMC_MODE_SDCARD)
-        mHSS_DEBUG_PRINTF(LOG_STATUS, "Attempting to select SDCARD ... ");
-        mmc_initialized = mmc_init_sdcard();
-        mHSS_DEBUG_PRINTF_EX("%s" CRLF, mmc_initialized ? "Passed" : "Failed");
+        mmcInit_.modeIndex = 0u;
+        mmc_init_try_mode_();
+        break;
 
-#endif
-#if defined(CONFIG_SERVICE_MMC_MODE_EMMC)
-        if (!mmc_initialized) {
-            mHSS_DEBUG_PRINTF(LOG_STATUS, "Attempting to select eMMC ... ");
-            mmc_initialized = mmc_init_emmc();
-            mHSS_DEBUG_PRINTF_EX("%s" CRLF, mmc_initialized ? "Passed" : "Failed");
+    case MMC_INIT_RETRY_WAIT:
+        if (HSS_Timer_IsElapsed(mmcInit_.retryTime, MMC_INIT_RETRY_DELAY)) {
+            mmc_init_attempt_done_(MSS_MMC_init(mmcInit_.pConfig) == MSS_MMC_INIT_SUCCESS);
         }
-#endif
-        HSS_PerfCtr_Lap(perf_ctr_index);
+        break;
+
+    default:
+        break;
     }
 
-    result = mmc_initialized;
+    if (mmcInit_.state == MMC_INIT_DONE) {
+        result = HSS_STORAGE_INIT_DONE;
+    } else if (mmcInit_.state == MMC_INIT_FAILED) {
+        result = HSS_STORAGE_INIT_FAILED;
+    }
 
     return result;
 }
 
+bool HSS_MMCInit(void)
+{
+    enum HSS_StorageInitStatus status;
+
+    // a failed initialization is attempted afresh on each call
+    if (mmcInit_.state == MMC_INIT_FAILED) {
+        mmcInit_.state = MMC_INIT_START;
+    }
+
+    do {
+        status = HSS_MMCInitPoll();
+    } while (status == HSS_STORAGE_INIT_PENDING);
+
+    return (status == HSS_STORAGE_INIT_DONE);
+}
+
 #define HSS_MMC_SECTOR_SIZE (512u)
 
+// MSS_MMC_sdma_read() and MSS_MMC_sdma_write() limit a single transfer to just under 32MiB,
+// and refuse empty ones
+#define HSS_MMC_MAX_SDMA_BYTES ((32u * 1024u * 1024u) - HSS_MMC_SECTOR_SIZE)
+
 //
 // HSS_MMC_ReadBlock will handle reads less than a multiple of the sector
 // size by doing the last transfer into a sector buffer
@@ -263,27 +334,38 @@ bool HSS_MMC_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount)
 
     uint32_t src_sector_num = (uint32_t)(srcOffset / HSS_MMC_SECTOR_SIZE);
     mss_mmc_status_t result = MSS_MMC_TRANSFER_SUCCESS;
-    uint32_t sectorByteCount = byteCount - (byteCount % HSS_MMC_SECTOR_SIZE);
+    size_t sectorByteCount = byteCount - (byteCount % HSS_MMC_SECTOR_SIZE);
+
+    // make sure any queued writes are visible to this read
+    HSS_MMC_FlushWriteBuffer();
 
     do {
         result = mmc_main_plic_IRQHandler();
     } while (MSS_MMC_TRANSFER_IN_PROGRESS == result);
 
-    //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Calling MSS_MMC_sdma_read(%lu, %p) "
-    //    "(%lu bytes remaining)" CRLF, src_sector_num, pCDest, sectorByteCount);
-    result = MSS_MMC_sdma_read(src_sector_num, (uint8_t *)pCDest, sectorByteCount);
+    result = MSS_MMC_TRANSFER_SUCCESS;
+    byteCount = byteCount - sectorByteCount;
+
+    while ((result == MSS_MMC_TRANSFER_SUCCESS) && sectorByteCount) {
+        size_t const chunkByteCount = MIN(sectorByteCount, (size_t)HSS_MMC_MAX_SDMA_BYTES);
 
-    while (result == MSS_MMC_TRANSFER_IN_PROGRESS) {
-        result = mmc_main_plic_IRQHandler();
+        //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Calling MSS_MMC_sdma_read(%lu, %p) "
+        //    "(%lu bytes remaining)" CRLF, src_sector_num, pCDest, sectorByteCount);
+        result = MSS_MMC_sdma_read(src_sector_num, (uint8_t *)pCDest, chunkByteCount);
+
+        while (result == MSS_MMC_TRANSFER_IN_PROGRESS) {
+            result = mmc_main_plic_IRQHandler();
+        }
+
+        src_sector_num += (uint32_t)(chunkByteCount / HSS_MMC_SECTOR_SIZE);
+        pCDest += chunkByteCount;
+        sectorByteCount -= chunkByteCount;
     }
 
-    byteCount = byteCount - sectorByteCount;
     // handle remainder
     if ((result == MSS_MMC_TRANSFER_SUCCESS) && byteCount) {
         assert(byteCount < HSS_MMC_SECTOR_SIZE);
 
-        src_sector_num += (uint32_t)(sectorByteCount / HSS_MMC_SECTOR_SIZE);
-
         //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Dealing with remainder (less that full sector)" CRLF);
         //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Calling MSS_MMC_single_block_read(%lu, %p) "
         //    "(%lu bytes remaining)" CRLF, src_sector_num, runtBuffer, byteCount);
@@ -299,7 +381,7 @@ bool HSS_MMC_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount)
         }
 
         if (result == MSS_MMC_TRANSFER_SUCCESS) {
-            memcpy_via_pdma(pCDest + sectorByteCount, runtBuffer, byteCount);
+            memcpy_via_pdma(pCDest, runtBuffer, byteCount);
         }
     }
 
@@ -307,55 +389,129 @@ bool HSS_MMC_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount)
 }
 
 //
-// HSS_MMC_WriteBlock will handle requested writes of less than a multiple of the sector
-// size by rounding up to the next full sector worth
+// mmc_sdma_write_ issues multi-block (CMD25) SDMA writes, splitting only where the
+// MSS MMC driver transfer size limit requires it
 //
-bool HSS_MMC_WriteBlock(size_t dstOffset, void *pSrc, size_t byteCount)
+static bool mmc_sdma_write_(uint32_t dst_sector_num, char const *pCSrc, size_t byteCount)
 {
-    // temporary code to bring up Icicle board
-    char *pCSrc = (char *)pSrc;
-
-    // if byte count is not a multiple of the sector size, round it up...
-    if (byteCount & (HSS_MMC_SECTOR_SIZE-1)) {
-        byteCount = byteCount + HSS_MMC_SECTOR_SIZE;
-        byteCount &= ~(HSS_MMC_SECTOR_SIZE-1);
-    }
+    mss_mmc_status_t result = MSS_MMC_TRANSFER_SUCCESS;
 
-    // source and byteCount must be multiples of the sector size
-    //
-    // The MSS MMC driver uses uint32_t* as its pointer type
-    // To ensure alignment, would rather tramp through void* and
-    // assert check here
-    assert(((size_t)dstOffset & (HSS_MMC_SECTOR_SIZE-1)) == 0u);
-    assert(((size_t)pCSrc & (sizeof(uint32_t)-1)) == 0u);
     assert((byteCount & (HSS_MMC_SECTOR_SIZE-1)) == 0u);
 
-    uint32_t dst_sector_num = (uint32_t)(dstOffset / HSS_MMC_SECTOR_SIZE);
-    mss_mmc_status_t result = MSS_MMC_TRANSFER_SUCCESS;
+    // wait for any in-flight transactions to complete
+    while (MSS_MMC_get_transfer_status() == MSS_MMC_TRANSFER_IN_PROGRESS) {
+        do {
+            result = mmc_main_plic_IRQHandler();
+        } while (result == MSS_MMC_TRANSFER_IN_PROGRESS);
+    }
 
+    result = MSS_MMC_TRANSFER_SUCCESS;
     while ((result == MSS_MMC_TRANSFER_SUCCESS) && (byteCount)) {
-        result = MSS_MMC_single_block_write((uint32_t *)pCSrc, dst_sector_num);
+        size_t const chunkByteCount = MIN(byteCount, (size_t)HSS_MMC_MAX_SDMA_BYTES);
+
+        result = MSS_MMC_sdma_write((uint8_t *)pCSrc, dst_sector_num, chunkByteCount);
+        while (result == MSS_MMC_TRANSFER_IN_PROGRESS) {
+            result = mmc_main_plic_IRQHandler();
+        }
 
         if (result != MSS_MMC_TRANSFER_SUCCESS) {
-            mHSS_DEBUG_PRINTF(LOG_ERROR, "MSS_MMC_single_block_write() unexpectedly returned %d" CRLF,
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "MSS_MMC_sdma_write() unexpectedly returned %d" CRLF,
                 result);
         }
 
-        dst_sector_num++;
-        byteCount = byteCount - HSS_MMC_SECTOR_SIZE;
-        pCSrc = pCSrc + HSS_MMC_SECTOR_SIZE;
+        dst_sector_num += (uint32_t)(chunkByteCount / HSS_MMC_SECTOR_SIZE);
+        pCSrc += chunkByteCount;
+        byteCount -= chunkByteCount;
     }
 
     return (result == MSS_MMC_TRANSFER_SUCCESS);
 }
 
+#if IS_ENABLED(CONFIG_SERVICE_MMC_WRITE_COALESCE)
+//
+// Sector writes (e.g. from USB MSC) are staged in a write queue, and adjacent writes are
+// coalesced into a single multi-block transfer. The queue is written out when a
+// non-adjacent write arrives, when it fills, before any read, and on
+// HSS_MMC_FlushWriteBuffer()
+//
+#define HSS_MMC_WRITE_QUEUE_SECTORS (CONFIG_SERVICE_MMC_WRITE_COALESCE_SECTORS)
+static struct {
+    char buffer[HSS_MMC_WRITE_QUEUE_SECTORS * HSS_MMC_SECTOR_SIZE] __attribute__((aligned(sizeof(uint32_t))));
+    uint32_t startSector;
+    uint32_t numSectors;
+} writeQueue_;
+
+static bool mmc_flush_write_queue_(void)
+{
+    bool result = true;
+
+    if (writeQueue_.numSectors) {
+        result = mmc_sdma_write_(writeQueue_.startSector, writeQueue_.buffer,
+            writeQueue_.numSectors * HSS_MMC_SECTOR_SIZE);
+        writeQueue_.numSectors = 0u;
+    }
+
+    return result;
+}
+
+static bool mmc_queue_write_(uint32_t dst_sector_num, char const *pCSrc, size_t byteCount)
+{
+    bool result = true;
+
+    if (writeQueue_.numSectors) {
+        size_t const paddedByteCount = (byteCount + HSS_MMC_SECTOR_SIZE - 1u) & ~(HSS_MMC_SECTOR_SIZE-1);
+
+        if ((dst_sector_num != (writeQueue_.startSector + writeQueue_.numSectors))
+            || (((writeQueue_.numSectors * HSS_MMC_SECTOR_SIZE) + paddedByteCount) > sizeof(writeQueue_.buffer))) {
+            result = mmc_flush_write_queue_();
+        }
+    }
+
+    if (result && !writeQueue_.numSectors && (byteCount >= sizeof(writeQueue_.buffer))) {
+        // too large to be worth staging, so write whole sectors straight out
+        size_t const sectorByteCount = byteCount & ~(HSS_MMC_SECTOR_SIZE-1);
+
+        result = mmc_sdma_write_(dst_sector_num, pCSrc, sectorByteCount);
+
+        dst_sector_num += (uint32_t)(sectorByteCount / HSS_MMC_SECTOR_SIZE);
+        pCSrc += sectorByteCount;
+        byteCount -= sectorByteCount;
+    }
+
+    if (result && byteCount) {
+        size_t const paddedByteCount = (byteCount + HSS_MMC_SECTOR_SIZE - 1u) & ~(HSS_MMC_SECTOR_SIZE-1);
+        char *pCDest = writeQueue_.buffer + (writeQueue_.numSectors * HSS_MMC_SECTOR_SIZE);
+
+        if (!writeQueue_.numSectors) {
+            writeQueue_.startSector = dst_sector_num;
+        }
+
+        memcpy(pCDest, pCSrc, byteCount);
+        memset(pCDest + byteCount, 0, paddedByteCount - byteCount);
+        writeQueue_.numSectors += (uint32_t)(paddedByteCount / HSS_MMC_SECTOR_SIZE);
+
+        if (writeQueue_.numSectors == HSS_MMC_WRITE_QUEUE_SECTORS) {
+            result = mmc_flush_write_queue_();
+        }
+    }
+
+    return result;
+}
+#endif
+
+void HSS_MMC_FlushWriteBuffer(void)
+{
+#if IS_ENABLED(CONFIG_SERVICE_MMC_WRITE_COALESCE)
+    (void)mmc_flush_write_queue_();
+#endif
+}
+
 //
 // HSS_MMC_WriteBlock will handle requested writes of less than a multiple of the sector
 // size by rounding up to the next full sector worth
 //
-bool HSS_MMC_WriteBlockSDMA(size_t dstOffset, void *pSrc, size_t byteCount)
+bool HSS_MMC_WriteBlock(size_t dstOffset, void *pSrc, size_t byteCount)
 {
-    // temporary code to bring up Icicle board
     char *pCSrc = (char *)pSrc;
 
     // if byte count is not a multiple of the sector size, round it up...
@@ -373,25 +529,41 @@ bool HSS_MMC_WriteBlockSDMA(size_t dstOffset, void *pSrc, size_t byteCount)
     assert(((size_t)pCSrc & (sizeof(uint32_t)-1)) == 0u);
     assert((byteCount & (HSS_MMC_SECTOR_SIZE-1)) == 0u);
 
-    mss_mmc_status_t result = MSS_MMC_NO_ERROR;
     uint32_t dst_sector_num = (uint32_t)(dstOffset / HSS_MMC_SECTOR_SIZE);
 
-    // wait for any in-flight transactions to complete
-    while (MSS_MMC_get_transfer_status() == MSS_MMC_TRANSFER_IN_PROGRESS) {
-        do {
-            result = mmc_main_plic_IRQHandler();
-        } while (result == MSS_MMC_TRANSFER_IN_PROGRESS);
-    }
+    // keep ordering with respect to any queued writes
+    HSS_MMC_FlushWriteBuffer();
 
-    // setup new transaction...
-    result = MSS_MMC_sdma_write((uint8_t *)pCSrc, dst_sector_num, byteCount);
-    if (result == MSS_MMC_TRANSFER_IN_PROGRESS) {
-        do {
-            result = mmc_main_plic_IRQHandler();
-        } while (result == MSS_MMC_TRANSFER_IN_PROGRESS);
+    return mmc_sdma_write_(dst_sector_num, pCSrc, byteCount);
+}
+
+//
+// HSS_MMC_WriteBlockSDMA will handle requested writes of less than a multiple of the sector
+// size by padding out to the next full sector worth
+//
+bool HSS_MMC_WriteBlockSDMA(size_t dstOffset, void *pSrc, size_t byteCount)
+{
+    char *pCSrc = (char *)pSrc;
+
+    // The MSS MMC driver uses uint32_t* as its pointer type
+    // To ensure alignment, would rather tramp through void* and
+    // assert check here
+    assert(((size_t)dstOffset & (HSS_MMC_SECTOR_SIZE-1)) == 0u);
+    assert(((size_t)pCSrc & (sizeof(uint32_t)-1)) == 0u);
+
+    uint32_t dst_sector_num = (uint32_t)(dstOffset / HSS_MMC_SECTOR_SIZE);
+
+#if IS_ENABLED(CONFIG_SERVICE_MMC_WRITE_COALESCE)
+    return mmc_queue_write_(dst_sector_num, pCSrc, byteCount);
+#else
+    // if byte count is not a multiple of the sector size, round it up...
+    if (byteCount & (HSS_MMC_SECTOR_SIZE-1)) {
+        byteCount = byteCount + HSS_MMC_SECTOR_SIZE;
+        byteCount &= ~(HSS_MMC_SECTOR_SIZE-1);
     }
 
-    return (result == MSS_MMC_TRANSFER_SUCCESS);
+    return mmc_sdma_write_(dst_sector_num, pCSrc, byteCount);
+#endif
 }
 
 void HSS_MMC_GetInfo(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlockCount)
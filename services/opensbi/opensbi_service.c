@@ -30,6 +30,7 @@
 
 #include "opensbi_service.h"
 #include "opensbi_ecall.h"
+#include "hss_boot_timeline.h"
 #include "riscv_encoding.h"
 
 #if IS_ENABLED(CONFIG_SERVICE_BOOT)
@@ -145,7 +146,7 @@ static void opensbi_init_handler(struct StateMachine * const pMyMachine)
 /////////////////
 static void opensbi_idle_handler(struct StateMachine * const pMyMachine)
 {
-    (void)pMyMachine; // unused
+    SleepStateMachine(pMyMachine, SM_WAKE_ON_STATE_CHANGE, 0u);
 }
 
 
@@ -187,6 +188,7 @@ void __noreturn HSS_OpenSBI_DoBoot(enum HSSHartId hartid)
 
     opensbi_scratch_setup(hartid);
     mpfs_mark_hart_as_booted(hartid);
+    mHSS_BOOT_PHASE_HART_ENTRY(hartid);
     sbi_init(&(pScratches[hartid].scratch));
 
     while (1) {
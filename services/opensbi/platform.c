@@ -57,6 +57,7 @@
 #include <sbi_utils/sys/clint.h>
 
 #include "opensbi_service.h"
+#include "uart_helper.h"
 #include "opensbi_ecall.h"
 
 
@@ -130,6 +131,7 @@ static bool uart_surrendered_flag = false;
 void uart_surrender(void);
 void uart_surrender(void)
 {
+    uart_tx_flush(); // buffered output must go out before the UART is handed over
     uart_surrendered_flag = true;
 }
 #endif
@@ -144,7 +146,6 @@ static void mpfs_console_putc(char ch)
 #else
         {
 #endif
-            int uart_putc(int hartid, const char ch); //TBD
             uart_putc(hartid, ch);
         }
     }
@@ -156,7 +157,6 @@ static void mpfs_console_putc(char ch)
 static int mpfs_console_getc(void)
 {
     int result = GETC_EOF;
-    bool uart_getchar(uint8_t *pbuf, int32_t timeout_sec, bool do_sec_tick);
 
     uint8_t rcvBuf;
     if (uart_getchar(&rcvBuf, NO_BLOCK, FALSE)) {
@@ -78,6 +78,7 @@ static void powermode_state1_handler(struct StateMachine * const pMyMachine)
         IPI_ConsumeIntent(i, IPI_MSG_POWERMODE);
     }
     i = (i + 1u) % HSS_HART_NUM_PEERS;
+    SleepStateMachine(pMyMachine, SM_WAKE_ON_IPI, 0u);
 }
 
 
@@ -17,6 +17,7 @@
 #include "hss_state_machine.h"
 #include "hss_progress.h"
 #include "hss_debug.h"
+#include "hss_perfctr.h"
 
 #include <assert.h>
 #include <string.h>
@@ -50,13 +51,38 @@ static uint32_t numBadBlocks;
 
 static uint16_t *pLogicalToPhysicalMap = NULL;
 static uint16_t *pBadBlocksMap = NULL;
+
+//
+// The cache holds a bounded number of erase blocks, keyed by logical block number.
+// Entries are kept on an LRU list (head is most recently used) for eviction, and
+// dirty entries are additionally kept on a dirty list so that flushing only needs
+// to visit the blocks that have actually been written.
+//
+#define QSPI_CACHE_NUM_ENTRIES  ((uint16_t)CONFIG_SERVICE_QSPI_CACHE_NUM_BLOCKS)
+#define QSPI_CACHE_NO_ENTRY     (0xFFFFu)
+
 static struct HSS_QSPI_Cache_Descriptor
 {
-    bool dirtyCache;
-    bool inCache;
-} *pLogicalBlockDesc = NULL;
+    uint16_t logicalBlock;
+    uint16_t lruPrev;
+    uint16_t lruNext;
+    uint16_t dirtyPrev;
+    uint16_t dirtyNext;
+    bool dirty;
+} *pCacheDesc = NULL;
+static uint16_t *pLogicalBlockToCacheEntry = NULL;
 static uint8_t *pCacheDataBuffer = NULL;
 
+static struct {
+    uint16_t lruHead;
+    uint16_t lruTail;
+    uint16_t dirtyHead;
+    uint16_t numEntriesUsed;
+    uint16_t numDirty;
+    size_t hits;
+    size_t misses;
+} cacheState_;
+
 bool cacheDirtyFlag = false;
 
 ////////////////////////////////////////////////////////////////////////////////////////
@@ -127,64 +153,206 @@ __attribute__((pure)) static inline uint32_t logical_to_physical_block_(const ui
     return result;
 }
 
-static void demandCopyFlashBlocksToCache_(size_t byteOffset, size_t byteCount, bool markDirty)
+static void cacheInit_(void)
+{
+    cacheState_.lruHead = QSPI_CACHE_NO_ENTRY;
+    cacheState_.lruTail = QSPI_CACHE_NO_ENTRY;
+    cacheState_.dirtyHead = QSPI_CACHE_NO_ENTRY;
+    cacheState_.numEntriesUsed = 0u;
+    cacheState_.numDirty = 0u;
+    cacheState_.hits = 0u;
+    cacheState_.misses = 0u;
+
+    for (size_t i = 0u; i < blockCount; i++) {
+        pLogicalBlockToCacheEntry[i] = QSPI_CACHE_NO_ENTRY;
+    }
+}
+
+static void lruUnlink_(const uint16_t entry)
+{
+    struct HSS_QSPI_Cache_Descriptor * const pDesc = &pCacheDesc[entry];
+
+    if (pDesc->lruPrev != QSPI_CACHE_NO_ENTRY) {
+        pCacheDesc[pDesc->lruPrev].lruNext = pDesc->lruNext;
+    } else {
+        cacheState_.lruHead = pDesc->lruNext;
+    }
+
+    if (pDesc->lruNext != QSPI_CACHE_NO_ENTRY) {
+        pCacheDesc[pDesc->lruNext].lruPrev = pDesc->lruPrev;
+    } else {
+        cacheState_.lruTail = pDesc->lruPrev;
+    }
+}
+
+static void lruPushHead_(const uint16_t entry)
+{
+    struct HSS_QSPI_Cache_Descriptor * const pDesc = &pCacheDesc[entry];
+
+    pDesc->lruPrev = QSPI_CACHE_NO_ENTRY;
+    pDesc->lruNext = cacheState_.lruHead;
+
+    if (cacheState_.lruHead != QSPI_CACHE_NO_ENTRY) {
+        pCacheDesc[cacheState_.lruHead].lruPrev = entry;
+    } else {
+        cacheState_.lruTail = entry;
+    }
+
+    cacheState_.lruHead = entry;
+}
+
+static void markDirty_(const uint16_t entry)
 {
-    for (size_t offset = byteOffset; offset < (byteOffset + byteCount); offset += blockSize) {
-        const size_t physicalBlockOffset = logical_to_physical_block_(column_to_block_(offset));
+    struct HSS_QSPI_Cache_Descriptor * const pDesc = &pCacheDesc[entry];
+
+    if (!pDesc->dirty) {
+        pDesc->dirty = true;
+        pDesc->dirtyPrev = QSPI_CACHE_NO_ENTRY;
+        pDesc->dirtyNext = cacheState_.dirtyHead;
 
-        if (!pLogicalBlockDesc[physicalBlockOffset].inCache) {
-            //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Reading block %u into cache" CRLF, physicalBlockOffset);
+        if (cacheState_.dirtyHead != QSPI_CACHE_NO_ENTRY) {
+            pCacheDesc[cacheState_.dirtyHead].dirtyPrev = entry;
+        }
+
+        cacheState_.dirtyHead = entry;
+        cacheState_.numDirty++;
+        cacheDirtyFlag = true;
+    }
+}
+
+static void markClean_(const uint16_t entry)
+{
+    struct HSS_QSPI_Cache_Descriptor * const pDesc = &pCacheDesc[entry];
 
-            const size_t physicalBlockByteOffset = physicalBlockOffset * blockSize;
-            Flash_read(pCacheDataBuffer + physicalBlockByteOffset, physicalBlockByteOffset, blockSize);
-            pLogicalBlockDesc[physicalBlockOffset].inCache = true;
+    if (pDesc->dirty) {
+        if (pDesc->dirtyPrev != QSPI_CACHE_NO_ENTRY) {
+            pCacheDesc[pDesc->dirtyPrev].dirtyNext = pDesc->dirtyNext;
+        } else {
+            cacheState_.dirtyHead = pDesc->dirtyNext;
         }
 
-        if (markDirty) {
-            pLogicalBlockDesc[physicalBlockOffset].dirtyCache = true;
+        if (pDesc->dirtyNext != QSPI_CACHE_NO_ENTRY) {
+            pCacheDesc[pDesc->dirtyNext].dirtyPrev = pDesc->dirtyPrev;
         }
+
+        pDesc->dirty = false;
+        cacheState_.numDirty--;
+        cacheDirtyFlag = (cacheState_.numDirty != 0u);
     }
 }
 
-static void copyCacheToFlashBlocks_(size_t byteOffset, size_t byteCount)
+static inline uint8_t *cacheEntryData_(const uint16_t entry)
 {
-    const size_t endOffset = byteOffset + byteCount;
-    size_t dirtyBlockCount = 0u;
-    mHSS_DEBUG_PRINTF_EX(CRLF);
+    return pCacheDataBuffer + ((size_t)entry * blockSize);
+}
 
-    for (size_t blockOffset = 0u; blockOffset < blockCount; blockOffset++) {
-        if (pLogicalBlockDesc[blockOffset].dirtyCache) {
-            dirtyBlockCount++;
+static bool writeBackCacheEntry_(const uint16_t entry)
+{
+    bool result = true;
+    const uint32_t physicalBlock = logical_to_physical_block_(pCacheDesc[entry].logicalBlock);
+
+    //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Writing block %u from cache" CRLF, physicalBlock);
+
+    uint8_t status = Flash_erase_block(physicalBlock);
+    if (status) {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "Error erasing block %u" CRLF, physicalBlock);
+        result = false;
+    } else {
+        status = Flash_program(cacheEntryData_(entry), physicalBlock * blockSize, blockSize);
+        if (status) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "Error programming block %u" CRLF, physicalBlock);
+            result = false;
         }
     }
 
-    const size_t initialDirtyBlockCount = dirtyBlockCount;
-    for (size_t offset = byteOffset; dirtyBlockCount && (offset < endOffset); offset += blockSize) {
-        HSS_ShowProgress(initialDirtyBlockCount, dirtyBlockCount);
+    // on failure, the block stays dirty so that its data is not lost
+    if (result) {
+        markClean_(entry);
+    }
 
-        const size_t physicalBlockOffset = logical_to_physical_block_(column_to_block_(offset));
+    return result;
+}
 
-        if (pLogicalBlockDesc[physicalBlockOffset].inCache) {
-            if (pLogicalBlockDesc[physicalBlockOffset].dirtyCache) {
-                //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Writing block %u from cache" CRLF, physicalBlockOffset);
+//
+// Choose a cache entry to evict, starting from the least recently used. Dirty entries are
+// written back first, and any that cannot be written back are skipped, so that their data
+// is kept. Returns QSPI_CACHE_NO_ENTRY if every entry is dirty and failed to write back.
+//
+static uint16_t evictCacheEntry_(void)
+{
+    uint16_t entry = cacheState_.lruTail;
 
-                const size_t physicalBlockByteOffset = physicalBlockOffset * blockSize;
-                uint8_t status = Flash_erase_block(physicalBlockOffset);
+    while ((entry != QSPI_CACHE_NO_ENTRY) && pCacheDesc[entry].dirty && !writeBackCacheEntry_(entry)) {
+        entry = pCacheDesc[entry].lruPrev;
+    }
 
-                if (status) {
-                    mHSS_DEBUG_PRINTF(LOG_ERROR, "Error erasing block %u" CRLF, physicalBlockOffset);
-                    break;
-                }
+    if (entry != QSPI_CACHE_NO_ENTRY) {
+        lruUnlink_(entry);
+        pLogicalBlockToCacheEntry[pCacheDesc[entry].logicalBlock] = QSPI_CACHE_NO_ENTRY;
+    } else {
+        mHSS_DEBUG_PRINTF(LOG_ERROR, "No QSPI cache entry can be evicted" CRLF);
+    }
 
-                status = Flash_program(pCacheDataBuffer + physicalBlockByteOffset, physicalBlockByteOffset, blockSize);
-                if (status) {
-                    mHSS_DEBUG_PRINTF(LOG_ERROR, "Error programming block %u" CRLF, physicalBlockOffset);
+    return entry;
+}
 
-                }
-                pLogicalBlockDesc[physicalBlockOffset].dirtyCache = false;
-                dirtyBlockCount--;
+//
+// Find the cache entry for a logical block, loading it from flash if necessary.
+// If the caller is about to overwrite the entire block, the flash read is skipped.
+// Returns QSPI_CACHE_NO_ENTRY if no entry could be freed for it.
+//
+static uint16_t demandCacheEntry_(const uint32_t logicalBlock, const bool wholeBlockWrite)
+{
+    uint16_t entry = pLogicalBlockToCacheEntry[logicalBlock];
+
+    if (entry != QSPI_CACHE_NO_ENTRY) {
+        cacheState_.hits++;
+        lruUnlink_(entry);
+    } else {
+        cacheState_.misses++;
+
+        if (cacheState_.numEntriesUsed < QSPI_CACHE_NUM_ENTRIES) {
+            entry = cacheState_.numEntriesUsed;
+            cacheState_.numEntriesUsed++;
+        } else {
+            // evict least recently used block, writing it back if necessary
+            entry = evictCacheEntry_();
+
+            if (entry == QSPI_CACHE_NO_ENTRY) {
+                return entry;
             }
         }
+
+        pCacheDesc[entry].logicalBlock = (uint16_t)logicalBlock;
+        pCacheDesc[entry].dirty = false;
+        pLogicalBlockToCacheEntry[logicalBlock] = entry;
+
+        if (!wholeBlockWrite) {
+            //mHSS_DEBUG_PRINTF(LOG_NORMAL, "Reading block %u into cache" CRLF, logicalBlock);
+            Flash_read(cacheEntryData_(entry), logical_to_physical_block_(logicalBlock) * blockSize,
+                blockSize);
+        }
+    }
+
+    lruPushHead_(entry);
+
+    return entry;
+}
+
+static void copyCacheToFlashBlocks_(void)
+{
+    const size_t initialDirtyBlockCount = cacheState_.numDirty;
+    mHSS_DEBUG_PRINTF_EX(CRLF);
+
+    // blocks that fail to write back stay dirty, so carry on with the rest
+    uint16_t entry = cacheState_.dirtyHead;
+    while (entry != QSPI_CACHE_NO_ENTRY) {
+        const uint16_t nextEntry = pCacheDesc[entry].dirtyNext;
+
+        HSS_ShowProgress(initialDirtyBlockCount, cacheState_.numDirty);
+        (void)writeBackCacheEntry_(entry);
+
+        entry = nextEntry;
     }
 
     HSS_ShowProgress(initialDirtyBlockCount, 0u);
@@ -233,8 +401,9 @@ bool HSS_QSPIInit(void)
             // we're going to place buffers in DDR for
             //   * a set of logical to physical block qspiIndex mappings;
             //   * a list of bad blocks;
-            //   * a set of logical block descriptors;
-            //   * a data cache the same size as the QSPI Flash device
+            //   * a logical block to cache entry lookup table;
+            //   * a set of cache entry descriptors;
+            //   * a bounded data cache of CONFIG_SERVICE_QSPI_CACHE_NUM_BLOCKS erase blocks
             //
             extern const uint64_t __ddr_start;
 #define DDR_START              (&__ddr_start)
@@ -247,14 +416,19 @@ bool HSS_QSPIInit(void)
             memset(pBadBlocksMap, 0, (sizeof(*pBadBlocksMap) * blockCount));
             pU8Buffer += (sizeof(*pBadBlocksMap) * blockCount);
 
-            pLogicalBlockDesc = (struct HSS_QSPI_Cache_Descriptor*)pU8Buffer;
-            memset(pLogicalBlockDesc, 0, (sizeof(*pLogicalBlockDesc) * blockCount));
-            pU8Buffer += (sizeof(*pLogicalBlockDesc) * blockCount);
+            pLogicalBlockToCacheEntry = (uint16_t *)pU8Buffer;
+            pU8Buffer += (sizeof(*pLogicalBlockToCacheEntry) * blockCount);
+
+            pU8Buffer = (uint8_t *)(((uintptr_t)pU8Buffer + 7u) & ~(uintptr_t)7u);
+            pCacheDesc = (struct HSS_QSPI_Cache_Descriptor*)pU8Buffer;
+            memset(pCacheDesc, 0, (sizeof(*pCacheDesc) * QSPI_CACHE_NUM_ENTRIES));
+            pU8Buffer += (sizeof(*pCacheDesc) * QSPI_CACHE_NUM_ENTRIES);
 
+            pU8Buffer = (uint8_t *)(((uintptr_t)pU8Buffer + 63u) & ~(uintptr_t)63u);
             pCacheDataBuffer = (uint8_t *)pU8Buffer;
 
             // mHSS_DEBUG_PRINTF(LOG_NORMAL, "pLogicalToPhysicalMap: %p" CRLF, pLogicalToPhysicalMap);
-            // mHSS_DEBUG_PRINTF(LOG_NORMAL, "pLogicalBlockDesc: %p" CRLF, pLogicalBlockDesc);
+            // mHSS_DEBUG_PRINTF(LOG_NORMAL, "pCacheDesc: %p" CRLF, pCacheDesc);
             // mHSS_DEBUG_PRINTF(LOG_NORMAL, "pCacheDataBuffer: %p" CRLF, pCacheDataBuffer);
 
             //
@@ -268,6 +442,8 @@ bool HSS_QSPIInit(void)
 
             // mHSS_DEBUG_PRINTF(LOG_NORMAL, "blockCount (after bad blocks): %u" CRLF, blockCount);
 
+            cacheInit_();
+
             mHSS_DEBUG_PRINTF(LOG_NORMAL, "Initialized Flash" CRLF);
             qspiInitialized = true;
 
@@ -283,8 +459,15 @@ __attribute__((nonnull)) bool HSS_QSPI_ReadBlock(void *pDest, size_t srcOffset,
 {
     bool result = true;
 
+    static int perfCtr = PERF_CTR_UNINITIALIZED;
+    if (IS_ENABLED(CONFIG_DEBUG_PERF_CTRS) && (perfCtr == PERF_CTR_UNINITIALIZED)) {
+        HSS_PerfCtr_Allocate(&perfCtr, "QSPI ReadBlock");
+    }
+
     const uint32_t read_addr = logical_to_physical_address_((uint32_t)srcOffset);
+    HSS_PerfCtr_Start(perfCtr);
     Flash_read((uint8_t *)pDest, read_addr, (uint32_t) byteCount);
+    HSS_PerfCtr_Lap(perfCtr);
 
     return result;
 }
@@ -318,6 +501,30 @@ void HSS_QSPI_FlashChipErase(void)
     HSS_ShowProgress(blockCount, 0u);
 }
 
+bool HSS_QSPI_EraseBlocks(size_t dstOffset, size_t byteCount)
+{
+    bool result = true;
+
+    if (byteCount) {
+        const uint32_t firstBlock = (uint32_t)(dstOffset / blockSize);
+        const uint32_t lastBlock = (uint32_t)((dstOffset + byteCount - 1u) / blockSize);
+
+        if (lastBlock >= blockCount) {
+            result = false;
+        }
+
+        for (uint32_t blockIndex = firstBlock; result && (blockIndex <= lastBlock); blockIndex++) {
+            uint8_t status = Flash_erase_block(logical_to_physical_block_(blockIndex));
+            if (status) {
+                mHSS_DEBUG_PRINTF(LOG_ERROR, "Error erasing block %u" CRLF, blockIndex);
+                result = false;
+            }
+        }
+    }
+
+    return result;
+}
+
 void HSS_QSPI_BadBlocksInfo(void)
 {
     if (qspiInitialized)
@@ -347,10 +554,13 @@ void HSS_QSPI_BadBlocksInfo(void)
 //
 // QSPI Cached Functions
 //
-//  To make QSPI Flash available as a USB drive, we need to cache the contents
-//  in DDR. This allows us to reduce wear on the flash by minimizing the number of
+//  To make QSPI Flash available as a USB drive, we cache erase blocks in DDR.
+//  This allows us to reduce wear on the flash by minimizing the number of
 //  block erases performed, and it also makes operation quicker...
 //
+//  Only CONFIG_SERVICE_QSPI_CACHE_NUM_BLOCKS blocks are cached at any one time,
+//  with the least recently used block written back (if dirty) on eviction.
+//
 
 bool HSS_CachedQSPIInit(void)
 {
@@ -361,13 +571,28 @@ bool HSS_CachedQSPIInit(void)
 __attribute__((nonnull)) bool HSS_CachedQSPI_ReadBlock(void *pDest, size_t srcOffset, size_t byteCount)
 {
     bool result = true;
+    uint8_t *pU8Dest = (uint8_t *)pDest;
 
     assert(pDest);
     assert((srcOffset + byteCount) <= dieSize);
 
-    demandCopyFlashBlocksToCache_(srcOffset, byteCount, false);
+    while (byteCount) {
+        const uint32_t logicalBlock = column_to_block_(srcOffset);
+        const size_t blockOffset = srcOffset % blockSize;
+        const size_t chunkSize = MIN(byteCount, blockSize - blockOffset);
 
-    memcpy(pDest, pCacheDataBuffer + srcOffset, byteCount);
+        const uint16_t entry = demandCacheEntry_(logicalBlock, false);
+        if (entry == QSPI_CACHE_NO_ENTRY) {
+            result = false;
+            break;
+        }
+
+        memcpy(pU8Dest, cacheEntryData_(entry) + blockOffset, chunkSize);
+
+        pU8Dest += chunkSize;
+        srcOffset += chunkSize;
+        byteCount -= chunkSize;
+    }
 
     return result;
 }
@@ -375,14 +600,30 @@ __attribute__((nonnull)) bool HSS_CachedQSPI_ReadBlock(void *pDest, size_t srcOf
 __attribute__((nonnull)) bool HSS_CachedQSPI_WriteBlock(size_t dstOffset, void *pSrc, size_t byteCount)
 {
     bool result = true;
+    uint8_t *pU8Src = (uint8_t *)pSrc;
 
     assert(pSrc);
     assert((dstOffset + byteCount) <= dieSize);
 
-    cacheDirtyFlag = true;
-    demandCopyFlashBlocksToCache_(dstOffset, byteCount, true);
+    while (byteCount) {
+        const uint32_t logicalBlock = column_to_block_(dstOffset);
+        const size_t blockOffset = dstOffset % blockSize;
+        const size_t chunkSize = MIN(byteCount, blockSize - blockOffset);
+
+        const uint16_t entry = demandCacheEntry_(logicalBlock, (chunkSize == blockSize));
+        if (entry == QSPI_CACHE_NO_ENTRY) {
+            result = false;
+            break;
+        }
+
+        memcpy(cacheEntryData_(entry) + blockOffset, pU8Src, chunkSize);
+        markDirty_(entry);
+
+        pU8Src += chunkSize;
+        dstOffset += chunkSize;
+        byteCount -= chunkSize;
+    }
 
-    memcpy(pCacheDataBuffer + dstOffset, pSrc, byteCount);
     return result;
 }
 
@@ -394,10 +635,9 @@ __attribute__((nonnull)) void HSS_CachedQSPI_GetInfo(uint32_t *pBlockSize, uint3
 void HSS_CachedQSPI_FlushWriteBuffer(void)
 {
     if (cacheDirtyFlag) {
-        copyCacheToFlashBlocks_(0u, dieSize);
+        copyCacheToFlashBlocks_();
         mHSS_DEBUG_PRINTF_EX(CRLF);
-        mHSS_DEBUG_PRINTF(LOG_NORMAL, "Synchronized Cache with Flash ..." CRLF);
-
-        cacheDirtyFlag = false;
+        mHSS_DEBUG_PRINTF(LOG_NORMAL, "Synchronized Cache with Flash (%lu hits, %lu misses) ..." CRLF,
+            cacheState_.hits, cacheState_.misses);
     }
 }
@@ -48,6 +48,7 @@ void HSS_QSPI_GetInfo(uint32_t *pBlockSize, uint32_t *pEraseSize, uint32_t *pBlo
 void HSS_QSPI_FlushWriteBuffer(void);
 
 void HSS_QSPI_FlashChipErase(void);
+bool HSS_QSPI_EraseBlocks(size_t dstOffset, size_t byteCount);
 void HSS_QSPI_BadBlocksInfo(void);
 
 bool HSS_CachedQSPIInit(void);
@@ -16,6 +16,7 @@
 #include "hss_types.h"
 #include "hss_state_machine.h"
 #include "hss_debug.h"
+#include "hss_clock.h"
 #include "hss_boot_pmp.h"
 
 #include "ssmb_ipi.h"
@@ -64,15 +65,6 @@ struct StateMachine scrub_service = {
 };
 
 
-// --------------------------------------------------------------------------------------------------
-// Handlers for each state in the state machine
-//
-static void scrub_init_handler(struct StateMachine * const pMyMachine)
-{
-    pMyMachine->state++;
-}
-
-/////////////////
 extern const uint64_t __l2lim_start,         __l2lim_end;
 extern const uint64_t __l2_start, __l2_end;
 extern const uint64_t __ddr_start,           __ddr_end;
@@ -100,42 +92,133 @@ const struct {
     //{ (uintptr_t)&__u54_4_itim_start,    (uintptr_t)&__u54_4_itim_end },
 };
 
+#define SCRUB_CHUNK_SIZE ((size_t)CONFIG_SERVICE_SCRUB_MAX_SIZE_PER_LOOP_ITER)
+
+#if IS_ENABLED(CONFIG_SERVICE_SCRUB_USE_PDMA)
+// the PDMA copies each chunk here -- only the reads matter
+static uint8_t scrubSink_[SCRUB_CHUNK_SIZE] __attribute__((aligned(64)));
+static HSS_PDMA_Txn_t scrubTxn_ = 0u;
+#endif
+
+static struct {
+    HSSTicks_t startTime;
+    HSSTicks_t lastPassTime;
+} regionStats_[ARRAY_SIZE(rams)];
+
 static size_t offset = 0u;
 static size_t index = 0u;
 static size_t entryCount = 0u;
+static uint64_t passCount = 0u;
+static uint64_t passBytes = 0u;
+static HSSTicks_t passStartTime = 0u;
+static HSSTicks_t lastPassTime = 0u;
+
+//
+// With a configured rate, each pass is paced against HSS_GetTime() so that the bytes
+// scrubbed so far never run ahead of the target. Otherwise, only run every X superloops.
+//
+static bool scrub_is_throttled_(HSSTicks_t now)
+{
+    bool result = false;
+
+#if defined(CONFIG_SERVICE_SCRUB_RATE_KIB_PER_SEC) && (CONFIG_SERVICE_SCRUB_RATE_KIB_PER_SEC)
+    uint64_t const allowedBytes = ((now - passStartTime)
+        * ((uint64_t)CONFIG_SERVICE_SCRUB_RATE_KIB_PER_SEC * 1024u)) / TICKS_PER_SEC;
+    result = (passBytes >= allowedBytes);
+#else
+    (void)now;
+    result = (entryCount != 0u);
+#  if defined(CONFIG_SERVICE_SCRUB_RUN_EVERY_X_SUPERLOOPS) && (CONFIG_SERVICE_SCRUB_RUN_EVERY_X_SUPERLOOPS)
+    entryCount = (entryCount + 1u) % CONFIG_SERVICE_SCRUB_RUN_EVERY_X_SUPERLOOPS;
+#  endif
+#endif
+
+    return result;
+}
+
+static void scrub_next_region_(HSSTicks_t now)
+{
+    regionStats_[index].lastPassTime = now - regionStats_[index].startTime;
+
+    index = (index + 1u) % ARRAY_SIZE(rams);
+    offset = 0u;
+
+    if (index == 0u) {
+        passCount++;
+        lastPassTime = now - passStartTime;
+        mHSS_DEBUG_PRINTF(LOG_NORMAL, "Scrub pass %" PRIu64 " completed in %" PRIu64 " ms" CRLF,
+            passCount, (uint64_t)(lastPassTime / TICKS_PER_MILLISEC));
+
+        passStartTime = now;
+        passBytes = 0u;
+    }
+
+    regionStats_[index].startTime = now;
+    mHSS_DEBUG_PRINTF(LOG_NORMAL, "Scrubbing %p to %p" CRLF, rams[index].baseAddr, rams[index].endAddr);
+}
+
+// returns false if the chunk could not be started, and should be retried later
+static bool scrub_chunk_(uintptr_t baseAddr, size_t chunkSize)
+{
+    bool result = true;
+
+#if IS_ENABLED(CONFIG_SERVICE_SCRUB_USE_PDMA)
+    result = memcpy_via_pdma_submit_channel(HSS_PDMA_SCRUB_CHANNEL, scrubSink_, (void const *)baseAddr,
+        chunkSize, &scrubTxn_);
+#else
+    const uint64_t *pStart = (uint64_t *)baseAddr;
+    const uint64_t *pEnd = pStart + (chunkSize / sizeof(uint64_t));
+
+    for (uint64_t *pMem = (uint64_t *)pStart; pMem < pEnd; pMem++) {
+        *(volatile uint64_t *)pMem;
+    }
+#endif
+
+    return result;
+}
+
+// --------------------------------------------------------------------------------------------------
+// Handlers for each state in the state machine
+//
+static void scrub_init_handler(struct StateMachine * const pMyMachine)
+{
+    passStartTime = HSS_GetTime();
+    regionStats_[0].startTime = passStartTime;
+
+    pMyMachine->state++;
+}
+
+/////////////////
 static void scrub_scrubbing_handler(struct StateMachine * const pMyMachine)
 {
     (void)pMyMachine;
 
     if (ARRAY_SIZE(rams)) {
-        if (!entryCount) {
+#if IS_ENABLED(CONFIG_SERVICE_SCRUB_USE_PDMA)
+        if (scrubTxn_ && !memcpy_via_pdma_poll(&scrubTxn_)) {
+            return; // previous chunk still in flight
+        }
+#endif
+
+        HSSTicks_t const now = HSS_GetTime();
+
+        if (!scrub_is_throttled_(now)) {
             if ((rams[index].baseAddr + offset)  >= rams[index].endAddr) {
-                index = (index + 1u) % ARRAY_SIZE(rams);
-                mHSS_DEBUG_PRINTF(LOG_NORMAL, "Scrubbing %p to %p" CRLF, rams[index].baseAddr, rams[index].endAddr);
-		offset = 0u;
+                scrub_next_region_(now);
             }
 
             const uintptr_t length = rams[index].endAddr - rams[index].baseAddr;
 
             if (length) {
-                const size_t chunkSize = MIN(CONFIG_SERVICE_SCRUB_MAX_SIZE_PER_LOOP_ITER, length-offset);
-
-                const uint64_t *pStart = (uint64_t *)(rams[index].baseAddr + offset);
-                const uint64_t *pEnd = (uint64_t *)(pStart + chunkSize);
+                const size_t chunkSize = MIN(SCRUB_CHUNK_SIZE, length-offset);
 
-                for (uint64_t *pMem = (uint64_t *)pStart; pMem < pEnd; pMem++) {
-                    *(volatile uint64_t *)pMem;
+                if (scrub_chunk_(rams[index].baseAddr + offset, chunkSize)) {
+                    offset = offset + chunkSize;
+                    passBytes += chunkSize;
                 }
-                offset = offset + chunkSize;
             }
         }
     }
-
-#if defined(CONFIG_SERVICE_SCRUB_RUN_EVERY_X_SUPERLOOPS) && (CONFIG_SERVICE_SCRUB_RUN_EVERY_X_SUPERLOOPS)
-    entryCount = (entryCount + 1u) % CONFIG_SERVICE_SCRUB_RUN_EVERY_X_SUPERLOOPS;
-#else
-    entryCount = 0u;
-#endif
 }
 
 void scrub_dump_stats(void)
@@ -144,4 +227,23 @@ void scrub_dump_stats(void)
     mHSS_DEBUG_PRINTF(LOG_NORMAL, "Mem base:   0x%" PRIx64 CRLF, rams[index].baseAddr);
     mHSS_DEBUG_PRINTF(LOG_NORMAL, "offset:     0x%" PRIx64 CRLF, offset);
     mHSS_DEBUG_PRINTF(LOG_NORMAL, "entryCount: 0x%" PRIx64 CRLF, entryCount);
+
+    for (size_t i = 0u; i < ARRAY_SIZE(rams); i++) {
+        const uintptr_t length = rams[i].endAddr - rams[i].baseAddr;
+
+        if (i == index) {
+            mHSS_DEBUG_PRINTF(LOG_NORMAL, "Region %" PRIu64 ":   0x%" PRIx64 " to 0x%" PRIx64
+                ", %" PRIu64 " of %" PRIu64 " KiB scrubbed" CRLF, (uint64_t)i,
+                (uint64_t)rams[i].baseAddr, (uint64_t)rams[i].endAddr,
+                (uint64_t)(offset / 1024u), (uint64_t)(length / 1024u));
+        } else {
+            mHSS_DEBUG_PRINTF(LOG_NORMAL, "Region %" PRIu64 ":   0x%" PRIx64 " to 0x%" PRIx64
+                ", last took %" PRIu64 " ms" CRLF, (uint64_t)i,
+                (uint64_t)rams[i].baseAddr, (uint64_t)rams[i].endAddr,
+                (uint64_t)(regionStats_[i].lastPassTime / TICKS_PER_MILLISEC));
+        }
+    }
+
+    mHSS_DEBUG_PRINTF(LOG_NORMAL, "Passes:     %" PRIu64 " (last took %" PRIu64 " ms)" CRLF,
+        passCount, (uint64_t)(lastPassTime / TICKS_PER_MILLISEC));
 }
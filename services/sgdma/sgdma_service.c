@@ -67,8 +67,28 @@ struct StateMachine sgdma_service = {
 };
 
 
-static struct HSS_SGDMA_BlockDesc *pBlockDesc = NULL;
-static enum HSSHartId activeHart = HSS_HART_E51; // set to signify no U54 active...
+//
+// Each U54 gets its own job, so that requests from different harts proceed concurrently.
+// Jobs are carried on the PDMA channels reserved for SGDMA, which nothing else uses - with
+// fewer channels than U54s, harts sharing a channel take turns a block at a time. Each
+// block descriptor is submitted whole, so the E51 is only involved once per block rather
+// than once per slice.
+//
+static struct SGDMA_Job {
+    struct HSS_SGDMA_BlockDesc *pBlockDesc; // NULL if no request is active for this hart
+    HSS_PDMA_Txn_t pdmaTxn;
+} sgdmaJobs_[HSS_HART_NUM_PEERS];
+
+static inline unsigned int sgdma_channel_(enum HSSHartId hartId)
+{
+#if HSS_PDMA_SGDMA_NUM_CHANNELS
+    return HSS_PDMA_SGDMA_FIRST_CHANNEL
+        + ((unsigned int)(hartId - HSS_HART_U54_1) % (unsigned int)HSS_PDMA_SGDMA_NUM_CHANNELS);
+#else
+    (void)hartId;
+    return 0u; // no PDMA, so copies are done by the CPU
+#endif
+}
 
 // --------------------------------------------------------------------------------------------------
 // Handlers for each state in the state machine
@@ -80,64 +100,75 @@ static void sgdma_init_handler(struct StateMachine * const pMyMachine)
 
 /////////////////
 static uint32_t i = HSS_HART_U54_1;
-static void sgdma_idle_handler(struct StateMachine * const pMyMachine)
+static void sgdma_accept_request_(void)
 {
-    (void)pMyMachine;
-
-    // check each core to see if it wants to transmit
-    if (IPI_GetQueuePendingCount(i)) {
+    // check each core to see if it wants to transfer, unless it already has a request active
+    if ((i >= HSS_HART_U54_1) && (sgdmaJobs_[i].pBlockDesc == NULL) && IPI_GetQueuePendingCount(i)) {
         IPI_ConsumeIntent(i, IPI_MSG_SCATTERGATHER_DMA);
     }
     i = (i + 1u) % HSS_HART_NUM_PEERS;
 }
 
+static void sgdma_idle_handler(struct StateMachine * const pMyMachine)
+{
+    sgdma_accept_request_();
+    SleepStateMachine(pMyMachine, SM_WAKE_ON_IPI, 0u);
+}
+
 
 /////////////////
 
-#define MAX_SGDMA_SIZE_PER_LOOP_ITER (4096u)
-static size_t remaining_in_current_block = 0u;
+//
+// Advance one hart's job: once its current block has completed, submit the next one.
+// Returns true while the job is still active.
+//
+static bool sgdma_step_job_(enum HSSHartId hartId)
+{
+    struct SGDMA_Job * const pJob = &sgdmaJobs_[hartId];
+
+    if (pJob->pdmaTxn && !memcpy_via_pdma_poll(&pJob->pdmaTxn)) {
+        return true; // current block still in flight
+    }
+
+    struct HSS_SGDMA_BlockDesc * const pBlockDesc = pJob->pBlockDesc;
+
+    if (!pBlockDesc->ext) {
+        pJob->pBlockDesc = NULL;
+        return false;
+    }
+
+    // check PMPs - todo - check MPRs also
+    if (HSS_PMP_CheckWrite(hartId, (ptrdiff_t)pBlockDesc->dest_phys_addr, pBlockDesc->size)
+        && HSS_PMP_CheckRead(hartId, (ptrdiff_t)pBlockDesc->src_phys_addr, pBlockDesc->size)) {
+        if (!memcpy_via_pdma_submit_channel(sgdma_channel_(hartId), pBlockDesc->dest_phys_addr,
+                pBlockDesc->src_phys_addr, pBlockDesc->size, &pJob->pdmaTxn)) {
+            return true; // channel busy with another hart's block, retry on the next pass
+        }
+    }
+
+    pJob->pBlockDesc++;
+
+    return true;
+}
+
 static void sgdma_transferring_handler(struct StateMachine * const pMyMachine)
 {
     //mHSS_DEBUG_PRINTF(LOG_NORMAL, "called" CRLF);
 
-    assert(pBlockDesc != NULL);
-
-    if (pBlockDesc->ext) {
-       // for now, memcpy...
-       // TODO: replace this with PDMA, and x blocks per superloop??
-       // should a max pBlockDesc->size be permitted per loop iteration? I guess so...
-       //
-       size_t chunk_size = 0u;
-
-       if (remaining_in_current_block == 0u) {
-           remaining_in_current_block = pBlockDesc->size;
-           chunk_size = pBlockDesc->size;
-       } else {
-           chunk_size = remaining_in_current_block;
-       }
-
-       if (chunk_size > MAX_SGDMA_SIZE_PER_LOOP_ITER) {
-           chunk_size = MAX_SGDMA_SIZE_PER_LOOP_ITER;
-       }
-
-       // check PMPs - todo - check MPRs also
-       if (HSS_PMP_CheckWrite(activeHart, (ptrdiff_t)pBlockDesc->dest_phys_addr, chunk_size)
-           && HSS_PMP_CheckRead(activeHart, (ptrdiff_t)pBlockDesc->src_phys_addr, chunk_size)) {
-           memcpy_via_pdma(pBlockDesc->dest_phys_addr, pBlockDesc->src_phys_addr, chunk_size);
-       }
-
-       assert(remaining_in_current_block >= chunk_size);
-       remaining_in_current_block -= chunk_size;
-
-       if (remaining_in_current_block == 0u) {
-           // finished current block, move to next
-           pBlockDesc++;
-       }
-    } else {
+    bool active = false;
+
+    for (enum HSSHartId hartId = HSS_HART_U54_1; hartId < HSS_HART_NUM_PEERS; hartId++) {
+        if (sgdmaJobs_[hartId].pBlockDesc != NULL) {
+            active = sgdma_step_job_(hartId) || active;
+        }
+    }
+
+    if (!active) {
         pMyMachine->state = SGDMA_IDLE;
-        pBlockDesc = NULL;
-        activeHart = HSS_HART_E51; // set to signify no U54 active...
     }
+
+    // admit concurrent requests from other harts
+    sgdma_accept_request_();
 }
 
 enum IPIStatusCode HSS_SGDMA_IPIHandler(TxId_t transaction_id, enum HSSHartId source, uint32_t immediate_arg, void *p_extended_buffer_in_ddr, void *p_ancilliary_buffer_in_ddr)
@@ -152,11 +183,12 @@ enum IPIStatusCode HSS_SGDMA_IPIHandler(TxId_t transaction_id, enum HSSHartId so
 
     // the following should always be true if we have consumed intents for SGDMA...
     assert(p_extended_buffer_in_ddr != NULL);
-    assert(sgdma_service.state == SGDMA_IDLE);
+    assert((source >= HSS_HART_U54_1) && (source < HSS_HART_NUM_PEERS));
+    assert(sgdmaJobs_[source].pBlockDesc == NULL);
 
-    // setup the transfer -- the state machine will execute it in chunks
-    pBlockDesc = (struct HSS_SGDMA_BlockDesc *)p_extended_buffer_in_ddr;
-    activeHart = source;
+    // setup the transfer -- the state machine will execute it a block at a time
+    sgdmaJobs_[source].pBlockDesc = (struct HSS_SGDMA_BlockDesc *)p_extended_buffer_in_ddr;
+    sgdmaJobs_[source].pdmaTxn = 0u;
     sgdma_service.state = SGDMA_TRANSFERRING;
 
     return IPI_SUCCESS;
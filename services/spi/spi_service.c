@@ -77,6 +77,7 @@ static void spi_init_onExit(struct StateMachine * const pMyMachine)
 
 static void spi_init_handler(struct StateMachine * const pMyMachine)
 {
+    SleepStateMachine(pMyMachine, SM_WAKE_ON_STATE_CHANGE, 0u);
 }
 
 /////////////////
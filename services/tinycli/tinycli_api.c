@@ -38,6 +38,8 @@
 #include "csr_helper.h"
 #include "wdog_service.h"
 #include "hss_perfctr.h"
+#include "hss_trace.h"
+#include "hss_boot_timeline.h"
 
 #include "hss_registry.h"
 #include "assert.h"
@@ -410,7 +412,22 @@ static void tinyCLI_BEU_(void)
 #if IS_ENABLED(CONFIG_DEBUG_PERF_CTRS)
 static void tinyCLI_PerfCtrs_(void)
 {
-    HSS_PerfCtr_DumpAll();
+    if ((argc_tokenCount > 2u) && (strncasecmp(argv_tokenArray[2], "RESET", strlen("RESET")) == 0)) {
+        HSS_PerfCtr_ResetAll();
+    } else {
+        HSS_PerfCtr_DumpAll();
+    }
+}
+#endif
+
+#if IS_ENABLED(CONFIG_DEBUG_TRACE)
+static void tinyCLI_Trace_(void)
+{
+    if ((argc_tokenCount > 2u) && (strncasecmp(argv_tokenArray[2], "CLEAR", strlen("CLEAR")) == 0)) {
+        HSS_Trace_Clear();
+    } else {
+        HSS_Trace_Dump();
+    }
 }
 #endif
 
@@ -432,6 +449,12 @@ static void tinyCLI_Debug_(void)
         DBG_L2CACHE,
 #if IS_ENABLED(CONFIG_DEBUG_PERF_CTRS)
         DBG_PERFCTR,
+#endif
+#if IS_ENABLED(CONFIG_DEBUG_TRACE)
+        DBG_TRACE,
+#endif
+#if IS_ENABLED(CONFIG_DEBUG_BOOT_TIMELINE)
+        DBG_TIMELINE,
 #endif
         DBG_WDOG,
     };
@@ -450,7 +473,13 @@ static void tinyCLI_Debug_(void)
         { DBG_SEG,      "SEG",     "display seg registers" },
         { DBG_L2CACHE,  "L2CACHE", "display l2cache settings" },
 #if IS_ENABLED(CONFIG_DEBUG_PERF_CTRS)
-        { DBG_PERFCTR , "PERFCTR", "display perf counters" },
+        { DBG_PERFCTR , "PERFCTR", "display (or RESET) perf counters" },
+#endif
+#if IS_ENABLED(CONFIG_DEBUG_TRACE)
+        { DBG_TRACE ,   "TRACE",   "dump (or CLEAR) binary trace log" },
+#endif
+#if IS_ENABLED(CONFIG_DEBUG_BOOT_TIMELINE)
+        { DBG_TIMELINE, "TIMELINE", "display boot timeline" },
 #endif
         { DBG_WDOG ,    "WDOG",    "display watchdog statistics" },
     };
@@ -501,6 +530,18 @@ static void tinyCLI_Debug_(void)
             break;
 #endif
 
+#if IS_ENABLED(CONFIG_DEBUG_TRACE)
+        case DBG_TRACE:
+            tinyCLI_Trace_();
+            break;
+#endif
+
+#if IS_ENABLED(CONFIG_DEBUG_BOOT_TIMELINE)
+        case DBG_TIMELINE:
+            HSS_BootTimeline_Dump();
+            break;
+#endif
+
         case DBG_WDOG:
 #if IS_ENABLED(CONFIG_SERVICE_WDOG)
             HSS_Wdog_DumpStats();
@@ -535,12 +576,19 @@ static void tinyCLI_Boot_List_(void)
         struct HSS_Storage *pStorage = HSS_BootGetActiveStorage();
         assert(pStorage);
 
-        uint32_t blockSize, eraseSize, blockCount;
-        pStorage->getInfo(&blockSize, &eraseSize, &blockCount);
+        // with CONFIG_SERVICE_BOOT_CONCURRENT_PROBE, storage is not initialized until boot
+        bool result = !pStorage->init || pStorage->init();
 
-        gpt.lbaSize = blockSize;
-        GPT_Init(&gpt, pStorage);
-        bool result = GPT_ReadHeader(&gpt);
+        if (!result) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "%s: initialization failed" CRLF, pStorage->name);
+        } else {
+            uint32_t blockSize, eraseSize, blockCount;
+            pStorage->getInfo(&blockSize, &eraseSize, &blockCount);
+
+            gpt.lbaSize = blockSize;
+            GPT_Init(&gpt, pStorage);
+            result = GPT_ReadHeader(&gpt);
+        }
 
         if (result) {
             size_t srcIndex = 0u;
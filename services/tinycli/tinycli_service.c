@@ -123,7 +123,9 @@ static void tinycli_readline_handler(struct StateMachine * const pMyMachine)
 
     static bool escapeActive = false;
 
-    if (0 != MSS_UART_get_rx(&g_mss_uart0_lo, cBuf, 1)) {
+    if (0 != uart_getbuf(cBuf, 1u, 0)) {
+        uart_tx_flush(); // echo directly, so make sure buffered output goes first
+
 	if (escapeActive) {
 		switch (cBuf[0]) {
 		case '[':
@@ -246,6 +248,10 @@ static void tinycli_readline_handler(struct StateMachine * const pMyMachine)
             break;
         }
     }
+
+#if !IS_ENABLED(CONFIG_SERVICE_TINYCLI_MONITOR)
+    SleepStateMachine(pMyMachine, SM_WAKE_ON_UART_RX, 0u);
+#endif
 }
 
 static void tinycli_readline_onExit(struct StateMachine * const pMyMachine)
@@ -295,7 +301,7 @@ static void tinycli_usbdmsc_handler(struct StateMachine * const pMyMachine)
 
     done = !USBDMSC_IsActive();
 
-    if (!done && (0 != MSS_UART_get_rx(&g_mss_uart0_lo, cBuf, 1))) {
+    if (!done && (0 != uart_getbuf(cBuf, 1u, 0))) {
         done = (cBuf[0] == '\003') || (cBuf[0] == '\033');
     }
 
@@ -316,7 +322,7 @@ void HSS_TinyCLI_WaitForUSBMSCDDone(void)
 
 static void tinycli_uart_surrender_handler(struct StateMachine * const pMyMachine)
 {
-	; // nothing to do here
+    SleepStateMachine(pMyMachine, SM_WAKE_ON_STATE_CHANGE, 0u); // nothing to do here
 }
 
 void HSS_TinyCLI_SurrenderUART(void)
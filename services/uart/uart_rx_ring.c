@@ -0,0 +1,79 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Hart Software Services - Console Input Ring Buffer
+ *
+ */
+
+/*!
+ * \file Console Input Ring Buffer
+ * \brief Ring buffer for E51 console input
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include "uart_rx_ring.h"
+
+#if (CONFIG_UART_RX_RING_SIZE & (CONFIG_UART_RX_RING_SIZE - 1))
+#  error CONFIG_UART_RX_RING_SIZE must be a power of 2
+#endif
+
+#define UART_RX_RING_INDEX_MASK (CONFIG_UART_RX_RING_SIZE - 1u)
+
+static struct UartRxRing {
+    uint8_t buffer[CONFIG_UART_RX_RING_SIZE];
+    uint32_t head;      // written only by uart_rx_ring_fill()
+    uint32_t tail;      // written only by uart_rx_ring_get()
+} rxRing_;
+
+//
+// Moves whatever pReadFn has available into the free space of the ring. If the ring
+// is full, the remainder is left in the UART RX FIFO.
+//
+size_t uart_rx_ring_fill(UartRxReadFn_t pReadFn)
+{
+    size_t result = 0u;
+    struct UartRxRing * const pRing = &rxRing_;
+    bool more = true;
+
+    while (more) {
+        uint32_t const head = pRing->head;
+        uint32_t const space = CONFIG_UART_RX_RING_SIZE
+            - (head - __atomic_load_n(&pRing->tail, __ATOMIC_ACQUIRE));
+        uint32_t const offset = head & UART_RX_RING_INDEX_MASK;
+        size_t const len = MIN((size_t)space, (size_t)(CONFIG_UART_RX_RING_SIZE - offset));
+
+        size_t const count = len ? pReadFn(&pRing->buffer[offset], len) : 0u;
+        __atomic_store_n(&pRing->head, head + (uint32_t)count, __ATOMIC_RELEASE);
+
+        result += count;
+        more = (count != 0u) && (count == len); // wrapped, or still arriving
+    }
+
+    return result;
+}
+
+size_t uart_rx_ring_get(uint8_t *pBuf, size_t len)
+{
+    struct UartRxRing * const pRing = &rxRing_;
+    uint32_t const tail = pRing->tail;
+    uint32_t const pending = __atomic_load_n(&pRing->head, __ATOMIC_ACQUIRE) - tail;
+    size_t const count = MIN(len, (size_t)pending);
+
+    for (size_t i = 0u; i < count; i++) {
+        pBuf[i] = pRing->buffer[(tail + i) & UART_RX_RING_INDEX_MASK];
+    }
+    __atomic_store_n(&pRing->tail, tail + (uint32_t)count, __ATOMIC_RELEASE);
+
+    return count;
+}
+
+size_t uart_rx_ring_count(void)
+{
+    struct UartRxRing * const pRing = &rxRing_;
+
+    return (size_t)(__atomic_load_n(&pRing->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&pRing->tail, __ATOMIC_ACQUIRE));
+}
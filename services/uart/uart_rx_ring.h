@@ -0,0 +1,40 @@
+#ifndef HSS_UART_RX_RING_H
+#define HSS_UART_RX_RING_H
+
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Hart Software Services - Console Input Ring Buffer
+ *
+ */
+
+/*!
+ * \file Console Input Ring Buffer
+ * \brief Ring buffer for E51 console input
+ *
+ * The E51 runs with interrupts masked, so the 16-byte UART RX FIFO is emptied into
+ * this ring by uart_rx_ring_fill() whenever the console is read or polled, which lets
+ * the FIFO be serviced far less often than once per character time. The ring has a
+ * single producer and a single consumer, both on the E51.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "config.h"
+#include "hss_types.h"
+
+typedef size_t (*UartRxReadFn_t)(uint8_t *pBuf, size_t len);
+
+size_t uart_rx_ring_fill(UartRxReadFn_t pReadFn);
+size_t uart_rx_ring_get(uint8_t *pBuf, size_t len);
+size_t uart_rx_ring_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -18,6 +18,11 @@
 #include "hss_debug.h"
 
 #include "ssmb_ipi.h"
+#include "uart_helper.h"
+#if IS_ENABLED(CONFIG_UART_TX_RING)
+#  include "hss_clock.h"
+#  include "uart_tx_ring.h"
+#endif
 
 static void uart_init_handler(struct StateMachine * const pMyMachine);
 static void uart_state1_handler(struct StateMachine * const pMyMachine);
@@ -55,6 +60,9 @@ struct StateMachine uart_service = {
 static void uart_init_handler(struct StateMachine * const pMyMachine)
 {
     //mHSS_DEBUG_PRINTF("\tcalled" CRLF);
+#if IS_ENABLED(CONFIG_UART_TX_RING)
+    uart_tx_ring_start();
+#endif
     pMyMachine->state++;
 }
 
@@ -69,6 +77,26 @@ static void uart_state1_handler(struct StateMachine * const pMyMachine)
         IPI_ConsumeIntent(i, IPI_MSG_UART_TX);
     }
     i = (i + 1u) % HSS_HART_NUM_PEERS;
+
+#if IS_ENABLED(CONFIG_UART_TX_RING)
+    // drain buffered console output, one TX FIFO's worth per hart per pass
+    bool allDrained = true;
+    for (int hartid = HSS_HART_E51; hartid < HSS_HART_NUM_PEERS; hartid++) {
+        allDrained = uart_tx_drain(hartid) && allDrained;
+    }
+
+    if (!allDrained) {
+        // the TX FIFO takes over a millisecond to empty at 115200 baud
+        SleepStateMachine(pMyMachine, SM_WAKE_ON_IPI | SM_WAKE_ON_TIMER, HSS_GetTime() + ONE_MILLISEC);
+    } else if (IS_ENABLED(CONFIG_UART_TX_RING_ALL_HARTS)) {
+        // U54 output doesn't wake us directly, so poll for it
+        SleepStateMachine(pMyMachine, SM_WAKE_ON_IPI | SM_WAKE_ON_TIMER, HSS_GetTime() + 10u * ONE_MILLISEC);
+    } else {
+        SleepStateMachine(pMyMachine, SM_WAKE_ON_IPI, 0u);
+    }
+#else
+    SleepStateMachine(pMyMachine, SM_WAKE_ON_IPI, 0u);
+#endif
     //pMyMachine->state++;
 }
 
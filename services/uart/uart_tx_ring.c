@@ -0,0 +1,154 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Hart Software Services - Console Output Ring Buffers
+ *
+ */
+
+/*!
+ * \file Console Output Ring Buffers
+ * \brief Per-hart ring buffers for deferred console output
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_state_machine.h"
+
+#include "ssmb_ipi.h"
+#include "uart_helper.h"
+#include "uart_service.h"
+#include "uart_tx_ring.h"
+
+#if (CONFIG_UART_TX_RING_SIZE & (CONFIG_UART_TX_RING_SIZE - 1))
+#  error CONFIG_UART_TX_RING_SIZE must be a power of 2
+#endif
+
+#define UART_TX_RING_INDEX_MASK (CONFIG_UART_TX_RING_SIZE - 1u)
+
+static struct UartTxRing {
+    uint8_t buffer[CONFIG_UART_TX_RING_SIZE];
+    uint32_t head;      // written only by the producing hart
+    uint32_t tail;      // written only with drainLock held
+    uint32_t drainLock;
+} txRings_[HSS_HART_NUM_PEERS];
+
+// until the UART state machine is running, nothing would drain the rings, so early
+// boot output (and anything printed before a hang) is written to the UART directly
+static bool txRingsStarted_ = false;
+
+static inline bool is_buffered_(int hartid)
+{
+    if (!__atomic_load_n(&txRingsStarted_, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    bool result = (hartid == HSS_HART_E51);
+
+#if IS_ENABLED(CONFIG_UART_TX_RING_ALL_HARTS)
+    result = (hartid >= HSS_HART_E51) && (hartid < HSS_HART_NUM_PEERS);
+#endif
+
+    return result;
+}
+
+#if IS_ENABLED(CONFIG_UART_TX_RING_OVERFLOW_OVERWRITE)
+static void discard_oldest_(struct UartTxRing * const pRing, uint32_t count)
+{
+    while (__atomic_exchange_n(&pRing->drainLock, 1u, __ATOMIC_ACQUIRE)) {
+        ; // a drain on another hart is in progress, and will release the lock shortly
+    }
+
+    uint32_t const tail = pRing->tail;
+    uint32_t const pending = pRing->head - tail;
+    __atomic_store_n(&pRing->tail, tail + MIN(count, pending), __ATOMIC_RELEASE);
+
+    __atomic_store_n(&pRing->drainLock, 0u, __ATOMIC_RELEASE);
+}
+#endif
+
+//
+// Called by the UART state machine once it is running, to start buffering output
+//
+void uart_tx_ring_start(void)
+{
+    __atomic_store_n(&txRingsStarted_, true, __ATOMIC_RELEASE);
+}
+
+//
+// Returns false if output for this hart is not buffered, in which case the caller
+// should write it to the UART directly
+//
+bool uart_tx_ring_put(int hartid, uint8_t const *pBuf, size_t len)
+{
+    bool const result = is_buffered_(hartid);
+    struct UartTxRing * const pRing = &txRings_[hartid];
+
+    while (result && len) {
+        uint32_t const head = pRing->head;
+        uint32_t const space = CONFIG_UART_TX_RING_SIZE
+            - (head - __atomic_load_n(&pRing->tail, __ATOMIC_ACQUIRE));
+
+        if (!space) {
+#if IS_ENABLED(CONFIG_UART_TX_RING_OVERFLOW_BLOCK)
+            (void)uart_tx_drain(hartid);
+            continue;
+#elif IS_ENABLED(CONFIG_UART_TX_RING_OVERFLOW_OVERWRITE)
+            discard_oldest_(pRing, (uint32_t)MIN(len, (size_t)CONFIG_UART_TX_RING_SIZE));
+            continue;
+#else
+            break; // drop
+#endif
+        }
+
+        size_t const count = MIN(len, (size_t)space);
+        for (size_t i = 0u; i < count; i++) {
+            pRing->buffer[(head + i) & UART_TX_RING_INDEX_MASK] = pBuf[i];
+        }
+        __atomic_store_n(&pRing->head, head + (uint32_t)count, __ATOMIC_RELEASE);
+
+        pBuf += count;
+        len -= count;
+    }
+
+    if (result) {
+        WakeStateMachine(&uart_service);
+    }
+
+    return result;
+}
+
+//
+// Hands the oldest contiguous run of pending bytes to pWriteFn, and retires however
+// many it accepted. Returns without doing anything if another hart is draining.
+//
+size_t uart_tx_ring_drain(int hartid, UartTxWriteFn_t pWriteFn)
+{
+    size_t result = 0u;
+    struct UartTxRing * const pRing = &txRings_[hartid];
+
+    if (!__atomic_exchange_n(&pRing->drainLock, 1u, __ATOMIC_ACQUIRE)) {
+        uint32_t const tail = pRing->tail;
+        uint32_t const head = __atomic_load_n(&pRing->head, __ATOMIC_ACQUIRE);
+
+        if (head != tail) {
+            uint32_t const offset = tail & UART_TX_RING_INDEX_MASK;
+            size_t const len = MIN((size_t)(head - tail), (size_t)(CONFIG_UART_TX_RING_SIZE - offset));
+
+            result = pWriteFn(hartid, &pRing->buffer[offset], len);
+            __atomic_store_n(&pRing->tail, tail + (uint32_t)result, __ATOMIC_RELEASE);
+        }
+
+        __atomic_store_n(&pRing->drainLock, 0u, __ATOMIC_RELEASE);
+    }
+
+    return result;
+}
+
+bool uart_tx_ring_is_empty(int hartid)
+{
+    struct UartTxRing * const pRing = &txRings_[hartid];
+
+    return (__atomic_load_n(&pRing->head, __ATOMIC_ACQUIRE) == __atomic_load_n(&pRing->tail, __ATOMIC_ACQUIRE));
+}
@@ -0,0 +1,41 @@
+#ifndef HSS_UART_TX_RING_H
+#define HSS_UART_TX_RING_H
+
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Hart Software Services - Console Output Ring Buffers
+ *
+ */
+
+/*!
+ * \file Console Output Ring Buffers
+ * \brief Per-hart ring buffers for deferred console output
+ *
+ * Console output is queued with uart_tx_ring_put(), and later written into the
+ * UART TX FIFO by uart_tx_ring_drain(), from the UART state machine. Output is
+ * only buffered once that state machine has called uart_tx_ring_start(). Each ring
+ * has a single producer (its own hart), but may be drained from any hart.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "config.h"
+#include "hss_types.h"
+
+typedef size_t (*UartTxWriteFn_t)(int hartid, uint8_t const *pBuf, size_t len);
+
+void uart_tx_ring_start(void);
+bool uart_tx_ring_put(int hartid, uint8_t const *pBuf, size_t len);
+size_t uart_tx_ring_drain(int hartid, UartTxWriteFn_t pWriteFn);
+bool uart_tx_ring_is_empty(int hartid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
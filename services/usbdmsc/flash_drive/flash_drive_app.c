@@ -18,6 +18,7 @@
 #include "mss_clint.h"
 #include <stdbool.h>
 #include "flash_drive_app.h"
+#include "flash_drive_pipeline.h"
 #include "drivers/mss/mss_usb/mss_usb_device.h"
 #include "drivers/mss/mss_usb/mss_usb_device_msd.h"
 #include "hal/hal.h"
@@ -46,7 +47,6 @@ int sbi_printf(const char *format, ...);
 #define MMC_LBA_BLOCK_SIZE            512u
 #define MMC_NUM_LBA_BLOCKS            0xE90E80u   // 15273600 => ~7.28GiB
 #define MMC_ERASE_SIZE                4096u
-#define SD_RD_WR_SIZE                 32768u
 
 uint32_t g_host_connection_detected = 0u;
 
@@ -88,12 +88,6 @@ static mss_usbd_msc_media_t usb_flash_media = {
 
 extern mss_usbd_user_descr_cb_t flash_drive_descriptors_cb;
 
-/*This buffer is passed to the USB driver. When USB drivers are configured to
-use internal DMA, the address of this buffer must be modulo-4.Otherwise DMA
-Transfer will fail.*/
-
-uint8_t  lun0_data_buffer[SD_RD_WR_SIZE] __attribute__((aligned(8))) = { 0u };
-
 flash_lun_data_t lun_data[NUMBER_OF_LUNS_ON_DRIVE] = {{MMC_NUM_LBA_BLOCKS, MMC_ERASE_SIZE, MMC_LBA_BLOCK_SIZE}};
 
 static mss_usbd_msc_scsi_inq_resp_t usb_flash_media_inquiry_data[NUMBER_OF_LUNS_ON_DRIVE] =
@@ -208,6 +202,8 @@ static uint8_t usb_flash_media_release(uint8_t cfgidx)
 {
     (void)cfgidx;
 
+    FLASH_DRIVE_process_pending();
+
     void HSS_Storage_FlushWriteBuffer(void);
     HSS_Storage_FlushWriteBuffer();
 
@@ -242,7 +238,7 @@ static uint8_t usb_flash_media_get_capacity(uint8_t lun, uint32_t *no_of_blocks,
     return result;
 }
 
-static void physical_device_read(uint64_t byte_address, uint8_t *p_rx_buffer,
+void FLASH_DRIVE_physical_read(uint64_t byte_address, uint8_t *p_rx_buffer,
     size_t size_in_bytes)
 {
     update_read_count(size_in_bytes);
@@ -270,6 +266,16 @@ static void physical_device_read(uint64_t byte_address, uint8_t *p_rx_buffer,
     (void)HSS_Storage_ReadBlock((void *)p_rx_buffer, (size_t)byte_address, size_in_bytes);
 }
 
+void FLASH_DRIVE_physical_program(uint64_t byte_address, uint8_t * p_write_buffer,
+    uint32_t size_in_bytes)
+{
+    update_write_count(size_in_bytes);
+
+    bool HSS_Storage_WriteBlock(size_t dstOffset, void * pSrc, size_t byteCount);
+    (void)HSS_Storage_WriteBlock((size_t)byte_address, (void *)p_write_buffer,
+        (size_t)size_in_bytes);
+}
+
 static uint32_t usb_flash_media_read(uint8_t lun, uint8_t **buf, uint64_t lba_addr, uint32_t len)
 {
     if (lun == 0) {
@@ -277,9 +283,9 @@ static uint32_t usb_flash_media_read(uint8_t lun, uint8_t **buf, uint64_t lba_ad
             len = SD_RD_WR_SIZE;
         }
 
-        physical_device_read(lba_addr, lun0_data_buffer, len);
-
-        *buf = lun0_data_buffer;
+        uint64_t const capacity =
+            (uint64_t)lun_data[0].number_of_blocks * lun_data[0].lba_block_size;
+        *buf = FLASH_DRIVE_pipeline_read(lba_addr, len, capacity);
     }
 
     return len;
@@ -293,22 +299,12 @@ static uint8_t* usb_flash_media_acquire_write_buf(uint8_t lun, uint64_t blk_addr
     //if ((blk_addr <= ((uint64_t)NUM_LBA_BLOCKS * LBA_BLOCK_SIZE)) && (lun == 0u)) {
     if ((blk_addr <= ((uint64_t)lun_data[0].number_of_blocks * lun_data[0].lba_block_size)) && (lun == 0u)) {
         *len = SD_RD_WR_SIZE;
-        result = lun0_data_buffer;
+        result = FLASH_DRIVE_pipeline_acquire_write_buf();
     }
 
     return result;
 }
 
-static void physical_device_program(uint64_t byte_address, uint8_t * p_write_buffer,
-    uint32_t size_in_bytes)
-{
-    update_write_count(size_in_bytes);
-
-    bool HSS_Storage_WriteBlock(size_t dstOffset, void * pSrc, size_t byteCount);
-    (void)HSS_Storage_WriteBlock((size_t)byte_address, (void *)p_write_buffer,
-        (size_t)size_in_bytes);
-}
-
 static uint32_t usb_flash_media_write_ready(uint8_t lun, uint64_t blk_addr, uint32_t len)
 {
     uint32_t result = 0u;
@@ -317,7 +313,7 @@ static uint32_t usb_flash_media_write_ready(uint8_t lun, uint64_t blk_addr, uint
             len = SD_RD_WR_SIZE;
         }
 
-        physical_device_program(blk_addr, lun0_data_buffer, len);
+        FLASH_DRIVE_pipeline_write_ready(blk_addr, len);
         result = 1u;
     }
 
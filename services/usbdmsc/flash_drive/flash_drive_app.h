@@ -54,6 +54,7 @@ bool FLASH_DRIVE_init(void);
 uint32_t FLASH_DRIVE_is_host_connected(void);
 
 void FLASH_DRIVE_dump_xfer_status(void);
+void FLASH_DRIVE_process_pending(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,135 @@
+/***************************************************************************//**
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * USB MSC Class Storage Device transfer buffers.
+ *
+ * Keeps the buffers lent to the USB driver, and sequences the storage accesses
+ * for them. This needs nothing from the USB driver, so that it can be checked
+ * on its own (see tools/secure-boot/test/test_usbdmsc.c).
+ *
+ */
+
+#include "config.h"
+#include "hss_types.h"
+
+#include <stdbool.h>
+
+#include "flash_drive_app.h"
+#include "flash_drive_pipeline.h"
+
+/*This buffer is passed to the USB driver. When USB drivers are configured to
+use internal DMA, the address of this buffer must be modulo-4.Otherwise DMA
+Transfer will fail.*/
+
+#ifdef CONFIG_SERVICE_USBDMSC_PIPELINE
+#  define NUM_DATA_BUFFERS            2u
+#else
+#  define NUM_DATA_BUFFERS            1u
+#endif
+
+uint8_t  lun0_data_buffer[NUM_DATA_BUFFERS][SD_RD_WR_SIZE] __attribute__((aligned(8))) = { 0u };
+
+/*With more than one data buffer, the buffer not currently lent to the USB driver is used
+either to read ahead the next sequential chunk, or to hold a received chunk until it is
+programmed. Either is done from FLASH_DRIVE_process_pending(), while the USB DMA transfers
+the other buffer.*/
+enum flash_pending_op {
+    PENDING_NONE,
+    PENDING_READ_AHEAD,         /* read requested, but not yet performed */
+    PENDING_READ_AHEAD_VALID,   /* read performed, data is in the buffer */
+    PENDING_WRITE,              /* data received, but not yet programmed */
+};
+
+static struct {
+    enum flash_pending_op op;
+    uint64_t byte_address;
+    uint32_t len;
+} pending = { PENDING_NONE, 0u, 0u };
+
+static unsigned usb_buf_idx = 0u; /* buffer currently lent to the USB driver */
+
+static inline unsigned other_buf_idx(void)
+{
+    return (usb_buf_idx + 1u) % NUM_DATA_BUFFERS;
+}
+
+/*Performs any deferred read-ahead or write, using the buffer not lent to the USB driver.
+Called from the USBDMSC poll loop, so that it overlaps the USB transfer of the other
+buffer, and before anything that needs the storage to be up to date.*/
+void FLASH_DRIVE_process_pending(void)
+{
+    switch (pending.op) {
+    case PENDING_READ_AHEAD:
+        FLASH_DRIVE_physical_read(pending.byte_address, lun0_data_buffer[other_buf_idx()],
+            pending.len);
+        pending.op = PENDING_READ_AHEAD_VALID;
+        break;
+
+    case PENDING_WRITE:
+        FLASH_DRIVE_physical_program(pending.byte_address, lun0_data_buffer[other_buf_idx()],
+            pending.len);
+        pending.op = PENDING_NONE;
+        break;
+
+    default:
+        break;
+    }
+}
+
+uint8_t *FLASH_DRIVE_pipeline_read(uint64_t byte_address, uint32_t len, uint64_t capacity)
+{
+    if (pending.op == PENDING_WRITE) {
+        FLASH_DRIVE_process_pending(); /* reads must see earlier writes */
+    }
+
+    if ((pending.op == PENDING_READ_AHEAD) && (pending.byte_address == byte_address)) {
+        FLASH_DRIVE_process_pending(); /* requested before the poll loop got to it */
+    }
+
+    if ((pending.op == PENDING_READ_AHEAD_VALID) && (pending.byte_address == byte_address)
+            && (pending.len >= len)) {
+        usb_buf_idx = other_buf_idx();
+    } else {
+        FLASH_DRIVE_physical_read(byte_address, lun0_data_buffer[usb_buf_idx], len);
+    }
+    pending.op = PENDING_NONE;
+
+    /*assume sequential access, and read ahead the next chunk into the other buffer*/
+    uint64_t const next_address = byte_address + len;
+
+    if ((NUM_DATA_BUFFERS > 1u) && (next_address < capacity)) {
+        pending.op = PENDING_READ_AHEAD;
+        pending.byte_address = next_address;
+        pending.len = (uint32_t)MIN((uint64_t)SD_RD_WR_SIZE, capacity - next_address);
+    }
+
+    return lun0_data_buffer[usb_buf_idx];
+}
+
+uint8_t *FLASH_DRIVE_pipeline_acquire_write_buf(void)
+{
+    if (pending.op != PENDING_WRITE) {
+        pending.op = PENDING_NONE; /* any read-ahead is now stale */
+    }
+
+    return lun0_data_buffer[usb_buf_idx];
+}
+
+void FLASH_DRIVE_pipeline_write_ready(uint64_t byte_address, uint32_t len)
+{
+    if (NUM_DATA_BUFFERS > 1u) {
+        /*defer programming, and receive the next chunk into the other buffer meanwhile*/
+        if (pending.op == PENDING_WRITE) {
+            FLASH_DRIVE_process_pending();
+        }
+
+        pending.op = PENDING_WRITE;
+        pending.byte_address = byte_address;
+        pending.len = len;
+        usb_buf_idx = other_buf_idx();
+    } else {
+        FLASH_DRIVE_physical_program(byte_address, lun0_data_buffer[usb_buf_idx], len);
+    }
+}
@@ -0,0 +1,66 @@
+/***************************************************************************//**
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * USB MSC Class Storage Device transfer buffers.
+ *
+ * Header for flash_drive_pipeline.c
+ *
+ */
+
+#ifndef FLASH_DRIVE_PIPELINE_H_
+#define FLASH_DRIVE_PIPELINE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Size of each transfer buffer lent to the USB driver */
+#define SD_RD_WR_SIZE                 32768u
+
+/******************************************************************************
+  Exported functions from this file
+*/
+
+/***************************************************************************//**
+  @brief FLASH_DRIVE_pipeline_read()
+
+  Returns a transfer buffer holding len bytes (at most SD_RD_WR_SIZE) from
+  byte_address, served from the read-ahead if it hit, and schedules a read-ahead
+  of the following chunk, up to capacity.
+*/
+uint8_t *FLASH_DRIVE_pipeline_read(uint64_t byte_address, uint32_t len, uint64_t capacity);
+
+/***************************************************************************//**
+  @brief FLASH_DRIVE_pipeline_acquire_write_buf()
+
+  Returns the transfer buffer to receive the next chunk written by the host.
+*/
+uint8_t *FLASH_DRIVE_pipeline_acquire_write_buf(void);
+
+/***************************************************************************//**
+  @brief FLASH_DRIVE_pipeline_write_ready()
+
+  Programs the len bytes (at most SD_RD_WR_SIZE) received into the buffer from
+  FLASH_DRIVE_pipeline_acquire_write_buf() to byte_address, or defers that to
+  FLASH_DRIVE_process_pending() when there is a second buffer.
+*/
+void FLASH_DRIVE_pipeline_write_ready(uint64_t byte_address, uint32_t len);
+
+/***************************************************************************//**
+  Storage accesses, provided by flash_drive_app.c
+*/
+void FLASH_DRIVE_physical_read(uint64_t byte_address, uint8_t *p_rx_buffer,
+    size_t size_in_bytes);
+void FLASH_DRIVE_physical_program(uint64_t byte_address, uint8_t *p_write_buffer,
+    uint32_t size_in_bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLASH_DRIVE_PIPELINE_H_*/
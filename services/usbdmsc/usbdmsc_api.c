@@ -97,6 +97,9 @@ bool USBDMSC_Poll(void)
         }
     }
 
+    // with the USB transfer now under way, catch up on any read-ahead or deferred write
+    FLASH_DRIVE_process_pending();
+
     if (HSS_Timer_IsElapsed(last_poll_time, 5*TICKS_PER_SEC)) {
         FLASH_DRIVE_dump_xfer_status();
         last_poll_time = HSS_GetTime();
@@ -88,7 +88,7 @@ static void usbdmsc_init_handler(struct StateMachine * const pMyMachine)
 
 static void usbdmsc_idle_handler(struct StateMachine * const pMyMachine)
 {
-    (void)pMyMachine;
+    SleepStateMachine(pMyMachine, SM_WAKE_ON_STATE_CHANGE, 0u);
 }
 
 /////////////////
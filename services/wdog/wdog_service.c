@@ -25,6 +25,9 @@
 
 #include "mss_watchdog.h"
 
+// how often the hardware watchdogs are checked and tickled while monitoring
+#define WDOG_MONITOR_PERIOD (ONE_MILLISEC)
+
 static void wdog_init_handler(struct StateMachine * const pMyMachine);
 static void wdog_idle_handler(struct StateMachine * const pMyMachine);
 
@@ -115,9 +118,10 @@ static void wdog_idle_handler(struct StateMachine * const pMyMachine)
 
         //mHSS_DEBUG_PRINTF("watchdog bitmask is 0x%x" CRLF, hartBitmask.uint);
         pMyMachine->state = WDOG_MONITORING;
+    } else {
+        // nothing to do in this state until HSS_Wdog_MonitorHart() is called
+        SleepStateMachine(pMyMachine, SM_WAKE_ON_STATE_CHANGE, 0u);
     }
-
-    // nothing to do in this state
 }
 
 
@@ -176,6 +180,8 @@ static void wdog_monitoring_handler(struct StateMachine * const pMyMachine)
             wdogInitTime[HSS_HART_U54_4] = HSS_GetTime();
         }
     }
+
+    SleepStateMachine(pMyMachine, SM_WAKE_ON_TIMER, HSS_GetTime() + WDOG_MONITOR_PERIOD);
 }
 
 
@@ -218,6 +224,8 @@ void HSS_Wdog_MonitorHart(enum HSSHartId target)
         assert(1 == 0); // should never reach here!! LCOV_EXCL_LINE
         break;
     }
+
+    WakeStateMachine(&wdog_service);
 }
 
 void HSS_Wdog_Reboot(enum HSSHartId target)
@@ -75,16 +75,23 @@ static bool hss_loader_mmc_init(void);
 static bool hss_loader_mmc_program(uint8_t *pBuffer, size_t wrAddr, size_t receivedCount);
 #endif
 
+#if IS_ENABLED(CONFIG_SERVICE_YMODEM_STREAMING)
+static uint8_t *hss_loader_get_window(size_t windowSize);
+#  if IS_ENABLED(CONFIG_SERVICE_QSPI)
+static bool hss_loader_qspi_stream_write(size_t offset, uint8_t *pData, size_t byteCount);
+static size_t hss_loader_qspi_stream(void);
+#  endif
+#  if IS_ENABLED(CONFIG_SERVICE_MMC)
+static bool hss_loader_mmc_stream_write(size_t offset, uint8_t *pData, size_t byteCount);
+static size_t hss_loader_mmc_stream(void);
+#  endif
+#endif
+
 #if IS_ENABLED(CONFIG_SERVICE_QSPI)
 static bool hss_loader_qspi_init(void)
 {
-    static bool initialized = false;
-    bool result = false;
-
-    if (!initialized) {
-        result = HSS_QSPIInit();
-        initialized = true;
-    }
+    // HSS_QSPIInit() only initializes once, so a second transfer also sees the flash
+    bool result = HSS_QSPIInit();
     return result;
 }
 
@@ -122,6 +129,75 @@ bool hss_loader_mmc_program(uint8_t *pBuffer, size_t wrAddr, size_t receivedCoun
 }
 #endif
 
+#if IS_ENABLED(CONFIG_SERVICE_YMODEM_STREAMING)
+//
+// The streaming window lives at the top of DDR, clear of the QSPI driver's block maps and
+// cache, which are placed at the start of DDR
+//
+static uint8_t *hss_loader_get_window(size_t windowSize)
+{
+    return (uint8_t *)(HSS_DDR_GetStart() + HSS_DDR_GetSize() - windowSize);
+}
+
+#  if IS_ENABLED(CONFIG_SERVICE_QSPI)
+static bool hss_loader_qspi_stream_write(size_t offset, uint8_t *pData, size_t byteCount)
+{
+    // erase only the blocks that this window covers, just before programming them
+    bool result = HSS_QSPI_EraseBlocks(offset, byteCount);
+
+    if (result) {
+        result = hss_loader_qspi_program(pData, offset, byteCount);
+    }
+
+    return result;
+}
+
+static size_t hss_loader_qspi_stream(void)
+{
+    size_t result = 0u;
+
+    if (hss_loader_qspi_init()) {
+        uint32_t pageSize, eraseSize, pageCount;
+        HSS_QSPI_GetInfo(&pageSize, &eraseSize, &pageCount);
+
+        size_t const windowSize = eraseSize;
+        size_t const capacity = (size_t)pageSize * pageCount;
+
+        result = ymodem_receive_streaming(hss_loader_get_window(windowSize), windowSize, capacity,
+            hss_loader_qspi_stream_write);
+    }
+
+    return result;
+}
+#  endif
+
+#  if IS_ENABLED(CONFIG_SERVICE_MMC)
+static bool hss_loader_mmc_stream_write(size_t offset, uint8_t *pData, size_t byteCount)
+{
+    return hss_loader_mmc_program(pData, offset, byteCount);
+}
+
+static size_t hss_loader_mmc_stream(void)
+{
+    size_t result = 0u;
+
+    if (hss_loader_mmc_init()) {
+        uint32_t sectorSize, eraseSize, sectorCount;
+        HSS_MMC_GetInfo(&sectorSize, &eraseSize, &sectorCount);
+
+        size_t const windowSize = (size_t)CONFIG_SERVICE_YMODEM_STREAMING_MMC_WINDOW_KIB * 1024u;
+        size_t const capacity = (size_t)sectorSize * sectorCount;
+
+        result = ymodem_receive_streaming(hss_loader_get_window(windowSize), windowSize, capacity,
+            hss_loader_mmc_stream_write);
+        HSS_MMC_FlushWriteBuffer();
+    }
+
+    return result;
+}
+#  endif
+#endif
+
 void hss_loader_ymodem_loop(void);
 void hss_loader_ymodem_loop(void)
 {
@@ -160,7 +236,14 @@ void hss_loader_ymodem_loop(void)
 #if IS_ENABLED(CONFIG_SERVICE_MMC)
             " 5. MMC Write -- write application file to the Device" CRLF
 #endif
-            " 6. Quit -- quit QSPI Utility" CRLF CRLF
+            " 6. Quit -- quit QSPI Utility" CRLF
+#if IS_ENABLED(CONFIG_SERVICE_YMODEM_STREAMING) && IS_ENABLED(CONFIG_SERVICE_QSPI)
+            " 7. QSPI Stream -- receive application file, writing it through to the Device" CRLF
+#endif
+#if IS_ENABLED(CONFIG_SERVICE_YMODEM_STREAMING) && IS_ENABLED(CONFIG_SERVICE_MMC)
+            " 8. MMC Stream -- receive application file, writing it through to the Device" CRLF
+#endif
+            CRLF
             " Select a number:" CRLF;
 
         mHSS_PUTS(menuText);
@@ -272,6 +355,30 @@ void hss_loader_ymodem_loop(void)
                 done = true;
                 break;
 
+#if IS_ENABLED(CONFIG_SERVICE_YMODEM_STREAMING) && IS_ENABLED(CONFIG_SERVICE_QSPI)
+            case '7':
+                mHSS_PUTS(CRLF "Attempting to receive .bin file to QSPI using YMODEM (CTRL-C to cancel)"
+                    CRLF);
+                if (hss_loader_qspi_stream() == 0u) {
+                    HSS_Debug_Highlight(HSS_DEBUG_LOG_ERROR);
+                    mHSS_PUTS(CRLF "YMODEM failed to receive and write file successfully" CRLF CRLF);
+                    HSS_Debug_Highlight(HSS_DEBUG_LOG_NORMAL);
+                }
+                break;
+#endif
+
+#if IS_ENABLED(CONFIG_SERVICE_YMODEM_STREAMING) && IS_ENABLED(CONFIG_SERVICE_MMC)
+            case '8':
+                mHSS_PUTS(CRLF "Attempting to receive .bin file to MMC using YMODEM (CTRL-C to cancel)"
+                    CRLF);
+                if (hss_loader_mmc_stream() == 0u) {
+                    HSS_Debug_Highlight(HSS_DEBUG_LOG_ERROR);
+                    mHSS_PUTS(CRLF "YMODEM failed to receive and write file successfully" CRLF CRLF);
+                    HSS_Debug_Highlight(HSS_DEBUG_LOG_NORMAL);
+                }
+                break;
+#endif
+
             default: // ignore
                 break;
 	    }
@@ -35,6 +35,24 @@ extern "C" {
 
 size_t ymodem_receive(uint8_t *buffer, size_t bufferSize);
 
+/*!
+ * \brief Callback used by ymodem_receive_streaming() to write out each completed window
+ *
+ * Called with the offset of the window within the received file. Returns false to abort
+ * the transfer.
+ */
+typedef bool (*ymodem_write_fn_t)(size_t offset, uint8_t *pData, size_t byteCount);
+
+/*!
+ * \brief Receive a file, writing it through to storage as it arrives
+ *
+ * Received data is staged in windowBuffer, and each time windowSize bytes have arrived they
+ * are handed to writeFn before the completing packet is acknowledged. The final partial
+ * window is written once the session ends. maxSize bounds the overall file size.
+ */
+size_t ymodem_receive_streaming(uint8_t *windowBuffer, size_t windowSize, size_t maxSize,
+    ymodem_write_fn_t writeFn);
+
 #ifdef __cplusplus
 }
 #endif
@@ -90,6 +90,7 @@ static int16_t getchar_with_timeout_(int32_t timeout_sec)
 
 static void putchar_(uint8_t tx_byte)
 {
+    uart_tx_flush();
     MSS_UART_polled_tx(g_my_uart, &tx_byte, 1);
 }
 
@@ -124,6 +125,12 @@ struct XYModem_State {
     char filename[HSS_XYMODEM_MAX_FILENAME_LENGTH];
     size_t expectedSize;
     size_t maxSize;
+    // streaming: data is staged in a window buffer and handed to writeFn each time it fills
+    ymodem_write_fn_t writeFn;
+    size_t windowSize;
+    size_t windowFill;
+    size_t flushedSize;
+    uint32_t crc32;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -272,21 +279,16 @@ static bool XYMODEM_ReadPacket(struct XYModem_Packet *pPacket, struct XYModem_St
             pPacket->blkNumOnesComplement = getchar_with_timeout_(timeout_sec);
             ++(pState->numReceivedPackets);
 
-            size_t i = 0u;
-            while (i < pPacket->length) {
-                pPacket->buffer[i] = getchar_with_timeout_(timeout_sec);
-                ++i;
-            }
-
-            pPacket->buffer[i] = getchar_with_timeout_(timeout_sec); ++i; //crc_hi
-            pPacket->buffer[i] = getchar_with_timeout_(timeout_sec); ++i; //crc_lo
+            // read the data and CRC (crc_hi, crc_lo) as one block
+            size_t const expected = pPacket->length + HSS_XYMODEM_PACKET_TRAILER;
+            size_t const received = uart_getbuf((uint8_t *)pPacket->buffer, expected, timeout_sec);
 
             if (pState->status.done) {
                 ;
             } else {
                 if (pState->eotReceived)  {
                     ;
-                } else if (XYMODEM_ValidatePacket(pPacket, pState)) {
+                } else if ((received == expected) && XYMODEM_ValidatePacket(pPacket, pState)) {
                     pState->lastReceivedBlkNum = pPacket->blkNum;
                     ++(pState->expectedBlkNum);
                 } else { // corrupt packet?
@@ -350,6 +352,60 @@ static size_t XYMODEM_GetFileSize(char *pStart, char *pEnd)
     return fileSize;
 }
 
+//
+// Hand the staged window to the write callback (if any), trimming any SUB padding beyond the
+// advertised file size, and fold the written bytes into the running CRC32
+//
+static bool XYMODEM_FlushWindow(struct XYModem_State *pState, char *buffer, size_t count)
+{
+    bool result = true;
+
+    if ((pState->expectedSize != 0u) && ((pState->flushedSize + count) > pState->expectedSize)) {
+        count = (pState->expectedSize > pState->flushedSize) ?
+            (pState->expectedSize - pState->flushedSize) : 0u;
+    }
+
+    if (count) {
+        if (pState->writeFn) {
+            result = pState->writeFn(pState->flushedSize, (uint8_t *)buffer, count);
+        }
+
+        pState->crc32 = CRC32_calculate_ex(pState->crc32, (uint8_t const *)buffer, count);
+        pState->flushedSize += count;
+    }
+
+    return result;
+}
+
+static bool XYMODEM_StoreData(struct XYModem_State *pState, char *buffer, struct XYModem_Packet *pPacket)
+{
+    bool result = true;
+
+    // dynamically ensure we have enough space to receive, on each received chunk
+    if ((pState->totalReceivedSize + pPacket->length) >= pState->maxSize) {
+        result = false;
+    } else {
+        size_t copied = 0u;
+
+        while (result && (copied < pPacket->length)) {
+            size_t const chunk = MIN(pPacket->length - copied, pState->windowSize - pState->windowFill);
+
+            memcpy(buffer + pState->windowFill, pPacket->buffer + copied, chunk);
+            pState->windowFill += chunk;
+            copied += chunk;
+
+            if (pState->writeFn && (pState->windowFill == pState->windowSize)) {
+                result = XYMODEM_FlushWindow(pState, buffer, pState->windowSize);
+                pState->windowFill = 0u;
+            }
+        }
+
+        pState->totalReceivedSize += pPacket->length;
+    }
+
+    return result;
+}
+
 static size_t XYMODEM_Receive(int protocol, struct XYModem_State *pState, char *buffer, size_t bufferSize)
 {
     size_t result;
@@ -364,6 +420,12 @@ static size_t XYMODEM_Receive(int protocol, struct XYModem_State *pState, char *
     pState->expectedSize = 0u;
     pState->maxSize = bufferSize;
     pState->protocol = protocol;
+    pState->windowFill = 0u;
+    pState->flushedSize = 0u;
+    pState->crc32 = 0u;
+    if (!pState->writeFn) {
+        pState->windowSize = bufferSize;
+    }
 
     //
     // Protocol starts with receiver sending a character to indicate to the sender that it is ready...
@@ -383,10 +445,9 @@ static size_t XYMODEM_Receive(int protocol, struct XYModem_State *pState, char *
     retries = 0u;
     while (!pState->status.done && (retries < HSS_XYMODEM_BAD_PACKET_RETRIES)) {
         if (XYMODEM_ReadPacket(&packet, pState)) {
-            putchar_(XYMODEM_ACK);
-
             if (!pState->status.done) {
                 if ((pState->protocol == HSS_XYMODEM_PROTOCOL_YMODEM) && (pState->lastReceivedBlkNum == 0) && (pState->numReceivedPackets == 1u)) {
+                    putchar_(XYMODEM_ACK);
                     memcpy(pState->filename, packet.buffer, HSS_XYMODEM_MAX_FILENAME_LENGTH-1);
                     pState->expectedSize = XYMODEM_GetFileSize(packet.buffer, packet.buffer + ARRAY_SIZE(packet.buffer));
 
@@ -399,12 +460,14 @@ static size_t XYMODEM_Receive(int protocol, struct XYModem_State *pState, char *
                         break;
                     }
                 } else if (pState->eotReceived) { // end of session
+                    putchar_(XYMODEM_ACK);
                     pState->status.s.endOfSession = true;
                     putchar_(XYMODEM_ACK);
-                } else if ((pState->totalReceivedSize + packet.length) < pState->maxSize) {
-                    // dynamically ensure we have enough buffer space to receive, on each received chunk
-                    memcpy(buffer + pState->totalReceivedSize, packet.buffer, packet.length);
-                    pState->totalReceivedSize += packet.length;
+                } else if (XYMODEM_StoreData(pState, buffer, &packet)) {
+                    // only ACK once the packet is stored (and any window it completed is written),
+                    // as the sender starts on the next packet straight away and the UART RX FIFO
+                    // is too shallow to hold it while we program storage
+                    putchar_(XYMODEM_ACK);
                 } else {
                     pState->status.s.abort = true;
                     pState->totalReceivedSize = 0u;
@@ -412,6 +475,8 @@ static size_t XYMODEM_Receive(int protocol, struct XYModem_State *pState, char *
                     break;
                 }
             } else { // transfer is done
+                putchar_(XYMODEM_ACK);
+
                 if (pState->status.s.abort) {
                     pState->totalReceivedSize = 0u;
                     XYMODEM_SendCAN();
@@ -440,6 +505,18 @@ static size_t XYMODEM_Receive(int protocol, struct XYModem_State *pState, char *
 
     XYMODEM_Purge(HSS_XYMODEM_POST_SYNC_TIMEOUT_SEC);
 
+    // write out whatever remains of the final (partial) window
+    if (result != 0u) {
+        if (!XYMODEM_FlushWindow(pState, buffer, pState->windowFill)) {
+            mHSS_DEBUG_PRINTF(LOG_ERROR, "Failed to write received data" CRLF);
+            result = 0u;
+        } else {
+            // report what was written, which excludes the SUB padding of the last block
+            // whenever block 0 advertised the file size
+            result = pState->flushedSize;
+        }
+    }
+
     if (retries >= HSS_XYMODEM_BAD_PACKET_RETRIES) {
         mHSS_DEBUG_PRINTF(LOG_ERROR, "maximum retries exceeded" CRLF);
     }
@@ -458,12 +535,31 @@ size_t ymodem_receive(uint8_t *buffer, size_t bufferSize)
     result = XYMODEM_Receive(HSS_XYMODEM_PROTOCOL_YMODEM, &state, (char *)buffer, bufferSize);
 
     if (result != 0) {
-        uint32_t crc32 = CRC32_calculate((const unsigned char *)buffer, result);
         mHSS_PRINTF(CRLF CRLF "Received %lu bytes from %s (CRC32 is 0x%08X)" CRLF, result,
-            state.filename, crc32);
+            state.filename, state.crc32);
         //mHSS_PRINTF(CRLF CRLF "Expected %lu bytes in %lu packets (%lu NAKs)" CRLF, state.expectedSize,
         //    state.numReceivedPackets, state.numNAKs);
     }
 
     return result;
 }
+
+size_t ymodem_receive_streaming(uint8_t *windowBuffer, size_t windowSize, size_t maxSize,
+    ymodem_write_fn_t writeFn)
+{
+    size_t result = 0u;
+    struct XYModem_State state = { 0 };
+    memset(state.filename, 0, HSS_XYMODEM_MAX_FILENAME_LENGTH);
+
+    state.writeFn = writeFn;
+    state.windowSize = windowSize;
+
+    result = XYMODEM_Receive(HSS_XYMODEM_PROTOCOL_YMODEM, &state, (char *)windowBuffer, maxSize);
+
+    if (result != 0) {
+        mHSS_PRINTF(CRLF CRLF "Received and wrote %lu bytes from %s (CRC32 is 0x%08X)" CRLF, result,
+            state.filename, state.crc32);
+    }
+
+    return result;
+}
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+
+#==============================================================================
+#
+# MPFS HSS Profile Folder
+#
+# Copyright 2022 Microchip Corporation.
+#
+# SPDX-License-Identifier: MIT
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to
+# deal in the Software without restriction, including without limitation the
+# rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+# sell copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+# IN THE SOFTWARE.
+#
+#
+# This script takes a console capture of the PROFILE: lines emitted by
+# dump_profile() (CONFIG_DEBUG_PROFILING_SUPPORT) and outputs folded stacks,
+# suitable for flamegraph.pl, or a caller->callee edge summary
+#
+#==============================================================================
+
+import argparse
+import bisect
+import os
+import re
+import subprocess
+import sys
+
+def get_script_version():
+	return "1.0.0"
+
+class Symbols:
+	def __init__(self, elf, nm):
+		self.addrs = []
+		self.names = []
+		if not elf:
+			return
+
+		output = subprocess.run([nm, "-n", "-C", elf], check=True, capture_output=True,
+			text=True).stdout
+		for line in output.splitlines():
+			fields = line.split(None, 2)
+			if len(fields) == 3 and fields[1] in "tTwW":
+				self.addrs.append(int(fields[0], 16))
+				self.names.append(fields[2])
+
+	def lookup(self, addr):
+		index = bisect.bisect_right(self.addrs, addr) - 1
+		if index >= 0:
+			return self.names[index]
+		return "0x%x" % addr
+
+def parse_profile(lines):
+	#
+	# PROFILE: <hart> <node> <parent> <function> <calls> <inclusive> <exclusive>
+	#
+	# Counts are cumulative, so if the capture holds several dumps, the last
+	# one wins
+	#
+	nodes = {}
+	pattern = re.compile(r"PROFILE: (\d+) (\d+) (-?\d+) (?:0x)?([0-9a-fA-F]+) (\d+) (\d+) (\d+)")
+
+	for line in lines:
+		match = pattern.search(line)
+		if match:
+			hart, node, parent = int(match.group(1)), int(match.group(2)), int(match.group(3))
+			nodes[(hart, node)] = {
+				"parent": parent,
+				"func": int(match.group(4), 16),
+				"calls": int(match.group(5)),
+				"inclusive": int(match.group(6)),
+				"exclusive": int(match.group(7)),
+			}
+	return nodes
+
+def stack_of(nodes, hart, node, symbols):
+	frames = []
+	seen = set()
+	while node >= 0 and (hart, node) in nodes and node not in seen:
+		seen.add(node)
+		frames.append(symbols.lookup(nodes[(hart, node)]["func"]))
+		node = nodes[(hart, node)]["parent"]
+	frames.append("hart%u" % hart)
+	return ";".join(reversed(frames))
+
+def print_folded(nodes, symbols):
+	folded = {}
+	for (hart, node), info in nodes.items():
+		if info["exclusive"]:
+			stack = stack_of(nodes, hart, node, symbols)
+			folded[stack] = folded.get(stack, 0) + info["exclusive"]
+
+	for stack in sorted(folded):
+		print("%s %u" % (stack, folded[stack]))
+
+def print_edges(nodes, symbols):
+	edges = {}
+	for (hart, node), info in nodes.items():
+		parent = info["parent"]
+		caller = symbols.lookup(nodes[(hart, parent)]["func"]) if (hart, parent) in nodes else "<root>"
+		key = (caller, symbols.lookup(info["func"]))
+		totals = edges.setdefault(key, [0, 0, 0])
+		totals[0] += info["calls"]
+		totals[1] += info["inclusive"]
+		totals[2] += info["exclusive"]
+
+	print("%-32s %-32s %10s %16s %16s" % ("caller", "callee", "calls", "inclusive", "exclusive"))
+	for (caller, callee), (calls, inclusive, exclusive) in sorted(edges.items(),
+			key=lambda item: item[1][1], reverse=True):
+		print("%-32s %-32s %10u %16u %16u" % (caller, callee, calls, inclusive, exclusive))
+
+def main():
+	parser = argparse.ArgumentParser(description = "Fold an HSS profile dump into flame graph stacks")
+	parser.add_argument("input", nargs="?", default="-", help="console capture (default: stdin)")
+	parser.add_argument("--elf", help="HSS ELF file, to resolve function addresses to names")
+	parser.add_argument("--nm", default=os.environ.get("NM", "riscv64-unknown-elf-nm"),
+		help="nm to use with --elf")
+	parser.add_argument("--edges", action="store_true",
+		help="print a caller->callee edge summary instead of folded stacks")
+	parser.add_argument("--version", action="version", version=get_script_version())
+	args = parser.parse_args()
+
+	if args.input == "-":
+		lines = sys.stdin.readlines()
+	else:
+		with open(args.input, "r", errors="replace") as f:
+			lines = f.readlines()
+
+	nodes = parse_profile(lines)
+	if not nodes:
+		sys.exit("no PROFILE: lines found in input")
+
+	symbols = Symbols(args.elf, args.nm)
+
+	if args.edges:
+		print_edges(nodes, symbols)
+	else:
+		print_folded(nodes, symbols)
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,80 @@
+#ifndef HSS_HOST_TEST_CONFIG_H
+#define HSS_HOST_TEST_CONFIG_H
+
+//
+// Configuration for building the code signing checks on the host (see Makefile)
+//
+#define CONFIG_SERVICE_BOOT 1
+#define CONFIG_CRYPTO_SIGNING 1
+#define CONFIG_CRYPTO_SIGNING_STREAMING 1
+#define CONFIG_CRYPTO_LIBECC 1
+#define CONFIG_CC_HAS_INTTYPES 1
+
+//
+// The User Crypto backend reads the device configuration from the system registers, which
+// the backend test fakes (see test_crypto_backends.c)
+//
+#ifdef HSS_CAL_STUB_HOST_TEST
+#  include <stdint.h>
+extern uint32_t hostSysregScb[];
+#  define SYSREGSCB_BASE_ADDR ((uintptr_t)hostSysregScb)
+#endif
+
+//
+// The IPI test plays each hart in turn on one host thread, and fakes the CLINT MSIP
+// registers (see test_ipi.c)
+//
+#ifdef HSS_IPI_HOST_TEST
+#  include <stdint.h>
+extern uint32_t hostClint[];
+extern unsigned int hostHartId;
+#  define CLINT_BASE_ADDR ((uintptr_t)hostClint)
+#  define current_hartid() hostHartId
+#  define mb() __sync_synchronize()
+#endif
+
+//
+// The parallel memory test runs against host threads standing in for the U54s (see
+// test_memtest.c), and polls on the host clock, which counts nanoseconds
+//
+#ifdef HSS_MEMTEST_HOST_TEST
+#  define mb() __sync_synchronize()
+#  define ONE_MILLISEC 1000000llu
+#endif
+
+//
+// The zero fill engine runs against host threads standing in for the U54s (see
+// test_zerofill.c), and times out on the host clock, which counts nanoseconds
+//
+#ifdef HSS_ZEROFILL_HOST_TEST
+#  define mb() __sync_synchronize()
+#  define ONE_MILLISEC 1000000llu
+#endif
+
+//
+// The superloop runs on a simulated clock (see test_superloop.c), with the E51 CLINT timer
+// compare, mie and WFI faked, and csr_helper.h skipped
+//
+#ifdef HSS_SUPERLOOP_HOST_TEST
+#  include <stdint.h>
+extern uint64_t hostClint[];
+extern unsigned long hostCsr_mie;
+void hostWfi(void);
+#  define CLINT_BASE_ADDR ((uintptr_t)hostClint)
+#  define current_hartid() 0u
+#  define mHSS_CSR_READ(csr) (hostCsr_##csr)
+#  define mHSS_CSR_WRITE(csr, value) (hostCsr_##csr = (value))
+#  define MIP_MSIP (1u << 3)
+#  define MIP_MTIP (1u << 7)
+#  define mHSS_WFI() hostWfi()
+#endif
+
+//
+// The MMC service runs against a mock of the MSS MMC driver (see test_mmc.c), and times
+// out on the host clock
+//
+#ifdef HSS_MMC_HOST_TEST
+#  define ONE_MILLISEC 1000000llu
+#endif
+
+#endif
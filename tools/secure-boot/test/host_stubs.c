@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - host stand-ins for the HSS debug and timing helpers
+ *
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_debug.h"
+#include "hss_perfctr.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+int sbi_printf(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    int const result = vprintf(fmt, args);
+    va_end(args);
+
+    return result;
+}
+
+void sbi_puts(const char *buf)
+{
+    (void)fputs(buf, stdout);
+}
+
+void sbi_putc(char c)
+{
+    (void)putchar(c);
+}
+
+void HSS_Debug_Highlight(HSS_Debug_LogLevel_t logLevel)
+{
+    (void)logLevel;
+}
+
+void HSS_Debug_Timestamp(void)
+{
+}
+
+HSSTicks_t HSS_GetTime(void)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (HSSTicks_t)now.tv_sec * 1000000000u + (HSSTicks_t)now.tv_nsec;
+}
+
+bool HSS_PerfCtr_Allocate(int *pIdx, char const * name)
+{
+    (void)name;
+    *pIdx = 0;
+    return true;
+}
+
+void HSS_PerfCtr_Start(int index)
+{
+    (void)index;
+}
+
+void HSS_PerfCtr_Lap(int index)
+{
+    (void)index;
+}
@@ -0,0 +1,229 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - code signing host test
+ *
+ * Signs boot images with a key from gen_keys.sh, then checks that hashing them as they
+ * are copied in (HSS_Boot_Secure_StreamBegin()/StreamUpdate()) gives the same verdict
+ * as the one-shot check, for chunk sizes that put chunk boundaries inside the signature
+ * field that is zeroed while hashing. It also checks that a reset stream is not taken to
+ * cover an image that replaced the one it hashed.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_crypto.h"
+#include "hss_boot_secure.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <openssl/ecdsa.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+#define SIG_START offsetof(struct HSS_BootImage, signature)
+#define SIG_END   (SIG_START + sizeof(struct HSS_Signature))
+
+static unsigned int numFailures_ = 0u;
+
+static void sign_image_(EVP_PKEY *pKey, uint8_t *pImage, size_t length)
+{
+    struct HSS_BootImage * const pHeader = (struct HSS_BootImage *)pImage;
+    uint8_t digest[48];
+    unsigned int digestLen = sizeof(digest);
+
+    // images are signed with the signature itself zeroed
+    memset(&pHeader->signature, 0, sizeof(pHeader->signature));
+    if (!EVP_Digest(pImage, length, digest, &digestLen, EVP_sha384(), NULL)) {
+        fprintf(stderr, "EVP_Digest() failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    EVP_PKEY_CTX *pCtx = EVP_PKEY_CTX_new(pKey, NULL);
+    uint8_t derSig[128];
+    size_t derSigLen = sizeof(derSig);
+
+    if (!pCtx || (EVP_PKEY_sign_init(pCtx) <= 0)
+            || (EVP_PKEY_CTX_set_signature_md(pCtx, EVP_sha384()) <= 0)
+            || (EVP_PKEY_sign(pCtx, derSig, &derSigLen, digest, digestLen) <= 0)) {
+        fprintf(stderr, "EVP_PKEY_sign() failed\n");
+        exit(EXIT_FAILURE);
+    }
+    EVP_PKEY_CTX_free(pCtx);
+
+    // the boot image carries r and s as raw big-endian 48 byte values, as generated by
+    // hss-payload-generator
+    uint8_t const *pDerSig = derSig;
+    ECDSA_SIG *pSig = d2i_ECDSA_SIG(NULL, &pDerSig, (long)derSigLen);
+    BIGNUM const *pR, *pS;
+
+    ECDSA_SIG_get0(pSig, &pR, &pS);
+    memcpy(pHeader->signature.digest, digest, sizeof(digest));
+    (void)BN_bn2binpad(pR, &pHeader->signature.ecdsaSig[0], 48);
+    (void)BN_bn2binpad(pS, &pHeader->signature.ecdsaSig[48], 48);
+    ECDSA_SIG_free(pSig);
+}
+
+// as copyBootImageToDDR_(), copying chunkSize bytes at a time and hashing each as it lands
+static bool check_streaming_(uint8_t const *pImage, size_t length, size_t chunkSize, uint8_t *pDest)
+{
+    struct HSS_BootImage header;
+
+    memcpy(&header, pImage, sizeof(header));
+    HSS_Boot_Secure_StreamBegin(&header, (struct HSS_BootImage *)pDest);
+
+    for (size_t offset = 0u; offset < length; offset += chunkSize) {
+        size_t const thisChunk = MIN(length - offset, chunkSize);
+
+        memcpy(pDest + offset, pImage + offset, thisChunk);
+        HSS_Boot_Secure_StreamUpdate(thisChunk);
+    }
+
+    return HSS_Crypto_Verify_ECDSA_P384_Finalize();
+}
+
+// as the non-streaming path of HSS_Boot_Secure_CheckCodeSigning()
+static bool check_one_shot_(uint8_t const *pImage, size_t length, uint8_t *pDest)
+{
+    struct HSS_BootImage * const pHeader = (struct HSS_BootImage *)pDest;
+
+    memcpy(pDest, pImage, length);
+
+    struct HSS_Signature originalSig = pHeader->signature;
+    memset(&pHeader->signature, 0, sizeof(pHeader->signature));
+
+    return HSS_Crypto_Verify_ECDSA_P384(ARRAY_SIZE(originalSig.ecdsaSig), &originalSig.ecdsaSig[0],
+        length, pDest);
+}
+
+//
+// As a streamed copy abandoned for another path (e.g. streaming decompression) into the
+// same destination: HSS_Boot_Secure_CheckCodeSigning() must hash the image it is given,
+// not finish the stale stream. It never returns on failure, hence the alarm in main()
+//
+static void check_stream_reset_(uint8_t const *pImage, size_t length, uint8_t *pDest)
+{
+    struct HSS_BootImage header;
+
+    memcpy(&header, pImage, sizeof(header));
+    HSS_Boot_Secure_StreamBegin(&header, (struct HSS_BootImage *)pDest);
+
+    memcpy(pDest, pImage, length);
+    pDest[length - 1u] ^= 0x01u;
+    HSS_Boot_Secure_StreamUpdate(length);
+
+    HSS_Boot_Secure_StreamReset();
+
+    memcpy(pDest, pImage, length);
+    if (!HSS_Boot_Secure_CheckCodeSigning((struct HSS_BootImage *)pDest)) {
+        printf("FAIL: reset stream (%zu bytes): check returned false\n", length);
+        numFailures_++;
+    }
+}
+
+static void check_image_(char const *pDesc, uint8_t const *pImage, size_t length, bool expected,
+    uint8_t *pDest)
+{
+    // chunk boundaries before, inside (including between digest and ecdsaSig) and after
+    // the signature, and chunks smaller than the signature, so that it spans several
+    size_t const chunkSizes[] = {
+        1u, 13u, 64u, 100u,
+        SIG_START, SIG_START + 1u, SIG_START + 48u, SIG_START + 49u, SIG_END - 1u, SIG_END,
+        512u, 4096u, 64u * 1024u, length,
+    };
+
+    bool const oneShot = check_one_shot_(pImage, length, pDest);
+    if (oneShot != expected) {
+        printf("FAIL: %s (%zu bytes): one-shot check returned %d\n", pDesc, length, oneShot);
+        numFailures_++;
+    }
+
+    for (size_t i = 0u; i < ARRAY_SIZE(chunkSizes); i++) {
+        bool const streaming = check_streaming_(pImage, length, chunkSizes[i], pDest);
+
+        if (streaming != oneShot) {
+            printf("FAIL: %s (%zu bytes): streaming check with %zu byte chunks returned %d,"
+                " one-shot returned %d\n", pDesc, length, chunkSizes[i], streaming, oneShot);
+            numFailures_++;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <x509-ec-secp384r1-private.pem>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *pKeyFile = fopen(argv[1], "r");
+    EVP_PKEY *pKey = pKeyFile ? PEM_read_PrivateKey(pKeyFile, NULL, NULL, NULL) : NULL;
+    if (!pKey) {
+        fprintf(stderr, "unable to read private key from %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    fclose(pKeyFile);
+
+    size_t const lengths[] = {
+        sizeof(struct HSS_BootImage), sizeof(struct HSS_BootImage) + 1u, 4096u + 17u, 200000u,
+    };
+
+    // a failed HSS_Boot_Secure_CheckCodeSigning() spins forever
+    (void)alarm(60u);
+
+    srand(1u);
+    for (size_t i = 0u; i < ARRAY_SIZE(lengths); i++) {
+        size_t const length = lengths[i];
+        uint8_t *pImage = malloc(length);
+        uint8_t *pDest = malloc(length);
+
+        for (size_t j = 0u; j < length; j++) {
+            pImage[j] = (uint8_t)rand();
+        }
+
+        struct HSS_BootImage * const pHeader = (struct HSS_BootImage *)pImage;
+        pHeader->magic = mHSS_BOOT_MAGIC;
+        pHeader->version = mHSS_BOOT_VERSION;
+        pHeader->headerLength = sizeof(struct HSS_BootImage);
+        pHeader->bootImageLength = length;
+
+        sign_image_(pKey, pImage, length);
+        check_image_("signed image", pImage, length, true, pDest);
+        check_stream_reset_(pImage, length, pDest);
+
+        // the stored digest is not covered by the signature, as it is zeroed while hashing
+        pHeader->signature.digest[0] ^= 0xFFu;
+        check_image_("signed image, stale digest", pImage, length, true, pDest);
+        pHeader->signature.digest[0] ^= 0xFFu;
+
+        pHeader->signature.ecdsaSig[95] ^= 0x01u;
+        check_image_("corrupted signature", pImage, length, false, pDest);
+        pHeader->signature.ecdsaSig[95] ^= 0x01u;
+
+        pImage[length - 1u] ^= 0x01u;
+        check_image_("corrupted last byte", pImage, length, false, pDest);
+        pImage[length - 1u] ^= 0x01u;
+
+        pHeader->set_name[0] ^= 0x01u;
+        check_image_("corrupted header", pImage, length, false, pDest);
+        pHeader->set_name[0] ^= 0x01u;
+
+        free(pDest);
+        free(pImage);
+    }
+
+    EVP_PKEY_free(pKey);
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    printf("code signing: streaming and one-shot checks agree\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - CRC32 host test and benchmark
+ *
+ * Checks CRC32_calculate(), CRC32_calculate_ex() and CRC32_combine() against known
+ * answers and a bit-wise reference, across lengths and alignments that exercise the
+ * head, 8 byte body and tail of the slicing-by-8 loop, then times the engine. The
+ * Makefile links this against both the slicing-by-8 and the byte-wise builds.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_clock.h"
+#include "hss_crc32.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned int numFailures_ = 0u;
+
+static uint32_t crc32_reference_(uint8_t const *pInput, size_t numBytes)
+{
+    uint32_t crc32 = 0xFFFFFFFFu;
+
+    for (size_t i = 0u; i < numBytes; i++) {
+        crc32 ^= pInput[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc32 = (crc32 >> 1) ^ ((crc32 & 1u) ? 0xEDB88320u : 0u);
+        }
+    }
+
+    return ~crc32;
+}
+
+static void expect_(char const *pDesc, size_t length, size_t alignment, uint32_t result,
+    uint32_t expected)
+{
+    if (result != expected) {
+        printf("FAIL: %s (%zu bytes at +%zu): %08x, expected %08x\n", pDesc, length, alignment,
+            result, expected);
+        numFailures_++;
+    }
+}
+
+static void run_known_answers_(void)
+{
+    static struct {
+        char const *pMsg;
+        uint32_t crc32;
+    } const knownAnswers[] = {
+        { "", 0x00000000u },
+        { "a", 0xE8B7BE43u },
+        { "123456789", 0xCBF43926u },
+        { "The quick brown fox jumps over the lazy dog", 0x414FA339u },
+    };
+
+    for (size_t i = 0u; i < ARRAY_SIZE(knownAnswers); i++) {
+        size_t const length = strlen(knownAnswers[i].pMsg);
+
+        expect_(knownAnswers[i].pMsg, length, 0u,
+            CRC32_calculate((uint8_t const *)knownAnswers[i].pMsg, length), knownAnswers[i].crc32);
+    }
+
+    // a NULL buffer leaves the seed as it is
+    expect_("NULL buffer", 0u, 0u, CRC32_calculate_ex(0xCBF43926u, NULL, 16u), 0xCBF43926u);
+}
+
+static void run_reference_(uint8_t const *pBuffer)
+{
+    for (size_t alignment = 0u; alignment < 8u; alignment++) {
+        for (size_t length = 0u; length <= 300u; length++) {
+            uint8_t const *pInput = pBuffer + alignment;
+            uint32_t const expected = crc32_reference_(pInput, length);
+
+            expect_("CRC32_calculate()", length, alignment, CRC32_calculate(pInput, length),
+                expected);
+
+            // split anywhere, continuing from the CRC of the first part...
+            for (size_t split = 0u; split <= length; split += 13u) {
+                uint32_t const crc1 = CRC32_calculate(pInput, split);
+                uint32_t const crc2 = CRC32_calculate(pInput + split, length - split);
+
+                expect_("CRC32_calculate_ex()", length, alignment,
+                    CRC32_calculate_ex(crc1, pInput + split, length - split), expected);
+
+                // ...or combining the CRCs of both parts
+                expect_("CRC32_combine()", length, alignment,
+                    CRC32_combine(crc1, crc2, length - split), expected);
+            }
+        }
+    }
+}
+
+static void run_combine_large_(uint8_t const *pBuffer, size_t length)
+{
+    // as for boot chunks, combining the CRCs of sub-chunks that are not powers of two
+    size_t const partSizes[] = { 1u, 4095u, 65536u, 100000u };
+
+    uint32_t const expected = crc32_reference_(pBuffer, length);
+
+    for (size_t i = 0u; i < ARRAY_SIZE(partSizes); i++) {
+        uint32_t crc32 = 0u;
+
+        for (size_t offset = 0u; offset < length; offset += partSizes[i]) {
+            size_t const thisPart = MIN(length - offset, partSizes[i]);
+
+            crc32 = CRC32_combine(crc32, CRC32_calculate(pBuffer + offset, thisPart), thisPart);
+        }
+        expect_("CRC32_combine() of parts", length, partSizes[i], crc32, expected);
+    }
+}
+
+static void run_benchmark_(uint8_t const *pBuffer, size_t length)
+{
+    int const iterations = 16;
+    uint32_t crc32 = 0u;
+
+    HSSTicks_t const startTime = HSS_GetTime();
+    for (int i = 0; i < iterations; i++) {
+        crc32 = CRC32_calculate_ex(crc32, pBuffer, length);
+    }
+    HSSTicks_t const endTime = HSS_GetTime();
+
+    // HSS_GetTime() counts nanoseconds on the host (see host_stubs.c)
+    double const seconds = (double)(endTime - startTime) / 1e9;
+    printf("  %zu MiB in %8.3f ms, %8.1f MB/s (%08x)\n", length / (1024u * 1024u),
+        seconds * 1e3 / iterations, (double)length * iterations / seconds / 1e6, crc32);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t const length = 8u * 1024u * 1024u;
+    uint8_t *pBuffer = malloc(length);
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <name>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    srand(1u);
+    for (size_t i = 0u; i < length; i++) {
+        pBuffer[i] = (uint8_t)rand();
+    }
+
+    run_known_answers_();
+    run_reference_(pBuffer);
+    run_combine_large_(pBuffer, 1000003u);
+
+    printf("crc32 (%s): benchmark\n", argv[1]);
+    run_benchmark_(pBuffer, length);
+
+    free(pBuffer);
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    printf("crc32 (%s): known answers and reference match\n", argv[1]);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,295 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - crypto backend host test and benchmark
+ *
+ * Runs the same known-answer vectors through each code signing backend, using the
+ * struct HSS_Crypto_Backend interface directly rather than the dispatcher (which would
+ * only ever pick one), then times each backend verifying a large image in chunks.
+ *
+ * The User Crypto backend is built here against the stub CAL, which accepts any
+ * signature, so only its pass/fail plumbing is exercised - which is why the stub can
+ * not be linked into the HSS. Its probe is also checked against a faked device
+ * configuration with the core disabled.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_debug.h"
+#include "hss_crypto.h"
+#include "mss_peripherals.h"
+#include "mpfs_reg_map.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/ecdsa.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+#define ECDSA_P384_SIG_LEN 96u
+
+static unsigned int numFailures_ = 0u;
+
+// system registers, as read by the User Crypto backend probe (see config.h)
+uint32_t hostSysregScb[(SYSREGSCB_DEVICE_CONFIG_CR_OFFSET / sizeof(uint32_t)) + 1u];
+
+static unsigned int numCryptoClockEnables_ = 0u;
+
+uint8_t mss_config_clk_rst(mss_peripherals peripheral, uint8_t hart, PERIPH_RESET_STATE req_state)
+{
+    (void)hart;
+
+    if ((peripheral == MSS_PERIPH_ATHENA) && (req_state == PERIPHERAL_ON)) {
+        numCryptoClockEnables_++;
+    }
+    return 0u;
+}
+
+static struct {
+    struct HSS_Crypto_Backend const *pBackend;
+    bool acceptsAnySignature;
+} const backends_[] = {
+    { &HSS_Crypto_Libecc_Backend, false },
+    { &HSS_Crypto_CAL_Backend, true },     // stub CAL
+};
+
+//
+// Known-answer messages. "abc" and the 896 bit message are the FIPS 180-2 SHA-384
+// examples; the others put the data across SHA-384 block (128 byte) boundaries
+//
+static struct {
+    char const *pDesc;
+    char const *pMsg;
+    size_t length;      // 0 => strlen(pMsg)
+} const messages_[] = {
+    { "FIPS 180-2 \"abc\"", "abc", 0u },
+    { "FIPS 180-2 896 bit",
+        "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopq"
+        "klmnopqrlmnopqrsmnopqrstnopqrstu", 0u },
+    { "one byte", "\x5a", 1u },
+    { "111 bytes (one block with padding)",
+        "0123456789012345678901234567890123456789012345678901234567890123456789"
+        "01234567890123456789012345678901234567890", 0u },
+    { "112 bytes (padding spills a block)",
+        "0123456789012345678901234567890123456789012345678901234567890123456789"
+        "012345678901234567890123456789012345678901", 0u },
+};
+
+static void sign_(EVP_PKEY *pKey, uint8_t const *pMsg, size_t length, uint8_t sig[ECDSA_P384_SIG_LEN])
+{
+    uint8_t digest[48];
+    unsigned int digestLen = sizeof(digest);
+    uint8_t derSig[128];
+    size_t derSigLen = sizeof(derSig);
+    EVP_PKEY_CTX *pCtx = EVP_PKEY_CTX_new(pKey, NULL);
+
+    if (!EVP_Digest(pMsg, length, digest, &digestLen, EVP_sha384(), NULL)
+            || !pCtx || (EVP_PKEY_sign_init(pCtx) <= 0)
+            || (EVP_PKEY_CTX_set_signature_md(pCtx, EVP_sha384()) <= 0)
+            || (EVP_PKEY_sign(pCtx, derSig, &derSigLen, digest, digestLen) <= 0)) {
+        fprintf(stderr, "signing failed\n");
+        exit(EXIT_FAILURE);
+    }
+    EVP_PKEY_CTX_free(pCtx);
+
+    // raw big-endian r || s, as carried in boot images
+    uint8_t const *pDerSig = derSig;
+    ECDSA_SIG *pSig = d2i_ECDSA_SIG(NULL, &pDerSig, (long)derSigLen);
+    BIGNUM const *pR, *pS;
+
+    ECDSA_SIG_get0(pSig, &pR, &pS);
+    (void)BN_bn2binpad(pR, &sig[0], 48);
+    (void)BN_bn2binpad(pS, &sig[48], 48);
+    ECDSA_SIG_free(pSig);
+}
+
+static bool verify_(struct HSS_Crypto_Backend const *pBackend, uint8_t const sig[ECDSA_P384_SIG_LEN],
+    uint8_t *pMsg, size_t length, size_t chunkSize)
+{
+    uint8_t sigCopy[ECDSA_P384_SIG_LEN];
+    bool result;
+
+    memcpy(sigCopy, sig, sizeof(sigCopy));
+    result = pBackend->verifyInit(sizeof(sigCopy), sigCopy, length);
+
+    for (size_t offset = 0u; result && (offset < length); offset += chunkSize) {
+        result = pBackend->verifyUpdate(MIN(length - offset, chunkSize), pMsg + offset);
+    }
+
+    // finalize regardless, as the boot path does, so that no verification is left open
+    bool const finalized = pBackend->verifyFinalize();
+
+    return result && finalized;
+}
+
+static void check_(struct HSS_Crypto_Backend const *pBackend, bool acceptsAnySignature,
+    char const *pDesc, char const *pCase, uint8_t const sig[ECDSA_P384_SIG_LEN],
+    uint8_t *pMsg, size_t length, bool valid)
+{
+    size_t const chunkSizes[] = { 1u, 7u, 128u, 129u, length ? length : 1u };
+    bool const expected = valid || acceptsAnySignature;
+
+    for (size_t i = 0u; i < ARRAY_SIZE(chunkSizes); i++) {
+        bool const result = verify_(pBackend, sig, pMsg, length, chunkSizes[i]);
+
+        if (result != expected) {
+            printf("FAIL: %s: %s, %s, %zu byte chunks: returned %d, expected %d\n",
+                pBackend->name, pDesc, pCase, chunkSizes[i], result, expected);
+            numFailures_++;
+        }
+    }
+}
+
+static void run_known_answers_(EVP_PKEY *pKey, struct HSS_Crypto_Backend const *pBackend,
+    bool acceptsAnySignature)
+{
+    if (!pBackend->probe()) {
+        printf("FAIL: %s: probe failed\n", pBackend->name);
+        numFailures_++;
+        return;
+    }
+
+    for (size_t i = 0u; i < ARRAY_SIZE(messages_); i++) {
+        size_t const length = messages_[i].length ? messages_[i].length : strlen(messages_[i].pMsg);
+        uint8_t *pMsg = malloc(length);
+        uint8_t sig[ECDSA_P384_SIG_LEN];
+        uint8_t badSig[ECDSA_P384_SIG_LEN];
+
+        memcpy(pMsg, messages_[i].pMsg, length);
+        sign_(pKey, pMsg, length, sig);
+
+        check_(pBackend, acceptsAnySignature, messages_[i].pDesc, "valid signature", sig, pMsg,
+            length, true);
+
+        pMsg[length - 1u] ^= 0x01u;
+        check_(pBackend, acceptsAnySignature, messages_[i].pDesc, "corrupted message", sig, pMsg,
+            length, false);
+        pMsg[length - 1u] ^= 0x01u;
+
+        memcpy(badSig, sig, sizeof(badSig));
+        badSig[0] ^= 0x80u;
+        check_(pBackend, acceptsAnySignature, messages_[i].pDesc, "corrupted r", badSig, pMsg,
+            length, false);
+
+        memcpy(badSig, sig, sizeof(badSig));
+        badSig[ECDSA_P384_SIG_LEN - 1u] ^= 0x01u;
+        check_(pBackend, acceptsAnySignature, messages_[i].pDesc, "corrupted s", badSig, pMsg,
+            length, false);
+
+        memset(badSig, 0, sizeof(badSig));
+        check_(pBackend, acceptsAnySignature, messages_[i].pDesc, "r = s = 0", badSig, pMsg,
+            length, false);
+
+        free(pMsg);
+    }
+}
+
+//
+// On a device without the User Crypto core the probe has to fail without touching it
+//
+static void run_probe_crypto_disabled_(void)
+{
+    unsigned int const numClockEnables = numCryptoClockEnables_;
+
+    mHSS_WriteRegU32(SYSREGSCB, DEVICE_CONFIG_CR, SYSREGSCB_DEVICE_CONFIG_CR_CRYPTO_DISABLE_MASK);
+
+    if (HSS_Crypto_CAL_Backend.probe()) {
+        printf("FAIL: %s: probe succeeded with the core disabled\n", HSS_Crypto_CAL_Backend.name);
+        numFailures_++;
+    }
+    if (numCryptoClockEnables_ != numClockEnables) {
+        printf("FAIL: %s: probe enabled the core with it disabled\n", HSS_Crypto_CAL_Backend.name);
+        numFailures_++;
+    }
+
+    mHSS_WriteRegU32(SYSREGSCB, DEVICE_CONFIG_CR, 0u);
+}
+
+static void run_benchmark_(EVP_PKEY *pKey, struct HSS_Crypto_Backend const *pBackend,
+    bool acceptsAnySignature)
+{
+    size_t const length = 8u * 1024u * 1024u;
+    size_t const chunkSize = 64u * 1024u;
+    int const iterations = 4;
+    uint8_t *pMsg = malloc(length);
+    uint8_t sig[ECDSA_P384_SIG_LEN];
+
+    for (size_t i = 0u; i < length; i++) {
+        pMsg[i] = (uint8_t)(i * 31u);
+    }
+    sign_(pKey, pMsg, length, sig);
+
+    HSSTicks_t hashTime = 0u, finalizeTime = 0u;
+
+    for (int i = 0; i < iterations; i++) {
+        uint8_t sigCopy[ECDSA_P384_SIG_LEN];
+        memcpy(sigCopy, sig, sizeof(sigCopy));
+
+        HSSTicks_t const startTime = HSS_GetTime();
+        bool result = pBackend->verifyInit(sizeof(sigCopy), sigCopy, length);
+        for (size_t offset = 0u; result && (offset < length); offset += chunkSize) {
+            result = pBackend->verifyUpdate(MIN(length - offset, chunkSize), pMsg + offset);
+        }
+
+        HSSTicks_t const finalizeStartTime = HSS_GetTime();
+        result = pBackend->verifyFinalize() && result;
+        HSSTicks_t const endTime = HSS_GetTime();
+
+        if (!result) {
+            printf("FAIL: %s: benchmark image did not verify\n", pBackend->name);
+            numFailures_++;
+        }
+
+        hashTime += finalizeStartTime - startTime;
+        finalizeTime += endTime - finalizeStartTime;
+    }
+
+    // HSS_GetTime() counts nanoseconds on the host (see host_stubs.c)
+    printf("  %-12s  hash %zu MiB in %zu KiB chunks %9.3f ms  signature check %8.3f ms%s\n",
+        pBackend->name, length / (1024u * 1024u), chunkSize / 1024u,
+        (double)hashTime / 1e6 / iterations, (double)finalizeTime / 1e6 / iterations,
+        acceptsAnySignature ? "  (stub CAL, not representative)" : "");
+
+    free(pMsg);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <x509-ec-secp384r1-private.pem>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *pKeyFile = fopen(argv[1], "r");
+    EVP_PKEY *pKey = pKeyFile ? PEM_read_PrivateKey(pKeyFile, NULL, NULL, NULL) : NULL;
+    if (!pKey) {
+        fprintf(stderr, "unable to read private key from %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    fclose(pKeyFile);
+
+    run_probe_crypto_disabled_();
+
+    for (size_t i = 0u; i < ARRAY_SIZE(backends_); i++) {
+        run_known_answers_(pKey, backends_[i].pBackend, backends_[i].acceptsAnySignature);
+    }
+
+    printf("crypto backends: benchmark\n");
+    for (size_t i = 0u; i < ARRAY_SIZE(backends_); i++) {
+        run_benchmark_(pKey, backends_[i].pBackend, backends_[i].acceptsAnySignature);
+    }
+
+    EVP_PKEY_free(pKey);
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    printf("crypto backends: known answers match for all backends\n");
+    return EXIT_SUCCESS;
+}
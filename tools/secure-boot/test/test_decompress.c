@@ -0,0 +1,193 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - streaming decompression host test
+ *
+ * Compresses images of sizes around the read window size, places each at the very end
+ * of a simulated storage device, and checks that HSS_DecompressFromStorage() inflates
+ * it exactly while never reading past the image, and reading each window from a
+ * window-aligned offset from the start of the image. Damaged images must fail.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_crc32.h"
+#include "hss_decompress.h"
+#include "hss_progress.h"
+#include "miniz.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WINDOW_SIZE ((size_t)CONFIG_COMPRESSION_STREAM_WINDOW_SIZE)
+#define IMAGE_OFFSET (64u * 1024u)
+
+static unsigned int numFailures_ = 0u;
+
+static struct {
+    uint8_t *pData;
+    size_t size;
+    size_t imageOffset;
+    size_t numReads;
+    bool badRead;
+} storage_;
+
+void HSS_ShowProgress(size_t totalNumTasks, size_t numTasksRemaining)
+{
+    (void)totalNumTasks;
+    (void)numTasksRemaining;
+}
+
+static bool storage_read_(void *pDest, size_t srcOffset, size_t byteCount)
+{
+    bool result = false;
+    size_t const offsetInImage = srcOffset - storage_.imageOffset;
+
+    storage_.numReads++;
+
+    if ((srcOffset < storage_.imageOffset) || (srcOffset + byteCount > storage_.size)) {
+        printf("  read of %zu bytes at 0x%zx is outside the image\n", byteCount, srcOffset);
+        storage_.badRead = true;
+    } else if ((byteCount > WINDOW_SIZE) || (offsetInImage % WINDOW_SIZE)) {
+        printf("  read of %zu bytes at image offset 0x%zx is not a window\n", byteCount,
+            offsetInImage);
+        storage_.badRead = true;
+    } else {
+        memcpy(pDest, storage_.pData + srcOffset, byteCount);
+        result = true;
+    }
+
+    return result;
+}
+
+//
+// builds the compressed image at the end of storage, returning the compressed image
+// header so that the caller can damage it
+//
+static struct HSS_CompressedImage *build_image_(uint8_t const *pOriginal, size_t originalLen)
+{
+    mz_ulong compressedLen = mz_compressBound((mz_ulong)originalLen);
+    uint8_t *pCompressed = malloc(compressedLen);
+
+    if (mz_compress2(pCompressed, &compressedLen, pOriginal, (mz_ulong)originalLen,
+            MZ_BEST_COMPRESSION) != MZ_OK) {
+        fprintf(stderr, "mz_compress2() failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    struct HSS_CompressedImage header;
+    memset(&header, 0, sizeof(header));
+    header.magic = mHSS_COMPRESSED_MAGIC;
+    header.version = mHSS_COMPRESSED_VERSION_DEFLATE;
+    header.headerLength = sizeof(header);
+    header.compressedCrc = CRC32_calculate(pCompressed, compressedLen);
+    header.originalCrc = CRC32_calculate(pOriginal, originalLen);
+    header.compressedImageLen = compressedLen;
+    header.originalImageLen = originalLen;
+    header.headerCrc = CRC32_calculate((uint8_t const *)&header, sizeof(header));
+
+    free(storage_.pData);
+    storage_.imageOffset = IMAGE_OFFSET;
+    storage_.size = IMAGE_OFFSET + sizeof(header) + compressedLen;
+    storage_.pData = malloc(storage_.size);
+    storage_.numReads = 0u;
+    storage_.badRead = false;
+
+    memset(storage_.pData, 0xA5, IMAGE_OFFSET);
+    memcpy(storage_.pData + IMAGE_OFFSET, &header, sizeof(header));
+    memcpy(storage_.pData + IMAGE_OFFSET + sizeof(header), pCompressed, compressedLen);
+    free(pCompressed);
+
+    return (struct HSS_CompressedImage *)(storage_.pData + IMAGE_OFFSET);
+}
+
+static void check_inflate_(char const *pDesc, uint8_t const *pOriginal, size_t originalLen,
+    bool expectSuccess)
+{
+    // one spare byte to catch an overrun
+    uint8_t *pOutput = malloc(originalLen + 1u);
+    pOutput[originalLen] = 0x5Au;
+
+    size_t const outputLen = HSS_DecompressFromStorage(storage_read_, storage_.imageOffset, pOutput);
+
+    if (expectSuccess) {
+        if (storage_.badRead || (outputLen != originalLen) || memcmp(pOutput, pOriginal, originalLen)) {
+            printf("FAIL: %s (%zu bytes): returned %zu, %s\n", pDesc, originalLen, outputLen,
+                storage_.badRead ? "bad read" : "output differs");
+            numFailures_++;
+        }
+    } else if (storage_.badRead || outputLen) {
+        printf("FAIL: %s (%zu bytes): returned %zu%s, expected failure\n", pDesc, originalLen,
+            outputLen, storage_.badRead ? " after a bad read" : "");
+        numFailures_++;
+    }
+
+    if (pOutput[originalLen] != 0x5Au) {
+        printf("FAIL: %s (%zu bytes): output overrun\n", pDesc, originalLen);
+        numFailures_++;
+    }
+
+    free(pOutput);
+}
+
+int main(void)
+{
+    // image sizes either side of the window, so the compressed sizes straddle it too
+    size_t const lengths[] = {
+        1u, 100u, WINDOW_SIZE - 1u, WINDOW_SIZE, WINDOW_SIZE + 1u, 4u * WINDOW_SIZE,
+        64u * 1024u + 3u, 1024u * 1024u,
+    };
+
+    srand(1u);
+    for (size_t i = 0u; i < ARRAY_SIZE(lengths); i++) {
+        size_t const length = lengths[i];
+        uint8_t *pOriginal = malloc(length);
+
+        // half random, half runs, so that the data neither compresses away nor grows much
+        for (size_t j = 0u; j < length; j++) {
+            pOriginal[j] = (j & 256u) ? (uint8_t)rand() : (uint8_t)(j >> 9);
+        }
+
+        struct HSS_CompressedImage *pHeader = build_image_(pOriginal, length);
+        check_inflate_("image", pOriginal, length, true);
+
+        pHeader->headerCrc ^= 1u;
+        check_inflate_("header CRC damaged", pOriginal, length, false);
+
+        pHeader = build_image_(pOriginal, length);
+        pHeader->magic = 0u;
+        check_inflate_("magic damaged", pOriginal, length, false);
+
+        // an image that inflates to more than the header says must not overrun
+        if (length > 1u) {
+            pHeader = build_image_(pOriginal, length);
+            pHeader->originalImageLen = length - 1u;
+            pHeader->headerCrc = 0u;
+            pHeader->headerCrc = CRC32_calculate((uint8_t const *)pHeader, sizeof(*pHeader));
+            check_inflate_("original length short", pOriginal, length - 1u, false);
+        }
+
+        // the deflate stream cut short, with storage ending where the header says
+        pHeader = build_image_(pOriginal, length);
+        pHeader->compressedImageLen -= 1u;
+        pHeader->headerCrc = 0u;
+        pHeader->headerCrc = CRC32_calculate((uint8_t const *)pHeader, sizeof(*pHeader));
+        storage_.size -= 1u;
+        check_inflate_("compressed stream truncated", pOriginal, length, false);
+
+        free(pOriginal);
+    }
+
+    free(storage_.pData);
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    printf("decompress: %zu byte windows, images inflate within bounds\n", WINDOW_SIZE);
+    return EXIT_SUCCESS;
+}
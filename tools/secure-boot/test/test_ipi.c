@@ -0,0 +1,330 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - IPI queue host test
+ *
+ * Plays the source and target harts in turn against the SSMB IPI queues, checking the
+ * outbox ring (full, wrap of the free-running counters, out-of-order consumption and
+ * retirement of consumed slots in send order), the completion slot transaction IDs
+ * (slot and generation encoding, stale IDs rejected, generation 0 never handed out) and
+ * a full deliver/handle/acknowledge round trip.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "ssmb_ipi.h"
+#include "hss_state_machine.h"
+#include "hss_registry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint32_t hostClint[MAX_NUM_HARTS];
+unsigned int hostHartId = HSS_HART_E51;
+
+static unsigned int numFailures_ = 0u;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            printf("FAIL: " __VA_ARGS__); \
+            printf(" (%s, line %d)\n", #cond, __LINE__); \
+            numFailures_++; \
+        } \
+    } while (0)
+
+//
+// messages handled by the test are logged, in the order they are handled
+//
+#define MAX_LOGGED (4u * IPI_MAX_NUM_QUEUE_MESSAGES)
+
+static struct {
+    enum HSSHartId source;
+    TxId_t transaction_id;
+    uint32_t immediate_arg;
+} handled_[MAX_LOGGED];
+static size_t numHandled_ = 0u;
+static enum IPIStatusCode handlerResult_ = IPI_IDLE;
+
+static enum IPIStatusCode test_handler_(TxId_t transaction_id, enum HSSHartId source,
+    uint32_t immediate_arg, void *p_extended_buffer_in_ddr, void *p_ancilliary_buffer_in_ddr)
+{
+    (void)p_extended_buffer_in_ddr;
+    (void)p_ancilliary_buffer_in_ddr;
+
+    if (numHandled_ < MAX_LOGGED) {
+        handled_[numHandled_].source = source;
+        handled_[numHandled_].transaction_id = transaction_id;
+        handled_[numHandled_].immediate_arg = immediate_arg;
+    }
+    numHandled_++;
+
+    return handlerResult_;
+}
+
+const struct IPI_Handler ipiRegistry[] = {
+    { IPI_MSG_NO_MESSAGE,   NULL },
+    { IPI_MSG_BOOT_REQUEST, test_handler_ },
+    { IPI_MSG_PMP_SETUP,    test_handler_ },
+    { IPI_MSG_SPI_XFER,     test_handler_ },
+    { IPI_MSG_NET_RXPOLL,   test_handler_ },
+    { IPI_MSG_NET_TX,       test_handler_ },
+    { IPI_MSG_SCATTERGATHER_DMA, test_handler_ },
+    { IPI_MSG_WDOG_INIT,    test_handler_ },
+    { IPI_MSG_GPIO_SET,     test_handler_ },
+    { IPI_MSG_UART_TX,      test_handler_ },
+    { IPI_MSG_UART_POLL_RX, test_handler_ },
+    { IPI_MSG_POWERMODE,    test_handler_ },
+    { IPI_MSG_ACK_PENDING,  IPI_ACK_IPIHandler },
+    { IPI_MSG_ACK_COMPLETE, IPI_ACK_IPIHandler },
+    { IPI_MSG_HALT,         test_handler_ },
+    { IPI_MSG_CONTINUE,     test_handler_ },
+    { IPI_MSG_GOTO,         test_handler_ },
+    { IPI_MSG_OPENSBI_INIT, test_handler_ },
+    { IPI_MSG_MEMTEST,      test_handler_ },
+    { IPI_MSG_ZEROFILL,     test_handler_ },
+};
+const size_t spanOfIpiRegistry = ARRAY_SIZE(ipiRegistry);
+
+static struct IPI_Outbox_Queue *queue_(enum HSSHartId source, enum HSSHartId target)
+{
+    // the message array is the first member of the queue
+    return (struct IPI_Outbox_Queue *)IPI_DirectionToFirstMsgInQueue(source, target);
+}
+
+static void reset_(void)
+{
+    (void)IPI_QueuesInit();
+    memset(hostClint, 0, sizeof(hostClint));
+    numHandled_ = 0u;
+    handlerResult_ = IPI_IDLE;
+    hostHartId = HSS_HART_E51;
+}
+
+static void run_queue_index_(void)
+{
+    bool seen[IPI_OUTBOX_NUM_QUEUES] = { false };
+
+    for (enum HSSHartId source = HSS_HART_E51; source < HSS_HART_NUM_PEERS; source++) {
+        for (enum HSSHartId target = HSS_HART_E51; target < HSS_HART_NUM_PEERS; target++) {
+            if (source == target) { continue; }
+
+            uint32_t const index = IPI_CalculateQueueIndex(source, target);
+            CHECK(index < IPI_OUTBOX_NUM_QUEUES, "queue index %u for %d->%d", index, source,
+                target);
+            if (index < IPI_OUTBOX_NUM_QUEUES) {
+                CHECK(!seen[index], "queue index %u used twice", index);
+                seen[index] = true;
+            }
+        }
+    }
+
+    CHECK(IPI_CalculateQueueIndex(HSS_HART_E51, HSS_HART_U54_1) == IPI_OUTBOX_E51_TO_U54_1,
+        "E51->U54_1");
+    CHECK(IPI_CalculateQueueIndex(HSS_HART_U54_2, HSS_HART_U54_1) == IPI_OUTBOX_U54_2_TO_U54_1,
+        "U54_2->U54_1");
+    CHECK(IPI_CalculateQueueIndex(HSS_HART_U54_4, HSS_HART_U54_3) == IPI_OUTBOX_U54_4_TO_U54_3,
+        "U54_4->U54_3");
+}
+
+//
+// sends from the E51 to U54_1 until the outbox is full, returning the number sent
+//
+static uint32_t fill_(enum IPIMessagesEnum msgA, enum IPIMessagesEnum msgB, uint32_t *pArg)
+{
+    uint32_t numSent = 0u;
+
+    hostHartId = HSS_HART_E51;
+    while (IPI_Send(HSS_HART_U54_1, (*pArg & 1u) ? msgB : msgA, 0u, *pArg, NULL, NULL)) {
+        (*pArg)++;
+        numSent++;
+    }
+
+    return numSent;
+}
+
+static void run_ring_(uint32_t startCount)
+{
+    reset_();
+
+    // start the free-running counters anywhere, including just short of wrapping
+    struct IPI_Outbox_Queue * const pQueue = queue_(HSS_HART_E51, HSS_HART_U54_1);
+    pQueue->head = pQueue->tail = startCount;
+
+    uint32_t const queueIndex = IPI_CalculateQueueIndex(HSS_HART_E51, HSS_HART_U54_1);
+    union HSSHartBitmask const fromE51 = { .uint = (1u << HSS_HART_E51) };
+    uint32_t nextArg = 0u;
+
+    // all messages of one type: the outbox takes exactly its capacity
+    uint32_t numSent = fill_(IPI_MSG_GOTO, IPI_MSG_GOTO, &nextArg);
+    CHECK(numSent == IPI_MAX_NUM_QUEUE_MESSAGES, "sent %u of %lu into an empty outbox", numSent,
+        IPI_MAX_NUM_QUEUE_MESSAGES);
+    CHECK(hostClint[HSS_HART_U54_1] == 1u, "MSIP not raised for U54_1");
+    CHECK(IPI_GetQueuePendingCount(queueIndex) == IPI_MAX_NUM_QUEUE_MESSAGES,
+        "pending count %u when full", IPI_GetQueuePendingCount(queueIndex));
+
+    hostHartId = HSS_HART_U54_1;
+    CHECK(IPI_PollReceive(fromE51), "U54_1 did not see new messages");
+    CHECK(!IPI_PollReceive(fromE51), "U54_1 saw the same messages twice");
+
+    while (IPI_ConsumeIntent(HSS_HART_E51, IPI_MSG_GOTO)) { ; }
+    CHECK(numHandled_ == numSent, "handled %zu of %u", numHandled_, numSent);
+    for (size_t i = 0u; (i < numHandled_) && (i < MAX_LOGGED); i++) {
+        CHECK(handled_[i].immediate_arg == i, "message %zu handled out of order (%u)", i,
+            handled_[i].immediate_arg);
+    }
+    CHECK(IPI_GetQueuePendingCount(queueIndex) == 0u, "pending count %u when drained",
+        IPI_GetQueuePendingCount(queueIndex));
+
+    // alternating types, consuming all of one type first: the slots freed behind the
+    // messages still pending must be retired, and the rest keep their order
+    numHandled_ = 0u;
+    nextArg = 0u;
+    numSent = fill_(IPI_MSG_GOTO, IPI_MSG_HALT, &nextArg);
+    CHECK(numSent == IPI_MAX_NUM_QUEUE_MESSAGES, "sent %u of %lu alternating", numSent,
+        IPI_MAX_NUM_QUEUE_MESSAGES);
+
+    hostHartId = HSS_HART_U54_1;
+    while (IPI_ConsumeIntent(HSS_HART_E51, IPI_MSG_HALT)) { ; }
+    CHECK(numHandled_ == numSent / 2u, "handled %zu HALTs of %u", numHandled_, numSent / 2u);
+    CHECK(IPI_GetQueuePendingCount(queueIndex) == numSent / 2u,
+        "pending count %u with only GOTOs left", IPI_GetQueuePendingCount(queueIndex));
+
+    // the retired slots are available to the sender again
+    uint32_t const numRefilled = fill_(IPI_MSG_GOTO, IPI_MSG_GOTO, &nextArg);
+    CHECK(numRefilled == numSent / 2u, "refilled %u of %u retired slots", numRefilled,
+        numSent / 2u);
+
+    numHandled_ = 0u;
+    hostHartId = HSS_HART_U54_1;
+    while (IPI_ConsumeIntent(HSS_HART_E51, IPI_MSG_GOTO)) { ; }
+    CHECK(numHandled_ == numSent / 2u + numRefilled, "handled %zu GOTOs", numHandled_);
+
+    // the original GOTOs (even arguments) first, then the refill, in the order sent
+    for (size_t i = 0u; (i < numHandled_) && (i < MAX_LOGGED); i++) {
+        uint32_t const expected = (i < numSent / 2u) ? 2u * i : numSent + (i - numSent / 2u);
+        CHECK(handled_[i].immediate_arg == expected, "GOTO %zu has argument %u, expected %u",
+            i, handled_[i].immediate_arg, expected);
+    }
+    CHECK(IPI_GetQueuePendingCount(queueIndex) == 0u, "pending count %u at the end",
+        IPI_GetQueuePendingCount(queueIndex));
+}
+
+static void run_txid_(void)
+{
+    static uint32_t indexes[IPI_MAX_NUM_OUTSTANDING_COMPLETES];
+    static TxId_t txIds[IPI_MAX_NUM_OUTSTANDING_COMPLETES];
+    uint32_t index;
+
+    reset_();
+
+    // every slot can be allocated once, each with its own slot encoded in the ID
+    for (uint32_t i = 0u; i < IPI_MAX_NUM_OUTSTANDING_COMPLETES; i++) {
+        CHECK(IPI_MessageAlloc(&indexes[i]), "allocation %u failed", i);
+        txIds[i] = IPI_DebugGetTxId();
+
+        CHECK(IPI_TXID_TO_SLOT(txIds[i]) == indexes[i], "TxId %08x is not for slot %u",
+            txIds[i], indexes[i]);
+        CHECK(IPI_TXID_TO_GEN(txIds[i]) == 1u, "TxId %08x is not the first generation",
+            txIds[i]);
+        CHECK(!IPI_MessageCheckIfComplete(indexes[i]), "slot %u complete when allocated",
+            indexes[i]);
+    }
+    CHECK(!IPI_MessageAlloc(&index), "allocated more than %lu slots",
+        IPI_MAX_NUM_OUTSTANDING_COMPLETES);
+
+    // reallocating a slot moves it to the next generation, and the old ID goes stale
+    uint32_t const slot = indexes[3];
+    IPI_MessageFree(slot);
+    CHECK(IPI_MessageAlloc(&index) && (index == slot), "slot %u not reallocated", slot);
+
+    TxId_t const newTxId = IPI_DebugGetTxId();
+    CHECK(IPI_TXID_TO_GEN(newTxId) == 2u, "TxId %08x is not the second generation", newTxId);
+    CHECK(!IPI_MessageUpdateStatus(txIds[3], IPI_SUCCESS), "stale TxId %08x accepted",
+        txIds[3]);
+    CHECK(!IPI_MessageCheckIfComplete(slot), "slot %u completed by a stale TxId", slot);
+    CHECK(IPI_MessageUpdateStatus(newTxId, IPI_SUCCESS), "TxId %08x rejected", newTxId);
+    CHECK(IPI_MessageCheckIfComplete(slot), "slot %u not completed", slot);
+
+    // a freed slot does not accept its last ID either
+    IPI_MessageFree(slot);
+    CHECK(!IPI_MessageUpdateStatus(newTxId, IPI_SUCCESS), "TxId %08x of a free slot accepted",
+        newTxId);
+
+    // the generation wraps without ever being 0
+    uint32_t lastGeneration = 2u;
+    for (uint32_t i = 0u; i <= IPI_TXID_SLOT_MASK + 1u; i++) {
+        CHECK(IPI_MessageAlloc(&index) && (index == slot), "slot %u not reallocated", slot);
+
+        uint32_t const generation = IPI_TXID_TO_GEN(IPI_DebugGetTxId());
+        uint32_t const expected = (lastGeneration == IPI_TXID_SLOT_MASK) ? 1u : lastGeneration + 1u;
+        if (generation != expected) {
+            CHECK(generation == expected, "generation %u after %u", generation, lastGeneration);
+            break;
+        }
+        lastGeneration = generation;
+        IPI_MessageFree(slot);
+    }
+}
+
+static void run_round_trip_(void)
+{
+    uint32_t index;
+    union HSSHartBitmask const fromE51 = { .uint = (1u << HSS_HART_E51) };
+    union HSSHartBitmask const fromU54_2 = { .uint = (1u << HSS_HART_U54_2) };
+
+    reset_();
+
+    // the E51 asks U54_2 to do something...
+    CHECK(IPI_MessageAlloc(&index), "allocation failed");
+    TxId_t const txId = IPI_DebugGetTxId();
+    CHECK(IPI_MessageDeliver(index, HSS_HART_U54_2, IPI_MSG_GOTO, 0x1234u, NULL, NULL),
+        "delivery failed");
+    CHECK(hostClint[HSS_HART_U54_2] == 1u, "MSIP not raised for U54_2");
+
+    // ...which U54_2 handles, and acknowledges...
+    hostHartId = HSS_HART_U54_2;
+    handlerResult_ = IPI_SUCCESS;
+    CHECK(IPI_PollReceive(fromE51), "U54_2 did not see the message");
+    CHECK(IPI_ConsumeIntent(HSS_HART_E51, IPI_MSG_GOTO), "U54_2 did not consume the message");
+    CHECK((numHandled_ == 1u) && (handled_[0].source == HSS_HART_E51)
+        && (handled_[0].transaction_id == txId) && (handled_[0].immediate_arg == 0x1234u),
+        "message not handled as sent");
+    CHECK(hostClint[HSS_HART_E51] == 1u, "MSIP not raised for the E51");
+
+    // ...and the E51 sees the acknowledgement complete the transaction
+    hostHartId = HSS_HART_E51;
+    CHECK(!IPI_MessageCheckIfComplete(index), "complete before the acknowledgement");
+    CHECK(IPI_PollReceive(fromU54_2), "E51 did not see the acknowledgement");
+    CHECK(IPI_ConsumeIntent(HSS_HART_U54_2, IPI_MSG_ACK_COMPLETE),
+        "E51 did not consume the acknowledgement");
+    CHECK(IPI_MessageCheckIfComplete(index), "not complete after the acknowledgement");
+    IPI_MessageFree(index);
+}
+
+int main(void)
+{
+    uint32_t const startCounts[] = {
+        0u, 1u, IPI_MAX_NUM_QUEUE_MESSAGES / 2u + 3u,
+        UINT32_MAX - (uint32_t)(IPI_MAX_NUM_QUEUE_MESSAGES / 2u),
+    };
+
+    run_queue_index_();
+    for (size_t i = 0u; i < ARRAY_SIZE(startCounts); i++) {
+        run_ring_(startCounts[i]);
+    }
+    run_txid_();
+    run_round_trip_();
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    printf("ipi: %lu message outboxes, %lu completion slots: queues and transaction IDs ok\n",
+        IPI_MAX_NUM_QUEUE_MESSAGES, IPI_MAX_NUM_OUTSTANDING_COMPLETES);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,456 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - parallel memory test host test
+ *
+ * Runs the parallel March C- memory test over a host buffer, with one host thread standing
+ * in for each U54, some of them busy so that the E51 must claim their slices. A clean
+ * buffer must pass with every word tested, and stale requests must be ignored. Faults are
+ * injected to check that they are found: an address decoder fault (two pages mapping the
+ * same memory, away from the power-of-two offsets the address bus test checks), within
+ * the E51's slice and within a U54's, and a bit flipped between two March elements.
+ */
+
+#define _GNU_SOURCE
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_clock.h"
+#include "hss_progress.h"
+#include "hss_memtest.h"
+#include "ssmb_ipi.h"
+#include "uart_helper.h"
+#include "ddr_service.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define NUM_PAGES 64u
+#define NUM_MSGS  16u
+
+static unsigned int numFailures_ = 0u;
+
+static size_t pageSize_;
+static int memFd_;
+static uint64_t *pBuffer_;
+
+//
+// host stand-ins for the U54s and the IPI messages sent to them
+//
+static struct {
+    bool allocated;
+    uint32_t generation;
+    volatile bool complete;
+} msgs_[NUM_MSGS];
+
+static struct {
+    pthread_t thread;
+    volatile bool busy;
+    volatile bool pending;
+    uint32_t msgIndex;
+    uint32_t msgGeneration;
+    uint32_t immediate;
+    void *pJob;
+    volatile unsigned int numRun;
+    volatile unsigned int numIgnored;
+} u54s_[HSS_HART_NUM_PEERS];
+
+static pthread_mutex_t lock_ = PTHREAD_MUTEX_INITIALIZER;
+static volatile bool quit_ = false;
+
+// the last MEMTEST request delivered, to replay later
+static uint32_t lastImmediate_;
+static void *pLastJob_;
+
+// the E51 waits at its first poll until the idle U54s have run their slices, so that
+// they are not all claimed by the E51 first
+static bool holdE51_;
+static unsigned int numHandledAtStart_[HSS_HART_NUM_PEERS];
+
+// a request from the previous run, replayed while the E51 is held
+static bool replayStale_;
+static uint32_t staleImmediate_;
+static void *pStaleJob_;
+
+// fault injection
+static unsigned int numProgressCalls_;
+static unsigned int flipAtProgressCall_;
+static size_t flipWord_;
+static bool abortAtProgressCall_;
+
+bool IPI_QueuesInitialized(void)
+{
+    return true;
+}
+
+bool IPI_ConsumeIntent(enum HSSHartId source, enum IPIMessagesEnum msg_type)
+{
+    (void)source;
+    (void)msg_type;
+    return false;
+}
+
+bool IPI_MessageAlloc(uint32_t *indexOut)
+{
+    bool result = false;
+
+    pthread_mutex_lock(&lock_);
+    for (uint32_t i = 0u; i < NUM_MSGS; i++) {
+        if (!msgs_[i].allocated) {
+            msgs_[i].allocated = true;
+            msgs_[i].generation++;
+            msgs_[i].complete = false;
+            *indexOut = i;
+            result = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&lock_);
+
+    return result;
+}
+
+bool IPI_MessageDeliver(uint32_t index, enum HSSHartId target, enum IPIMessagesEnum message,
+    uint32_t immediate_arg, void const *p_extended_buffer_in_ddr,
+    void const *p_ancilliary_buffer_in_ddr)
+{
+    (void)p_ancilliary_buffer_in_ddr;
+
+    if ((message != IPI_MSG_MEMTEST) || (target < HSS_HART_U54_1) || (target >= HSS_HART_NUM_PEERS)) {
+        printf("FAIL: unexpected message %d to hart %d\n", message, target);
+        numFailures_++;
+        return false;
+    }
+
+    pthread_mutex_lock(&lock_);
+    u54s_[target].msgIndex = index;
+    u54s_[target].msgGeneration = msgs_[index].generation;
+    u54s_[target].immediate = immediate_arg;
+    u54s_[target].pJob = (void *)p_extended_buffer_in_ddr;
+    u54s_[target].pending = true;
+    lastImmediate_ = immediate_arg;
+    pLastJob_ = (void *)p_extended_buffer_in_ddr;
+    pthread_mutex_unlock(&lock_);
+
+    return true;
+}
+
+bool IPI_MessageCheckIfComplete(uint32_t index)
+{
+    return __atomic_load_n(&msgs_[index].complete, __ATOMIC_ACQUIRE);
+}
+
+void IPI_MessageFree(uint32_t index)
+{
+    pthread_mutex_lock(&lock_);
+    msgs_[index].allocated = false;
+    pthread_mutex_unlock(&lock_);
+}
+
+static void *u54_(void *pArg)
+{
+    enum HSSHartId const hartId = (enum HSSHartId)(uintptr_t)pArg;
+
+    while (!quit_) {
+        if (!u54s_[hartId].busy && u54s_[hartId].pending) {
+            pthread_mutex_lock(&lock_);
+            uint32_t const msgIndex = u54s_[hartId].msgIndex;
+            uint32_t const msgGeneration = u54s_[hartId].msgGeneration;
+            uint32_t const immediate = u54s_[hartId].immediate;
+            void * const pJob = u54s_[hartId].pJob;
+            u54s_[hartId].pending = false;
+            pthread_mutex_unlock(&lock_);
+
+            if (HSS_MemTest_IPIHandler(0u, HSS_HART_E51, immediate, pJob, NULL) == IPI_SUCCESS) {
+                u54s_[hartId].numRun++;
+            } else {
+                u54s_[hartId].numIgnored++;
+            }
+
+            // as the real ACK, this only completes the message if it has not been freed
+            pthread_mutex_lock(&lock_);
+            if (msgs_[msgIndex].allocated && (msgs_[msgIndex].generation == msgGeneration)) {
+                __atomic_store_n(&msgs_[msgIndex].complete, true, __ATOMIC_RELEASE);
+            }
+            pthread_mutex_unlock(&lock_);
+        } else {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+//
+// host stand-ins for the progress, keypress, timer and DDR helpers
+//
+void HSS_ShowProgress(size_t totalNumTasks, size_t numTasksRemaining)
+{
+    (void)totalNumTasks;
+    (void)numTasksRemaining;
+
+    numProgressCalls_++;
+    if (holdE51_ && (numProgressCalls_ == 1u)) {
+        for (int peer = HSS_HART_U54_1; peer < HSS_HART_NUM_PEERS; peer++) {
+            while (!u54s_[peer].busy
+                    && (u54s_[peer].numRun + u54s_[peer].numIgnored == numHandledAtStart_[peer])) {
+                sched_yield();
+            }
+        }
+
+        if (replayStale_ && (HSS_MemTest_IPIHandler(0u, HSS_HART_E51, staleImmediate_, pStaleJob_,
+                NULL) != IPI_FAIL)) {
+            printf("FAIL: request from the previous run run\n");
+            numFailures_++;
+            u54s_[HSS_HART_NUM_PEERS - 1].busy = false; // so that its message completes
+        }
+    }
+
+    if (numProgressCalls_ == flipAtProgressCall_) {
+        pBuffer_[flipWord_] ^= 1llu << 17;
+    }
+}
+
+bool uart_getchar(uint8_t *pbuf, int32_t timeout_sec, bool do_sec_tick)
+{
+    (void)timeout_sec;
+    (void)do_sec_tick;
+
+    if (abortAtProgressCall_ && numProgressCalls_) {
+        *pbuf = '\003';
+        return true;
+    }
+
+    return false;
+}
+
+bool HSS_Timer_IsElapsed(HSSTicks_t startTick, HSSTicks_t durationInTicks)
+{
+    (void)startTick;
+    (void)durationInTicks;
+    return true; // poll after every batch
+}
+
+size_t HSS_DDR_GetSize(void) { return NUM_PAGES * pageSize_; }
+uintptr_t HSS_DDR_GetStart(void) { return (uintptr_t)pBuffer_; }
+size_t HSS_DDRHi_GetSize(void) { return NUM_PAGES * pageSize_; }
+uintptr_t HSS_DDRHi_GetStart(void) { return (uintptr_t)pBuffer_; }
+
+//
+// maps page onto the memory behind filePage, or back onto its own
+//
+static void map_page_(size_t page, size_t filePage)
+{
+    void *p = mmap((uint8_t *)pBuffer_ + page * pageSize_, pageSize_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_FIXED, memFd_, (off_t)(filePage * pageSize_));
+
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static size_t slice_words_(void)
+{
+    size_t const numWords = NUM_PAGES * pageSize_ / sizeof(uint64_t);
+    return ((numWords / HSS_HART_NUM_PEERS) / 8u) * 8u;
+}
+
+static void set_busy_(unsigned int busyMask)
+{
+    for (int peer = HSS_HART_U54_1; peer < HSS_HART_NUM_PEERS; peer++) {
+        u54s_[peer].busy = (busyMask & (1u << peer)) != 0u;
+    }
+}
+
+static void wait_idle_(void)
+{
+    for (int peer = HSS_HART_U54_1; peer < HSS_HART_NUM_PEERS; peer++) {
+        while (u54s_[peer].pending) {
+            sched_yield();
+        }
+    }
+}
+
+static void run_(char const *pDesc, bool expectPass)
+{
+    numProgressCalls_ = 0u;
+    holdE51_ = true;
+    for (int peer = HSS_HART_U54_1; peer < HSS_HART_NUM_PEERS; peer++) {
+        numHandledAtStart_[peer] = u54s_[peer].numRun + u54s_[peer].numIgnored;
+    }
+
+    bool const result = HSS_MemTestDDR_Ex(pBuffer_, NUM_PAGES * pageSize_);
+
+    if (result != expectPass) {
+        printf("FAIL: %s: memory test %s\n", pDesc, result ? "passed" : "failed");
+        numFailures_++;
+    }
+}
+
+static unsigned int num_run_(void)
+{
+    unsigned int result = 0u;
+
+    for (int peer = HSS_HART_U54_1; peer < HSS_HART_NUM_PEERS; peer++) {
+        result += u54s_[peer].numRun;
+    }
+
+    return result;
+}
+
+static unsigned int num_ignored_(void)
+{
+    unsigned int result = 0u;
+
+    for (int peer = HSS_HART_U54_1; peer < HSS_HART_NUM_PEERS; peer++) {
+        result += u54s_[peer].numIgnored;
+    }
+
+    return result;
+}
+
+static void run_clean_(unsigned int busyMask)
+{
+    unsigned int const numRun = num_run_();
+    unsigned int const numIgnored = num_ignored_();
+
+    set_busy_(busyMask);
+    for (size_t i = 0u; i < NUM_PAGES * pageSize_ / sizeof(uint64_t); i++) {
+        pBuffer_[i] = (uint64_t)i * 0x9E3779B97F4A7C15llu;
+    }
+    run_("clean", true);
+
+    // March C- ends on the background everywhere, so every word was tested to the end
+    for (size_t i = 0u; i < NUM_PAGES * pageSize_ / sizeof(uint64_t); i++) {
+        if (pBuffer_[i] != 0x5555555555555555llu) {
+            printf("FAIL: busy 0x%x: word %zu not tested\n", busyMask, i);
+            numFailures_++;
+            break;
+        }
+    }
+
+    // busy U54s then see their requests, already run by the E51, and must ignore them
+    set_busy_(0u);
+    wait_idle_();
+
+    unsigned int const numBusy = (unsigned int)__builtin_popcount(busyMask);
+    if ((num_run_() - numRun != (HSS_HART_NUM_PEERS - 1u) - numBusy)
+            || (num_ignored_() - numIgnored != numBusy)) {
+        printf("FAIL: busy 0x%x: %u slices run on U54s, %u requests ignored\n", busyMask,
+            num_run_() - numRun, num_ignored_() - numIgnored);
+        numFailures_++;
+    }
+}
+
+static void run_stale_(void)
+{
+    // a request replayed after its run is ignored...
+    if (!pLastJob_ || (HSS_MemTest_IPIHandler(0u, HSS_HART_E51, lastImmediate_, pLastJob_, NULL)
+            != IPI_FAIL)) {
+        printf("FAIL: replayed request run\n");
+        numFailures_++;
+    }
+
+    // ... as is one from the previous run, even while the same slice is queued again
+    staleImmediate_ = lastImmediate_;
+    pStaleJob_ = pLastJob_;
+    replayStale_ = true;
+    set_busy_(1u << (HSS_HART_NUM_PEERS - 1));
+    run_("stale request", true);
+    replayStale_ = false;
+    set_busy_(0u);
+    wait_idle_();
+}
+
+static void run_alias_(char const *pDesc, size_t page, size_t filePage)
+{
+    set_busy_(0u);
+    map_page_(page, filePage);
+    run_(pDesc, false);
+    map_page_(page, page);
+    wait_idle_();
+}
+
+static void run_flip_(void)
+{
+    // after the third element, (r1,w0) up, the slice is all background, and the next
+    // reads each word before writing it
+    set_busy_(0u);
+    flipAtProgressCall_ = 3u;
+    flipWord_ = slice_words_() / 2u;
+    run_("bit flip between elements", false);
+    flipAtProgressCall_ = 0u;
+    wait_idle_();
+}
+
+static void run_abort_(void)
+{
+    set_busy_(0u);
+    numProgressCalls_ = 0u;
+    holdE51_ = false;
+    abortAtProgressCall_ = true;
+    (void)HSS_MemTestDDR_Ex(pBuffer_, NUM_PAGES * pageSize_);
+    abortAtProgressCall_ = false;
+    wait_idle_();
+}
+
+int main(void)
+{
+    pageSize_ = (size_t)sysconf(_SC_PAGESIZE);
+    memFd_ = memfd_create("memtest", 0);
+    if ((memFd_ < 0) || ftruncate(memFd_, (off_t)(NUM_PAGES * pageSize_))) {
+        perror("memfd");
+        return EXIT_FAILURE;
+    }
+
+    pBuffer_ = mmap(NULL, NUM_PAGES * pageSize_, PROT_READ | PROT_WRITE, MAP_SHARED, memFd_, 0);
+    if (pBuffer_ == MAP_FAILED) {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+
+    for (int peer = HSS_HART_U54_1; peer < HSS_HART_NUM_PEERS; peer++) {
+        (void)pthread_create(&u54s_[peer].thread, NULL, u54_, (void *)(uintptr_t)peer);
+    }
+
+    for (unsigned int busyMask = 0u; busyMask < (1u << HSS_HART_NUM_PEERS); busyMask += 2u) {
+        run_clean_(busyMask);
+    }
+    run_stale_();
+
+    // pages 3 and 5 are in the E51's slice, and 28 and 30 in the second U54's; none of
+    // them hold a power-of-two word offset
+    size_t const wordsPerPage = pageSize_ / sizeof(uint64_t);
+    if ((5u * wordsPerPage >= slice_words_()) || (28u * wordsPerPage < 2u * slice_words_())
+            || (31u * wordsPerPage > 3u * slice_words_())) {
+        printf("FAIL: unexpected slices of %zu words\n", slice_words_());
+        numFailures_++;
+    }
+    run_alias_("alias in E51 slice", 5u, 3u);
+    run_alias_("alias in U54 slice", 30u, 28u);
+    run_flip_();
+
+    run_abort_();
+    run_clean_(0u);
+
+    quit_ = true;
+    for (int peer = HSS_HART_U54_1; peer < HSS_HART_NUM_PEERS; peer++) {
+        (void)pthread_join(u54s_[peer].thread, NULL);
+    }
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    printf("memtest: March C- finds injected faults, %u slices run on U54s, %u stale requests ignored\n",
+        num_run_(), num_ignored_());
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,346 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - MMC service host test
+ *
+ * Runs the MMC read and write paths against a mock of the MSS MMC driver, which checks
+ * each SDMA transfer as the driver does (whole sectors, not empty, just under 32MiB at
+ * most, one at a time) and only moves the data when the transfer completes, a random
+ * number of interrupts after it was started. A random trace of staged (USB MSC) writes,
+ * direct writes and reads, some of them partial sectors, must read back what was written,
+ * and the device must hold it all after a flush. With write coalescing, sequential
+ * sector writes must go out as whole write queues. Transfers beyond the driver limit
+ * must be split. The Makefile builds this with and without write coalescing.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_clock.h"
+#include "hss_memcpy_via_pdma.h"
+#include "mmc_service.h"
+#include "mss_mmc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SECTOR_SIZE      512u
+#define MAX_SDMA_BYTES   ((32u * 1024u * 1024u) - SECTOR_SIZE)
+#define DEVICE_SIZE      (MAX_SDMA_BYTES + 64u * SECTOR_SIZE)
+#define TRACE_SECTORS    256u // the random trace keeps to the start, so that writes meet
+
+static unsigned int numFailures_ = 0u;
+
+static uint8_t *pDevice_;    // the mock device
+static uint8_t *pReference_; // what it should hold once all writes are out
+static uint8_t *pSource_;
+static uint8_t *pReadBack_;
+
+//
+// mock of the MSS MMC driver
+//
+static struct {
+    mss_mmc_status_t state;
+    bool isWrite;
+    uint8_t *pBuffer;
+    uint32_t sector;
+    uint32_t size;
+    unsigned int interruptsLeft;
+    size_t numWrites;
+    size_t numWriteSectors;
+    size_t numReads;
+} mmc_ = { MSS_MMC_NO_ERROR };
+
+static mss_mmc_status_t start_(bool isWrite, uint8_t *pBuffer, uint32_t sector, uint32_t size)
+{
+    if (mmc_.state == MSS_MMC_TRANSFER_IN_PROGRESS) {
+        printf("FAIL: %s started with a transfer in progress\n", isWrite ? "write" : "read");
+        numFailures_++;
+        return MSS_MMC_TRANSFER_IN_PROGRESS;
+    }
+
+    if ((size % SECTOR_SIZE) || (size > MAX_SDMA_BYTES) || !size || !pBuffer
+            || ((uint64_t)sector * SECTOR_SIZE + size > DEVICE_SIZE)) {
+        printf("FAIL: %s of %u bytes at sector %u\n", isWrite ? "write" : "read", size, sector);
+        numFailures_++;
+        mmc_.state = MSS_MMC_INVALID_PARAMETER;
+        return MSS_MMC_INVALID_PARAMETER;
+    }
+
+    mmc_.isWrite = isWrite;
+    mmc_.pBuffer = pBuffer;
+    mmc_.sector = sector;
+    mmc_.size = size;
+    mmc_.interruptsLeft = (unsigned int)rand() % 3u;
+    mmc_.state = MSS_MMC_TRANSFER_IN_PROGRESS;
+
+    if (isWrite) {
+        mmc_.numWrites++;
+        mmc_.numWriteSectors += size / SECTOR_SIZE;
+    } else {
+        mmc_.numReads++;
+    }
+
+    return MSS_MMC_TRANSFER_IN_PROGRESS;
+}
+
+mss_mmc_status_t MSS_MMC_sdma_write(const uint8_t *src, uint32_t dest, uint32_t size)
+{
+    return start_(true, (uint8_t *)src, dest, size);
+}
+
+mss_mmc_status_t MSS_MMC_sdma_read(uint32_t src, uint8_t *dest, uint32_t size)
+{
+    return start_(false, dest, src, size);
+}
+
+uint8_t mmc_main_plic_IRQHandler(void); // the driver has no prototype for this
+uint8_t mmc_main_plic_IRQHandler(void)
+{
+    if (mmc_.state == MSS_MMC_TRANSFER_IN_PROGRESS) {
+        if (mmc_.interruptsLeft) {
+            mmc_.interruptsLeft--;
+        } else {
+            uint8_t *pDevice = &pDevice_[(size_t)mmc_.sector * SECTOR_SIZE];
+
+            if (mmc_.isWrite) {
+                memcpy(pDevice, mmc_.pBuffer, mmc_.size);
+            } else {
+                memcpy(mmc_.pBuffer, pDevice, mmc_.size);
+            }
+            mmc_.state = MSS_MMC_TRANSFER_SUCCESS;
+        }
+    }
+
+    return (uint8_t)mmc_.state;
+}
+
+mss_mmc_status_t MSS_MMC_get_transfer_status(void)
+{
+    return mmc_.state;
+}
+
+mss_mmc_status_t MSS_MMC_init(const mss_mmc_cfg_t *cfg)
+{
+    (void)cfg;
+    return MSS_MMC_INIT_SUCCESS;
+}
+
+void MSS_MMC_get_info(uint16_t *sector_size, uint32_t *sector_count)
+{
+    *sector_size = SECTOR_SIZE;
+    *sector_count = DEVICE_SIZE / SECTOR_SIZE;
+}
+
+bool HSS_Timer_IsElapsed(HSSTicks_t startTick, HSSTicks_t durationInTicks)
+{
+    (void)startTick;
+    (void)durationInTicks;
+    return true;
+}
+
+void *memcpy_via_pdma(void *dest, void const *src, size_t num_bytes)
+{
+    return memcpy(dest, src, num_bytes);
+}
+
+//
+// the tests
+//
+static size_t round_up_(size_t byteCount)
+{
+    return (byteCount + SECTOR_SIZE - 1u) & ~(size_t)(SECTOR_SIZE - 1u);
+}
+
+static void fill_source_(size_t byteCount)
+{
+    for (size_t i = 0u; i < round_up_(byteCount); i++) {
+        pSource_[i] = (uint8_t)rand();
+    }
+}
+
+static void staged_write_(size_t sector, size_t byteCount)
+{
+    fill_source_(byteCount);
+
+    if (!HSS_MMC_WriteBlockSDMA(sector * SECTOR_SIZE, pSource_, byteCount)) {
+        printf("FAIL: staged write of %zu bytes at sector %zu\n", byteCount, sector);
+        numFailures_++;
+    }
+
+    // a partial last sector is padded with zeros when staged, and with whatever follows
+    // the source when written directly
+    memcpy(&pReference_[sector * SECTOR_SIZE], pSource_, round_up_(byteCount));
+#if IS_ENABLED(CONFIG_SERVICE_MMC_WRITE_COALESCE)
+    memset(&pReference_[sector * SECTOR_SIZE + byteCount], 0, round_up_(byteCount) - byteCount);
+#endif
+}
+
+static void direct_write_(size_t sector, size_t byteCount)
+{
+    fill_source_(byteCount);
+
+    if (!HSS_MMC_WriteBlock(sector * SECTOR_SIZE, pSource_, byteCount)) {
+        printf("FAIL: direct write of %zu bytes at sector %zu\n", byteCount, sector);
+        numFailures_++;
+    }
+
+    memcpy(&pReference_[sector * SECTOR_SIZE], pSource_, round_up_(byteCount));
+}
+
+static void read_(size_t sector, size_t byteCount)
+{
+    // the guard after the read must be left alone
+    memset(pReadBack_, 0xA5, byteCount + 8u);
+
+    if (!HSS_MMC_ReadBlock(pReadBack_, sector * SECTOR_SIZE, byteCount)) {
+        printf("FAIL: read of %zu bytes at sector %zu\n", byteCount, sector);
+        numFailures_++;
+    } else if (memcmp(pReadBack_, &pReference_[sector * SECTOR_SIZE], byteCount)) {
+        printf("FAIL: read of %zu bytes at sector %zu does not return what was written\n",
+            byteCount, sector);
+        numFailures_++;
+    } else if (pReadBack_[byteCount] != 0xA5u) {
+        printf("FAIL: read of %zu bytes at sector %zu overran\n", byteCount, sector);
+        numFailures_++;
+    }
+}
+
+static void check_device_(char const *pDesc)
+{
+    HSS_MMC_FlushWriteBuffer();
+
+    if (mmc_.state == MSS_MMC_TRANSFER_IN_PROGRESS) {
+        printf("FAIL: %s: transfer still in progress after flush\n", pDesc);
+        numFailures_++;
+    }
+
+    if (memcmp(pDevice_, pReference_, DEVICE_SIZE)) {
+        printf("FAIL: %s: device does not hold what was written after flush\n", pDesc);
+        numFailures_++;
+    }
+}
+
+static void run_sequential_(void)
+{
+    size_t const numWrites = mmc_.numWrites;
+    size_t const numSectors = 64u;
+
+    for (size_t sector = 0u; sector < numSectors; sector++) {
+        staged_write_(sector, SECTOR_SIZE);
+    }
+    check_device_("sequential");
+
+#if IS_ENABLED(CONFIG_SERVICE_MMC_WRITE_COALESCE)
+    size_t const expected = numSectors / CONFIG_SERVICE_MMC_WRITE_COALESCE_SECTORS;
+#else
+    size_t const expected = numSectors;
+#endif
+    if (mmc_.numWrites - numWrites != expected) {
+        printf("FAIL: %zu sequential sectors took %zu writes, expected %zu\n", numSectors,
+            mmc_.numWrites - numWrites, expected);
+        numFailures_++;
+    }
+}
+
+static void run_random_trace_(size_t numOps)
+{
+    size_t sector = 0u;
+
+    for (size_t i = 0u; i < numOps; i++) {
+        // mostly carry on from the last access, as USB MSC does
+        if ((rand() % 4) == 0) {
+            sector = (size_t)rand() % TRACE_SECTORS;
+        }
+
+        size_t const byteCount = 1u + ((size_t)rand() % (20u * SECTOR_SIZE));
+
+        switch (rand() % 8) {
+        case 0:
+            direct_write_(sector, byteCount);
+            break;
+
+        case 1:
+        case 2:
+            read_(sector, byteCount);
+            break;
+
+        case 3:
+            HSS_MMC_FlushWriteBuffer();
+            break;
+
+        default:
+            staged_write_(sector, (rand() % 2) ? byteCount : SECTOR_SIZE);
+            break;
+        }
+
+        sector += round_up_(byteCount) / SECTOR_SIZE;
+        if (sector >= TRACE_SECTORS) {
+            sector = 0u;
+        }
+    }
+
+    check_device_("random trace");
+}
+
+static void run_large_(void)
+{
+    // a transfer beyond the driver limit must be split, both ways
+    size_t const byteCount = MAX_SDMA_BYTES + 3u * SECTOR_SIZE + 100u;
+    size_t const numWrites = mmc_.numWrites;
+    size_t const numReads = mmc_.numReads;
+
+    direct_write_(1u, byteCount);
+    read_(1u, byteCount);
+    staged_write_(2u, byteCount);
+    read_(2u, byteCount);
+    check_device_("large");
+
+#if IS_ENABLED(CONFIG_SERVICE_MMC_WRITE_COALESCE)
+    size_t const expectedWrites = 5u; // the staged one leaves its partial sector queued
+#else
+    size_t const expectedWrites = 4u;
+#endif
+    if ((mmc_.numWrites - numWrites != expectedWrites) || (mmc_.numReads - numReads != 6u)) {
+        printf("FAIL: two large writes and reads took %zu writes and %zu reads\n",
+            mmc_.numWrites - numWrites, mmc_.numReads - numReads);
+        numFailures_++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <name>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    pDevice_ = malloc(DEVICE_SIZE);
+    pReference_ = malloc(DEVICE_SIZE);
+    pSource_ = malloc(DEVICE_SIZE);
+    pReadBack_ = malloc(DEVICE_SIZE);
+    if (!pDevice_ || !pReference_ || !pSource_ || !pReadBack_) {
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+
+    srand(1u);
+    for (size_t i = 0u; i < DEVICE_SIZE; i++) {
+        pDevice_[i] = pReference_[i] = (uint8_t)rand();
+    }
+
+    run_sequential_();
+    run_random_trace_(20000u);
+    run_large_();
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    printf("mmc (%s): %zu writes of %zu sectors, %zu reads\n", argv[1], mmc_.numWrites,
+        mmc_.numWriteSectors, mmc_.numReads);
+    return EXIT_SUCCESS;
+}
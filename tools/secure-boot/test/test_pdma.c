@@ -0,0 +1,429 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - asynchronous PDMA copy host test
+ *
+ * Runs the asynchronous PDMA copy engine against a model of the MSS PDMA, whose channels
+ * only copy when they complete, a random number of polls after being started. Random
+ * copies, with random alignments and overlapping submissions, must land intact and
+ * complete only once every channel carrying them has. Copies must be spread across the
+ * free channels (but not split into slivers), never touch the channels reserved for
+ * SGDMA and RAM scrubbing, and give the PDMA only aligned destinations. Transfer errors
+ * and refused setups are injected, and must fall back to the CPU.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_memcpy_via_pdma.h"
+#include "drivers/mss/mss_pdma/mss_pdma.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BUFFER_SIZE (256u * 1024u)
+#define GUARD       64u
+
+static unsigned int numFailures_ = 0u;
+
+static uint8_t src_[BUFFER_SIZE] __attribute__((aligned(64)));
+static uint8_t dest_[BUFFER_SIZE + 2u * GUARD] __attribute__((aligned(64)));
+
+//
+// model of the MSS PDMA
+//
+static struct {
+    bool configured;
+    bool active;
+    mss_pdma_channel_config_t config;
+    unsigned int pollsLeft;
+    bool failTransfer;
+    uint8_t completeStatus;
+    uint8_t errorStatus;
+} channels_[MSS_PDMA_lAST_CHANNEL];
+
+static HSS_PDMA_Txn_t allowedChannels_;  // channels the engine may use for this call
+static HSS_PDMA_Txn_t refuseSetup_;      // channels whose next setup is refused
+static HSS_PDMA_Txn_t failTransfer_;     // channels whose next transfer fails
+static unsigned int numStarted_;
+
+mss_pdma_error_id_t MSS_PDMA_setup_transfer(mss_pdma_channel_id_t channel_id,
+    mss_pdma_channel_config_t *channel_config)
+{
+    if (channel_id >= MSS_PDMA_lAST_CHANNEL) {
+        return MSS_PDMA_ERROR_INVALID_CHANNEL_ID;
+    }
+
+    if (!(allowedChannels_ & (1u << channel_id))) {
+        printf("FAIL: channel %d used, only 0x%x allowed\n", channel_id, allowedChannels_);
+        numFailures_++;
+    }
+
+    if (channels_[channel_id].active) {
+        printf("FAIL: channel %d set up while busy\n", channel_id);
+        numFailures_++;
+        return MSS_PDMA_ERROR_TRANSACTION_IN_PROGRESS;
+    }
+
+    if ((channel_config->dest_addr % 16u) || (channel_config->num_bytes % 16u)
+            || !channel_config->num_bytes) {
+        printf("FAIL: channel %d given %llu bytes to 0x%llx\n", channel_id,
+            (unsigned long long)channel_config->num_bytes,
+            (unsigned long long)channel_config->dest_addr);
+        numFailures_++;
+    }
+
+    if (refuseSetup_ & (1u << channel_id)) {
+        refuseSetup_ &= (HSS_PDMA_Txn_t)~(1u << channel_id);
+        return MSS_PDMA_ERROR_INVALID_SRC_ADDR;
+    }
+
+    channels_[channel_id].config = *channel_config;
+    channels_[channel_id].configured = true;
+
+    return MSS_PDMA_OK;
+}
+
+mss_pdma_error_id_t MSS_PDMA_start_transfer(mss_pdma_channel_id_t channel_id)
+{
+    if (!channels_[channel_id].configured) {
+        printf("FAIL: channel %d started without setup\n", channel_id);
+        numFailures_++;
+    }
+
+    channels_[channel_id].configured = false;
+    channels_[channel_id].active = true;
+    channels_[channel_id].pollsLeft = (unsigned int)rand() % 4u;
+    channels_[channel_id].failTransfer = (failTransfer_ & (1u << channel_id)) != 0u;
+    failTransfer_ &= (HSS_PDMA_Txn_t)~(1u << channel_id);
+    numStarted_++;
+
+    return MSS_PDMA_OK;
+}
+
+// the engine checks for errors first, so each poll of a channel advances it here
+uint8_t MSS_PDMA_get_transfer_error_status(mss_pdma_channel_id_t channel_id)
+{
+    if (channels_[channel_id].active) {
+        if (channels_[channel_id].pollsLeft) {
+            channels_[channel_id].pollsLeft--;
+        } else {
+            uint8_t *pDest = (uint8_t *)(uintptr_t)channels_[channel_id].config.dest_addr;
+            uint8_t const *pSrc = (uint8_t const *)(uintptr_t)channels_[channel_id].config.src_addr;
+            size_t const numBytes = (size_t)channels_[channel_id].config.num_bytes;
+
+            if (channels_[channel_id].failTransfer) {
+                memcpy(pDest, pSrc, numBytes / 2u);
+                memset(pDest + numBytes / 2u, 0xEE, numBytes - numBytes / 2u);
+                channels_[channel_id].errorStatus = 1u;
+            } else {
+                memcpy(pDest, pSrc, numBytes);
+                channels_[channel_id].completeStatus = 1u;
+            }
+            channels_[channel_id].active = false;
+        }
+    }
+
+    return channels_[channel_id].errorStatus;
+}
+
+uint8_t MSS_PDMA_get_transfer_complete_status(mss_pdma_channel_id_t channel_id)
+{
+    return channels_[channel_id].completeStatus;
+}
+
+uint8_t MSS_PDMA_clear_transfer_complete_status(mss_pdma_channel_id_t channel_id)
+{
+    channels_[channel_id].completeStatus = 0u;
+    return 0u;
+}
+
+uint8_t MSS_PDMA_clear_transfer_error_status(mss_pdma_channel_id_t channel_id)
+{
+    channels_[channel_id].errorStatus = 0u;
+    return 0u;
+}
+
+static HSS_PDMA_Txn_t busy_channels_(void)
+{
+    HSS_PDMA_Txn_t result = 0u;
+
+    for (unsigned int channel = 0u; channel < MSS_PDMA_lAST_CHANNEL; channel++) {
+        if (channels_[channel].active || channels_[channel].completeStatus
+                || channels_[channel].errorStatus) {
+            result |= (HSS_PDMA_Txn_t)(1u << channel);
+        }
+    }
+
+    return result;
+}
+
+//
+// a copy in flight, and the checks on it
+//
+struct Copy {
+    size_t srcOffset;
+    size_t destOffset;
+    size_t numBytes;
+    HSS_PDMA_Txn_t txn;
+};
+
+static uint8_t *dest_at_(size_t offset)
+{
+    return &dest_[GUARD + offset];
+}
+
+static void random_copy_(struct Copy *pCopy, size_t maxBytes)
+{
+    pCopy->numBytes = (size_t)rand() % (maxBytes + 1u);
+    pCopy->srcOffset = (size_t)rand() % (BUFFER_SIZE - pCopy->numBytes + 1u);
+    pCopy->destOffset = (size_t)rand() % (BUFFER_SIZE - pCopy->numBytes + 1u);
+}
+
+static void check_copy_(char const *pDesc, struct Copy const *pCopy)
+{
+    if (memcmp(dest_at_(pCopy->destOffset), &src_[pCopy->srcOffset], pCopy->numBytes)) {
+        printf("FAIL: %s: %zu bytes from +%zu to +%zu not copied\n", pDesc, pCopy->numBytes,
+            pCopy->srcOffset, pCopy->destOffset);
+        numFailures_++;
+    }
+}
+
+static void clear_dest_(void)
+{
+    memset(dest_, 0xA5, sizeof(dest_));
+}
+
+// nothing outside the copies may be written
+static void check_untouched_(char const *pDesc, struct Copy const *pCopies, size_t numCopies)
+{
+    for (size_t i = 0u; i < sizeof(dest_); i++) {
+        bool inCopy = false;
+
+        for (size_t copy = 0u; copy < numCopies; copy++) {
+            size_t const start = GUARD + pCopies[copy].destOffset;
+            inCopy = inCopy || ((i >= start) && (i < start + pCopies[copy].numBytes));
+        }
+
+        if (!inCopy && (dest_[i] != 0xA5u)) {
+            printf("FAIL: %s: byte %zd written outside the copies\n", pDesc, (ssize_t)i - GUARD);
+            numFailures_++;
+            break;
+        }
+    }
+}
+
+static bool submit_(struct Copy *pCopy)
+{
+    allowedChannels_ = (HSS_PDMA_Txn_t)(~HSS_PDMA_RESERVED_CHANNELS_MASK
+        & ((1u << MSS_PDMA_lAST_CHANNEL) - 1u));
+
+    return memcpy_via_pdma_submit(dest_at_(pCopy->destOffset), &src_[pCopy->srcOffset],
+        pCopy->numBytes, &pCopy->txn);
+}
+
+static void complete_(char const *pDesc, struct Copy *pCopy)
+{
+    HSS_PDMA_Txn_t const txn = pCopy->txn;
+
+    while (!memcpy_via_pdma_poll(&pCopy->txn)) {
+        if (pCopy->txn & ~txn) {
+            printf("FAIL: %s: transfer gained channels 0x%x\n", pDesc, pCopy->txn & ~txn);
+            numFailures_++;
+            break;
+        }
+    }
+
+    // complete only once every channel carrying it has
+    if (txn & busy_channels_()) {
+        printf("FAIL: %s: complete with channels 0x%x still busy\n", pDesc, txn & busy_channels_());
+        numFailures_++;
+    }
+}
+
+//
+// the tests
+//
+static void run_random_(size_t numCopies)
+{
+    for (size_t i = 0u; i < numCopies; i++) {
+        struct Copy copy;
+
+        clear_dest_();
+        random_copy_(&copy, (rand() % 2) ? 256u : 64u * 1024u);
+
+        if (!submit_(&copy)) {
+            printf("FAIL: random: no free channel when idle\n");
+            numFailures_++;
+            continue;
+        }
+
+        complete_("random", &copy);
+        check_copy_("random", &copy);
+        check_untouched_("random", &copy, 1u);
+    }
+}
+
+static void run_overlapping_(size_t numRounds)
+{
+    for (size_t round = 0u; round < numRounds; round++) {
+        struct Copy copies[4];
+        size_t numCopies = 0u;
+
+        clear_dest_();
+
+        // submit until refused, each copy in its own quarter of the buffer
+        while (numCopies < ARRAY_SIZE(copies)) {
+            struct Copy *pCopy = &copies[numCopies];
+
+            pCopy->numBytes = 64u + ((size_t)rand() % (BUFFER_SIZE / 4u - 128u));
+            pCopy->srcOffset = (size_t)rand() % (BUFFER_SIZE - pCopy->numBytes);
+            pCopy->destOffset = numCopies * (BUFFER_SIZE / 4u) + ((size_t)rand() % 64u);
+
+            if (!submit_(pCopy)) {
+                break; // nothing must have been copied
+            }
+            numCopies++;
+
+            if (rand() % 2) {
+                complete_("overlapping", &copies[(size_t)rand() % numCopies]);
+            }
+        }
+
+        for (size_t i = 0u; i < numCopies; i++) {
+            complete_("overlapping", &copies[i]);
+            check_copy_("overlapping", &copies[i]);
+        }
+        check_untouched_("overlapping", copies, numCopies);
+    }
+}
+
+static void run_split_(void)
+{
+    unsigned int const numFree = (unsigned int)__builtin_popcount(~HSS_PDMA_RESERVED_CHANNELS_MASK
+        & ((1u << MSS_PDMA_lAST_CHANNEL) - 1u));
+    const struct {
+        size_t numBytes;
+        unsigned int numChannels;
+    } cases[] = {
+        { 63u, 0u },               // too small for the PDMA
+        { 64u, 1u },
+        { 8191u, 1u },             // too small to split
+        { 64u * 1024u, numFree },  // spread across all free channels
+    };
+
+    for (size_t i = 0u; i < ARRAY_SIZE(cases); i++) {
+        struct Copy copy = { 0u, 0u, cases[i].numBytes, 0u };
+        unsigned int const expected = cases[i].numChannels;
+
+        clear_dest_();
+        (void)submit_(&copy);
+
+        if ((unsigned int)__builtin_popcount(copy.txn) != expected) {
+            printf("FAIL: %zu bytes carried by channels 0x%x, expected %u channels\n",
+                copy.numBytes, copy.txn, expected);
+            numFailures_++;
+        }
+
+        complete_("split", &copy);
+        check_copy_("split", &copy);
+    }
+}
+
+static void run_reserved_(void)
+{
+    // the owner of a reserved channel gets it, whatever else is in flight
+    struct Copy other = { 0u, 0u, 64u * 1024u, 0u };
+    struct Copy owned = { BUFFER_SIZE / 2u, BUFFER_SIZE / 2u + 3u, 32u * 1024u, 0u };
+
+    clear_dest_();
+    (void)submit_(&other);
+
+    allowedChannels_ = (HSS_PDMA_Txn_t)(1u << HSS_PDMA_SCRUB_CHANNEL);
+    if (!memcpy_via_pdma_submit_channel(HSS_PDMA_SCRUB_CHANNEL, dest_at_(owned.destOffset),
+            &src_[owned.srcOffset], owned.numBytes, &owned.txn)
+            || (owned.txn != (1u << HSS_PDMA_SCRUB_CHANNEL))) {
+        printf("FAIL: reserved channel not given to its owner\n");
+        numFailures_++;
+    }
+
+    // and is refused it while it is busy
+    struct Copy again = owned;
+    if (memcpy_via_pdma_submit_channel(HSS_PDMA_SCRUB_CHANNEL, dest_at_(again.destOffset),
+            &src_[again.srcOffset], again.numBytes, &again.txn)) {
+        printf("FAIL: busy reserved channel given again\n");
+        numFailures_++;
+    }
+
+    complete_("reserved", &owned);
+    complete_("reserved", &other);
+    check_copy_("reserved", &owned);
+    check_copy_("reserved", &other);
+}
+
+static void run_errors_(size_t numCopies)
+{
+    HSS_PDMA_Txn_t const freeChannels = (HSS_PDMA_Txn_t)(~HSS_PDMA_RESERVED_CHANNELS_MASK
+        & ((1u << MSS_PDMA_lAST_CHANNEL) - 1u));
+
+    for (size_t i = 0u; i < numCopies; i++) {
+        struct Copy copy;
+
+        clear_dest_();
+        random_copy_(&copy, 64u * 1024u);
+        refuseSetup_ = (HSS_PDMA_Txn_t)rand() & freeChannels;
+        failTransfer_ = (HSS_PDMA_Txn_t)rand() & freeChannels;
+
+        (void)submit_(&copy);
+        if (copy.txn & ~freeChannels) {
+            printf("FAIL: errors: reserved channels 0x%x used\n", copy.txn);
+            numFailures_++;
+        }
+
+        complete_("errors", &copy);
+        check_copy_("errors", &copy);
+        check_untouched_("errors", &copy, 1u);
+
+        refuseSetup_ = 0u;
+        failTransfer_ = 0u;
+    }
+
+    // the synchronous copy is the same, waited for
+    struct Copy copy = { 5u, 7u, BUFFER_SIZE - 16u, 0u };
+    clear_dest_();
+    failTransfer_ = freeChannels;
+    allowedChannels_ = freeChannels;
+    (void)memcpy_via_pdma(dest_at_(copy.destOffset), &src_[copy.srcOffset], copy.numBytes);
+    check_copy_("synchronous", &copy);
+    failTransfer_ = 0u;
+}
+
+int main(void)
+{
+    srand(1u);
+    for (size_t i = 0u; i < BUFFER_SIZE; i++) {
+        src_[i] = (uint8_t)rand();
+    }
+
+    run_split_();
+    run_random_(2000u);
+    run_overlapping_(500u);
+    run_reserved_();
+    run_errors_(500u);
+
+    if (busy_channels_()) {
+        printf("FAIL: channels 0x%x left busy\n", busy_channels_());
+        numFailures_++;
+    }
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    printf("pdma: %u transfers on channels 0x%x, copies intact, errors fall back to the CPU\n",
+        numStarted_, (unsigned int)(~HSS_PDMA_RESERVED_CHANNELS_MASK & 0xFu));
+    return EXIT_SUCCESS;
+}
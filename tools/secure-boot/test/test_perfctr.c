@@ -0,0 +1,251 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - performance counter host test
+ *
+ * Records known samples into the performance counters, on a simulated clock, and checks
+ * the report: count, min/mean/max, the log2 histogram percentiles (bucket upper bounds,
+ * clamped to the observed max), Lap and Reset. Also checks that invalid parents (itself,
+ * out of range, or not allocated) give top-level counters, that children of a released
+ * counter become top-level, and that allocation fails cleanly once all are in use. The
+ * report is captured from sbi_printf(), so this is not linked with host_stubs.c.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_debug.h"
+#include "hss_clock.h"
+#include "hss_perfctr.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned int numFailures_ = 0u;
+
+static char log_[16384];
+static size_t logLen_ = 0u;
+static HSSTicks_t now_ = 0u;
+
+int sbi_printf(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    int const result = vsnprintf(&log_[logLen_], sizeof(log_) - logLen_, fmt, args);
+    va_end(args);
+
+    if (result > 0) {
+        logLen_ = MIN(logLen_ + (size_t)result, sizeof(log_) - 1u);
+    }
+
+    return result;
+}
+
+void sbi_puts(const char *buf)
+{
+    (void)sbi_printf("%s", buf);
+}
+
+void sbi_putc(char c)
+{
+    (void)sbi_printf("%c", c);
+}
+
+void HSS_Debug_Highlight(HSS_Debug_LogLevel_t logLevel)
+{
+    (void)logLevel;
+}
+
+void HSS_Debug_Timestamp(void)
+{
+}
+
+HSSTicks_t HSS_GetTime(void)
+{
+    return now_;
+}
+
+static void clear_log_(void)
+{
+    logLen_ = 0u;
+    log_[0] = '\0';
+}
+
+static void dump_(void)
+{
+    clear_log_();
+    HSS_PerfCtr_DumpAll();
+}
+
+static void expect_logged_(char const *pDesc, char const *pExpected, bool logged)
+{
+    if ((strstr(log_, pExpected) != NULL) != logged) {
+        printf("FAIL: %s: >>%s<< %s in:\n%s", pDesc, pExpected, logged ? "missing" : "unexpected",
+            log_);
+        numFailures_++;
+    }
+}
+
+//
+// the report line for a counter at the given depth in the tree
+//
+static void expect_counter_(char const *pDesc, char const *pName, unsigned int depth)
+{
+    char expected[64];
+
+    (void)snprintf(expected, sizeof(expected), "ticks) - %*s%s" CRLF, 2 * depth, "", pName);
+    expect_logged_(pDesc, expected, true);
+}
+
+static void run_stats_(void)
+{
+    int idx = PERF_CTR_UNINITIALIZED;
+
+    if (!HSS_PerfCtr_Allocate(&idx, "stats") || (idx < 0)) {
+        printf("FAIL: allocate\n");
+        numFailures_++;
+        return;
+    }
+
+    // a single sample gives no statistics
+    HSS_PerfCtr_Record(idx, 42u);
+    dump_();
+    expect_counter_("one sample", "stats", 0u);
+    expect_logged_("one sample", "n=", false);
+
+    // 1..100: p50 falls in [32, 64), p90 and p99 in [64, 128) and are clamped to the max
+    HSS_PerfCtr_Reset(idx);
+    for (HSSTicks_t ticks = 1u; ticks <= 100u; ticks++) {
+        HSS_PerfCtr_Record(idx, ticks);
+    }
+    dump_();
+    expect_logged_("1..100", "n=100 min/mean/max=1/50/100 p50/p90/p99<=63/100/100 ticks", true);
+
+    // zero goes into the first bucket, and anything beyond 2^32 into the last
+    HSS_PerfCtr_Reset(idx);
+    HSS_PerfCtr_Record(idx, 0u);
+    HSS_PerfCtr_Record(idx, 1llu << 40);
+    dump_();
+    expect_logged_("0, 2^40",
+        "n=2 min/mean/max=0/549755813888/1099511627776 p50/p90/p99<=1/4294967295/4294967295 ticks",
+        true);
+
+    // Reset forgets everything before it
+    HSS_PerfCtr_Reset(idx);
+    HSS_PerfCtr_Record(idx, 5u);
+    HSS_PerfCtr_Record(idx, 5u);
+    dump_();
+    expect_logged_("reset", "n=2 min/mean/max=5/5/5 p50/p90/p99<=5/5/5 ticks", true);
+
+    // Lap records the time since Start
+    HSS_PerfCtr_Reset(idx);
+    now_ = 1000u;
+    HSS_PerfCtr_Start(idx);
+    now_ += 3u * TICKS_PER_MILLISEC;
+    HSS_PerfCtr_Lap(idx);
+    now_ += 1u * TICKS_PER_MILLISEC;
+    HSS_PerfCtr_Lap(idx);
+
+    if (HSS_PerfCtr_GetTime(idx) != 4u * TICKS_PER_MILLISEC) {
+        printf("FAIL: lap time %llu, expected %llu\n",
+            (unsigned long long)HSS_PerfCtr_GetTime(idx), 4llu * TICKS_PER_MILLISEC);
+        numFailures_++;
+    }
+
+    char expected[96];
+    (void)snprintf(expected, sizeof(expected), "n=2 min/mean/max=%llu/%llu/%llu",
+        3llu * TICKS_PER_MILLISEC, 7llu * TICKS_PER_MILLISEC / 2u, 4llu * TICKS_PER_MILLISEC);
+    dump_();
+    expect_logged_("laps", expected, true);
+    expect_logged_("laps", "       4 ms", true);
+
+    HSS_PerfCtr_Deallocate(idx);
+    dump_();
+    expect_logged_("deallocated", "stats", false);
+}
+
+static void run_tree_(void)
+{
+    int parent = PERF_CTR_UNINITIALIZED, child = PERF_CTR_UNINITIALIZED;
+    int grandchild = PERF_CTR_UNINITIALIZED, self = PERF_CTR_UNINITIALIZED;
+    int outOfRange = PERF_CTR_UNINITIALIZED, stale = PERF_CTR_UNINITIALIZED;
+    int released = PERF_CTR_UNINITIALIZED;
+
+    (void)HSS_PerfCtr_Allocate(&parent, "parent");
+    (void)HSS_PerfCtr_AllocateChild(&child, "child", parent);
+    (void)HSS_PerfCtr_AllocateChild(&grandchild, "grandchild", child);
+
+    // the next free counter follows the grandchild here
+    clear_log_();
+    (void)HSS_PerfCtr_AllocateChild(&self, "self", grandchild + 1);
+    expect_logged_("own parent", "invalid parent perf ctr", true);
+    (void)HSS_PerfCtr_AllocateChild(&outOfRange, "out-of-range", CONFIG_DEBUG_PERF_CTRS_NUM);
+
+    (void)HSS_PerfCtr_Allocate(&released, "released");
+    int const releasedIdx = released;
+    HSS_PerfCtr_Deallocate(released);
+    (void)HSS_PerfCtr_AllocateChild(&stale, "stale", releasedIdx);
+
+    if ((self != grandchild + 1) || (stale != releasedIdx)) {
+        printf("FAIL: unexpected allocation order %d/%d/%d/%d/%d\n", parent, child,
+            grandchild, self, stale);
+        numFailures_++;
+    }
+
+    dump_();
+    expect_counter_("tree", "parent", 0u);
+    expect_counter_("tree", "child", 1u);
+    expect_counter_("tree", "grandchild", 2u);
+    expect_counter_("own parent", "self", 0u);
+    expect_counter_("out of range parent", "out-of-range", 0u);
+    expect_counter_("unallocated parent", "stale", 0u);
+
+    // releasing a counter orphans its children, which become top-level
+    HSS_PerfCtr_Deallocate(child);
+    dump_();
+    expect_counter_("orphaned", "parent", 0u);
+    expect_counter_("orphaned", "grandchild", 0u);
+    expect_logged_("orphaned", "- child", false);
+
+    // a counter reusing the released slot does not adopt its old children
+    int reused = PERF_CTR_UNINITIALIZED;
+    (void)HSS_PerfCtr_Allocate(&reused, "reused");
+    dump_();
+    expect_counter_("reused", "reused", 0u);
+    expect_counter_("reused", "grandchild", 0u);
+
+    // allocation fails cleanly once all counters are in use
+    int idx;
+    unsigned int numAllocated = 0u;
+    do {
+        idx = PERF_CTR_UNINITIALIZED;
+        numAllocated++;
+    } while (HSS_PerfCtr_Allocate(&idx, "filler") && (numAllocated <= CONFIG_DEBUG_PERF_CTRS_NUM));
+
+    if (idx != PERF_CTR_UNAVAILABLE) {
+        printf("FAIL: allocating beyond %u counters gave %d\n", CONFIG_DEBUG_PERF_CTRS_NUM, idx);
+        numFailures_++;
+    }
+
+    // recording against an unavailable counter is ignored
+    HSS_PerfCtr_Record(idx, 1u);
+    HSS_PerfCtr_Lap(PERF_CTR_UNINITIALIZED);
+}
+
+int main(void)
+{
+    run_stats_();
+    run_tree_();
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    printf("perfctr: statistics and counter tree as expected\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,367 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - RAM scrubbing service host test
+ *
+ * Runs the scrubbing state machine over host stand-ins for the RAM regions (one of them
+ * empty), with a simulated superloop on a simulated clock. With a configured rate, the
+ * reads go to a model of the PDMA scrub channel, which takes time to complete and
+ * sometimes refuses a transfer: the bytes scrubbed must never run ahead of the rate, and
+ * passes and regions must take the time the rate gives them, and each pass must read
+ * every byte exactly once. Otherwise, the E51 reads a chunk every X superloops, and
+ * passes must complete after the matching number of superloops. The Makefile builds
+ * both. The report is captured from sbi_printf(), so this is not linked with
+ * host_stubs.c.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_debug.h"
+#include "hss_clock.h"
+#include "hss_memcpy_via_pdma.h"
+#include "scrub_service.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//
+// the RAM regions, as the linker script would give them
+//
+__asm__(
+    "    .bss\n"
+    "    .balign 64\n"
+    "    .globl __l2lim_start, __l2lim_end, __l2_start, __l2_end\n"
+    "    .globl __ddr_start, __ddr_end, __ddrhi_start, __ddrhi_end\n"
+    "__l2lim_start:\n"
+    "    .space 49152\n"
+    "__l2lim_end:\n"
+    "__l2_start:\n"
+    "    .space 204900\n"
+    "__l2_end:\n"
+    "    .balign 64\n"
+    "__ddr_start:\n"
+    "    .space 1048576\n"
+    "__ddr_end:\n"
+    "__ddrhi_start:\n"
+    "__ddrhi_end:\n"
+    "    .text\n");
+
+extern const uint64_t __l2lim_start, __l2lim_end;
+extern const uint64_t __l2_start, __l2_end;
+extern const uint64_t __ddr_start, __ddr_end;
+extern const uint64_t __ddrhi_start, __ddrhi_end;
+
+#define NUM_RAMS         4u
+#define RAM_SIZE         (49152u + 204900u + 1048576u)
+#define CHUNK_SIZE       ((size_t)CONFIG_SERVICE_SCRUB_MAX_SIZE_PER_LOOP_ITER)
+#define SUPERLOOP_TICKS  20u // each simulated superloop pass takes this long
+
+static unsigned int numFailures_ = 0u;
+
+static HSSTicks_t now_ = 0u;
+static char line_[256];
+static size_t lineLen_ = 0u;
+static uint64_t numPasses_ = 0u;
+static uint64_t lastPassMillisecs_ = 0u;
+static uint64_t regionMillisecs_[NUM_RAMS];
+static uint64_t bytesRead_ = 0u;
+static HSSTicks_t passStartTime_ = 0u;
+static uint64_t passStartBytes_ = 0u;
+
+//
+// the report is checked a line at a time
+//
+static void parse_line_(void)
+{
+    char const *pText;
+    unsigned long long pass, millisecs, region;
+
+    if ((pText = strstr(line_, "Scrub pass ")) != NULL) {
+        if (sscanf(pText, "Scrub pass %llu completed in %llu ms", &pass, &millisecs) == 2) {
+            numPasses_ = pass;
+            lastPassMillisecs_ = millisecs;
+
+            // the rate applies from here, and the next pass is reported before it is read
+            passStartTime_ = now_;
+            passStartBytes_ = bytesRead_;
+        }
+    } else if ((pText = strstr(line_, "Region ")) != NULL) {
+        char const * const pLast = strstr(pText, "last took ");
+
+        if ((sscanf(pText, "Region %llu:", &region) == 1) && (region < NUM_RAMS) && pLast
+                && (sscanf(pLast, "last took %llu ms", &millisecs) == 1)) {
+            regionMillisecs_[region] = millisecs;
+        }
+    }
+}
+
+int sbi_printf(const char *fmt, ...)
+{
+    char buffer[256];
+    va_list args;
+
+    va_start(args, fmt);
+    int const result = vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+
+    for (char const *pChar = buffer; *pChar; pChar++) {
+        if (*pChar == '\n') {
+            line_[lineLen_] = '\0';
+            parse_line_();
+            lineLen_ = 0u;
+        } else if (lineLen_ < sizeof(line_) - 1u) {
+            line_[lineLen_++] = *pChar;
+        }
+    }
+
+    return result;
+}
+
+void sbi_puts(const char *buf)
+{
+    (void)sbi_printf("%s", buf);
+}
+
+void sbi_putc(char c)
+{
+    (void)sbi_printf("%c", c);
+}
+
+void HSS_Debug_Highlight(HSS_Debug_LogLevel_t logLevel)
+{
+    (void)logLevel;
+}
+
+void HSS_Debug_Timestamp(void)
+{
+}
+
+HSSTicks_t HSS_GetTime(void)
+{
+    return now_;
+}
+
+#if IS_ENABLED(CONFIG_SERVICE_SCRUB_USE_PDMA)
+//
+// every byte read is counted, so that each pass can be checked to cover all RAM once
+//
+static uint8_t readCounts_[RAM_SIZE];
+
+static struct {
+    uintptr_t baseAddr;
+    uintptr_t endAddr;
+    size_t countsOffset;
+} const rams_[NUM_RAMS] = {
+    { (uintptr_t)&__l2lim_start, (uintptr_t)&__l2lim_end, 0u },
+    { (uintptr_t)&__l2_start,    (uintptr_t)&__l2_end,    49152u },
+    { (uintptr_t)&__ddr_start,   (uintptr_t)&__ddr_end,   49152u + 204900u },
+    { (uintptr_t)&__ddrhi_start, (uintptr_t)&__ddrhi_end, RAM_SIZE },
+};
+
+static void record_read_(uintptr_t addr, size_t byteCount)
+{
+    // a new pass must follow a complete one
+    if (addr == rams_[0].baseAddr) {
+        for (size_t i = 0u; i < RAM_SIZE; i++) {
+            if (readCounts_[i] != readCounts_[0]) {
+                printf("FAIL: pass %u read byte %zu %u times\n", readCounts_[0], i,
+                    readCounts_[i]);
+                numFailures_++;
+                break;
+            }
+        }
+    }
+
+    for (size_t region = 0u; region < NUM_RAMS; region++) {
+        if ((addr >= rams_[region].baseAddr) && (addr + byteCount <= rams_[region].endAddr)
+                && byteCount) {
+            size_t const offset = rams_[region].countsOffset + (addr - rams_[region].baseAddr);
+
+            for (size_t i = 0u; i < byteCount; i++) {
+                readCounts_[offset + i]++;
+            }
+            bytesRead_ += byteCount;
+            return;
+        }
+    }
+
+    printf("FAIL: read of %zu bytes at %p is not within one RAM region\n", byteCount,
+        (void *)addr);
+    numFailures_++;
+}
+
+//
+// model of the PDMA scrub channel: a transfer completes after a time in proportion to its
+// size, every so often one stalls for longer, as when sharing the bus with a boot copy,
+// and some are refused, as when a boot copy holds the channel
+//
+#  define PDMA_BYTES_PER_TICK 64u
+#  define PDMA_STALL_TICKS    1000u
+#  define PDMA_STALL_EVERY    16u
+
+static bool inFlight_ = false;
+static HSSTicks_t completionTime_ = 0u;
+static unsigned int numTransfers_ = 0u;
+
+bool memcpy_via_pdma_submit_channel(unsigned int channel, void * restrict dest,
+    void const * restrict src, size_t num_bytes, HSS_PDMA_Txn_t *pTxn)
+{
+    (void)dest;
+
+    if (channel != HSS_PDMA_SCRUB_CHANNEL) {
+        printf("FAIL: scrubbing on PDMA channel %u\n", channel);
+        numFailures_++;
+    }
+
+    if (inFlight_ || *pTxn) {
+        printf("FAIL: scrub transfer submitted while one is in flight\n");
+        numFailures_++;
+    }
+
+    if ((rand() % 8) == 0) {
+        return false;
+    }
+
+    record_read_((uintptr_t)src, num_bytes);
+    inFlight_ = true;
+    completionTime_ = now_ + (num_bytes / PDMA_BYTES_PER_TICK);
+    if ((++numTransfers_ % PDMA_STALL_EVERY) == 0u) {
+        completionTime_ += PDMA_STALL_TICKS;
+    }
+    *pTxn = (HSS_PDMA_Txn_t)(1u << channel);
+
+    return true;
+}
+
+bool memcpy_via_pdma_poll(HSS_PDMA_Txn_t *pTxn)
+{
+    bool result = !inFlight_ || (now_ >= completionTime_);
+
+    if (result) {
+        inFlight_ = false;
+        *pTxn = 0u;
+    }
+
+    return result;
+}
+#endif
+
+static void run_superloop_(void)
+{
+    scrub_service.pStateDescs[scrub_service.state].state_handler(&scrub_service);
+    now_ += SUPERLOOP_TICKS;
+}
+
+#if defined(CONFIG_SERVICE_SCRUB_RATE_KIB_PER_SEC) && (CONFIG_SERVICE_SCRUB_RATE_KIB_PER_SEC)
+#  define RATE_BYTES_PER_SEC ((uint64_t)CONFIG_SERVICE_SCRUB_RATE_KIB_PER_SEC * 1024u)
+
+static void check_millisecs_(char const *pDesc, uint64_t millisecs, uint64_t byteCount)
+{
+    // allow for the truncation in the report, and for the superloop granularity
+    uint64_t const expected = (byteCount * 1000u) / RATE_BYTES_PER_SEC;
+
+    if ((millisecs + 1u < expected) || (millisecs > expected + 1u)) {
+        printf("FAIL: %s took %llu ms, expected %llu ms\n", pDesc, (unsigned long long)millisecs,
+            (unsigned long long)expected);
+        numFailures_++;
+    }
+}
+
+static void run_paced_(unsigned int numPasses)
+{
+    uint64_t maxAhead = 0u, maxBehind = 0u;
+
+    while ((numPasses_ < numPasses) && !numFailures_) {
+        run_superloop_();
+
+        // within a pass, what is read never runs ahead of the rate by more than the chunk
+        // being read, and never falls behind it by more than a chunk and a stalled PDMA
+        // transfer
+        uint64_t const allowed = ((now_ - passStartTime_) * RATE_BYTES_PER_SEC) / TICKS_PER_SEC;
+        uint64_t const passBytes = bytesRead_ - passStartBytes_;
+
+        if (passBytes > allowed) {
+            maxAhead = MAX(maxAhead, passBytes - allowed);
+        } else {
+            maxBehind = MAX(maxBehind, allowed - passBytes);
+        }
+    }
+
+    uint64_t const slack = ((4u * SUPERLOOP_TICKS + CHUNK_SIZE / PDMA_BYTES_PER_TICK
+        + PDMA_STALL_TICKS) * RATE_BYTES_PER_SEC) / TICKS_PER_SEC;
+
+    if ((maxAhead > CHUNK_SIZE) || (maxBehind > CHUNK_SIZE + slack)) {
+        printf("FAIL: scrubbing ran up to %llu bytes ahead of and %llu bytes behind the rate\n",
+            (unsigned long long)maxAhead, (unsigned long long)maxBehind);
+        numFailures_++;
+    }
+
+    check_millisecs_("last pass", lastPassMillisecs_, RAM_SIZE);
+
+    // the report gives per-region times for all but the region being scrubbed
+    scrub_dump_stats();
+    check_millisecs_("L2 region", regionMillisecs_[1], 204900u);
+    check_millisecs_("DDR region", regionMillisecs_[2], 1048576u);
+    if (regionMillisecs_[3]) {
+        printf("FAIL: empty region took %llu ms\n", (unsigned long long)regionMillisecs_[3]);
+        numFailures_++;
+    }
+}
+#else
+static void run_superloops_(unsigned int numPasses)
+{
+    // a chunk every X superloops, with an extra pass of the scrubber to move past the empty
+    // region, and the pass completing as the next one starts
+    size_t const chunksPerPass = ((49152u + CHUNK_SIZE - 1u) / CHUNK_SIZE)
+        + ((204900u + CHUNK_SIZE - 1u) / CHUNK_SIZE) + ((1048576u + CHUNK_SIZE - 1u) / CHUNK_SIZE)
+        + 1u;
+    size_t const expectedSuperloops = (numPasses * chunksPerPass)
+        * CONFIG_SERVICE_SCRUB_RUN_EVERY_X_SUPERLOOPS + 1u;
+    size_t numSuperloops = 0u;
+
+    while ((numPasses_ < numPasses) && (numSuperloops <= expectedSuperloops)) {
+        run_superloop_();
+        numSuperloops++;
+    }
+
+    if (numSuperloops != expectedSuperloops) {
+        printf("FAIL: %u passes took %zu superloops, expected %zu\n", numPasses, numSuperloops,
+            expectedSuperloops);
+        numFailures_++;
+    }
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <name>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    srand(1u);
+    now_ = 12345u;
+    passStartTime_ = now_;
+
+    // the init state
+    run_superloop_();
+
+#if defined(CONFIG_SERVICE_SCRUB_RATE_KIB_PER_SEC) && (CONFIG_SERVICE_SCRUB_RATE_KIB_PER_SEC)
+    run_paced_(4u);
+#else
+    run_superloops_(4u);
+#endif
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    printf("scrub (%s): %llu passes, the last in %llu ms\n", argv[1],
+        (unsigned long long)numPasses_, (unsigned long long)lastPassMillisecs_);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,478 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - superloop host test
+ *
+ * Simulates the E51 superloop on a simulated clock, with state machines waiting for IPIs,
+ * UART RX, a periodic timer and another machine's state change, alongside idle ones, and
+ * the same trace of IPI and UART RX arrivals. The machines first poll, as before they
+ * could sleep, and then declare themselves quiescent until their event. Every event must
+ * be handled within a pass of the superloop either way, the sleeping idle machines must
+ * not run again, and the E51 must only WFI when every machine is quiescent, with the timer
+ * compare set for the earliest deadline. Reports the handler calls and busy time per
+ * superloop pass, and the time in WFI, for each. The report is captured from sbi_printf(),
+ * so this is not linked with host_stubs.c.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_clock.h"
+#include "hss_debug.h"
+#include "hss_progress.h"
+#include "hss_state_machine.h"
+#include "ssmb_ipi.h"
+#include "hss_registry.h"
+#include "uart_helper.h"
+#include "mpfs_reg_map.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_TICKS       2000000u
+#define HANDLER_TICKS   3u    // each handler call takes this long
+#define LOOP_TICKS      2u    // as does the rest of each superloop pass
+#define TIMER_PERIOD    5000u
+#define MAX_EVENT_GAP   4000u
+#define MAX_IDLE_TICKS  ((CONFIG_SUPERLOOP_IDLE_WFI_MAX_USEC * TICKS_PER_MILLISEC) / 1000u)
+#define NUM_IDLE        6u
+#define NUM_MACHINES    (4u + NUM_IDLE)
+
+// an event must be handled within a whole pass of the superloop, with every machine running
+#define MAX_LATENCY     (NUM_MACHINES * HANDLER_TICKS + LOOP_TICKS)
+
+static unsigned int numFailures_ = 0u;
+
+static HSSTicks_t now_ = 0u;
+static bool sleep_ = false; // machines declare themselves quiescent
+
+uint64_t hostClint[(CLINT_MTIMECMP_E51_0_OFFSET / sizeof(uint64_t)) + 1u];
+unsigned long hostCsr_mie = 0u;
+
+static struct {
+    size_t numLoops;
+    size_t numHandlerCalls;
+    size_t numWfis;
+    HSSTicks_t idleTicks;
+    HSSTicks_t maxIpiLatency;
+    HSSTicks_t maxUartLatency;
+    HSSTicks_t maxTimerLateness;
+    HSSTicks_t maxChainLatency;
+    unsigned int numIpis;
+    unsigned int numIpisHandled;
+    unsigned int numUartBytes;
+    unsigned int numUartBytesHandled;
+    unsigned int numTimerTicks;
+    unsigned int numChains;
+} stats_;
+
+//
+// the event trace
+//
+static HSSTicks_t nextIpiTime_, nextUartTime_;
+static uint32_t pendingIpis_[MAX_NUM_HARTS];
+static HSSTicks_t ipiArrival_;
+static unsigned int pendingUartBytes_;
+static HSSTicks_t uartArrival_;
+
+static void deliver_(void)
+{
+    while (nextIpiTime_ <= now_) {
+        if (!stats_.numIpis || (stats_.numIpis == stats_.numIpisHandled)) {
+            ipiArrival_ = nextIpiTime_;
+        }
+        pendingIpis_[HSS_HART_U54_1 + ((unsigned int)rand() % 4u)]++;
+        stats_.numIpis++;
+        nextIpiTime_ += 1u + ((HSSTicks_t)rand() % MAX_EVENT_GAP);
+    }
+
+    while (nextUartTime_ <= now_) {
+        if (!pendingUartBytes_) {
+            uartArrival_ = nextUartTime_;
+        }
+        pendingUartBytes_++;
+        stats_.numUartBytes++;
+        nextUartTime_ += 1u + ((HSSTicks_t)rand() % (2u * MAX_EVENT_GAP));
+    }
+}
+
+static void advance_(HSSTicks_t ticks)
+{
+    now_ += ticks;
+    deliver_();
+}
+
+//
+// host stand-ins
+//
+HSSTicks_t HSS_GetTime(void)
+{
+    return now_;
+}
+
+HSSTicks_t HSS_GetTickCount(void)
+{
+    return now_;
+}
+
+int sbi_printf(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    int const result = vprintf(fmt, args);
+    va_end(args);
+
+    return result;
+}
+
+void sbi_puts(const char *buf)
+{
+    (void)sbi_printf("%s", buf);
+}
+
+void sbi_putc(char c)
+{
+    (void)sbi_printf("%c", c);
+}
+
+void HSS_Debug_Highlight(HSS_Debug_LogLevel_t logLevel)
+{
+    (void)logLevel;
+}
+
+void HSS_Debug_Timestamp(void)
+{
+}
+
+bool HSS_ShowTimeout(char const * const msg, uint32_t timeout_sec, uint8_t *pRcvBuf)
+{
+    (void)msg;
+    (void)timeout_sec;
+    (void)pRcvBuf;
+    return false; // so the superloop never restarts through _start
+}
+
+bool IPI_PollReceive(union HSSHartBitmask hartMask)
+{
+    (void)hartMask;
+    return false;
+}
+
+bool IPI_ConsumeIntent(enum HSSHartId source, enum IPIMessagesEnum msg_type)
+{
+    (void)source;
+    (void)msg_type;
+    return false;
+}
+
+uint32_t IPI_CalculateQueueIndex(enum HSSHartId source, enum HSSHartId target)
+{
+    return (source * MAX_NUM_HARTS) + target;
+}
+
+uint32_t IPI_GetQueuePendingCount(uint32_t queueIndex)
+{
+    return ((queueIndex % MAX_NUM_HARTS) == HSS_HART_E51) ? pendingIpis_[queueIndex / MAX_NUM_HARTS] : 0u;
+}
+
+void CLINT_Clear_MSIP(enum HSSHartId const target)
+{
+    (void)target;
+}
+
+bool uart_rx_ready(void)
+{
+    return pendingUartBytes_ != 0u;
+}
+
+//
+// the state machines
+//
+static void ipi_handler_(struct StateMachine * const pMyMachine);
+static void uart_handler_(struct StateMachine * const pMyMachine);
+static void timer_handler_(struct StateMachine * const pMyMachine);
+static void chain_wait_handler_(struct StateMachine * const pMyMachine);
+static void chain_run_handler_(struct StateMachine * const pMyMachine);
+static void idle_handler_(struct StateMachine * const pMyMachine);
+
+static const struct StateDesc ipiStates_[] = { { 0, "wait", NULL, NULL, &ipi_handler_ } };
+static const struct StateDesc uartStates_[] = { { 0, "wait", NULL, NULL, &uart_handler_ } };
+static const struct StateDesc timerStates_[] = { { 0, "wait", NULL, NULL, &timer_handler_ } };
+static const struct StateDesc chainStates_[] = {
+    { 0, "wait", NULL, NULL, &chain_wait_handler_ },
+    { 1, "run",  NULL, NULL, &chain_run_handler_ },
+};
+static const struct StateDesc idleStates_[] = { { 0, "idle", NULL, NULL, &idle_handler_ } };
+
+#define MACHINE(name, descs) { .numStates = ARRAY_SIZE(descs), .pMachineName = name, \
+    .pStateDescs = descs }
+
+static struct StateMachine ipiMachine_ = MACHINE("ipi", ipiStates_);
+static struct StateMachine uartMachine_ = MACHINE("uart", uartStates_);
+static struct StateMachine timerMachine_ = MACHINE("timer", timerStates_);
+static struct StateMachine chainMachine_ = MACHINE("chain", chainStates_);
+static struct StateMachine idleMachines_[NUM_IDLE] = {
+    [0 ... NUM_IDLE - 1] = MACHINE("idle", idleStates_)
+};
+
+// the IPI machine runs first, so that the machine it wakes runs in the same pass
+struct StateMachine * const pGlobalStateMachines[NUM_MACHINES] = {
+    &ipiMachine_, &idleMachines_[0], &idleMachines_[1], &chainMachine_, &uartMachine_,
+    &idleMachines_[2], &idleMachines_[3], &timerMachine_, &idleMachines_[4], &idleMachines_[5],
+};
+const size_t spanOfPGlobalStateMachines = ARRAY_SIZE(pGlobalStateMachines);
+
+static HSSTicks_t timerDeadline_;
+static HSSTicks_t chainTime_;
+
+static void handler_called_(void)
+{
+    stats_.numHandlerCalls++;
+    advance_(HANDLER_TICKS);
+}
+
+static void ipi_handler_(struct StateMachine * const pMyMachine)
+{
+    handler_called_();
+
+    unsigned int numIpis = 0u;
+    for (size_t i = 0u; i < MAX_NUM_HARTS; i++) {
+        numIpis += pendingIpis_[i];
+        pendingIpis_[i] = 0u;
+    }
+
+    if (numIpis) {
+        stats_.maxIpiLatency = MAX(stats_.maxIpiLatency, now_ - ipiArrival_);
+        stats_.numIpisHandled += numIpis;
+
+        // and hand over to another machine, as the boot service does for a hart
+        chainMachine_.state = 1;
+        chainTime_ = now_;
+    }
+
+    if (sleep_) {
+        SleepStateMachine(pMyMachine, SM_WAKE_ON_IPI, 0u);
+    }
+}
+
+static void uart_handler_(struct StateMachine * const pMyMachine)
+{
+    handler_called_();
+
+    if (pendingUartBytes_) {
+        stats_.maxUartLatency = MAX(stats_.maxUartLatency, now_ - uartArrival_);
+        stats_.numUartBytesHandled += pendingUartBytes_;
+        pendingUartBytes_ = 0u;
+    }
+
+    if (sleep_) {
+        SleepStateMachine(pMyMachine, SM_WAKE_ON_UART_RX, 0u);
+    }
+}
+
+static void timer_handler_(struct StateMachine * const pMyMachine)
+{
+    handler_called_();
+
+    if (now_ >= timerDeadline_) {
+        stats_.maxTimerLateness = MAX(stats_.maxTimerLateness, now_ - timerDeadline_);
+        stats_.numTimerTicks++;
+        timerDeadline_ += TIMER_PERIOD;
+    }
+
+    if (sleep_) {
+        SleepStateMachine(pMyMachine, SM_WAKE_ON_TIMER, timerDeadline_);
+    }
+}
+
+static void chain_wait_handler_(struct StateMachine * const pMyMachine)
+{
+    handler_called_();
+
+    if (sleep_) {
+        SleepStateMachine(pMyMachine, 0u, 0u);
+    }
+}
+
+static void chain_run_handler_(struct StateMachine * const pMyMachine)
+{
+    handler_called_();
+
+    stats_.maxChainLatency = MAX(stats_.maxChainLatency, now_ - chainTime_);
+    stats_.numChains++;
+    pMyMachine->state = 0;
+}
+
+static void idle_handler_(struct StateMachine * const pMyMachine)
+{
+    handler_called_();
+
+    if (sleep_) {
+        SleepStateMachine(pMyMachine, 0u, 0u);
+    }
+}
+
+//
+// the E51 sleeps until the timer compare or the next event
+//
+void hostWfi(void)
+{
+    HSSTicks_t const mtimecmp = hostClint[CLINT_MTIMECMP_E51_0_OFFSET / sizeof(uint64_t)];
+
+    for (size_t i = 0u; i < NUM_MACHINES; i++) {
+        struct StateMachine const * const pMachine = pGlobalStateMachines[i];
+
+        if (!pMachine->wakeEvents || (pMachine->state != pMachine->prevState)) {
+            printf("FAIL: WFI with %s runnable\n", pMachine->pMachineName);
+            numFailures_++;
+        }
+    }
+
+    if ((hostCsr_mie & (MIP_MSIP | MIP_MTIP)) != (MIP_MSIP | MIP_MTIP)) {
+        printf("FAIL: WFI with mie 0x%lx\n", hostCsr_mie);
+        numFailures_++;
+    }
+
+    if ((mtimecmp > timerDeadline_) || (mtimecmp > now_ + MAX_IDLE_TICKS)) {
+        printf("FAIL: WFI at %llu until %llu, with a timer deadline at %llu\n",
+            (unsigned long long)now_, (unsigned long long)mtimecmp,
+            (unsigned long long)timerDeadline_);
+        numFailures_++;
+    }
+
+    if (pendingUartBytes_ || (stats_.numIpis != stats_.numIpisHandled)) {
+        printf("FAIL: WFI with an event pending\n");
+        numFailures_++;
+    }
+
+    HSSTicks_t const wakeTime = MIN(mtimecmp, MIN(nextIpiTime_, nextUartTime_));
+
+    stats_.numWfis++;
+    if (wakeTime > now_) {
+        stats_.idleTicks += wakeTime - now_;
+        now_ = wakeTime;
+        deliver_();
+    }
+}
+
+//
+// runs the superloop over the event trace, with the machines polling or sleeping
+//
+static void run_(bool sleep)
+{
+    memset(&stats_, 0, sizeof(stats_));
+    memset(pendingIpis_, 0, sizeof(pendingIpis_));
+    pendingUartBytes_ = 0u;
+
+    for (size_t i = 0u; i < NUM_MACHINES; i++) {
+        pGlobalStateMachines[i]->state = 0;
+        pGlobalStateMachines[i]->prevState = SM_INVALID_STATE;
+        pGlobalStateMachines[i]->wakeEvents = 0u;
+        pGlobalStateMachines[i]->startTime = 0u;
+    }
+
+    sleep_ = sleep;
+    srand(1u);
+    now_ = 1000u;
+    nextIpiTime_ = now_ + 1u + ((HSSTicks_t)rand() % MAX_EVENT_GAP);
+    nextUartTime_ = now_ + 1u + ((HSSTicks_t)rand() % (2u * MAX_EVENT_GAP));
+    timerDeadline_ = now_ + TIMER_PERIOD;
+    hostClint[CLINT_MTIMECMP_E51_0_OFFSET / sizeof(uint64_t)] = UINT64_MAX;
+
+    HSSTicks_t const startTime = now_;
+    while (now_ < startTime + SIM_TICKS) {
+        size_t const numWfis = stats_.numWfis;
+
+        RunStateMachines(spanOfPGlobalStateMachines, pGlobalStateMachines);
+        advance_(LOOP_TICKS);
+        stats_.numLoops++;
+
+        if ((stats_.numWfis != numWfis) && ((hostCsr_mie != 0u)
+                || (hostClint[CLINT_MTIMECMP_E51_0_OFFSET / sizeof(uint64_t)] != UINT64_MAX))) {
+            printf("FAIL: mie or the timer compare not restored after WFI\n");
+            numFailures_++;
+        }
+    }
+
+    char const * const pDesc = sleep ? "sleeping" : "polling";
+    unsigned int const numTimerTicks = SIM_TICKS / TIMER_PERIOD;
+    unsigned int numIpisPending = 0u;
+    for (size_t i = 0u; i < MAX_NUM_HARTS; i++) {
+        numIpisPending += pendingIpis_[i];
+    }
+
+    if ((stats_.numIpisHandled + numIpisPending != stats_.numIpis)
+            || (stats_.numUartBytesHandled + pendingUartBytes_ != stats_.numUartBytes)
+            || (stats_.numTimerTicks + 1u < numTimerTicks) || !stats_.numChains) {
+        printf("FAIL: %s: %u of %u IPIs, %u of %u UART bytes, %u of %u timer ticks, %u chains\n",
+            pDesc, stats_.numIpisHandled, stats_.numIpis, stats_.numUartBytesHandled,
+            stats_.numUartBytes, stats_.numTimerTicks, numTimerTicks, stats_.numChains);
+        numFailures_++;
+    }
+
+    if ((stats_.maxIpiLatency > MAX_LATENCY) || (stats_.maxUartLatency > MAX_LATENCY)
+            || (stats_.maxTimerLateness > MAX_LATENCY) || (stats_.maxChainLatency > MAX_LATENCY)) {
+        printf("FAIL: %s: worst latency IPI %llu, UART %llu, timer %llu, chain %llu ticks\n", pDesc,
+            (unsigned long long)stats_.maxIpiLatency, (unsigned long long)stats_.maxUartLatency,
+            (unsigned long long)stats_.maxTimerLateness, (unsigned long long)stats_.maxChainLatency);
+        numFailures_++;
+    }
+
+    if (sleep) {
+        for (size_t i = 0u; i < NUM_IDLE; i++) {
+            if (idleMachines_[i].executionCount != 1u) {
+                printf("FAIL: sleeping idle machine ran %llu times\n",
+                    (unsigned long long)idleMachines_[i].executionCount);
+                numFailures_++;
+            }
+        }
+
+        if (!stats_.numWfis) {
+            printf("FAIL: never idled\n");
+            numFailures_++;
+        }
+    } else if (stats_.numWfis) {
+        printf("FAIL: idled while polling\n");
+        numFailures_++;
+    }
+}
+
+static void report_(char const *pDesc)
+{
+    HSSTicks_t const busyTicks = SIM_TICKS - stats_.idleTicks;
+
+    printf("superloop (%s): %zu passes, %.1f handler calls and %.1f busy ticks per pass, "
+        "%.0f%% in WFI, worst IPI latency %llu ticks\n", pDesc, stats_.numLoops,
+        (double)stats_.numHandlerCalls / (double)stats_.numLoops,
+        (double)busyTicks / (double)stats_.numLoops,
+        (100.0 * (double)stats_.idleTicks) / (double)SIM_TICKS,
+        (unsigned long long)stats_.maxIpiLatency);
+}
+
+int main(void)
+{
+    run_(false);
+    size_t const pollingCalls = stats_.numHandlerCalls;
+    if (!numFailures_) {
+        report_("polling");
+    }
+
+    run_(true);
+    if (stats_.numHandlerCalls * 10u > pollingCalls) {
+        printf("FAIL: sleeping made %zu handler calls, polling %zu\n", stats_.numHandlerCalls,
+            pollingCalls);
+        numFailures_++;
+    }
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    report_("sleeping");
+    return EXIT_SUCCESS;
+}
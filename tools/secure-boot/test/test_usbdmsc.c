@@ -0,0 +1,287 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - USBDMSC transfer buffer host test
+ *
+ * Replays traces of SCSI reads and writes against the USBDMSC transfer buffers, over a
+ * simulated storage device, with the USBDMSC poll loop running at random points while
+ * the USB driver owns a buffer. Every read must return what the host last wrote, the
+ * buffer the USB driver owns must never be touched by a pending storage access, and
+ * the storage must hold everything written once the media is released. With the
+ * pipeline, sequential reads must be served from the read-ahead, and writes programmed
+ * from the poll loop. The Makefile builds this with and without the pipeline.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "flash_drive_app.h"
+#include "flash_drive_pipeline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK_SIZE 512u
+#define CAPACITY ((uint64_t)(64u * SD_RD_WR_SIZE + 7u * BLOCK_SIZE)) // ends in a short chunk
+
+static unsigned int numFailures_ = 0u;
+
+static uint8_t storage_[CAPACITY];   // the simulated device
+static uint8_t reference_[CAPACITY]; // what the host has written
+
+static struct {
+    bool inPoll;
+    size_t numReads;
+    size_t numPolledReads;
+    size_t numPrograms;
+    size_t numPolledPrograms;
+    uint8_t const *pUsbBuffer; // the buffer the USB driver owns, and its contents
+    uint8_t usbBufferCopy[SD_RD_WR_SIZE];
+} sim_;
+
+void FLASH_DRIVE_physical_read(uint64_t byte_address, uint8_t *p_rx_buffer,
+    size_t size_in_bytes)
+{
+    if ((byte_address + size_in_bytes > CAPACITY) || (size_in_bytes > SD_RD_WR_SIZE)) {
+        printf("FAIL: read of %zu bytes at 0x%llx\n", size_in_bytes,
+            (unsigned long long)byte_address);
+        numFailures_++;
+    } else {
+        memcpy(p_rx_buffer, &storage_[byte_address], size_in_bytes);
+    }
+
+    sim_.numReads++;
+    if (sim_.inPoll) { sim_.numPolledReads++; }
+}
+
+void FLASH_DRIVE_physical_program(uint64_t byte_address, uint8_t *p_write_buffer,
+    uint32_t size_in_bytes)
+{
+    if ((byte_address + size_in_bytes > CAPACITY) || (size_in_bytes > SD_RD_WR_SIZE)) {
+        printf("FAIL: program of %u bytes at 0x%llx\n", size_in_bytes,
+            (unsigned long long)byte_address);
+        numFailures_++;
+    } else {
+        memcpy(&storage_[byte_address], p_write_buffer, size_in_bytes);
+    }
+
+    sim_.numPrograms++;
+    if (sim_.inPoll) { sim_.numPolledPrograms++; }
+}
+
+//
+// runs the USBDMSC poll loop a random number of times, checking that the buffer the USB
+// driver owns is left alone
+//
+static void poll_(void)
+{
+    unsigned int const numPolls = (unsigned int)rand() % 3u;
+
+    if (sim_.pUsbBuffer) {
+        memcpy(sim_.usbBufferCopy, sim_.pUsbBuffer, SD_RD_WR_SIZE);
+    }
+
+    sim_.inPoll = true;
+    for (unsigned int i = 0u; i < numPolls; i++) {
+        FLASH_DRIVE_process_pending();
+    }
+    sim_.inPoll = false;
+
+    if (sim_.pUsbBuffer && memcmp(sim_.usbBufferCopy, sim_.pUsbBuffer, SD_RD_WR_SIZE)) {
+        printf("FAIL: buffer owned by the USB driver changed by the poll loop\n");
+        numFailures_++;
+    }
+}
+
+static void host_read_(uint64_t byte_address, uint32_t len)
+{
+    uint8_t *pBuffer = FLASH_DRIVE_pipeline_read(byte_address, len, CAPACITY);
+
+    // the USB DMA sends the buffer while the poll loop runs
+    sim_.pUsbBuffer = pBuffer;
+    poll_();
+    sim_.pUsbBuffer = NULL;
+
+    if (memcmp(pBuffer, &reference_[byte_address], len)) {
+        printf("FAIL: read of %u bytes at 0x%llx does not return what was written\n", len,
+            (unsigned long long)byte_address);
+        numFailures_++;
+    }
+}
+
+static void host_write_(uint64_t byte_address, uint32_t len)
+{
+    uint8_t *pBuffer = FLASH_DRIVE_pipeline_acquire_write_buf();
+
+    // the USB DMA receives into the buffer while the poll loop runs
+    for (uint32_t i = 0u; i < len; i++) {
+        pBuffer[i] = reference_[byte_address + i] = (uint8_t)rand();
+        if (i == len / 2u) {
+            sim_.pUsbBuffer = pBuffer;
+            poll_();
+            sim_.pUsbBuffer = NULL;
+        }
+    }
+
+    FLASH_DRIVE_pipeline_write_ready(byte_address, len);
+}
+
+static uint32_t random_len_(uint64_t byte_address)
+{
+    uint32_t const numBlocks = 1u + ((uint32_t)rand() % (SD_RD_WR_SIZE / BLOCK_SIZE));
+
+    return (uint32_t)MIN((uint64_t)numBlocks * BLOCK_SIZE, CAPACITY - byte_address);
+}
+
+static uint64_t random_address_(void)
+{
+    return ((uint64_t)rand() % (CAPACITY / BLOCK_SIZE)) * BLOCK_SIZE;
+}
+
+static void run_sequential_reads_(void)
+{
+    size_t const numReads = sim_.numReads;
+    size_t const numPolledReads = sim_.numPolledReads;
+    size_t numChunks = 0u;
+
+    for (uint64_t address = 0u; address < CAPACITY; address += SD_RD_WR_SIZE) {
+        uint32_t const len = (uint32_t)MIN((uint64_t)SD_RD_WR_SIZE, CAPACITY - address);
+        uint8_t *pBuffer = FLASH_DRIVE_pipeline_read(address, len, CAPACITY);
+
+        sim_.pUsbBuffer = pBuffer;
+        sim_.inPoll = true;
+        FLASH_DRIVE_process_pending();
+        sim_.inPoll = false;
+        sim_.pUsbBuffer = NULL;
+
+        if (memcmp(pBuffer, &reference_[address], len)) {
+            printf("FAIL: sequential read at 0x%llx\n", (unsigned long long)address);
+            numFailures_++;
+        }
+        numChunks++;
+    }
+
+#ifdef CONFIG_SERVICE_USBDMSC_PIPELINE
+    // only the first chunk is read while the host waits
+    size_t const numWaitedReads = (sim_.numReads - numReads) - (sim_.numPolledReads - numPolledReads);
+    if ((numWaitedReads != 1u) || (sim_.numReads - numReads != numChunks)) {
+        printf("FAIL: %zu sequential chunks took %zu reads, %zu while the host waited\n",
+            numChunks, sim_.numReads - numReads, numWaitedReads);
+        numFailures_++;
+    }
+#else
+    (void)numPolledReads;
+    if (sim_.numReads - numReads != numChunks) {
+        printf("FAIL: %zu sequential chunks took %zu reads\n", numChunks,
+            sim_.numReads - numReads);
+        numFailures_++;
+    }
+#endif
+}
+
+static void run_sequential_writes_(void)
+{
+    size_t const numPrograms = sim_.numPrograms;
+    size_t const numPolledPrograms = sim_.numPolledPrograms;
+    size_t numChunks = 0u;
+
+    for (uint64_t address = 0u; address < CAPACITY; address += SD_RD_WR_SIZE) {
+        uint32_t const len = (uint32_t)MIN((uint64_t)SD_RD_WR_SIZE, CAPACITY - address);
+        uint8_t *pBuffer = FLASH_DRIVE_pipeline_acquire_write_buf();
+
+        for (uint32_t i = 0u; i < len; i++) {
+            pBuffer[i] = reference_[address + i] = (uint8_t)rand();
+        }
+        FLASH_DRIVE_pipeline_write_ready(address, len);
+
+        sim_.inPoll = true;
+        FLASH_DRIVE_process_pending();
+        sim_.inPoll = false;
+        numChunks++;
+    }
+
+    if (sim_.numPrograms - numPrograms != numChunks) {
+        printf("FAIL: %zu sequential chunks took %zu programs\n", numChunks,
+            sim_.numPrograms - numPrograms);
+        numFailures_++;
+    }
+
+#ifdef CONFIG_SERVICE_USBDMSC_PIPELINE
+    // none are programmed while the host waits
+    if (sim_.numPolledPrograms - numPolledPrograms != numChunks) {
+        printf("FAIL: %zu of %zu sequential chunks programmed while the host waited\n",
+            numChunks - (sim_.numPolledPrograms - numPolledPrograms), numChunks);
+        numFailures_++;
+    }
+#else
+    (void)numPolledPrograms;
+#endif
+}
+
+static void run_random_trace_(size_t numOps)
+{
+    uint64_t address = 0u;
+
+    for (size_t i = 0u; i < numOps; i++) {
+        // mostly carry on from the last access, as a host copying files does
+        if ((rand() % 4) == 0) {
+            address = random_address_();
+        } else if (address >= CAPACITY) {
+            address = 0u;
+        }
+
+        uint32_t const len = random_len_(address);
+
+        if (rand() % 2) {
+            host_read_(address, len);
+        } else {
+            host_write_(address, len);
+        }
+        address += len;
+    }
+}
+
+static void check_released_(char const *pDesc)
+{
+    // on release, the media flushes any pending write
+    sim_.inPoll = true;
+    FLASH_DRIVE_process_pending();
+    sim_.inPoll = false;
+
+    if (memcmp(storage_, reference_, CAPACITY)) {
+        printf("FAIL: %s: storage does not hold what was written after release\n", pDesc);
+        numFailures_++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <name>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    srand(1u);
+    for (size_t i = 0u; i < CAPACITY; i++) {
+        storage_[i] = reference_[i] = (uint8_t)rand();
+    }
+
+    run_sequential_reads_();
+    run_sequential_writes_();
+    check_released_("sequential writes");
+    run_sequential_reads_();
+
+    run_random_trace_(20000u);
+    check_released_("random trace");
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    printf("usbdmsc (%s): %zu reads (%zu polled), %zu programs (%zu polled)\n", argv[1],
+        sim_.numReads, sim_.numPolledReads, sim_.numPrograms, sim_.numPolledPrograms);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,409 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - YMODEM receive host test
+ *
+ * Runs the YMODEM receiver against a simulated sender on a simulated UART. The sender
+ * reacts to each character the receiver sends, as a real sender would: 'C' starts the
+ * transfer, ACK moves on to the next block, NAK repeats the block, and CAN aborts.
+ *
+ * For ymodem_receive_streaming(), checks that the file is written through in whole,
+ * contiguous windows (with the last one trimmed of SUB padding), that each window is
+ * written before the packet that completed it is acknowledged, that a damaged packet is
+ * repeated without disturbing the windows, and that a failed write or an oversized file
+ * aborts the transfer.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_crc16.h"
+#include "ymodem.h"
+#include "uart_helper.h"
+#include "drivers/mss/mss_mmuart/mss_uart.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SIZE (1024u * 1024u)
+
+#define XYMODEM_SOH 0x01u
+#define XYMODEM_STX 0x02u
+#define XYMODEM_EOT 0x04u
+#define XYMODEM_ACK 0x06u
+#define XYMODEM_NAK 0x15u
+#define XYMODEM_CAN 0x18u
+#define XYMODEM_SUB 0x1Au
+#define XYMODEM_C   0x43u
+
+mss_uart_instance_t g_mss_uart0_lo;
+
+static unsigned int numFailures_ = 0u;
+
+//
+// the simulated sender, and the bytes it has queued on the line to the receiver
+//
+enum SenderPhase {
+    SENDER_WAIT_START,
+    SENDER_SENT_HEADER,
+    SENDER_WAIT_DATA_START,
+    SENDER_SENT_DATA,
+    SENDER_SENT_EOT,
+    SENDER_DONE,
+    SENDER_CANCELLED,
+};
+
+static struct {
+    uint8_t const *pFile;
+    size_t fileSize;
+    enum SenderPhase phase;
+    uint8_t blkNum;
+    size_t blockOffset;  // offset in the file of the block last sent
+    size_t sentOffset;   // offset in the file of the end of the block last sent
+    size_t ackedOffset;  // offset in the file up to which blocks have been acknowledged
+    uint8_t corruptBlkNum; // damage the first send of this block, if not 0
+    size_t numNAKs;
+
+    uint8_t line[1024u + 5u];
+    size_t lineLen;
+    size_t linePos;
+} sender_;
+
+//
+// what the receiver wrote through
+//
+static struct {
+    uint8_t *pOutput;
+    size_t windowSize;
+    size_t numWrites;
+    size_t writtenSize;
+    bool shortWrite;
+    size_t failAtOffset; // fail the write of the window at this offset
+} writes_;
+
+static void queue_block_(uint8_t startByte, uint8_t blkNum, uint8_t const *pData, size_t dataLen,
+    size_t blockLen, uint8_t padding, bool corrupt)
+{
+    uint8_t *pBlock = sender_.line;
+
+    pBlock[0] = startByte;
+    pBlock[1] = blkNum;
+    pBlock[2] = blkNum ^ 0xFFu;
+    memcpy(&pBlock[3], pData, dataLen);
+    memset(&pBlock[3 + dataLen], padding, blockLen - dataLen);
+
+    uint16_t const crc16 = CRC16_calculate(&pBlock[3], blockLen);
+    pBlock[3 + blockLen] = (uint8_t)(crc16 >> 8);
+    pBlock[4 + blockLen] = (uint8_t)crc16;
+
+    if (corrupt) {
+        pBlock[3] ^= 0x01u;
+    }
+
+    sender_.lineLen = blockLen + 5u;
+    sender_.linePos = 0u;
+}
+
+static void send_header_(void)
+{
+    uint8_t header[128];
+
+    memset(header, 0, sizeof(header));
+    int const nameLen = snprintf((char *)header, sizeof(header), "payload.bin");
+    (void)snprintf((char *)&header[nameLen + 1], sizeof(header) - (size_t)nameLen - 1u, "%zu",
+        sender_.fileSize);
+
+    queue_block_(XYMODEM_SOH, 0u, header, sizeof(header), sizeof(header), 0u, false);
+    sender_.phase = SENDER_SENT_HEADER;
+}
+
+static void send_data_(bool firstSend)
+{
+    size_t const remaining = sender_.fileSize - sender_.blockOffset;
+
+    if (!remaining) {
+        sender_.line[0] = XYMODEM_EOT;
+        sender_.lineLen = 1u;
+        sender_.linePos = 0u;
+        sender_.phase = SENDER_SENT_EOT;
+    } else {
+        // as sz does, 1K blocks unless what remains fits a 128 byte block
+        size_t const blockLen = (remaining > 128u) ? 1024u : 128u;
+        size_t const dataLen = MIN(remaining, blockLen);
+
+        queue_block_((blockLen == 1024u) ? XYMODEM_STX : XYMODEM_SOH, sender_.blkNum,
+            sender_.pFile + sender_.blockOffset, dataLen, blockLen, XYMODEM_SUB,
+            firstSend && (sender_.blkNum == sender_.corruptBlkNum));
+        sender_.sentOffset = sender_.blockOffset + dataLen;
+        sender_.phase = SENDER_SENT_DATA;
+    }
+}
+
+static void sender_receive_(uint8_t ch)
+{
+    switch (ch) {
+    case XYMODEM_C:
+        if (sender_.phase == SENDER_WAIT_START) {
+            send_header_();
+        } else if (sender_.phase == SENDER_WAIT_DATA_START) {
+            sender_.blkNum = 1u;
+            sender_.blockOffset = 0u;
+            send_data_(true);
+        }
+        break;
+
+    case XYMODEM_ACK:
+        if (sender_.phase == SENDER_SENT_HEADER) {
+            sender_.phase = SENDER_WAIT_DATA_START;
+        } else if (sender_.phase == SENDER_SENT_DATA) {
+            sender_.ackedOffset = sender_.sentOffset;
+            sender_.blockOffset = sender_.sentOffset;
+            sender_.blkNum++;
+            send_data_(true);
+        } else if (sender_.phase == SENDER_SENT_EOT) {
+            sender_.phase = SENDER_DONE;
+        }
+        break;
+
+    case XYMODEM_NAK:
+        sender_.numNAKs++;
+        if (sender_.phase == SENDER_SENT_HEADER) {
+            send_header_();
+        } else if (sender_.phase == SENDER_SENT_DATA) {
+            send_data_(false);
+        }
+        break;
+
+    case XYMODEM_CAN:
+        sender_.phase = SENDER_CANCELLED;
+        sender_.lineLen = sender_.linePos = 0u;
+        break;
+
+    default:
+        break;
+    }
+}
+
+//
+// UART stand-ins: reading an empty line times out at once
+//
+bool uart_getchar(uint8_t *pbuf, int32_t timeout_sec, bool do_sec_tick)
+{
+    bool result = false;
+
+    (void)timeout_sec;
+    (void)do_sec_tick;
+
+    if (sender_.linePos < sender_.lineLen) {
+        *pbuf = sender_.line[sender_.linePos++];
+        result = true;
+    }
+
+    return result;
+}
+
+size_t uart_getbuf(uint8_t *pBuf, size_t len, int32_t timeout_sec)
+{
+    size_t const count = MIN(len, sender_.lineLen - sender_.linePos);
+
+    (void)timeout_sec;
+
+    memcpy(pBuf, &sender_.line[sender_.linePos], count);
+    sender_.linePos += count;
+
+    return count;
+}
+
+void uart_tx_flush(void)
+{
+}
+
+void MSS_UART_polled_tx(mss_uart_instance_t *this_uart, const uint8_t *pbuff, uint32_t tx_size)
+{
+    (void)this_uart;
+
+    for (uint32_t i = 0u; i < tx_size; i++) {
+        sender_receive_(pbuff[i]);
+    }
+}
+
+static bool write_(size_t offset, uint8_t *pData, size_t byteCount)
+{
+    bool result = true;
+
+    writes_.numWrites++;
+
+    if (offset != writes_.writtenSize) {
+        printf("FAIL: window written at %zu, expected %zu\n", offset, writes_.writtenSize);
+        numFailures_++;
+    } else if (writes_.shortWrite || (byteCount > writes_.windowSize) || !byteCount) {
+        printf("FAIL: %zu byte write at %zu is not a window, or follows a short one\n",
+            byteCount, offset);
+        numFailures_++;
+    } else if (offset + byteCount > sender_.fileSize) {
+        printf("FAIL: %zu byte write at %zu is beyond the file\n", byteCount, offset);
+        numFailures_++;
+    } else if ((sender_.phase == SENDER_SENT_DATA) && ((offset + byteCount <= sender_.ackedOffset)
+            || (offset + byteCount > sender_.sentOffset))) {
+        // windows completed during the transfer are written before the ACK of the block
+        // that completed them
+        printf("FAIL: window at %zu written with %zu bytes acknowledged of %zu sent\n", offset,
+            sender_.ackedOffset, sender_.sentOffset);
+        numFailures_++;
+    } else {
+        memcpy(writes_.pOutput + offset, pData, byteCount);
+        writes_.writtenSize += byteCount;
+        writes_.shortWrite = (byteCount < writes_.windowSize);
+    }
+
+    if (offset == writes_.failAtOffset) {
+        result = false;
+    }
+
+    return result;
+}
+
+static void start_(uint8_t const *pFile, size_t fileSize, size_t windowSize)
+{
+    memset(&sender_, 0, sizeof(sender_));
+    sender_.pFile = pFile;
+    sender_.fileSize = fileSize;
+    sender_.phase = SENDER_WAIT_START;
+
+    free(writes_.pOutput);
+    memset(&writes_, 0, sizeof(writes_));
+    writes_.pOutput = malloc(fileSize + 1u);
+    writes_.windowSize = windowSize;
+    writes_.failAtOffset = SIZE_MAX;
+}
+
+static size_t receive_streaming_(size_t windowSize, size_t maxSize)
+{
+    // one spare byte to catch an overrun of the window
+    uint8_t *pWindow = malloc(windowSize + 1u);
+    pWindow[windowSize] = 0x5Au;
+
+    size_t const result = ymodem_receive_streaming(pWindow, windowSize, maxSize, write_);
+
+    if (pWindow[windowSize] != 0x5Au) {
+        printf("FAIL: %zu byte window overrun\n", windowSize);
+        numFailures_++;
+    }
+    free(pWindow);
+
+    return result;
+}
+
+static void check_streaming_(uint8_t const *pFile, size_t fileSize, size_t windowSize,
+    uint8_t corruptBlkNum)
+{
+    start_(pFile, fileSize, windowSize);
+    sender_.corruptBlkNum = corruptBlkNum;
+
+    size_t const result = receive_streaming_(windowSize, MAX_SIZE);
+    size_t const expectedNumWrites = (fileSize + windowSize - 1u) / windowSize;
+
+    if ((result != fileSize) || (writes_.writtenSize != fileSize)
+            || (writes_.numWrites != expectedNumWrites) || memcmp(writes_.pOutput, pFile, fileSize)) {
+        printf("FAIL: %zu bytes through %zu byte window: returned %zu, wrote %zu in %zu writes%s\n",
+            fileSize, windowSize, result, writes_.writtenSize, writes_.numWrites,
+            memcmp(writes_.pOutput, pFile, MIN(fileSize, writes_.writtenSize)) ? ", differs" : "");
+        numFailures_++;
+    }
+
+    if (sender_.phase != SENDER_DONE) {
+        printf("FAIL: %zu bytes through %zu byte window: sender did not finish (%d)\n",
+            fileSize, windowSize, sender_.phase);
+        numFailures_++;
+    }
+
+    if (corruptBlkNum && !sender_.numNAKs) {
+        printf("FAIL: damaged block %u was not NAKed\n", corruptBlkNum);
+        numFailures_++;
+    }
+}
+
+static void check_aborts_(uint8_t const *pFile, size_t windowSize)
+{
+    size_t const fileSize = 5u * windowSize + 100u;
+
+    // a failed write cancels the transfer
+    start_(pFile, fileSize, windowSize);
+    writes_.failAtOffset = windowSize;
+
+    size_t result = receive_streaming_(windowSize, MAX_SIZE);
+    if (result || (sender_.phase != SENDER_CANCELLED) || (writes_.numWrites != 2u)) {
+        printf("FAIL: failed write returned %zu after %zu writes, sender phase %d\n", result,
+            writes_.numWrites, sender_.phase);
+        numFailures_++;
+    }
+
+    // as does a file larger than allowed, before anything is written
+    start_(pFile, fileSize, windowSize);
+
+    result = receive_streaming_(windowSize, fileSize - 1u);
+    if (result || (sender_.phase != SENDER_CANCELLED) || writes_.numWrites) {
+        printf("FAIL: oversized file returned %zu after %zu writes, sender phase %d\n", result,
+            writes_.numWrites, sender_.phase);
+        numFailures_++;
+    }
+}
+
+static void check_buffered_(uint8_t const *pFile, size_t fileSize)
+{
+    size_t const bufferSize = fileSize + 2048u;
+    uint8_t *pBuffer = malloc(bufferSize);
+
+    start_(pFile, fileSize, bufferSize);
+
+    size_t const result = ymodem_receive(pBuffer, bufferSize);
+    if ((result != fileSize) || memcmp(pBuffer, pFile, fileSize) || writes_.numWrites) {
+        printf("FAIL: %zu bytes received into a buffer: returned %zu\n", fileSize, result);
+        numFailures_++;
+    }
+
+    free(pBuffer);
+}
+
+int main(void)
+{
+    // one window a multiple of the block size, and one not
+    size_t const windowSizes[] = { 1024u, 3000u, 4096u };
+    size_t const fileSizes[] = {
+        1u, 127u, 128u, 129u, 1000u, 1024u, 1025u, 2999u, 3000u, 3001u, 4096u, 10000u,
+        64u * 1024u + 17u,
+    };
+    size_t const largestFile = 64u * 1024u + 17u;
+    uint8_t *pFile = malloc(largestFile);
+
+    srand(1u);
+    for (size_t i = 0u; i < largestFile; i++) {
+        pFile[i] = (uint8_t)rand();
+    }
+
+    for (size_t i = 0u; i < ARRAY_SIZE(windowSizes); i++) {
+        for (size_t j = 0u; j < ARRAY_SIZE(fileSizes); j++) {
+            check_streaming_(pFile, fileSizes[j], windowSizes[i], 0u);
+        }
+
+        // the damaged block completes the second window
+        check_streaming_(pFile, 10000u, windowSizes[i],
+            (uint8_t)((2u * windowSizes[i] - 1u) / 1024u + 1u));
+        check_aborts_(pFile, windowSizes[i]);
+    }
+
+    check_buffered_(pFile, 10000u);
+
+    free(writes_.pOutput);
+    free(pFile);
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    printf("ymodem: files written through in windows, before each ACK\n");
+    return EXIT_SUCCESS;
+}
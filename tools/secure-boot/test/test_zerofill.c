@@ -0,0 +1,453 @@
+/*******************************************************************************
+ * Copyright 2019-2022 Microchip FPGA Embedded Systems Solutions.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * MPFS HSS Embedded Software - zero fill engine host test
+ *
+ * Zeroes regions of a host buffer through each path of the zero fill engine, checking
+ * that exactly the region is zeroed: the E51 on its own, the PDMA doubling (against a
+ * model of the PDMA that only moves the data when a transfer completes, and is sometimes
+ * busy), and host threads standing in for the U54s. A U54 that is busy must have its
+ * region taken back by the E51, and must then leave it alone, as must a U54 handling a
+ * stale request. Then times zeroing a large region with the word loop HSS_ZeroDDR() used
+ * to run, the engine's wide stores on one hart, and split across four, and counts the
+ * transfers the PDMA doubling takes for it.
+ */
+
+#include "config.h"
+#include "hss_types.h"
+#include "hss_clock.h"
+#include "hss_zerofill.h"
+#include "ssmb_ipi.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BUFFER_SIZE     (64u * 1024u * 1024u)
+#define GUARD_SIZE      64u
+#define FILL            0xA5u
+#define NUM_U54S        (HSS_HART_NUM_PEERS - HSS_HART_U54_1)
+
+static unsigned int numFailures_ = 0u;
+
+static uint8_t *pBuffer_; // with a guard either side
+
+//
+// model of the PDMA: a transfer completes after a few polls, and only then is the data
+// copied, so a step that does not wait for the previous one copies stale data
+//
+static struct {
+    bool inFlight;
+    char *pDest;
+    char const *pSrc;
+    size_t numBytes;
+    unsigned int pollsLeft;
+    size_t numTransfers;
+    size_t numRefused;
+} pdma_;
+
+bool memcpy_via_pdma_submit(void * restrict dest, void const * restrict src, size_t num_bytes,
+    HSS_PDMA_Txn_t *pTxn)
+{
+    if (pdma_.inFlight) {
+        printf("FAIL: PDMA transfer submitted while one is in flight\n");
+        numFailures_++;
+    }
+
+    if (((char *)dest < (char const *)src + num_bytes) && ((char const *)src < (char *)dest + num_bytes)) {
+        printf("FAIL: overlapping PDMA transfer of %zu bytes\n", num_bytes);
+        numFailures_++;
+    }
+
+    if ((rand() % 4) == 0) {
+        pdma_.numRefused++;
+        return false; // every channel busy
+    }
+
+    pdma_.inFlight = true;
+    pdma_.pDest = dest;
+    pdma_.pSrc = src;
+    pdma_.numBytes = num_bytes;
+    pdma_.pollsLeft = (unsigned int)rand() % 3u;
+    pdma_.numTransfers++;
+    *pTxn = 1u;
+
+    return true;
+}
+
+bool memcpy_via_pdma_poll(HSS_PDMA_Txn_t *pTxn)
+{
+    if (pdma_.inFlight) {
+        if (pdma_.pollsLeft) {
+            pdma_.pollsLeft--;
+            return false;
+        }
+
+        memcpy(pdma_.pDest, pdma_.pSrc, pdma_.numBytes);
+        pdma_.inFlight = false;
+    }
+
+    *pTxn = 0u;
+    return true;
+}
+
+//
+// host stand-ins for the U54s and the IPIs sent to them
+//
+static struct {
+    pthread_t thread;
+    volatile bool busy;
+    volatile bool pending;
+    uint32_t immediate;
+    void *pJob;
+    volatile unsigned int numRun;
+    volatile unsigned int numIgnored;
+} u54s_[HSS_HART_NUM_PEERS];
+
+static pthread_mutex_t lock_ = PTHREAD_MUTEX_INITIALIZER;
+static volatile bool quit_ = false;
+static bool refuseIpis_ = false;
+
+bool IPI_Send(enum HSSHartId target, enum IPIMessagesEnum message, TxId_t transaction_id,
+    uint32_t immediate_arg, void const *p_extended_buffer_in_ddr,
+    void const *p_ancilliary_buffer_in_ddr)
+{
+    (void)transaction_id;
+    (void)p_ancilliary_buffer_in_ddr;
+
+    if ((message != IPI_MSG_ZEROFILL) || (target < HSS_HART_U54_1) || (target >= HSS_HART_NUM_PEERS)) {
+        printf("FAIL: unexpected message %d to hart %d\n", message, target);
+        numFailures_++;
+        return false;
+    }
+
+    if (refuseIpis_ || u54s_[target].pending) {
+        return false; // queue full
+    }
+
+    pthread_mutex_lock(&lock_);
+    u54s_[target].immediate = immediate_arg;
+    u54s_[target].pJob = (void *)p_extended_buffer_in_ddr;
+    u54s_[target].pending = true;
+    pthread_mutex_unlock(&lock_);
+
+    return true;
+}
+
+static void *u54_(void *pArg)
+{
+    enum HSSHartId const hartId = (enum HSSHartId)(uintptr_t)pArg;
+
+    while (!quit_) {
+        if (!u54s_[hartId].busy && u54s_[hartId].pending) {
+            pthread_mutex_lock(&lock_);
+            uint32_t const immediate = u54s_[hartId].immediate;
+            void * const pJob = u54s_[hartId].pJob;
+            pthread_mutex_unlock(&lock_);
+
+            if (HSS_ZeroFill_IPIHandler(0u, HSS_HART_E51, immediate, pJob, NULL) == IPI_SUCCESS) {
+                u54s_[hartId].numRun++;
+            } else {
+                u54s_[hartId].numIgnored++;
+            }
+
+            __atomic_store_n(&u54s_[hartId].pending, false, __ATOMIC_RELEASE);
+        } else {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void wait_for_u54_(enum HSSHartId hartId)
+{
+    while (__atomic_load_n(&u54s_[hartId].pending, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+}
+
+bool HSS_Timer_IsElapsed(HSSTicks_t startTick, HSSTicks_t durationInTicks)
+{
+    return (HSS_GetTime() - startTick) >= durationInTicks;
+}
+
+//
+// the checks
+//
+static void fill_(void)
+{
+    memset(pBuffer_, FILL, GUARD_SIZE + BUFFER_SIZE + GUARD_SIZE);
+}
+
+// takes offsets into the whole buffer, guards included
+static bool is_filled_(size_t start, size_t end, uint8_t value)
+{
+    for (size_t i = start; i < end; i++) {
+        if (pBuffer_[i] != value) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// exactly the region must be zeroed, and nothing either side of it
+static void check_zeroed_(char const *pDesc, size_t offset, size_t numBytes)
+{
+    size_t const start = GUARD_SIZE + offset;
+
+    if (!is_filled_(start, start + numBytes, 0u)) {
+        printf("FAIL: %s: %zu bytes at %zu not zeroed\n", pDesc, numBytes, offset);
+        numFailures_++;
+    }
+
+    if (!is_filled_(0u, start, FILL)
+            || !is_filled_(start + numBytes, GUARD_SIZE + BUFFER_SIZE + GUARD_SIZE, FILL)) {
+        printf("FAIL: %s: zeroing %zu bytes at %zu touched memory beyond them\n", pDesc, numBytes,
+            offset);
+        numFailures_++;
+    }
+}
+
+static void *region_(size_t offset)
+{
+    return &pBuffer_[GUARD_SIZE + offset];
+}
+
+static void run_e51_(void)
+{
+    static const struct {
+        size_t offset;
+        size_t numBytes;
+    } regions[] = {
+        { 0u, 0u }, { 8u, 1u }, { 1u, 3u }, { 3u, 7u }, { 64u, 4096u }, { 5u, 4097u },
+        { 3u, 12345u }, { 0u, 1024u * 1024u }, { 1u, 3u * 1024u * 1024u + 5u },
+        { 0u, BUFFER_SIZE },
+    };
+
+    // synchronously, and as a job polled by the E51
+    for (size_t i = 0u; i < ARRAY_SIZE(regions); i++) {
+        fill_();
+        HSS_ZeroFill(region_(regions[i].offset), regions[i].numBytes);
+        check_zeroed_("E51", regions[i].offset, regions[i].numBytes);
+    }
+
+    struct HSS_ZeroFill_Job job = { 0 };
+    for (size_t i = 0u; i < ARRAY_SIZE(regions); i++) {
+        fill_();
+        HSS_ZeroFill_Submit(&job, HSS_HART_E51, region_(regions[i].offset), regions[i].numBytes);
+        while (!HSS_ZeroFill_Poll(&job)) {
+            ;
+        }
+        check_zeroed_("E51 job", regions[i].offset, regions[i].numBytes);
+    }
+}
+
+static void run_u54s_(void)
+{
+    struct HSS_ZeroFill_Job jobs[NUM_U54S] = { 0 };
+    size_t const numBytes = 1024u * 1024u + 3u;
+
+    // one region per U54, at once
+    fill_();
+    for (size_t i = 0u; i < NUM_U54S; i++) {
+        HSS_ZeroFill_Submit(&jobs[i], (enum HSSHartId)(HSS_HART_U54_1 + i),
+            region_(i * 2u * numBytes), numBytes);
+    }
+
+    for (size_t i = 0u; i < NUM_U54S; i++) {
+        while (!HSS_ZeroFill_Poll(&jobs[i])) {
+            sched_yield();
+        }
+        memset(region_(i * 2u * numBytes + numBytes), 0, numBytes);
+    }
+    check_zeroed_("U54s", 0u, NUM_U54S * 2u * numBytes);
+
+    for (size_t i = 0u; i < NUM_U54S; i++) {
+        if (u54s_[HSS_HART_U54_1 + i].numRun != 1u) {
+            printf("FAIL: U54 %zu ran %u regions, expected 1\n", i + 1u,
+                u54s_[HSS_HART_U54_1 + i].numRun);
+            numFailures_++;
+        }
+    }
+
+    // a region no larger than the seed is not worth sending
+    fill_();
+    HSS_ZeroFill_Submit(&jobs[0], HSS_HART_U54_1, region_(0u), 4096u);
+    while (!HSS_ZeroFill_Poll(&jobs[0])) {
+        ;
+    }
+    check_zeroed_("small region", 0u, 4096u);
+
+    // nor when its queue is full
+    fill_();
+    refuseIpis_ = true;
+    HSS_ZeroFill_Submit(&jobs[0], HSS_HART_U54_1, region_(0u), numBytes);
+    refuseIpis_ = false;
+    while (!HSS_ZeroFill_Poll(&jobs[0])) {
+        ;
+    }
+    check_zeroed_("IPI queue full", 0u, numBytes);
+
+    if (u54s_[HSS_HART_U54_1].numRun != 1u) {
+        printf("FAIL: region sent to U54 1 when it should not have been\n");
+        numFailures_++;
+    }
+}
+
+static void run_busy_u54_(void)
+{
+    struct HSS_ZeroFill_Job job = { 0 };
+    enum HSSHartId const hartId = HSS_HART_U54_2;
+    size_t const numBytes = 256u * 1024u;
+
+    // the E51 takes the region back once it has waited long enough...
+    fill_();
+    u54s_[hartId].busy = true;
+    HSSTicks_t const startTime = HSS_GetTime();
+    HSS_ZeroFill_Submit(&job, hartId, region_(0u), numBytes);
+    while (!HSS_ZeroFill_Poll(&job)) {
+        sched_yield();
+    }
+
+    if (!HSS_Timer_IsElapsed(startTime, 10u * ONE_MILLISEC)) {
+        printf("FAIL: region taken back from a busy U54 too soon\n");
+        numFailures_++;
+    }
+    check_zeroed_("busy U54", 0u, numBytes);
+
+    // ... and the U54 must then leave it alone
+    unsigned int const numIgnored = u54s_[hartId].numIgnored;
+    fill_();
+    u54s_[hartId].busy = false;
+    wait_for_u54_(hartId);
+
+    if ((u54s_[hartId].numIgnored != numIgnored + 1u)
+            || !is_filled_(0u, GUARD_SIZE + BUFFER_SIZE + GUARD_SIZE, FILL)) {
+        printf("FAIL: U54 zeroed a region the E51 had taken back\n");
+        numFailures_++;
+    }
+
+    // a request from before the job was resubmitted must be ignored, even while the job
+    // is queued for the U54
+    uint32_t const staleGeneration = job.generation;
+    u54s_[hartId].busy = true;
+    HSS_ZeroFill_Submit(&job, hartId, region_(0u), numBytes);
+
+    if (HSS_ZeroFill_IPIHandler(0u, HSS_HART_E51, staleGeneration, &job, NULL) != IPI_FAIL) {
+        printf("FAIL: stale request run\n");
+        numFailures_++;
+    }
+
+    u54s_[hartId].busy = false;
+    while (!HSS_ZeroFill_Poll(&job)) {
+        sched_yield();
+    }
+    check_zeroed_("resubmitted", 0u, numBytes);
+}
+
+//
+// bandwidth of each strategy, over the whole buffer
+//
+static double mib_per_sec_(HSSTicks_t startTime)
+{
+    HSSTicks_t const elapsed = MAX(HSS_GetTime() - startTime, (HSSTicks_t)1u);
+
+    return ((double)BUFFER_SIZE / (1024.0 * 1024.0)) / ((double)elapsed / 1e9);
+}
+
+static void run_bandwidth_(void)
+{
+    struct HSS_ZeroFill_Job jobs[NUM_U54S] = { 0 };
+
+    // the word loop HSS_ZeroDDR() used to run on the E51
+    fill_();
+    HSSTicks_t startTime = HSS_GetTime();
+    for (uint64_t volatile *pWord = region_(0u); pWord < (uint64_t *)region_(BUFFER_SIZE); pWord++) {
+        *pWord = 0llu;
+    }
+    double const wordLoop = mib_per_sec_(startTime);
+    check_zeroed_("word loop", 0u, BUFFER_SIZE);
+
+    // wide stores on one U54
+    fill_();
+    startTime = HSS_GetTime();
+    HSS_ZeroFill_Submit(&jobs[0], HSS_HART_U54_1, region_(0u), BUFFER_SIZE);
+    while (!HSS_ZeroFill_Poll(&jobs[0])) {
+        ;
+    }
+    double const oneU54 = mib_per_sec_(startTime);
+    check_zeroed_("one U54", 0u, BUFFER_SIZE);
+
+    // split across all of them
+    fill_();
+    startTime = HSS_GetTime();
+    for (size_t i = 0u; i < NUM_U54S; i++) {
+        HSS_ZeroFill_Submit(&jobs[i], (enum HSSHartId)(HSS_HART_U54_1 + i),
+            region_(i * (BUFFER_SIZE / NUM_U54S)), BUFFER_SIZE / NUM_U54S);
+    }
+    for (size_t i = 0u; i < NUM_U54S; i++) {
+        while (!HSS_ZeroFill_Poll(&jobs[i])) {
+            ;
+        }
+    }
+    double const allU54s = mib_per_sec_(startTime);
+    check_zeroed_("all U54s", 0u, BUFFER_SIZE);
+
+    // the PDMA model copies with the host CPU, so only its transfers are counted
+    size_t const numTransfers = pdma_.numTransfers;
+    fill_();
+    HSS_ZeroFill(region_(0u), BUFFER_SIZE);
+    check_zeroed_("PDMA", 0u, BUFFER_SIZE);
+
+    printf("zerofill: %u MiB - word loop %.0f MiB/s, wide stores %.0f MiB/s on one U54, "
+        "%.0f MiB/s on %u, PDMA doubling in %zu transfers\n", BUFFER_SIZE / (1024u * 1024u),
+        wordLoop, oneU54, allU54s, (unsigned int)NUM_U54S, pdma_.numTransfers - numTransfers);
+}
+
+int main(void)
+{
+    pBuffer_ = malloc(GUARD_SIZE + BUFFER_SIZE + GUARD_SIZE);
+    if (!pBuffer_) {
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+
+    for (int peer = HSS_HART_U54_1; peer < HSS_HART_NUM_PEERS; peer++) {
+        if (pthread_create(&u54s_[peer].thread, NULL, u54_, (void *)(uintptr_t)peer)) {
+            perror("pthread_create");
+            return EXIT_FAILURE;
+        }
+    }
+
+    srand(1u);
+    run_e51_();
+    run_u54s_();
+    run_busy_u54_();
+
+    if (pdma_.numRefused == 0u) {
+        printf("FAIL: the PDMA was never busy\n");
+        numFailures_++;
+    }
+
+    if (!numFailures_) {
+        run_bandwidth_();
+    }
+
+    quit_ = true;
+    for (int peer = HSS_HART_U54_1; peer < HSS_HART_NUM_PEERS; peer++) {
+        (void)pthread_join(u54s_[peer].thread, NULL);
+    }
+
+    if (numFailures_) {
+        printf("%u failures\n", numFailures_);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
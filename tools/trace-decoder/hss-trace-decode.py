@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+
+#==============================================================================
+#
+# MPFS HSS Binary Trace Decoder
+#
+# Copyright 2022 Microchip Corporation.
+#
+# SPDX-License-Identifier: MIT
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to
+# deal in the Software without restriction, including without limitation the
+# rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+# sell copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+# IN THE SOFTWARE.
+#
+#
+# This script takes a console capture of the TinyCLI "DEBUG TRACE" command
+# and turns it into a readable timeline
+#
+#==============================================================================
+
+import argparse
+import os
+import re
+import sys
+
+# keep in sync with enum HSSTraceEvent in modules/debug/hss_trace.h
+EVT_NONE = 0
+EVT_SM_TRANSITION = 1
+EVT_IPI_SEND = 2
+EVT_IPI_CONSUME = 3
+EVT_USER = 4
+
+HART_NAMES = [ "E51", "U54_1", "U54_2", "U54_3", "U54_4" ]
+
+def get_script_version():
+	return "1.0.0"
+
+def load_ipi_names(header):
+	#
+	# enum IPIMessagesEnum in modules/ssmb/ipi/ssmb_ipi.h gives the names
+	# of IPI message types, in order
+	#
+	names = []
+	try:
+		with open(header, "r") as f:
+			text = f.read()
+	except OSError:
+		return names
+
+	match = re.search(r"enum IPIMessagesEnum\s*{([^}]*)}", text)
+	if match:
+		for token in match.group(1).split(","):
+			token = re.sub(r"//.*", "", token).strip()
+			if token.startswith("IPI_MSG_") and token != "IPI_MSG_NUM_MSG_TYPES":
+				names.append(token)
+	return names
+
+def hart_name(hartId):
+	if hartId < len(HART_NAMES):
+		return HART_NAMES[hartId]
+	return "hart%u" % hartId
+
+def ipi_name(ipiNames, msgType):
+	if msgType < len(ipiNames):
+		return ipiNames[msgType]
+	return "IPI_MSG(%u)" % msgType
+
+def parse_dump(lines):
+	ticksPerSec = None
+	machines = {}
+	states = {}
+	entries = []
+	dropped = 0
+
+	for line in lines:
+		# tolerate console timestamps or prompts in front of each line
+		match = re.search(r"\b(HSSTRACE|[MSE]) (.*)$", line.strip())
+		if not match:
+			continue
+
+		tag, rest = match.group(1), match.group(2).split()
+		if tag == "HSSTRACE":
+			if rest and rest[0] == "END":
+				break
+			if len(rest) >= 4:
+				ticksPerSec = int(rest[1])
+				dropped = int(rest[3])
+		elif tag == "M" and len(rest) >= 2:
+			machines[int(rest[0], 16)] = " ".join(rest[1:])
+		elif tag == "S" and len(rest) >= 3:
+			states[(int(rest[0], 16), int(rest[1]))] = " ".join(rest[2:])
+		elif tag == "E" and len(rest) >= 6:
+			entries.append([int(x, 16) for x in rest[:6]])
+
+	return ticksPerSec, machines, states, entries, dropped
+
+def describe(entry, machines, states, ipiNames):
+	tick, eventId, hartId, arg0, arg1, arg2 = entry
+
+	if eventId == EVT_SM_TRANSITION:
+		name = machines.get(arg0, "sm@%x" % arg0)
+		return "%s :: %s -> %s" % (name, states.get((arg0, arg1), str(arg1)),
+			states.get((arg0, arg2), str(arg2)))
+	elif eventId == EVT_IPI_SEND:
+		return "IPI send %s -> %s tx=%u" % (ipi_name(ipiNames, arg1), hart_name(arg0), arg2)
+	elif eventId == EVT_IPI_CONSUME:
+		return "IPI consume %s <- %s tx=%u" % (ipi_name(ipiNames, arg1), hart_name(arg0), arg2)
+	elif eventId == EVT_USER:
+		return "user 0x%x 0x%x 0x%x" % (arg0, arg1, arg2)
+	return "event %u 0x%x 0x%x 0x%x" % (eventId, arg0, arg1, arg2)
+
+def main():
+	scriptDir = os.path.dirname(os.path.abspath(__file__))
+	defaultIpiHeader = os.path.join(scriptDir, "..", "..", "modules", "ssmb", "ipi", "ssmb_ipi.h")
+
+	parser = argparse.ArgumentParser(description = "Decode an HSS binary trace dump")
+	parser.add_argument("input", nargs="?", default="-", help="console capture (default: stdin)")
+	parser.add_argument("--ipi-header", default=defaultIpiHeader,
+		help="path to ssmb_ipi.h, for IPI message names")
+	parser.add_argument("--version", action="version", version=get_script_version())
+	args = parser.parse_args()
+
+	if args.input == "-":
+		lines = sys.stdin.readlines()
+	else:
+		with open(args.input, "r", errors="replace") as f:
+			lines = f.readlines()
+
+	ticksPerSec, machines, states, entries, dropped = parse_dump(lines)
+	if ticksPerSec is None:
+		sys.exit("no HSSTRACE header found in input")
+
+	ipiNames = load_ipi_names(args.ipi_header)
+
+	if dropped:
+		print("(%u older entries were overwritten)" % dropped)
+
+	# entries are claimed in order, but may be stored out of order across harts
+	entries.sort(key=lambda e: e[0])
+	if entries:
+		firstTick = entries[0][0]
+		prevTick = firstTick
+		for entry in entries:
+			usec = (entry[0] - firstTick) * 1000000 / ticksPerSec
+			deltaUsec = (entry[0] - prevTick) * 1000000 / ticksPerSec
+			prevTick = entry[0]
+			print("%12.1f us (+%9.1f) %-6s %s" % (usec, deltaUsec, hart_name(entry[2]),
+				describe(entry, machines, states, ipiNames)))
+
+if __name__ == "__main__":
+	main()